@@ -51,6 +51,19 @@ namespace das {
         int32_t             mMagic = STATUS_MAGIC;
     };
 
+    // runs jobs of JobQue instead of its own threads (i.e. on the application thread pool, to not oversubscribe cpu).
+    // executor must invoke every job it was given exactly once, in any thread (including calling one)
+    class JobQueExecutor {
+    public:
+        virtual ~JobQueExecutor() {}
+        virtual int getTotalHwJobs() = 0;   // 0 means executor can't run jobs now, and JobQue starts its own threads
+        virtual void execute ( Job && job, JobPriority priority ) = 0;
+    };
+
+    // affects JobQue instances created after the call
+    void set_job_que_executor ( JobQueExecutor * executor );
+    JobQueExecutor * get_job_que_executor ();
+
     class JobQue {
     public:
         JobQue();
@@ -95,6 +108,8 @@ namespace das {
         void join();
         void job(int threadIndex);
         void submit(Job && job, JobCategory category, JobPriority priority);
+        void wakeUp(int count, JobPriority priority);
+        void executeOne();
     protected:
         condition_variable mCond;
         int mSleepMs;
@@ -106,6 +121,10 @@ namespace das {
         deque<JobEntry>	mFifo;
         vector<ThreadEntry>		mThreads;
         atomic<int> mJobsRunning{0};
+    protected:
+        JobQueExecutor *    mExecutor = nullptr;
+        atomic<int>         mExecutorPending{0};    // jobs given to executor and not finished yet
+        vector<JobCategory> mExecutorCategories;    // categories of jobs running in executor, guarded by mFifoMutex
     protected:
         mutex mEvalMainThreadMutex;
         vector<Job> mEvalMainThread;
@@ -313,6 +313,9 @@ namespace das
             stringHeap->reset();
         }
 
+        // brings clone back to the state it had right after cloning (heaps reset, globals initialized), so it can be reused
+        void restartClone();
+
         __forceinline uint32_t tryRestartAndLock() {
             if (insideContext == 0) {
                 restart();
@@ -333,10 +333,79 @@ das::Context* get_clone_context( das::Context * ctx, uint32_t category );//link
 
 namespace das {
 
+    // job clones are not deleted, but returned here when last reference to them is gone (job is done, and nothing it pushed
+    // into channels is alive), and reused for the next jobs of the same context. this saves allocation of globals and heaps
+    // per job. pool lives as long as with_job_que block, clones which outlive it are simply deleted
+    class JobContextPool : public enable_shared_from_this<JobContextPool> {
+        struct Entry {
+            Context *         source;
+            uint64_t          codeId;
+            vector<Context *> free;
+        };
+    public:
+        JobContextPool ( int maxFree ) : mMaxFree(maxFree) {}
+        ~JobContextPool () {
+            for ( auto & e : mEntries ) {
+                for ( auto ctx : e.free ) delete ctx;
+            }
+        }
+        shared_ptr<Context> acquire ( Context * context ) {
+            Context * clone = nullptr;
+            {
+                lock_guard<mutex> guard(mMutex);
+                auto e = find(context, context->getCodeAllocatorId());
+                if ( e && !e->free.empty() ) {
+                    clone = e->free.back();
+                    e->free.pop_back();
+                }
+            }
+            if ( clone ) {
+                clone->restartClone();
+            } else {
+                clone = get_clone_context(context, uint32_t(ContextCategory::job_clone));
+            }
+            weak_ptr<JobContextPool> wpool = shared_from_this();
+            uint64_t codeId = context->getCodeAllocatorId();
+            return shared_ptr<Context>(clone, [wpool, context, codeId]( Context * ctx ) {
+                auto pool = wpool.lock();
+                if ( !pool || !pool->release(context, codeId, ctx) ) delete ctx;
+            });
+        }
+    protected:
+        Entry * find ( Context * context, uint64_t codeId ) {
+            for ( auto & e : mEntries ) {
+                if ( e.source==context && e.codeId==codeId ) return &e;
+            }
+            return nullptr;
+        }
+        bool release ( Context * context, uint64_t codeId, Context * ctx ) {
+            if ( ctx->insideContext ) return false;
+            lock_guard<mutex> guard(mMutex);
+            Entry * e = find(context, codeId);
+            if ( !e ) {
+                mEntries.push_back({context, codeId, {}});
+                e = &mEntries.back();
+            }
+            if ( int(e->free.size()) >= mMaxFree ) return false;
+            e->free.push_back(ctx);
+            return true;
+        }
+    protected:
+        mutex           mMutex;
+        vector<Entry>   mEntries;
+        int             mMaxFree = 0;
+    };
+
+    shared_ptr<JobContextPool> g_jobContextPool;
+
     void new_job_invoke ( Lambda lambda, Func fn, int32_t lambdaSize, Context * context, LineInfoArg * lineinfo ) {
         if ( !g_jobQue ) context->throw_error_at(lineinfo, "need to be in 'with_job_que' block");
         shared_ptr<Context> forkContext;
-        forkContext.reset(get_clone_context(context, uint32_t(ContextCategory::job_clone)));
+        if ( auto pool = g_jobContextPool ) {
+            forkContext = pool->acquire(context);
+        } else {
+            forkContext.reset(get_clone_context(context, uint32_t(ContextCategory::job_clone)));
+        }
         auto ptr = forkContext->heap->allocate(lambdaSize + 16);
         forkContext->heap->mark_comment(ptr, "new [[ ]] in new_job");
         memset ( ptr, 0, lambdaSize + 16 );
@@ -383,6 +452,7 @@ namespace das {
         if ( !g_jobQue ) {
             lock_guard<mutex> guard(g_jobQueMutex);
             g_jobQue = make_shared<JobQue>();
+            g_jobContextPool = make_shared<JobContextPool>(g_jobQue->getTotalHwJobs() * 2);
         }
         {
             shared_ptr<JobQue> jq = g_jobQue;
@@ -390,7 +460,10 @@ namespace das {
         }
         {
             lock_guard<mutex> guard(g_jobQueMutex);
-            if ( g_jobQue.use_count()==1 ) g_jobQue.reset();
+            if ( g_jobQue.use_count()==1 ) {
+                g_jobQue.reset();
+                g_jobContextPool.reset();
+            }
         }
     }
 
@@ -634,6 +707,7 @@ namespace das {
                 }
                 lock_guard<mutex> guard(g_jobQueMutex);
                 g_jobQue.reset();
+                g_jobContextPool.reset();
             }
         }
     protected:
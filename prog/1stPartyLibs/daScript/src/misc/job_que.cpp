@@ -4,11 +4,29 @@
 
 namespace das {
 
+    static atomic<JobQueExecutor *> g_jobQueExecutor{nullptr};
+
+    void set_job_que_executor ( JobQueExecutor * executor ) {
+        g_jobQueExecutor = executor;
+    }
+
+    JobQueExecutor * get_job_que_executor () {
+        return g_jobQueExecutor;
+    }
+
     JobQue::JobQue()
         : mSleepMs(1)
         , mShutdown(false)
         , mThreadCount( 0 )
         , mJobsRunning(0) {
+        if ( JobQueExecutor * executor = get_job_que_executor() ) {
+            int executorJobs = executor->getTotalHwJobs();
+            if ( executorJobs > 0 ) {
+                mExecutor = executor;
+                mThreadCount = executorJobs;
+                return;
+            }
+        }
         mThreadCount = max(1,(static_cast<int>(thread::hardware_concurrency())));
         SetCurrentThreadPriority(JobPriority::High);
         for (int j = 0, js = mThreadCount; j < js; j++) {
@@ -51,6 +69,12 @@ namespace das {
 
     void JobQue::join() {
         mShutdown = true;
+        if ( mExecutor ) {
+            while ( mExecutorPending ) {    // executor jobs reference this que
+                this_thread::yield();
+            }
+            return;
+        }
         while ( mThreadCount ) {
             this_thread::yield();
         }
@@ -80,6 +104,9 @@ namespace das {
                 return threadEntry.currentPriority != JobPriority::Inactive && threadEntry.currentCategory == category; }) != mThreads.end()) {
             return true;
         }
+        if (find(mExecutorCategories.begin(), mExecutorCategories.end(), category) != mExecutorCategories.end()) {
+            return true;
+        }
         return false;
     }
 
@@ -99,9 +126,46 @@ namespace das {
     }
 
     void JobQue::push(Job && job, JobCategory category, JobPriority priority) {
-        lock_guard<mutex> lock(mFifoMutex);
-        submit(das::move(job), category, priority);
-        mCond.notify_one();
+        {
+            lock_guard<mutex> lock(mFifoMutex);
+            submit(das::move(job), category, priority);
+        }
+        wakeUp(1, priority);
+    }
+
+    void JobQue::wakeUp(int count, JobPriority priority) {
+        if ( !mExecutor ) {
+            if ( count==1 ) mCond.notify_one(); else mCond.notify_all();
+            return;
+        }
+        // each executor job runs one job of the highest priority from fifo, so priorities are kept even when executor reorders
+        mExecutorPending += count;
+        for ( int i=0; i!=count; ++i ) {
+            mExecutor->execute([this]() { executeOne(); }, priority);
+        }
+    }
+
+    void JobQue::executeOne() {
+        Job job;
+        JobCategory category = 0;
+        {
+            lock_guard<mutex> lock(mFifoMutex);
+            DAS_ASSERTF(mFifo.size() > 0, "There must be at least one job available");
+            job = das::move(mFifo.front().function);
+            category = mFifo.front().category;
+            mFifo.pop_front();
+            mExecutorCategories.push_back(category);
+            mJobsRunning++;
+        }
+        job();
+        {
+            lock_guard<mutex> lock(mFifoMutex);
+            auto it = find(mExecutorCategories.begin(), mExecutorCategories.end(), category);
+            *it = mExecutorCategories.back();
+            mExecutorCategories.pop_back();
+            mJobsRunning--;
+        }
+        mExecutorPending--;
     }
 
     void JobQue::job(int threadIndex) {
@@ -155,8 +219,8 @@ namespace das {
                     status.Notify();
                 }, category, priority);
             }
-            mCond.notify_all();
         }
+        wakeUp(onThreads, priority);
         chunk(from + onThreads * step, to);
     }
 
@@ -194,8 +258,8 @@ namespace das {
                     }
                 }, category, priority);
             }
-            mCond.notify_all();
         }
+        wakeUp(numChunks, priority);
         {
             int chunksRemaining = numChunks;
             while (chunksRemaining > 0) {
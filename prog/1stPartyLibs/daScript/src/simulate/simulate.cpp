@@ -1076,7 +1076,12 @@ namespace das
         // register
         announceCreation();
         // now, make it good to go
+        restartClone();
+    }
+
+    void Context::restartClone() {
         restart();
+        restartHeaps();
         if ( stack.size() > globalInitStackSize ) {
             runInitScript();
         } else {
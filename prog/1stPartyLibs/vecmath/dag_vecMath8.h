@@ -0,0 +1,416 @@
+//
+// Dagor Engine 6.5
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include "dag_vecMath.h"
+
+// 8-wide float/int vectors for bulk kernels.
+// With AVX (float ops) and AVX2 (int ops) they are native 256-bit registers, otherwise pairs of vec4f/vec4i, so same kernel code
+// can be compiled for baseline target and for AVX2/AVX-512 translation units selected at runtime (see dag_cpuDispatch.h).
+// Functions are placed to inline namespace named after target, so not inlined copies from translation units with different
+// target options are never mixed by linker.
+
+#if _TARGET_SIMD_SSE && defined(__AVX__)
+  #include <immintrin.h>
+  #define VECMATH_VEC8_NATIVE 1
+#else
+  #define VECMATH_VEC8_NATIVE 0
+#endif
+
+#if VECMATH_VEC8_NATIVE && defined(__AVX512F__) && defined(__AVX512VL__)
+  #define VECMATH_VEC8_NAMESPACE vec8_avx512
+#elif VECMATH_VEC8_NATIVE && defined(__AVX2__)
+  #define VECMATH_VEC8_NAMESPACE vec8_avx2
+#elif VECMATH_VEC8_NATIVE
+  #define VECMATH_VEC8_NAMESPACE vec8_avx
+#elif _TARGET_SIMD_SSE >= 4 || defined(__SSE4_1__)
+  #define VECMATH_VEC8_NAMESPACE vec8_sse4
+#else
+  #define VECMATH_VEC8_NAMESPACE vec8_base
+#endif
+
+inline namespace VECMATH_VEC8_NAMESPACE
+{
+
+#if VECMATH_VEC8_NATIVE
+typedef __m256 vec8f;
+typedef __m256i vec8i;
+#else
+struct vec8f
+{
+  vec4f lo, hi;
+};
+struct vec8i
+{
+  vec4i lo, hi;
+};
+#endif
+
+//! 0
+VECTORCALL VECMATH_FINLINE vec8f v8_zero();
+VECTORCALL VECMATH_FINLINE vec8i v8_zeroi();
+//! all 8 components = a
+VECTORCALL VECMATH_FINLINE vec8f v8_splats(float a);
+VECTORCALL VECMATH_FINLINE vec8i v8_splatsi(int a);
+//! components 0..3 = lo, 4..7 = hi
+VECTORCALL VECMATH_FINLINE vec8f v8_make_vec8f(vec4f lo, vec4f hi);
+VECTORCALL VECMATH_FINLINE vec8i v8_make_vec8i(vec4i lo, vec4i hi);
+//! components 0..3 / 4..7
+VECTORCALL VECMATH_FINLINE vec4f v8_get_lo(vec8f a);
+VECTORCALL VECMATH_FINLINE vec4f v8_get_hi(vec8f a);
+VECTORCALL VECMATH_FINLINE vec4i v8_get_loi(vec8i a);
+VECTORCALL VECMATH_FINLINE vec4i v8_get_hii(vec8i a);
+
+//! load vector from 32-byte aligned memory
+NO_ASAN_INLINE vec8f v8_ld(const float *m);
+NO_ASAN_INLINE vec8i v8_ldi(const int *m);
+//! load vector from unaligned memory
+NO_ASAN_INLINE vec8f v8_ldu(const float *m);
+NO_ASAN_INLINE vec8i v8_ldui(const int *m);
+//! load 8 unsigned bytes from unaligned memory and zero-extend them to ints
+NO_ASAN_INLINE vec8i v8_ldui_u8(const uint8_t *m);
+//! store vector to 32-byte aligned memory
+VECTORCALL VECMATH_FINLINE void v8_st(void *m, vec8f v);
+VECTORCALL VECMATH_FINLINE void v8_sti(void *m, vec8i v);
+//! store vector to unaligned memory
+VECTORCALL VECMATH_FINLINE void v8_stu(void *m, vec8f v);
+VECTORCALL VECMATH_FINLINE void v8_stui(void *m, vec8i v);
+//! pack ints to 8 unsigned bytes with saturation and store them to unaligned memory
+VECTORCALL VECMATH_FINLINE void v8_stui_packus_u8(void *m, vec8i v);
+
+//! (a + b), (a - b), (a * b), (a / b)
+VECTORCALL VECMATH_FINLINE vec8f v8_add(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_sub(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_mul(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_div(vec8f a, vec8f b);
+//! (a * b + c), fused when target has FMA
+VECTORCALL VECMATH_FINLINE vec8f v8_madd(vec8f a, vec8f b, vec8f c);
+//! component-wise min/max
+VECTORCALL VECMATH_FINLINE vec8f v8_min(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_max(vec8f a, vec8f b);
+//! -a, |a|
+VECTORCALL VECMATH_FINLINE vec8f v8_neg(vec8f a);
+VECTORCALL VECMATH_FINLINE vec8f v8_abs(vec8f a);
+//! sqrt(a)
+VECTORCALL VECMATH_FINLINE vec8f v8_sqrt(vec8f a);
+//! 1/a, fast estimate
+VECTORCALL VECMATH_FINLINE vec8f v8_rcp_est(vec8f a);
+//! return min/max of all 8 components in all components of vec4f
+VECTORCALL VECMATH_FINLINE vec4f v8_hmin(vec8f a);
+VECTORCALL VECMATH_FINLINE vec4f v8_hmax(vec8f a);
+
+//! component-wise comparison: .C = a.C OP b.C ? 0xFFFFFFFF : 0
+VECTORCALL VECMATH_FINLINE vec8f v8_cmp_eq(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_cmp_ge(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_cmp_gt(vec8f a, vec8f b);
+//! a & b, ~a & b, a | b, a ^ b
+VECTORCALL VECMATH_FINLINE vec8f v8_and(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_andnot(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_or(vec8f a, vec8f b);
+VECTORCALL VECMATH_FINLINE vec8f v8_xor(vec8f a, vec8f b);
+//! component-wise select: .C = c.C>=0 ? a.C : b.C
+VECTORCALL VECMATH_FINLINE vec8f v8_sel(vec8f a, vec8f b, vec8f c);
+//! return signbit mask of components, ith bit is ith float signbit
+VECTORCALL VECMATH_FINLINE int v8_signmask(vec8f a);
+//! transpose 4x4 matrices formed by components 0..3 and 4..7 of rows r0..r3
+VECTORCALL VECMATH_FINLINE void v8_transpose4(vec8f &r0, vec8f &r1, vec8f &r2, vec8f &r3);
+
+//! integer (a + b), (a - b), a & b, a | b, a ^ b
+VECTORCALL VECMATH_FINLINE vec8i v8_addi(vec8i a, vec8i b);
+VECTORCALL VECMATH_FINLINE vec8i v8_subi(vec8i a, vec8i b);
+VECTORCALL VECMATH_FINLINE vec8i v8_andi(vec8i a, vec8i b);
+VECTORCALL VECMATH_FINLINE vec8i v8_ori(vec8i a, vec8i b);
+VECTORCALL VECMATH_FINLINE vec8i v8_xori(vec8i a, vec8i b);
+//! shift left, shift right (unsigned), shift right (signed). bits is immediate value
+VECTORCALL VECMATH_FINLINE vec8i v8_slli(vec8i v, int bits);
+VECTORCALL VECMATH_FINLINE vec8i v8_srli(vec8i v, int bits);
+VECTORCALL VECMATH_FINLINE vec8i v8_srai(vec8i v, int bits);
+//! signed integer min/max
+VECTORCALL VECMATH_FINLINE vec8i v8_mini(vec8i a, vec8i b);
+VECTORCALL VECMATH_FINLINE vec8i v8_maxi(vec8i a, vec8i b);
+//! integer comparison: .C = a.C OP b.C ? 0xFFFFFFFF : 0
+VECTORCALL VECMATH_FINLINE vec8i v8_cmp_eqi(vec8i a, vec8i b);
+VECTORCALL VECMATH_FINLINE vec8i v8_cmp_gti(vec8i a, vec8i b);
+
+//! reinterpret bits
+VECTORCALL VECMATH_FINLINE vec8i v8_cast_vec8i(vec8f a);
+VECTORCALL VECMATH_FINLINE vec8f v8_cast_vec8f(vec8i a);
+//! convert to integer using round-to-zero mode
+VECTORCALL VECMATH_FINLINE vec8i v8_cvt_vec8i(vec8f a);
+//! round to nearest integer (result remains int)
+VECTORCALL VECMATH_FINLINE vec8i v8_cvt_roundi(vec8f a);
+//! convert to float
+VECTORCALL VECMATH_FINLINE vec8f v8_cvt_vec8f(vec8i a);
+
+//! same polynomials as v_exp2_est(), v_log2_est_p5() and v_pow_est()
+VECTORCALL VECMATH_INLINE vec8f v8_exp2_est(vec8f x);
+VECTORCALL VECMATH_INLINE vec8f v8_log2_est(vec8f x);
+VECTORCALL VECMATH_INLINE vec8f v8_pow_est(vec8f x, vec8f y);
+
+
+#if VECMATH_VEC8_NATIVE
+
+VECTORCALL VECMATH_FINLINE vec8f v8_zero() { return _mm256_setzero_ps(); }
+VECTORCALL VECMATH_FINLINE vec8i v8_zeroi() { return _mm256_setzero_si256(); }
+VECTORCALL VECMATH_FINLINE vec8f v8_splats(float a) { return _mm256_set1_ps(a); }
+VECTORCALL VECMATH_FINLINE vec8i v8_splatsi(int a) { return _mm256_set1_epi32(a); }
+VECTORCALL VECMATH_FINLINE vec8f v8_make_vec8f(vec4f lo, vec4f hi) { return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1); }
+VECTORCALL VECMATH_FINLINE vec8i v8_make_vec8i(vec4i lo, vec4i hi)
+{
+  return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+VECTORCALL VECMATH_FINLINE vec4f v8_get_lo(vec8f a) { return _mm256_castps256_ps128(a); }
+VECTORCALL VECMATH_FINLINE vec4f v8_get_hi(vec8f a) { return _mm256_extractf128_ps(a, 1); }
+VECTORCALL VECMATH_FINLINE vec4i v8_get_loi(vec8i a) { return _mm256_castsi256_si128(a); }
+VECTORCALL VECMATH_FINLINE vec4i v8_get_hii(vec8i a) { return _mm256_extractf128_si256(a, 1); }
+
+NO_ASAN_INLINE vec8f v8_ld(const float *m) { return _mm256_load_ps(m); }
+NO_ASAN_INLINE vec8i v8_ldi(const int *m) { return _mm256_load_si256((const __m256i *)m); }
+NO_ASAN_INLINE vec8f v8_ldu(const float *m) { return _mm256_loadu_ps(m); }
+NO_ASAN_INLINE vec8i v8_ldui(const int *m) { return _mm256_loadu_si256((const __m256i *)m); }
+VECTORCALL VECMATH_FINLINE void v8_st(void *m, vec8f v) { _mm256_store_ps((float *)m, v); }
+VECTORCALL VECMATH_FINLINE void v8_sti(void *m, vec8i v) { _mm256_store_si256((__m256i *)m, v); }
+VECTORCALL VECMATH_FINLINE void v8_stu(void *m, vec8f v) { _mm256_storeu_ps((float *)m, v); }
+VECTORCALL VECMATH_FINLINE void v8_stui(void *m, vec8i v) { _mm256_storeu_si256((__m256i *)m, v); }
+
+VECTORCALL VECMATH_FINLINE vec8f v8_add(vec8f a, vec8f b) { return _mm256_add_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_sub(vec8f a, vec8f b) { return _mm256_sub_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_mul(vec8f a, vec8f b) { return _mm256_mul_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_div(vec8f a, vec8f b) { return _mm256_div_ps(a, b); }
+#if defined(__FMA__) || defined(__AVX2__)
+VECTORCALL VECMATH_FINLINE vec8f v8_madd(vec8f a, vec8f b, vec8f c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+VECTORCALL VECMATH_FINLINE vec8f v8_madd(vec8f a, vec8f b, vec8f c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+VECTORCALL VECMATH_FINLINE vec8f v8_min(vec8f a, vec8f b) { return _mm256_min_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_max(vec8f a, vec8f b) { return _mm256_max_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_neg(vec8f a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.f)); }
+VECTORCALL VECMATH_FINLINE vec8f v8_abs(vec8f a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+VECTORCALL VECMATH_FINLINE vec8f v8_sqrt(vec8f a) { return _mm256_sqrt_ps(a); }
+VECTORCALL VECMATH_FINLINE vec8f v8_rcp_est(vec8f a) { return _mm256_rcp_ps(a); }
+
+VECTORCALL VECMATH_FINLINE vec8f v8_cmp_eq(vec8f a, vec8f b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+VECTORCALL VECMATH_FINLINE vec8f v8_cmp_ge(vec8f a, vec8f b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+VECTORCALL VECMATH_FINLINE vec8f v8_cmp_gt(vec8f a, vec8f b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+VECTORCALL VECMATH_FINLINE vec8f v8_and(vec8f a, vec8f b) { return _mm256_and_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_andnot(vec8f a, vec8f b) { return _mm256_andnot_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_or(vec8f a, vec8f b) { return _mm256_or_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_xor(vec8f a, vec8f b) { return _mm256_xor_ps(a, b); }
+VECTORCALL VECMATH_FINLINE vec8f v8_sel(vec8f a, vec8f b, vec8f c) { return _mm256_blendv_ps(a, b, c); }
+VECTORCALL VECMATH_FINLINE int v8_signmask(vec8f a) { return _mm256_movemask_ps(a); }
+VECTORCALL VECMATH_FINLINE void v8_transpose4(vec8f &r0, vec8f &r1, vec8f &r2, vec8f &r3)
+{
+  // unpack and shuffle work within 128-bit lanes, so it is two _MM_TRANSPOSE4_PS at once
+  vec8f t0 = _mm256_unpacklo_ps(r0, r1);
+  vec8f t1 = _mm256_unpacklo_ps(r2, r3);
+  vec8f t2 = _mm256_unpackhi_ps(r0, r1);
+  vec8f t3 = _mm256_unpackhi_ps(r2, r3);
+  r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+  r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+  r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+VECTORCALL VECMATH_FINLINE vec8i v8_cast_vec8i(vec8f a) { return _mm256_castps_si256(a); }
+VECTORCALL VECMATH_FINLINE vec8f v8_cast_vec8f(vec8i a) { return _mm256_castsi256_ps(a); }
+VECTORCALL VECMATH_FINLINE vec8i v8_cvt_vec8i(vec8f a) { return _mm256_cvttps_epi32(a); }
+VECTORCALL VECMATH_FINLINE vec8i v8_cvt_roundi(vec8f a) { return _mm256_cvtps_epi32(a); }
+VECTORCALL VECMATH_FINLINE vec8f v8_cvt_vec8f(vec8i a) { return _mm256_cvtepi32_ps(a); }
+
+#ifdef __AVX2__
+NO_ASAN_INLINE vec8i v8_ldui_u8(const uint8_t *m) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)m)); }
+VECTORCALL VECMATH_FINLINE vec8i v8_addi(vec8i a, vec8i b) { return _mm256_add_epi32(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_subi(vec8i a, vec8i b) { return _mm256_sub_epi32(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_andi(vec8i a, vec8i b) { return _mm256_and_si256(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_ori(vec8i a, vec8i b) { return _mm256_or_si256(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_xori(vec8i a, vec8i b) { return _mm256_xor_si256(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_slli(vec8i v, int bits) { return _mm256_slli_epi32(v, bits); }
+VECTORCALL VECMATH_FINLINE vec8i v8_srli(vec8i v, int bits) { return _mm256_srli_epi32(v, bits); }
+VECTORCALL VECMATH_FINLINE vec8i v8_srai(vec8i v, int bits) { return _mm256_srai_epi32(v, bits); }
+VECTORCALL VECMATH_FINLINE vec8i v8_mini(vec8i a, vec8i b) { return _mm256_min_epi32(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_maxi(vec8i a, vec8i b) { return _mm256_max_epi32(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_cmp_eqi(vec8i a, vec8i b) { return _mm256_cmpeq_epi32(a, b); }
+VECTORCALL VECMATH_FINLINE vec8i v8_cmp_gti(vec8i a, vec8i b) { return _mm256_cmpgt_epi32(a, b); }
+#else
+// AVX without AVX2 has no 256-bit integer ops, so they are done by 128-bit halves
+#define V8I_OP2(name, op4)                                                                      \
+  VECTORCALL VECMATH_FINLINE vec8i name(vec8i a, vec8i b)                                       \
+  {                                                                                             \
+    return v8_make_vec8i(op4(v8_get_loi(a), v8_get_loi(b)), op4(v8_get_hii(a), v8_get_hii(b))); \
+  }
+#define V8I_SHIFT(name, op4)                                                   \
+  VECTORCALL VECMATH_FINLINE vec8i name(vec8i v, int bits)                     \
+  {                                                                            \
+    return v8_make_vec8i(op4(v8_get_loi(v), bits), op4(v8_get_hii(v), bits)); \
+  }
+NO_ASAN_INLINE vec8i v8_ldui_u8(const uint8_t *m)
+{
+  vec4i s = v_cvt_byte_vec4i(v_ldui_half(m));
+  return v8_make_vec8i(v_cvt_lo_ush_vec4i(s), v_cvt_hi_ush_vec4i(s));
+}
+V8I_OP2(v8_addi, v_addi)
+V8I_OP2(v8_subi, v_subi)
+V8I_OP2(v8_andi, v_andi)
+V8I_OP2(v8_ori, v_ori)
+V8I_OP2(v8_xori, v_xori)
+V8I_SHIFT(v8_slli, v_slli)
+V8I_SHIFT(v8_srli, v_srli)
+V8I_SHIFT(v8_srai, v_srai)
+V8I_OP2(v8_mini, v_mini)
+V8I_OP2(v8_maxi, v_maxi)
+V8I_OP2(v8_cmp_eqi, v_cmp_eqi)
+V8I_OP2(v8_cmp_gti, v_cmp_gti)
+#undef V8I_OP2
+#undef V8I_SHIFT
+#endif // __AVX2__
+
+#else // !VECMATH_VEC8_NATIVE
+
+#define V8_OP1(type, name, op4) \
+  VECTORCALL VECMATH_FINLINE type name(type a) { return {op4(a.lo), op4(a.hi)}; }
+#define V8_OP2(type, name, op4) \
+  VECTORCALL VECMATH_FINLINE type name(type a, type b) { return {op4(a.lo, b.lo), op4(a.hi, b.hi)}; }
+#define V8_SHIFT(name, op4) \
+  VECTORCALL VECMATH_FINLINE vec8i name(vec8i v, int bits) { return {op4(v.lo, bits), op4(v.hi, bits)}; }
+
+VECTORCALL VECMATH_FINLINE vec8f v8_zero() { return {v_zero(), v_zero()}; }
+VECTORCALL VECMATH_FINLINE vec8i v8_zeroi() { return {v_zeroi(), v_zeroi()}; }
+VECTORCALL VECMATH_FINLINE vec8f v8_splats(float a)
+{
+  vec4f v = v_splats(a);
+  return {v, v};
+}
+VECTORCALL VECMATH_FINLINE vec8i v8_splatsi(int a)
+{
+  vec4i v = v_splatsi(a);
+  return {v, v};
+}
+VECTORCALL VECMATH_FINLINE vec8f v8_make_vec8f(vec4f lo, vec4f hi) { return {lo, hi}; }
+VECTORCALL VECMATH_FINLINE vec8i v8_make_vec8i(vec4i lo, vec4i hi) { return {lo, hi}; }
+VECTORCALL VECMATH_FINLINE vec4f v8_get_lo(vec8f a) { return a.lo; }
+VECTORCALL VECMATH_FINLINE vec4f v8_get_hi(vec8f a) { return a.hi; }
+VECTORCALL VECMATH_FINLINE vec4i v8_get_loi(vec8i a) { return a.lo; }
+VECTORCALL VECMATH_FINLINE vec4i v8_get_hii(vec8i a) { return a.hi; }
+
+NO_ASAN_INLINE vec8f v8_ld(const float *m) { return {v_ld(m), v_ld(m + 4)}; }
+NO_ASAN_INLINE vec8i v8_ldi(const int *m) { return {v_ldi(m), v_ldi(m + 4)}; }
+NO_ASAN_INLINE vec8f v8_ldu(const float *m) { return {v_ldu(m), v_ldu(m + 4)}; }
+NO_ASAN_INLINE vec8i v8_ldui(const int *m) { return {v_ldui(m), v_ldui(m + 4)}; }
+NO_ASAN_INLINE vec8i v8_ldui_u8(const uint8_t *m)
+{
+  vec4i s = v_cvt_byte_vec4i(v_ldui_half(m));
+  return {v_cvt_lo_ush_vec4i(s), v_cvt_hi_ush_vec4i(s)};
+}
+VECTORCALL VECMATH_FINLINE void v8_st(void *m, vec8f v)
+{
+  v_st(m, v.lo);
+  v_st((float *)m + 4, v.hi);
+}
+VECTORCALL VECMATH_FINLINE void v8_sti(void *m, vec8i v)
+{
+  v_sti(m, v.lo);
+  v_sti((int *)m + 4, v.hi);
+}
+VECTORCALL VECMATH_FINLINE void v8_stu(void *m, vec8f v)
+{
+  v_stu(m, v.lo);
+  v_stu((float *)m + 4, v.hi);
+}
+VECTORCALL VECMATH_FINLINE void v8_stui(void *m, vec8i v)
+{
+  v_stui(m, v.lo);
+  v_stui((int *)m + 4, v.hi);
+}
+
+V8_OP2(vec8f, v8_add, v_add)
+V8_OP2(vec8f, v8_sub, v_sub)
+V8_OP2(vec8f, v8_mul, v_mul)
+V8_OP2(vec8f, v8_div, v_div)
+VECTORCALL VECMATH_FINLINE vec8f v8_madd(vec8f a, vec8f b, vec8f c) { return {v_madd(a.lo, b.lo, c.lo), v_madd(a.hi, b.hi, c.hi)}; }
+V8_OP2(vec8f, v8_min, v_min)
+V8_OP2(vec8f, v8_max, v_max)
+V8_OP1(vec8f, v8_neg, v_neg)
+V8_OP1(vec8f, v8_abs, v_abs)
+V8_OP1(vec8f, v8_sqrt, v_sqrt4)
+V8_OP1(vec8f, v8_rcp_est, v_rcp_est)
+
+V8_OP2(vec8f, v8_cmp_eq, v_cmp_eq)
+V8_OP2(vec8f, v8_cmp_ge, v_cmp_ge)
+V8_OP2(vec8f, v8_cmp_gt, v_cmp_gt)
+V8_OP2(vec8f, v8_and, v_and)
+V8_OP2(vec8f, v8_andnot, v_andnot)
+V8_OP2(vec8f, v8_or, v_or)
+V8_OP2(vec8f, v8_xor, v_xor)
+VECTORCALL VECMATH_FINLINE vec8f v8_sel(vec8f a, vec8f b, vec8f c) { return {v_sel(a.lo, b.lo, c.lo), v_sel(a.hi, b.hi, c.hi)}; }
+VECTORCALL VECMATH_FINLINE int v8_signmask(vec8f a) { return v_signmask(a.lo) | (v_signmask(a.hi) << 4); }
+VECTORCALL VECMATH_FINLINE void v8_transpose4(vec8f &r0, vec8f &r1, vec8f &r2, vec8f &r3)
+{
+  v_mat44_transpose(r0.lo, r1.lo, r2.lo, r3.lo);
+  v_mat44_transpose(r0.hi, r1.hi, r2.hi, r3.hi);
+}
+
+V8_OP2(vec8i, v8_addi, v_addi)
+V8_OP2(vec8i, v8_subi, v_subi)
+V8_OP2(vec8i, v8_andi, v_andi)
+V8_OP2(vec8i, v8_ori, v_ori)
+V8_OP2(vec8i, v8_xori, v_xori)
+V8_SHIFT(v8_slli, v_slli)
+V8_SHIFT(v8_srli, v_srli)
+V8_SHIFT(v8_srai, v_srai)
+V8_OP2(vec8i, v8_mini, v_mini)
+V8_OP2(vec8i, v8_maxi, v_maxi)
+V8_OP2(vec8i, v8_cmp_eqi, v_cmp_eqi)
+V8_OP2(vec8i, v8_cmp_gti, v_cmp_gti)
+
+VECTORCALL VECMATH_FINLINE vec8i v8_cast_vec8i(vec8f a) { return {v_cast_vec4i(a.lo), v_cast_vec4i(a.hi)}; }
+VECTORCALL VECMATH_FINLINE vec8f v8_cast_vec8f(vec8i a) { return {v_cast_vec4f(a.lo), v_cast_vec4f(a.hi)}; }
+VECTORCALL VECMATH_FINLINE vec8i v8_cvt_vec8i(vec8f a) { return {v_cvt_vec4i(a.lo), v_cvt_vec4i(a.hi)}; }
+VECTORCALL VECMATH_FINLINE vec8i v8_cvt_roundi(vec8f a) { return {v_cvt_roundi(a.lo), v_cvt_roundi(a.hi)}; }
+VECTORCALL VECMATH_FINLINE vec8f v8_cvt_vec8f(vec8i a) { return {v_cvt_vec4f(a.lo), v_cvt_vec4f(a.hi)}; }
+
+#undef V8_OP1
+#undef V8_OP2
+#undef V8_SHIFT
+
+#endif // VECMATH_VEC8_NATIVE
+
+VECTORCALL VECMATH_FINLINE void v8_stui_packus_u8(void *m, vec8i v)
+{
+  v_stui_half(m, v_packus16(v_packs(v8_get_loi(v), v8_get_hii(v))));
+}
+VECTORCALL VECMATH_FINLINE vec4f v8_hmin(vec8f a) { return v_hmin(v_min(v8_get_lo(a), v8_get_hi(a))); }
+VECTORCALL VECMATH_FINLINE vec4f v8_hmax(vec8f a) { return v_hmax(v_max(v8_get_lo(a), v8_get_hi(a))); }
+
+VECTORCALL VECMATH_INLINE vec8f v8_exp2_est(vec8f x)
+{
+  x = v8_max(v8_min(x, v8_splats(129.00000f)), v8_splats(-126.99999f));
+  vec8i ipart = v8_cvt_roundi(v8_sub(x, v8_splats(0.5f)));
+  vec8f fpart = v8_sub(x, v8_cvt_vec8f(ipart));
+  vec8f expipart = v8_cast_vec8f(v8_slli(v8_addi(ipart, v8_splatsi(127)), 23));
+  vec8f expfpart = v8_madd(v8_splats(1.3534167e-2f), fpart, v8_splats(5.2011464e-2f));
+  expfpart = v8_madd(expfpart, fpart, v8_splats(2.4144275e-1f));
+  expfpart = v8_madd(expfpart, fpart, v8_splats(6.9300383e-1f));
+  expfpart = v8_madd(expfpart, fpart, v8_splats(1.0000026f));
+  return v8_mul(expipart, expfpart);
+}
+
+VECTORCALL VECMATH_INLINE vec8f v8_log2_est(vec8f x)
+{
+  vec8i i = v8_cast_vec8i(x);
+  vec8f e = v8_cvt_vec8f(v8_subi(v8_srli(v8_andi(i, v8_splatsi(0x7F800000)), 23), v8_splatsi(127)));
+  vec8f m = v8_or(v8_cast_vec8f(v8_andi(i, v8_splatsi(0x007FFFFF))), v8_splats(1.f));
+  vec8f p = v8_madd(v8_splats(-3.4436006e-2f), m, v8_splats(3.1821337e-1f));
+  p = v8_madd(p, m, v8_splats(-1.2315303f));
+  p = v8_madd(p, m, v8_splats(2.5988452f));
+  p = v8_madd(p, m, v8_splats(-3.3241990f));
+  p = v8_madd(p, m, v8_splats(3.1157899f));
+  // multiplying by (m - 1) ensures that log2(1) == 0
+  return v8_madd(p, v8_sub(m, v8_splats(1.f)), e);
+}
+
+VECTORCALL VECMATH_INLINE vec8f v8_pow_est(vec8f x, vec8f y) { return v8_exp2_est(v8_mul(v8_log2_est(x), y)); }
+
+} // namespace VECMATH_VEC8_NAMESPACE
@@ -0,0 +1,248 @@
+/**
+ @file  batch.c
+ @brief dagor - batched datagram I/O (recvmmsg/sendmmsg), lets host send/receive many datagrams with one syscall
+*/
+#if _TARGET_PC_LINUX && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE 1 // recvmmsg/sendmmsg
+#endif
+
+#include <string.h>
+
+#define ENET_BUILDING_LIB 1
+#include "enet/enet.h"
+
+#if _TARGET_PC_LINUX
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+
+#define UDP_HEADER_SIZE 28
+extern size_t enet_rx_bytes, enet_rx_packets;
+extern size_t enet_tx_bytes, enet_tx_dropped_bytes, enet_tx_packets;
+
+struct _ENetSocketBatch
+{
+    size_t capacity;
+
+    size_t rxCount, rxNext;                 /**< number of datagrams received by last recvmmsg and index of next one to return */
+    struct mmsghdr * rxMsgs;
+    struct iovec * rxIov;
+    struct sockaddr_in * rxAddr;
+    enet_uint8 * rxData;
+
+    size_t txCount;                         /**< number of datagrams queued for next sendmmsg */
+    struct mmsghdr * txMsgs;
+    struct iovec * txIov;
+    struct sockaddr_in * txAddr;
+    enet_uint8 * txData;
+};
+
+ENetSocketBatch *
+enet_socket_batch_create (size_t capacity)
+{
+    ENetSocketBatch * batch;
+    size_t dirSize = sizeof (struct mmsghdr) + sizeof (struct iovec) + sizeof (struct sockaddr_in);
+    enet_uint8 * mem;
+
+    if (capacity <= 1)
+      return NULL;
+
+    // headers of both directions are placed after batch struct, data buffers after them (both are pointer-aligned)
+    mem = (enet_uint8 *) enet_malloc (sizeof (ENetSocketBatch) + capacity * 2 * (dirSize + ENET_PROTOCOL_MAXIMUM_MTU));
+    if (mem == NULL)
+      return NULL;
+
+    batch = (ENetSocketBatch *) mem;
+    memset (batch, 0, sizeof (ENetSocketBatch) + capacity * 2 * dirSize);
+    batch -> capacity = capacity;
+
+    mem += sizeof (ENetSocketBatch);
+    batch -> rxMsgs = (struct mmsghdr *) mem;              mem += capacity * sizeof (struct mmsghdr);
+    batch -> txMsgs = (struct mmsghdr *) mem;              mem += capacity * sizeof (struct mmsghdr);
+    batch -> rxIov = (struct iovec *) mem;                 mem += capacity * sizeof (struct iovec);
+    batch -> txIov = (struct iovec *) mem;                 mem += capacity * sizeof (struct iovec);
+    batch -> rxAddr = (struct sockaddr_in *) mem;          mem += capacity * sizeof (struct sockaddr_in);
+    batch -> txAddr = (struct sockaddr_in *) mem;          mem += capacity * sizeof (struct sockaddr_in);
+    batch -> rxData = mem;                                 mem += capacity * ENET_PROTOCOL_MAXIMUM_MTU;
+    batch -> txData = mem;
+
+    return batch;
+}
+
+void
+enet_socket_batch_destroy (ENetSocketBatch * batch)
+{
+    if (batch != NULL)
+      enet_free (batch);
+}
+
+int
+enet_socket_batch_receive_impl (ENetSocket socket, ENetSocketBatch * batch, ENetAddress * address, enet_uint8 ** data)
+{
+    struct mmsghdr * msg;
+    size_t i;
+
+    if (batch -> rxNext >= batch -> rxCount)
+    {
+        int received;
+
+        batch -> rxNext = batch -> rxCount = 0;
+        for (i = 0; i < batch -> capacity; ++ i)
+        {
+            msg = & batch -> rxMsgs [i];
+            batch -> rxIov [i].iov_base = batch -> rxData + i * ENET_PROTOCOL_MAXIMUM_MTU;
+            batch -> rxIov [i].iov_len = ENET_PROTOCOL_MAXIMUM_MTU;
+            msg -> msg_hdr.msg_name = & batch -> rxAddr [i];
+            msg -> msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+            msg -> msg_hdr.msg_iov = & batch -> rxIov [i];
+            msg -> msg_hdr.msg_iovlen = 1;
+            msg -> msg_hdr.msg_flags = 0;
+            msg -> msg_len = 0;
+        }
+
+        received = recvmmsg (socket, batch -> rxMsgs, (unsigned int) batch -> capacity, MSG_DONTWAIT, NULL);
+        if (received < 0)
+          return (errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+        batch -> rxCount = (size_t) received;
+        if (received == 0)
+          return 0;
+    }
+
+    i = batch -> rxNext ++;
+    msg = & batch -> rxMsgs [i];
+
+    if (msg -> msg_hdr.msg_flags & MSG_TRUNC)
+      return -1;
+
+    if (address != NULL)
+    {
+        address -> host = (enet_uint32) batch -> rxAddr [i].sin_addr.s_addr;
+        address -> port = ENET_NET_TO_HOST_16 (batch -> rxAddr [i].sin_port);
+    }
+    * data = batch -> rxData + i * ENET_PROTOCOL_MAXIMUM_MTU;
+
+    enet_rx_bytes += msg -> msg_len + UDP_HEADER_SIZE;
+    enet_rx_packets++;
+
+    return (int) msg -> msg_len;
+}
+
+int
+enet_socket_batch_send (ENetSocket socket, ENetSocketBatch * batch, const ENetAddress * address, const ENetBuffer * buffers, size_t bufferCount)
+{
+    struct mmsghdr * msg;
+    enet_uint8 * dst;
+    size_t i, length = 0;
+
+    if (batch -> txCount >= batch -> capacity && enet_socket_batch_flush (socket, batch) < 0)
+      return -1;
+
+    for (i = 0; i < bufferCount; ++ i)
+      length += buffers [i].dataLength;
+    if (length > ENET_PROTOCOL_MAXIMUM_MTU) // never happens for enet protocol datagrams, but let's not corrupt slots
+      return enet_socket_send (socket, address, buffers, bufferCount);
+
+    dst = batch -> txData + batch -> txCount * ENET_PROTOCOL_MAXIMUM_MTU;
+    for (i = 0; i < bufferCount; ++ i)
+    {
+        memcpy (dst, buffers [i].data, buffers [i].dataLength);
+        dst += buffers [i].dataLength;
+    }
+
+    i = batch -> txCount ++;
+    msg = & batch -> txMsgs [i];
+    memset (msg, 0, sizeof (struct mmsghdr));
+    batch -> txIov [i].iov_base = batch -> txData + i * ENET_PROTOCOL_MAXIMUM_MTU;
+    batch -> txIov [i].iov_len = length;
+    msg -> msg_hdr.msg_iov = & batch -> txIov [i];
+    msg -> msg_hdr.msg_iovlen = 1;
+
+    if (address != NULL)
+    {
+        memset (& batch -> txAddr [i], 0, sizeof (struct sockaddr_in));
+        batch -> txAddr [i].sin_family = AF_INET;
+        batch -> txAddr [i].sin_port = ENET_HOST_TO_NET_16 (address -> port);
+        batch -> txAddr [i].sin_addr.s_addr = address -> host;
+
+        msg -> msg_hdr.msg_name = & batch -> txAddr [i];
+        msg -> msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+    }
+
+    // datagram is only queued here, so report it as sent; actual send errors are reported by enet_socket_batch_flush()
+    return (int) length;
+}
+
+int
+enet_socket_batch_flush (ENetSocket socket, ENetSocketBatch * batch)
+{
+    size_t sent = 0, i;
+    int result = 0;
+
+    while (sent < batch -> txCount)
+    {
+        int count = sendmmsg (socket, batch -> txMsgs + sent, (unsigned int) (batch -> txCount - sent), MSG_NOSIGNAL);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+              continue;
+            if (errno == EWOULDBLOCK) // socket buffer is full, rest of datagrams would fail the same way
+            {
+                for (i = sent; i < batch -> txCount; ++ i)
+                  enet_tx_dropped_bytes += batch -> txIov [i].iov_len;
+                break;
+            }
+            // skip datagram that failed (same as enet_socket_send() would do) and go on with the rest;
+            // EPERM might get reported if packet was dropped by firewall (e.g. for debug purposes)
+            enet_tx_dropped_bytes += batch -> txIov [sent].iov_len;
+            if (errno != EPERM)
+              result = -1;
+            ++ sent;
+            continue;
+        }
+
+        for (i = sent; i < sent + (size_t) count; ++ i)
+          enet_tx_bytes += batch -> txMsgs [i].msg_len + UDP_HEADER_SIZE;
+        enet_tx_packets += (size_t) count;
+        sent += (size_t) count;
+    }
+
+    batch -> txCount = 0;
+
+    return result;
+}
+
+#else // batching is not supported, host keeps using per-datagram enet_socket_send/enet_socket_receive
+
+ENetSocketBatch *
+enet_socket_batch_create (size_t capacity)
+{
+    return NULL;
+}
+
+void
+enet_socket_batch_destroy (ENetSocketBatch * batch)
+{
+}
+
+int
+enet_socket_batch_receive_impl (ENetSocket socket, ENetSocketBatch * batch, ENetAddress * address, enet_uint8 ** data)
+{
+    return -1;
+}
+
+int
+enet_socket_batch_send (ENetSocket socket, ENetSocketBatch * batch, const ENetAddress * address, const ENetBuffer * buffers, size_t bufferCount)
+{
+    return enet_socket_send (socket, address, buffers, bufferCount);
+}
+
+int
+enet_socket_batch_flush (ENetSocket socket, ENetSocketBatch * batch)
+{
+    return 0;
+}
+
+#endif
@@ -29,6 +29,16 @@
 */
 ENetHost *
 enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelLimit, enet_uint32 incomingBandwidth, enet_uint32 outgoingBandwidth)
+{
+    return enet_host_create_ex (address, peerCount, channelLimit, incomingBandwidth, outgoingBandwidth, 0);
+}
+
+/** dagor - same as enet_host_create(), with additional ENetHostFlag flags applied to socket before it is bound.
+
+    @param flags combination of ENetHostFlag values; returns NULL if requested flag is not supported by platform
+*/
+ENetHost *
+enet_host_create_ex (const ENetAddress * address, size_t peerCount, size_t channelLimit, enet_uint32 incomingBandwidth, enet_uint32 outgoingBandwidth, enet_uint32 flags)
 {
     ENetHost * host;
     ENetPeer * currentPeer;
@@ -51,7 +61,9 @@ enet_host_create (const ENetAddress * address, size_t peerCount, size_t channelL
     memset (host -> peers, 0, peerCount * sizeof (ENetPeer));
 
     host -> socket = enet_socket_create (ENET_SOCKET_TYPE_DATAGRAM);
-    if (host -> socket == ENET_SOCKET_NULL || (address != NULL && enet_socket_bind (host -> socket, address) < 0))
+    if (host -> socket == ENET_SOCKET_NULL ||
+        ((flags & ENET_HOST_FLAG_REUSEPORT) && enet_socket_set_option (host -> socket, ENET_SOCKOPT_REUSEPORT, 1) < 0) ||
+        (address != NULL && enet_socket_bind (host -> socket, address) < 0))
     {
        if (host -> socket != ENET_SOCKET_NULL)
          enet_socket_destroy (host -> socket);
@@ -160,10 +172,40 @@ enet_host_destroy (ENetHost * host)
     if (host -> compressor.context != NULL && host -> compressor.destroy)
       (* host -> compressor.destroy) (host -> compressor.context);
 
+    enet_socket_batch_destroy (host -> batch);
+
     enet_free (host -> peers);
     enet_free (host);
 }
 
+/** dagor - enables (or disables when maxDatagrams <= 1) batched datagram I/O for host: incoming datagrams are read
+    with one syscall per up to maxDatagrams datagrams and outgoing ones are sent with one syscall per enet_host_service()/enet_host_flush().
+
+    @returns 0 on success, -1 if batching is not supported by platform (host keeps using per-datagram I/O then)
+    @remarks intended to be called right after host creation; received but not yet processed datagrams of previous batch are dropped
+*/
+int
+enet_host_set_batching (ENetHost * host, size_t maxDatagrams)
+{
+    ENetSocketBatch * batch = NULL;
+
+    if (maxDatagrams > 1)
+    {
+       batch = enet_socket_batch_create (maxDatagrams);
+       if (batch == NULL)
+         return -1;
+    }
+
+    if (host -> batch != NULL)
+    {
+       enet_socket_batch_flush (host -> socket, host -> batch);
+       enet_socket_batch_destroy (host -> batch);
+    }
+    host -> batch = batch;
+
+    return 0;
+}
+
 enet_uint32
 enet_host_random (ENetHost * host)
 {
@@ -66,7 +66,8 @@ typedef enum _ENetSocketOption
    ENET_SOCKOPT_SNDTIMEO  = 7,
    ENET_SOCKOPT_ERROR     = 8,
    ENET_SOCKOPT_NODELAY   = 9,
-   ENET_SOCKOPT_DONTFRAG  = 10
+   ENET_SOCKOPT_DONTFRAG  = 10,
+   ENET_SOCKOPT_REUSEPORT = 11  // dagor - must be set before bind, see ENET_HOST_FLAG_REUSEPORT
 } ENetSocketOption;
 
 typedef enum _ENetSocketShutdown
@@ -410,8 +411,15 @@ typedef struct _ENetHost
    size_t               duplicatePeers;              /**< optional number of allowed peers from duplicate IPs, defaults to ENET_PROTOCOL_MAXIMUM_PEER_ID */
    size_t               maximumPacketSize;           /**< the maximum allowable packet size that may be sent or received on a peer */
    size_t               maximumWaitingData;          /**< the maximum aggregate amount of buffer space a peer may use waiting for packets to be delivered */
+   struct _ENetSocketBatch * batch;                  /**< dagor - optional batched datagram I/O state, see enet_host_set_batching() */
 } ENetHost;
 
+/** dagor - flags for enet_host_create_ex() */
+typedef enum _ENetHostFlag
+{
+   ENET_HOST_FLAG_REUSEPORT = (1 << 0) /**< bind socket with SO_REUSEPORT, so several hosts (e.g. one per thread) may share one port */
+} ENetHostFlag;
+
 /**
  * An ENet event type, as specified in @ref ENetEvent.
  */
@@ -516,6 +524,15 @@ ENET_API int        enet_socket_send (ENetSocket, const ENetAddress *, const ENe
 ENET_API int        enet_socket_receive (ENetSocket, ENetAddress *, ENetBuffer *, size_t);
 ENET_API int        enet_socket_wait (ENetSocket, enet_uint32 *, enet_uint32);
 ENET_API int        enet_socket_set_option (ENetSocket, ENetSocketOption, int);
+//== dagor start
+/* Batched datagram I/O (recvmmsg/sendmmsg); enet_socket_batch_create() returns NULL where it is not supported */
+typedef struct _ENetSocketBatch ENetSocketBatch;
+ENET_API ENetSocketBatch * enet_socket_batch_create (size_t);
+ENET_API void       enet_socket_batch_destroy (ENetSocketBatch *);
+ENET_API int        enet_socket_batch_receive (ENetSocket, ENetSocketBatch *, ENetAddress *, enet_uint8 **);
+ENET_API int        enet_socket_batch_send (ENetSocket, ENetSocketBatch *, const ENetAddress *, const ENetBuffer *, size_t);
+ENET_API int        enet_socket_batch_flush (ENetSocket, ENetSocketBatch *);
+//== dagor end
 ENET_API int        enet_socket_get_option (ENetSocket, ENetSocketOption, int *);
 ENET_API int        enet_socket_shutdown (ENetSocket, ENetSocketShutdown);
 ENET_API void       enet_socket_destroy (ENetSocket);
@@ -564,7 +581,9 @@ ENET_API int          enet_packet_resize  (ENetPacket *, size_t);
 ENET_API enet_uint32  ENET_CALLBACK enet_crc32 (const ENetBuffer *, size_t);
                 
 ENET_API ENetHost * enet_host_create (const ENetAddress *, size_t, size_t, enet_uint32, enet_uint32);
+ENET_API ENetHost * enet_host_create_ex (const ENetAddress *, size_t, size_t, enet_uint32, enet_uint32, enet_uint32);
 ENET_API void       enet_host_destroy (ENetHost *);
+ENET_API int        enet_host_set_batching (ENetHost *, size_t);
 ENET_API ENetPeer * enet_host_connect (ENetHost *, const ENetAddress *, size_t, enet_uint32);
 ENET_API int        enet_host_check_events (ENetHost *, ENetEvent *);
 ENET_API int        enet_host_service (ENetHost *, ENetEvent *, enet_uint32);
@@ -1262,14 +1262,18 @@ enet_protocol_receive_incoming_commands (ENetHost * host, ENetEvent * event)
     {
        int receivedLength;
        ENetBuffer buffer;
+       enet_uint8 * receivedData = host -> packetData [0];
 
        buffer.data = host -> packetData [0];
        buffer.dataLength = sizeof (host -> packetData [0]);
 
-       receivedLength = enet_socket_receive (host -> socket,
-                                             & host -> receivedAddress,
-                                             & buffer,
-                                             1);
+       if (host -> batch != NULL) // dagor - datagram is left in batch buffer, it's valid until next batch receive
+         receivedLength = enet_socket_batch_receive (host -> socket, host -> batch, & host -> receivedAddress, & receivedData);
+       else
+         receivedLength = enet_socket_receive (host -> socket,
+                                               & host -> receivedAddress,
+                                               & buffer,
+                                               1);
 
        if (receivedLength < 0)
          return -1;
@@ -1277,7 +1281,7 @@ enet_protocol_receive_incoming_commands (ENetHost * host, ENetEvent * event)
        if (receivedLength == 0)
          return 0;
 
-       host -> receivedData = host -> packetData [0];
+       host -> receivedData = receivedData;
        host -> receivedDataLength = receivedLength;
       
        host -> totalReceivedData += receivedLength;
@@ -1680,7 +1684,7 @@ enet_protocol_send_reliable_outgoing_commands (ENetHost * host, ENetPeer * peer)
 }
 
 static int
-enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int checkForTimeouts)
+enet_protocol_send_outgoing_commands_impl (ENetHost * host, ENetEvent * event, int checkForTimeouts)
 {
     enet_uint8 headerData [sizeof (ENetProtocolHeader) + sizeof (enet_uint32)];
     ENetProtocolHeader * header = (ENetProtocolHeader *) headerData;
@@ -1846,7 +1850,10 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
 
         currentPeer -> lastSendTime = host -> serviceTime;
 
-        sentLength = enet_socket_send (host -> socket, & currentPeer -> address, host -> buffers, host -> bufferCount);
+        if (host -> batch != NULL) // dagor - datagram is copied to batch, so it's safe to release sent commands right away
+          sentLength = enet_socket_batch_send (host -> socket, host -> batch, & currentPeer -> address, host -> buffers, host -> bufferCount);
+        else
+          sentLength = enet_socket_send (host -> socket, & currentPeer -> address, host -> buffers, host -> bufferCount);
 
         enet_protocol_remove_sent_unreliable_commands (currentPeer);
 
@@ -1860,6 +1867,19 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
     return 0;
 }
 
+//== dagor start
+static int
+enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int checkForTimeouts)
+{
+    int result = enet_protocol_send_outgoing_commands_impl (host, event, checkForTimeouts);
+
+    if (host -> batch != NULL && enet_socket_batch_flush (host -> socket, host -> batch) < 0 && result == 0)
+      result = -1;
+
+    return result;
+}
+//== dagor end
+
 /** Sends any queued packets on the host specified to its designated peers.
 
     @param host   host to flush
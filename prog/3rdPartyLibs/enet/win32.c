@@ -231,6 +231,12 @@ enet_socket_set_option (ENetSocket socket, ENetSocketOption option, int value)
             result = setsockopt (socket, IPPROTO_IP, IP_DONTFRAGMENT, (char *) & value, sizeof (int));
             break;
 
+//== dagor start
+        case ENET_SOCKOPT_REUSEPORT: // no SO_REUSEPORT (SO_REUSEADDR doesn't distribute datagrams between sockets), fail
+            result = SOCKET_ERROR;
+            break;
+//== dagor end
+
         default:
             break;
     }
@@ -13,6 +13,17 @@
 typedef int (*debug_override_timestamp_cb_t)(char *dest, int dest_sz, int64_t t_msec);
 typedef int (*debug_log_callback_t)(int lev_tag, const char *fmt, const void *arg, int anum, const char *ctx_file, int ctx_line);
 
+//! parameters of asynchronous logging mode, see debug_enable_async_mode()
+struct DebugAsyncLogParams
+{
+  int threadBufSize = 64 << 10; //< size of per-thread buffer of packed messages; messages that don't fit are dropped and counted
+  int writerPeriodMs = 20;      //< writer thread wakes up at least that often (and when any thread buffer gets half full)
+  int flushPeriodMs = 1000;     //< log files are flushed that often (or after each write when debug_flush(true) was requested)
+  unsigned rotateSize = 0;      //< when non-zero, debug file is rotated when its size exceeds this value (PC only)
+  int rotateKeepFiles = 4;      //< count of rotated files kept (debug.1 is the newest one)
+  void (*onRotated)(const char *rotated_fname) = nullptr; //< called on writer thread for each rotated file (e.g. to compress it)
+};
+
 #if DAGOR_DBGLEVEL > 0 || DAGOR_FORCE_LOGS
 KRNLIMP const char *get_log_directory();
 KRNLIMP const char *get_log_filename();
@@ -32,6 +43,16 @@ KRNLIMP void debug_enable_thread_ids(bool en_tid);
 KRNLIMP void debug_set_thread_name(const char *persistent_thread_name_ptr);
 KRNLIMP void debug_override_log_timestamp_format(debug_override_timestamp_cb_t);
 KRNLIMP debug_log_callback_t debug_set_log_callback(debug_log_callback_t cb);
+
+//! switches to asynchronous logging: messages are packed (format string and copies of args, without formatting) to per-thread
+//! lock-free buffers and are formatted and written by background thread; fatal messages are still written synchronously.
+//! flush_debug_file() (called on crash too) and tail_debug_file() write all pending messages first
+KRNLIMP void debug_enable_async_mode(const DebugAsyncLogParams &params = {});
+//! writes all pending messages, stops writer thread and switches back to synchronous logging
+KRNLIMP void debug_disable_async_mode();
+KRNLIMP bool debug_is_async_mode();
+//! total count of messages dropped due to full thread buffers
+KRNLIMP int64_t debug_get_async_dropped_count();
 #else
 inline const char *get_log_directory() { return ""; }
 inline const char *get_log_filename() { return ""; }
@@ -45,6 +66,10 @@ inline void debug_enable_thread_ids(bool) {}
 inline void debug_set_thread_name(const char *) {}
 inline void debug_override_log_timestamp_format(debug_override_timestamp_cb_t) {}
 inline debug_log_callback_t debug_set_log_callback(debug_log_callback_t) { return NULL; }
+inline void debug_enable_async_mode(const DebugAsyncLogParams & = {}) {}
+inline void debug_disable_async_mode() {}
+inline bool debug_is_async_mode() { return false; }
+inline int64_t debug_get_async_dropped_count() { return 0; }
 #endif
 
 #include <supp/dag_undef_COREIMP.h>
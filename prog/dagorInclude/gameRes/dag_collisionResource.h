@@ -99,6 +99,7 @@ enum CollisionResourceFlags : uint32_t
   COLLISION_RES_FLAG_REUSE_TRACE_FRT = 1 << 4,
   COLLISION_RES_FLAG_HAS_TRACE_FRT = 1 << 5,
   COLLISION_RES_FLAG_HAS_COLL_FRT = 1 << 6,
+  COLLISION_RES_FLAG_HAS_NODE_BVH = 1 << 7,
 };
 
 struct CollisionUserData;
@@ -109,6 +110,25 @@ using CollisionNodeMask = eastl::bitvector<framemem_allocator>;
 struct CollisionTrace;
 struct ProfileStats;
 
+// Node of compact BVH over triangles of big mesh node (see CollisionResource::buildNodesBVH). Box is quantized to 16 bits within
+// mesh node modelBBox, first child of inner node immediately follows it, leaf references consecutive triangles of mesh node
+struct CollisionBVHNode
+{
+  static constexpr int LEAF_TRIANGLES = 4;
+  static constexpr int MIN_TRIANGLES = 64; // smaller nodes are traced fast enough with batched bbox check
+  static constexpr int MAX_DEPTH = 32;
+  static constexpr float QUANT_MAX = 65535.f;
+
+  uint16_t bmin[3];
+  uint16_t bmax[3];
+  uint32_t data; // leaf: first triangle << 3 | triangles count, inner: second child index << 3
+
+  bool isLeaf() const { return (data & 7) != 0; }
+  uint32_t getTrianglesCount() const { return data & 7; }
+  uint32_t getFirstTriangle() const { return data >> 3; }
+  uint32_t getSecondChild() const { return data >> 3; }
+};
+
 struct CollisionNode
 {
   struct UserData
@@ -160,6 +180,7 @@ struct CollisionNode
   BSphere3 boundingSphere;
   float cachedMaxTmScale = 1.f;
   SmallTab<plane3f, MidmemAlloc> convexPlanes;
+  SmallTab<CollisionBVHNode, MidmemAlloc> bvh; // optional, for big mesh nodes only
 
   dag::Span<Point3_vec4> vertices;
   dag::Span<uint16_t> indices;
@@ -278,6 +299,7 @@ public:
   virtual void load(IGenLoad & cb, int res_id);
 
   void collapseAndOptimize(bool need_frt = false, bool frt_build_fast = true);
+  void buildNodesBVH(); //< build BVH for mesh nodes with many triangles (reorders their triangles), it is done by collapseAndOptimize
 
   CollisionNode *getNode(uint32_t index);
   const CollisionNode *getNode(uint32_t index) const;
@@ -539,6 +561,13 @@ private:
   VECTORCALL DAGOR_NOINLINE static bool rayHitMeshNodeLocalCullCCW_AVX256(const CollisionNode &node, const vec4f &v_local_from,
     const vec4f &v_local_dir, float in_t);
 
+  VECTORCALL DAGOR_NOINLINE static bool traceRayMeshNodeBVHLocalCullCCW(const CollisionNode &node, vec4f v_local_from,
+    vec4f v_local_dir, float &in_out_t, vec4f *v_out_norm);
+  VECTORCALL DAGOR_NOINLINE static bool rayHitMeshNodeBVHLocalCullCCW(const CollisionNode &node, vec4f v_local_from, vec4f v_local_dir,
+    float in_t);
+  VECTORCALL DAGOR_NOINLINE static bool traceRayMeshNodeBVHLocalAllHits(const CollisionNode &node, vec4f v_local_from,
+    vec4f v_local_dir, float in_t, bool calc_normal, bool no_cull, all_nodes_ret_t &ret_array);
+
   VECTORCALL DAGOR_NOINLINE bool capsuleHitMeshNodeLocalCullCCW(const CollisionNode &node, vec4f v_local_from, vec4f v_local_dir,
     float in_t, float radius) const;
 
@@ -64,6 +64,10 @@ public:
   // Initial reference counter is zero.
   virtual void loadGameResourceData(int res_id, IGenLoad &cb) = 0;
 
+  // Returns true when loadGameResourceData() may be called from worker threads concurrently (for different res_id)
+  // without gameres locks held by caller; such factories are fed directly by load_game_resource_packs_mt() jobs.
+  virtual bool isLoadDataThreadSafe() { return false; }
+
   // Create specified GameResource from provided data.
   // Called while loading resource pack.
   // Initial reference counter is zero.
@@ -124,6 +124,12 @@ void load_game_resource_pack_by_name(const char *fname, bool only_one_gameres_pa
 
 bool is_game_resource_pack_loaded(const char *fname);
 
+// Load all resource packs that contain listed resources (and resources they reference) using threadpool workers:
+// GRPs are read concurrently, data for thread-safe factories is loaded in workers, resources of each GRP are created
+// as soon as it and GRPs it references are loaded (referenced packs first). Returns number of GRPs loaded.
+// NOTE: falls back to serial loading when gameres hooks are set or one-pack loading is restricted.
+int load_game_resource_packs_mt(dag::ConstSpan<const char *> res_names);
+
 inline void enable_gameres_pack_loading(bool) {} // Legacy API. Now gameres pack loading is always on
 
 // enabled finer res loading (allowing fiber/thread switches after each resource, not only after GRP); disabled by default
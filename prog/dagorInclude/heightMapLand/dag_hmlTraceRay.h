@@ -178,6 +178,129 @@ inline bool trace_ray_midpoint_heightmap(const HM &heightmap, const Point3 &pt_,
   return wasHit;
 }
 
+// Same as trace_ray_midpoint_heightmap (any_hit=false) or ray_hit_midpoint_heightmap (any_hit=true), but skips empty space
+// using hierarchical height ranges of CompressedHeightmap (HeightRangeBlock levels, see dag_compressedHeightmap.h).
+// Ray is marched through range nodes, descending only into nodes whose min/max range overlaps ray's height span,
+// and cells are traced only inside overlapping nodes of the finest level. Long grazing rays skip most of the cells.
+// Falls back to cell-by-cell tracing if heightmap has no hierarchy (or it is not square).
+//
+// Class HM must additionally implement following methods:
+// const CompressedHeightmap &getCompressedData();
+// real getHeightMin();
+// real getHeightScaleRaw();
+template <bool any_hit, class HM>
+inline bool trace_ray_midpoint_heightmap_hier(const HM &heightmap, const Point3 &pt_, const Point3 &dir, real &mint_, Point3 *normal,
+  bool cull = true)
+{
+  const auto &hier = heightmap.getCompressedData();
+  const int levels = hier.htRangeBlocksLevels;
+  const int hmapW = heightmap.getHeightmapSizeX(), hmapH = heightmap.getHeightmapSizeY();
+  if (!levels || hier.getW() != hier.getH() || hier.getW() != hmapW || hier.getH() != hmapH)
+    return trace_ray_midpoint_heightmap(heightmap, pt_, dir, mint_, normal, cull);
+
+  float rayTBoxMin = 0;
+  bbox3f worldBox = HmapGetMinMax<HM>::getWorldBox(heightmap);
+  float minMaxT[2], mint = mint_;
+  vec3f rayStart = v_ldu(&pt_.x), rayDir = v_ldu(&dir.x);
+  bbox3f rayBox;
+  v_bbox3_init_by_ray(rayBox, rayStart, rayDir, v_splats(mint));
+  if (!v_bbox3_test_box_inside(worldBox, rayBox))
+  {
+    v_stu_half(minMaxT, v_ray_box_intersect_dist(worldBox.bmin, worldBox.bmax, rayStart, rayDir, v_zero()));
+    if (minMaxT[0] > mint || minMaxT[0] > minMaxT[1])
+      return false;
+    // ray intersects box if tmax >= max(ray.tmin, tmin) && tmin <= ray.tmax
+    rayTBoxMin = max(minMaxT[0] - 1e-3f, 0.f);
+    mint = min(mint, minMaxT[1] + 1e-3f) - rayTBoxMin;
+  }
+  const Point3 pt = pt_ + dir * rayTBoxMin - heightmap.getHeightmapOffset();
+  const float cellSize = heightmap.getHeightmapCellSize();
+  const float hScaleRaw = heightmap.getHeightScaleRaw(), hMin = heightmap.getHeightMin();
+  // one raw unit of safety, so rounding in ray heights can't cull a node which is touched by ray
+  const float rangeEps = hScaleRaw;
+
+  // per axis: 1/dir (0 for axis-parallel rays) and which side of node/cell is exit side
+  const bool hasX = fabsf(dir.x) > 1e-6f, hasZ = fabsf(dir.z) > 1e-6f;
+  const double invDirX = hasX ? 1.0 / dir.x : 0, invDirZ = hasZ ? 1.0 / dir.z : 0;
+  const int exitX = dir.x >= 0 ? 1 : 0, exitZ = dir.z >= 0 ? 1 : 0;
+  // nudge to pick node ray is going into, when we are exactly on its boundary
+  const float nudgeX = dir.x >= 0 ? 1e-3f : -1e-3f, nudgeZ = dir.z >= 0 ? 1e-3f : -1e-3f;
+
+  bool wasHit = false;
+  float t = 0;
+  int lev = 1; // range grid of level 'lev' has (1<<lev)^2 nodes, each is stored in HeightRangeBlock of level lev-1
+  while (t < mint)
+  {
+    const float nodeSize = cellSize * (hmapW >> lev);
+    const int nodeX = (int)floorf((pt.x + dir.x * t) / nodeSize + nudgeX), nodeZ = (int)floorf((pt.z + dir.z * t) / nodeSize + nudgeZ);
+    double nodeExitT = mint;
+    if (hasX)
+      nodeExitT = min(nodeExitT, ((nodeX + exitX) * double(nodeSize) - pt.x) * invDirX);
+    if (hasZ)
+      nodeExitT = min(nodeExitT, ((nodeZ + exitZ) * double(nodeSize) - pt.z) * invDirZ);
+    float exitT = max((float)nodeExitT, t + cellSize * 1e-3f); // always progress
+
+    const int res = 1 << lev;
+    if (uint32_t(nodeX) >= res || uint32_t(nodeZ) >= res) // moving along (outside) hmap border
+    {
+      t = exitT;
+      continue;
+    }
+    const float y0 = pt.y + dir.y * t, y1 = pt.y + dir.y * min(exitT, mint);
+    const auto &hrb = hier.getHtRangeBlocksLevData(lev - 1)[(nodeZ >> 1) * (res >> 1) + (nodeX >> 1)];
+    const int idx = (nodeZ & 1) * 2 + (nodeX & 1);
+    if (min(y0, y1) > hrb.hMax[idx] * hScaleRaw + hMin + rangeEps || max(y0, y1) < hrb.hMin[idx] * hScaleRaw + hMin - rangeEps)
+    {
+      t = exitT;
+      lev = max(lev - 1, 1); // empty space, try to take bigger steps
+      continue;
+    }
+    if (lev < levels)
+    {
+      lev++;
+      continue;
+    }
+
+    // finest node overlaps ray: trace its cells, same way as trace_ray_midpoint_heightmap
+    WooRay2dInf ray;
+    ray.init(Point2(pt.x + dir.x * t, pt.z + dir.z * t), Point2::xz(dir), Point2(cellSize, cellSize));
+    const float endT = min(exitT, mint);
+    float nextT = 0, curRayY = dir.y * t;
+    for (int n = (int)ceil(4 * (endT - t) / cellSize) + 2; n > 0; --n)
+    {
+      IPoint2 currentCell = ray.currentCell();
+      ray.nextCell(nextT);
+      float cellExitT = t + nextT;
+      if (cellExitT >= endT)
+      {
+        cellExitT = endT;
+        n = 0;
+      }
+      const float prevRayY = curRayY;
+      curRayY = dir.y * cellExitT;
+      if (uint32_t(currentCell.x) >= hmapW || uint32_t(currentCell.y) >= hmapH)
+        continue;
+      const float rayMinY = pt.y + min(curRayY, prevRayY), rayMaxY = pt.y + max(curRayY, prevRayY);
+      if (trace_heightmap_cell(heightmap, currentCell, cellSize, rayMinY, rayMaxY, pt, dir, mint, any_hit ? nullptr : normal,
+            any_hit ? true : cull))
+      {
+        wasHit = true;
+        if (any_hit)
+          return true;
+        // hit is inside of this cell, so no further cell can be closer
+        n = 0;
+      }
+    }
+    if (wasHit)
+      break;
+    t = exitT;
+    lev = max(lev - 1, 1);
+  }
+  if (wasHit)
+    mint_ = mint + rayTBoxMin;
+  return wasHit;
+}
+
 // Check ray intersection with heightmap cells represented as 4-triangle 5-point geometry,
 // with 4 points at grid vertices and 1 at the cell center.
 //
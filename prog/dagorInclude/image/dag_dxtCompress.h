@@ -31,6 +31,19 @@ enum
   MODE_BC5,       // ATI2N
 };
 
+/// Quality/speed presets for block compressors, from fastest to best quality
+/// (BC1-BC5 are mapped to DXT_ALGORITHM_*, tools map them to BC6H/BC7 encoder profiles as well)
+enum
+{
+  DXT_PRESET_FASTEST = 0,
+  DXT_PRESET_NORMAL,
+  DXT_PRESET_PRODUCTION,
+  DXT_PRESET_HIGHEST,
+};
+
+/// Minimal number of 4x4 blocks in band compressed by one job in *_MT functions
+static constexpr int DXT_MT_MIN_BLOCKS_PER_BAND = 256;
+
 /// Compresses image into provided pointer.
 void ManualDXT(int mode, TexPixel32 *pImage, int width, int height, int dxt_pitch, char *pCompressed,
   int algorithm = DXT_ALGORITHM_QUICK);
@@ -43,4 +56,19 @@ void *CompressDXT(int mode, TexPixel32 *image, int stride_bytes, int width, int
 void CompressBC4(unsigned char *image, int width, int height, int dxt_pitch, char *pCompressed, int row_stride, int pixel_stride);
 void CompressBC5(unsigned char *image, int width, int height, int dxt_pitch, char *pCompressed, int pixel_stride, int pixel_offset);
 
+/// Same as ManualDXT(), but image is split into bands of 4-pixel block rows that are compressed
+/// in parallel using threadpool (on current thread when threadpool is not inited or function is called from threadpool worker).
+/// Output is identical to single-threaded function; width and height are not required to be powers of 2.
+void ManualDXT_MT(int mode, TexPixel32 *pImage, int width, int height, int dxt_pitch, char *pCompressed,
+  int algorithm = DXT_ALGORITHM_QUICK);
+
+/// Calls compress_band(ctx, row0, row1) for bands of block rows [row0, row1) of image with block_rows x block_cols blocks
+/// in parallel using threadpool and waits for completion; used to parallelize other block compressors (e.g. BC6H/BC7 in tools)
+void dxt_parallel_block_rows(int block_rows, int block_cols, void (*compress_band)(void *ctx, int row0, int row1), void *ctx);
+
+/// Returns DXT_ALGORITHM_* for DXT_PRESET_*
+int dxt_preset_to_algorithm(int preset);
+/// Returns DXT_PRESET_* for quality name ("fastest", "normal", "production", "highest"), def_preset for empty or unknown name
+int dxt_preset_from_name(const char *quality, int def_preset = DXT_PRESET_PRODUCTION);
+
 void decompress_dxt(unsigned char *decompressedData, int lw, int lh, int row_pitch, unsigned char *src_data, bool is_dxt1);
@@ -0,0 +1,116 @@
+//
+// Dagor Engine 6.5
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <ioSys/dag_baseIo.h>
+#include <generic/dag_tab.h>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+#include <supp/dag_define_COREIMP.h>
+
+// Seekable zstd stream: sequence of independently compressed zstd frames followed by seek table,
+// stored as zstd skippable frame (compatible with zstd contrib/seekable_format, without per-frame checksums):
+//   [frame0][frame1]...[frameN-1][skippable frame: magic, size, {compSize, decompSize}*N, N, descriptor, seekable magic]
+// Such stream is still a valid zstd stream, so it may be decompressed sequentially by any zstd decoder.
+
+// Writes seekable zstd stream; frames are cut each frame_size bytes of input (or on explicit flushFrame()).
+// Blocks (beginBlock/endBlock) are supported within current (not yet compressed) frame; frame is not cut while blocks are open.
+class ZstdSeekableSaveCB : public IBaseSave
+{
+public:
+  static constexpr int DEFAULT_FRAME_SIZE = 256 << 10;
+
+  KRNLIMP ZstdSeekableSaveCB(IGenSave &dest_cwr, int compression_level, int frame_size = DEFAULT_FRAME_SIZE);
+  KRNLIMP ~ZstdSeekableSaveCB();
+
+  KRNLIMP void write(const void *ptr, int size) override;
+  // ends current frame (if not empty), so next data starts in new frame (e.g. to start new record for random access)
+  KRNLIMP void flushFrame();
+  // flushes last frame and writes seek table; must be called once when all data is written
+  KRNLIMP void finish();
+
+  // tell/seekto operate on uncompressed stream position; seekto is allowed only inside current (not yet compressed) frame
+  int tell() override { return int(frameStartPos + writePos); }
+  KRNLIMP void seekto(int pos) override;
+  void seektoend(int ofs = 0) override { seekto(tell() + ofs); }
+  const char *getTargetName() override { return cwrDest ? cwrDest->getTargetName() : NULL; }
+  void flush() override {}
+
+  int getFramesCount() const { return frames.size(); }
+
+protected:
+  struct FrameEntry
+  {
+    uint32_t compSize, decompSize;
+  };
+
+  IGenSave *cwrDest = nullptr;
+  ZSTD_CCtx_s *cctx = nullptr;
+  int compressionLevel = 0, frameSize = DEFAULT_FRAME_SIZE;
+  int64_t frameStartPos = 0;
+  int writePos = 0; // position inside frameBuf (differs from frameBuf.size() only after seekto)
+  Tab<char> frameBuf;
+  Tab<char> comprBuf;
+  Tab<FrameEntry> frames;
+
+  void compressFrame();
+};
+
+// Reads seekable zstd stream with random access; seekto() costs O(1) to locate frame when all frames (except last) are of equal
+// decompressed size (default for ZstdSeekableSaveCB), O(log N) otherwise, plus decompression of one frame.
+// Source is either memory (e.g. vromfs data) or IGenLoad that supports seekto().
+class ZstdSeekableLoadCB : public IBaseLoad
+{
+public:
+  ZstdSeekableLoadCB() = default;
+  // report error when stream can't be opened; isOpen() is false then
+  KRNLIMP ZstdSeekableLoadCB(dag::ConstSpan<char> enc_data);
+  KRNLIMP ZstdSeekableLoadCB(IGenLoad &in_crd, int in_size);
+  ~ZstdSeekableLoadCB() { close(); }
+
+  // source stream must remain valid until close(); in_crd is positioned at start of seekable stream; returns false on format error
+  KRNLIMP bool open(IGenLoad &in_crd, int in_size);
+  KRNLIMP bool open(dag::ConstSpan<char> enc_data);
+  KRNLIMP void close();
+  bool isOpen() const { return srcCrd || srcData.data(); }
+
+  KRNLIMP void read(void *ptr, int size) override;
+  KRNLIMP int tryRead(void *ptr, int size) override;
+  int tell() override { return int(curPos); }
+  KRNLIMP void seekto(int pos) override;
+  void seekrel(int ofs) override { seekto(int(curPos + ofs)); }
+  const char *getTargetName() override { return srcCrd ? srcCrd->getTargetName() : nullptr; }
+  int64_t getTargetDataSize() override { return getSize(); }
+
+  int64_t getSize() const { return frameDOfs.empty() ? 0 : frameDOfs.back(); }
+  int getFramesCount() const { return frameDOfs.empty() ? 0 : frameDOfs.size() - 1; }
+
+  // decompresses [ofs, ofs+size) of uncompressed stream to dest; frames are decompressed in parallel using threadpool
+  // (when use_threadpool=true and threadpool has workers); doesn't change current read position; returns decompressed size
+  KRNLIMP int64_t readRange(void *dest, int64_t ofs, int64_t size, bool use_threadpool = true);
+
+protected:
+  IGenLoad *srcCrd = nullptr;
+  int64_t srcBase = 0;
+  dag::ConstSpan<char> srcData;
+  ZSTD_DCtx_s *dctx = nullptr;
+
+  Tab<int64_t> frameCOfs, frameDOfs; // N+1 prefix offsets of compressed and decompressed frames
+  int64_t uniformFrameSize = 0;      // >0 when all frames except last are of this decompressed size
+
+  int64_t curPos = 0;
+  int curFrame = -1;
+  Tab<char> frameBuf, comprBuf;
+
+  bool readSeekTable(int64_t total_size);
+  int findFrame(int64_t pos) const;
+  void readCompressed(int frame, Tab<char> &buf);
+  bool decodeFrame(int frame);
+};
+
+#include <supp/dag_undef_COREIMP.h>
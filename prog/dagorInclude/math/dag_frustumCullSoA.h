@@ -0,0 +1,79 @@
+//
+// Dagor Engine 6.5
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <vecmath/dag_vecMathDecl.h>
+#include <util/dag_stdint.h>
+#include <float.h>
+
+struct Frustum;
+
+/// @addtogroup math
+/// @{
+
+/*
+Array-oriented culling of many bounding volumes, instead of Frustum::testSphereB()/testBoxExtentB() per object.
+
+Bounding volumes are passed as SoA arrays (x[], y[], z[], ...). Frustum and distance tests are fused and done for 8 objects at once
+(AVX2/AVX-512 variants, selected at runtime with CpuDispatch) or for 4 objects at once (baseline), and indices of objects in
+[start, end) which passed them are written compacted to out_visible. out_visible should have room for end - start indices.
+Returns number of visible objects.
+
+Narrow test (typically occlusion) can be fused to same pass, it is called for each object passed frustum and distance tests,
+chunk by chunk while its bounding volume is still in cache:
+
+  int visibleCount = frustum_cull_soa(frustum, boxes, 0, count, params, visible.data(), [&](uint32_t i) {
+    vec3f c = v_make_vec4f(boxes.cx[i], boxes.cy[i], boxes.cz[i], 0), e = v_make_vec4f(boxes.ex[i], boxes.ey[i], boxes.ez[i], 0);
+    return occlusion->isVisibleBox(v_sub(c, e), v_add(c, e));
+  });
+*/
+
+//! bounding spheres, center and radius
+struct SoASpheres
+{
+  const float *x, *y, *z, *r;
+};
+
+//! bounding boxes, center and half extent (not doubled, unlike Frustum::testBoxExtentB())
+struct SoABoxes
+{
+  const float *cx, *cy, *cz, *ex, *ey, *ez;
+};
+
+struct SoACullParams
+{
+  //! xyz - view position, w - squared distance scale (lod/distance bias), as in scene::SimpleScene::frustumCull()
+  vec4f posDistScale;
+  //! object is visible when lengthSq(center - view position) * posDistScale.w <= max distance squared, which is taken from
+  //! maxDistSqPerObject[index] or maxDistSq when there is no per object array
+  const float *maxDistSqPerObject = nullptr;
+  float maxDistSq = FLT_MAX;
+};
+
+int frustum_cull_soa(const Frustum &frustum, const SoASpheres &spheres, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible);
+int frustum_cull_soa(const Frustum &frustum, const SoABoxes &boxes, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible);
+
+//! same as above, with narrow_test(uint32_t index) -> bool applied to objects passed frustum and distance tests
+template <typename SoAVolumes, typename NarrowTest>
+inline int frustum_cull_soa(const Frustum &frustum, const SoAVolumes &volumes, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible, NarrowTest narrow_test)
+{
+  static constexpr int CHUNK_SIZE = 512;
+  int visibleCount = 0;
+  for (int chunkStart = start; chunkStart < end; chunkStart += CHUNK_SIZE)
+  {
+    int chunkEnd = end - chunkStart > CHUNK_SIZE ? chunkStart + CHUNK_SIZE : end;
+    uint32_t *chunkVisible = out_visible + visibleCount;
+    int chunkVisibleCount = frustum_cull_soa(frustum, volumes, chunkStart, chunkEnd, params, chunkVisible);
+    for (int i = 0; i < chunkVisibleCount; ++i)
+      if (narrow_test(chunkVisible[i]))
+        out_visible[visibleCount++] = chunkVisible[i];
+  }
+  return visibleCount;
+}
+/// @}
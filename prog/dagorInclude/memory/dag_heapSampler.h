@@ -0,0 +1,44 @@
+//
+// Dagor Engine 6.5
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <util/dag_stdint.h>
+
+#include <supp/dag_define_COREIMP.h>
+
+//! Sampling heap profiler built into the non-debug memory managers (engine/memory, rtlStdMemory and mimallocMem).
+//! Allocations through IMemAlloc and operator new are sampled; plain CRT malloc() is not.
+//! When enabled, roughly one allocation per sample interval bytes is recorded with its call stack;
+//! live and cumulative counts are aggregated per unique call stack and can be dumped to a file in
+//! legacy pprof heap format (usable with `pprof --text <exe> <file>`), counts are unsampled by pprof itself.
+//! Cost when disabled is a single load per alloc/free, so it is safe to keep compiled into release builds.
+namespace heap_sampler
+{
+struct Stats
+{
+  int64_t liveSamples, liveBytes;   //< sampled and not yet freed
+  int64_t totalSamples, totalBytes; //< sampled since start
+  int uniqueStacks;
+  int droppedSamples; //< samples lost due to full tables
+};
+
+//! returns false when memory manager has no sampler hooks (debug allocator), sampling can't be enabled then
+KRNLIMP bool is_supported();
+
+//! sets mean sampling interval in bytes (0 disables sampling, that is default); typical value is 512K
+//! logs error and keeps sampling disabled when !is_supported()
+KRNLIMP void set_sample_interval(size_t mean_bytes);
+//! returns current sampling interval (0 when sampling is disabled)
+KRNLIMP size_t get_sample_interval();
+
+//! fills aggregated stats of sampled allocations
+KRNLIMP void get_stats(Stats &out_stats);
+
+//! writes profile of live (and cumulative) sampled allocations to fname; returns false if file can't be written
+KRNLIMP bool dump_profile(const char *fname);
+} // namespace heap_sampler
+
+#include <supp/dag_undef_COREIMP.h>
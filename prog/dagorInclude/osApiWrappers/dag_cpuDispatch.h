@@ -0,0 +1,54 @@
+//
+// Dagor Engine 6.5
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <osApiWrappers/dag_cpuFeatures.h>
+#include <EASTL/utility.h>
+
+/*
+Runtime selection of hot kernel variants compiled for different SIMD levels.
+
+Kernel is compiled several times in files with _sse4, _avx2 and _avx512 suffixes, for which jamfile sets target options
+(see engine/math/jamfile), usually by including same .inc.cpp with code written with vec4f or vec8f (vecmath/dag_vecMath8.h).
+Each such file exports its variant, or nullptr when build doesn't support that target (check __SSE4_1__, __AVX2__, __AVX512F__),
+and CpuDispatch calls best variant which CPU supports:
+
+  static const CpuDispatch<void (*)(const float *, float *, int)> process = {{process_base, process_sse4, process_avx2, nullptr}};
+  process(src, dst, count);
+
+Selection happens on each call, so dispatch bulk work (arrays), not single elements.
+*/
+
+#include <supp/dag_define_COREIMP.h>
+
+//! cpu_simd_level_checked limited by set_cpu_simd_level_limit()
+KRNLIMP CpuSimdLevel get_cpu_simd_level();
+//! limits variants selected by CpuDispatch, for benchmarks, tests and to work around CPU/OS issues
+KRNLIMP void set_cpu_simd_level_limit(CpuSimdLevel level);
+
+#include <supp/dag_undef_COREIMP.h>
+
+template <typename Fn>
+struct CpuDispatch
+{
+  //! indexed by CpuSimdLevel, nullptr for missing variants. Base variant can be nullptr too, then get() returns nullptr when no
+  //! variant is available, and caller uses own generic code
+  Fn variants[CPU_SIMD_LEVEL_COUNT];
+
+  Fn get() const
+  {
+    for (int level = get_cpu_simd_level(); level > CPU_SIMD_BASE; level--)
+      if (variants[level])
+        return variants[level];
+    return variants[CPU_SIMD_BASE];
+  }
+
+  template <typename... Args>
+  auto operator()(Args &&...args) const
+  {
+    return get()(eastl::forward<Args>(args)...);
+  }
+};
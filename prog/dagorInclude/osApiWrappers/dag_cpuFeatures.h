@@ -13,6 +13,7 @@ Available bools for fast check (values following from compilation options will b
   cpu_feature_fma
   cpu_feature_avx
   cpu_feature_avx2
+  cpu_feature_avx512
   cpu_feature_fast_256bit_avx
 
 Some AMD CPU's with AVX support have not native 256-bit calculations. They are implemented by using
@@ -20,6 +21,10 @@ of two 128-bit execution units. Algorithms with 256-bit registers using on that
 about 0.8-1.0x speed difference againt 128-bit analogue, but CPU's with native 256-bit are about 1.6x
 times faster in same case.
 XBox One and PS4 (AMD Jaguar family) have slow 256-bit avx.
+
+cpu_feature_avx512 means AVX-512 F, DQ, BW and VL subsets, with ZMM state enabled by OS.
+
+cpu_simd_level_checked is highest level of multiversioned kernels (see dag_cpuDispatch.h) that CPU supports.
 */
 
 #include <supp/dag_define_COREIMP.h>
@@ -31,8 +36,20 @@ KRNLIMP extern bool cpu_feature_popcnt_checked;
 KRNLIMP extern bool cpu_feature_fma_checked;
 KRNLIMP extern bool cpu_feature_avx_checked;
 KRNLIMP extern bool cpu_feature_avx2_checked;
+KRNLIMP extern bool cpu_feature_avx512_checked;
 KRNLIMP extern bool cpu_feature_fast_256bit_avx_checked;
 
+enum CpuSimdLevel
+{
+  CPU_SIMD_BASE,   // SSE2 (x86) or NEON (ARM)
+  CPU_SIMD_SSE4,   // SSE4.1, SSE4.2, POPCNT
+  CPU_SIMD_AVX2,   // AVX, AVX2, FMA with native 256-bit execution
+  CPU_SIMD_AVX512, // AVX-512 F, DQ, BW, VL
+
+  CPU_SIMD_LEVEL_COUNT
+};
+KRNLIMP extern CpuSimdLevel cpu_simd_level_checked;
+
 #if (__cplusplus >= 201703L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) // for inline bool
 // MSVC defines only __AVX__ and __AVX2__
 
@@ -84,6 +101,14 @@ constexpr bool cpu_feature_avx2 = false;
 inline bool &cpu_feature_avx2 = cpu_feature_avx2_checked;
 #endif // __AVX2__
 
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+constexpr bool cpu_feature_avx512 = true;
+#elif !_TARGET_SIMD_SSE
+constexpr bool cpu_feature_avx512 = false;
+#else
+inline bool &cpu_feature_avx512 = cpu_feature_avx512_checked;
+#endif
+
 #if defined _TARGET_C1 || defined _TARGET_XBOXONE || !defined(_TARGET_64BIT)
 constexpr bool cpu_feature_fast_256bit_avx = false; // AMD Jaguar has no benefits from using 256-bit regs (which is used in prevgen
                                                     // consoles - ps4, xb1)
@@ -41,6 +41,31 @@ struct VirtualRomFsExtHdr
   uint32_t version = 0;
 };
 
+//! header of delta patch that builds new vromfs dump from base one (see vromfsPacker -mkpatch);
+//! followed by header of resulting dump (dumpHdrSz), base dump file name (baseNameLen, no path), signature of resulting dump (sigSz)
+//! and zstd-packed stream of ops (opsPackedSz); each op is uint8 type, uint32 len and then (for type):
+//!   VRFD_OP_ADD - len bytes of new data; VRFD_OP_COPY_BASE/VRFD_OP_COPY_SELF - uint32 offset in base/resulting dump contents
+struct VirtualRomFsPatchHdr
+{
+  enum
+  {
+    VRFD_OP_ADD = 0,
+    VRFD_OP_COPY_BASE = 1,
+    VRFD_OP_COPY_SELF = 2,
+  };
+
+  unsigned label; // _MAKE4C('VRFd')
+  unsigned target;
+  unsigned fullSz;
+  unsigned opsPackedSz;
+  unsigned baseFullSz;
+  unsigned sigSz;
+  uint16_t dumpHdrSz;
+  uint16_t baseNameLen;
+  unsigned char baseMD5[16];
+  unsigned char fullMD5[16];
+};
+
 struct VirtualRomFsDataBase
 {
   int64_t mtime = -1;
@@ -106,10 +131,20 @@ struct VirtualRomFsSingleFile : public VirtualRomFsPack
 //! buffers is NULL terminated list of buffers that require verification (NULL if signature not found)
 typedef bool (*verify_signature_cb)(const void **buffers, const unsigned *buf_sizes, const unsigned char *sigbuf, int siglen);
 
-//! loads vromfs dump from file into memory (to be released with mem->free(fs))
+//! loads vromfs dump from file into memory (to be released with mem->free(fs));
+//! when fname is delta patch, it is applied to base dump that is searched in the same folder
 KRNLIMP VirtualRomFsData *load_vromfs_dump(const char *fname, IMemAlloc *mem, verify_signature_cb sigcb = NULL,
   const dag::ConstSpan<uint8_t> *to_verify = NULL, int file_flags = 0);
 
+//! loads vromfs dump built by applying delta patch to base vromfs dump (to be released with mem->free(fs));
+//! patch ops are unpacked and applied in streaming fashion, base and resulting contents are checked with MD5 stored in patch;
+//! base_fname=NULL means base dump named as stored in patch and located in the same folder as patch
+KRNLIMP VirtualRomFsData *load_vromfs_dump_patched(const char *base_fname, const char *patch_fname, IMemAlloc *mem,
+  verify_signature_cb sigcb = NULL, const dag::ConstSpan<uint8_t> *to_verify = NULL, int file_flags = 0);
+
+//! applies delta patch to base vromfs dump and writes resulting vromfs dump (non-packed) to dest_fname (may be the same as base)
+KRNLIMP bool apply_vromfs_patch(const char *base_fname, const char *patch_fname, const char *dest_fname);
+
 //! loads vromfs dump from cryped file into memory (to be released with mem->free(fs))
 KRNLIMP VirtualRomFsData *load_crypted_vromfs_dump(const char *fname, IMemAlloc *mem);
 
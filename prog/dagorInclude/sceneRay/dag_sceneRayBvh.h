@@ -0,0 +1,119 @@
+//
+// Dagor Engine 6.5
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <sceneRay/dag_sceneRayDecl.h>
+#include <memory/dag_mem.h>
+#include <generic/dag_tab.h>
+#include <vecmath/dag_vecMath.h>
+#include <math/dag_Point3.h>
+
+class IGenSave;
+class IGenLoad;
+
+//! Alternative acceleration structure for StaticSceneRayTracerT: 4-wide bounding volume hierarchy built with binned SAH.
+//! Boxes of the 4 children of each node are stored as SoA, so one ray is tested against all of them with one SIMD slab test;
+//! leaf triangles are pre-transposed by 4 for traceray4Triangles()/rayhit4Triangles().
+//! Geometry is copied, tracer is referenced only for use/skip flag masks, so tracer must outlive the hierarchy.
+//! Hits are the same as StaticSceneRayTracerT::tracerayNormalized()/rayhitNormalizedIdx() (faces are never culled).
+template <typename FI>
+class StaticSceneRayBvhT
+{
+public:
+  DAG_DECLARE_NEW(midmem)
+
+  typedef StaticSceneRayTracerT<FI> Tracer;
+  typedef FI FaceIndex;
+
+  static constexpr int WIDTH = 4;
+  static constexpr int MAX_LEAF_FACES = 8;
+
+  enum : uint32_t
+  {
+    LEAF_BIT = 0x80000000u,
+    LEAF_PACKS_BITS = 1, //< leaf child is LEAF_BIT | (first_pack << LEAF_PACKS_BITS) | (packs_count - 1)
+    EMPTY_CHILD = 0xFFFFFFFFu,
+  };
+
+  struct alignas(16) Node
+  {
+    float box[2][3][WIDTH]; //< [min/max][x/y/z][child], empty children have inverted boxes
+    uint32_t child[WIDTH];
+  };
+
+  //! 4 triangles transposed to SoA; unused lanes repeat last triangle of leaf
+  struct alignas(16) TriPack
+  {
+    mat43f p0, p1, p2;
+  };
+
+  StaticSceneRayBvhT() = default;
+  StaticSceneRayBvhT(const StaticSceneRayBvhT &) = delete;
+  StaticSceneRayBvhT &operator=(const StaticSceneRayBvhT &) = delete;
+
+  //! Builds hierarchy over all faces of tracer. Subtrees are built on threadpool (if it has workers and use_threadpool is set);
+  //! result is the same as of serial build
+  bool build(const Tracer &rt, bool use_threadpool = true);
+  void clear();
+
+  bool isEmpty() const { return nodes.empty(); }
+  const Tracer *getTracer() const { return tracer; }
+  int getNodesCount() const { return nodes.size(); }
+  int getTriPacksCount() const { return packs.size(); }
+
+  //! Tests ray hit to closest face, for normalized dir only; returns -1 if not hit, face index otherwise (and updates mint)
+  VECTORCALL int tracerayNormalized(vec3f p, vec3f dir, real &mint) const;
+  int tracerayNormalized(const Point3 &p, const Point3 &dir, real &mint) const
+  {
+    return tracerayNormalized(v_ldu_p3(&p.x), v_ldu_p3(&dir.x), mint);
+  }
+  //! Tests ray hit to any face, for normalized dir only; returns -1 if not hit, index of some hit face otherwise
+  VECTORCALL int rayhitNormalizedIdx(vec3f p, vec3f dir, real mint) const;
+  bool rayhitNormalized(const Point3 &p, const Point3 &dir, real mint) const
+  {
+    return rayhitNormalizedIdx(v_ldu_p3(&p.x), v_ldu_p3(&dir.x), mint) >= 0;
+  }
+
+  //! Ray stream: traces cnt rays per call (normalized dirs), t[] is max distance on input and hit distance on output,
+  //! out_face[] (optional) receives face index or -1. Consecutive rays with the same direction octant are traced
+  //! as 4-ray packets sharing node traversal, so coherent rays (shadows, visibility from one point) should go together.
+  //! Returns number of hits
+  int tracerayNormalizedStream(const Point3 *p, const Point3 *dir, float *t, int *out_face, int cnt) const;
+  //! Ray stream any-hit test; out_hit_mask (optional) has (cnt+31)/32 words, bit i is set if ray i hit anything.
+  //! Returns number of hits
+  int rayhitNormalizedStream(const Point3 *p, const Point3 *dir, const float *t, uint32_t *out_hit_mask, int cnt) const;
+
+  //! Writes "RTbvh4" block, framed the same way as "RTdump" block of StaticSceneRayTracerT::serialize(), so it can be
+  //! stored next to it as optional data
+  bool serialize(IGenSave &cb, bool zcompr = true) const;
+  //! Loads "RTbvh4" block; fails (leaving hierarchy empty) if block doesn't match faces/verts of tracer (hash of contents)
+  bool serializedLoad(IGenLoad &cb, const Tracer &rt);
+
+protected:
+  struct Header
+  {
+    bbox3f box;
+    int facesCount, vertsCount, nodesCount, packsCount;
+    uint64_t geomHash; //< of tracer's faces, verts and face indices (with flags) hierarchy was built for
+    int reserved[2];
+  };
+
+  const Tracer *tracer = nullptr;
+  bbox3f rootBox;
+  Tab<Node> nodes;
+  Tab<TriPack> packs;
+  Tab<FaceIndex> packFaces; //< 4 per pack, with face flags
+
+  __forceinline int packLanes(int pack, unsigned use_flags, unsigned skip_flags) const;
+  template <bool any_hit>
+  VECTORCALL __forceinline int traceLeaf(vec3f p, vec3f dir, float &mint, uint32_t leaf, unsigned use_flags, unsigned skip_flags) const;
+  template <bool any_hit>
+  VECTORCALL inline int traceSingle(vec3f p, vec3f dir, float &mint) const;
+  template <bool any_hit>
+  inline void tracePacket4(const Point3 *p, const Point3 *dir, float *t, int *out_face) const;
+};
+
+typedef StaticSceneRayBvhT<SceneRayI24F8> StaticSceneRayBvh;
@@ -9,96 +9,78 @@
 #include <osApiWrappers/dag_rwLock.h>
 #include <osApiWrappers/dag_atomic.h>
 
-// thread safe FastNameMap (with read-write lock)
+// thread safe FastNameMap
+// lookups (getNameId, getName and hits of addNameId/internName) are wait-free, only adding of new names takes lock.
+// Names are stored in OAHashNameMap (string data never moves), while lookups go through separate open addressing table
+// of {hash, id} slots: slot is written once (id first, then hash with release), and on grow table is rebuilt and published
+// as a whole. Tables of previous generations can still be probed by concurrent readers, so they are retired
+// (freed in reset() and destructor only), which costs no more than size of current table.
+// name pointers are kept in chunks of growing size that are never reallocated, so getName() doesn't need lock either.
+// reset() must not be called concurrently with other methods (as names returned before reset become invalid anyway).
 template <bool case_insensitive = false>
 struct FastNameMapTS : protected OAHashNameMap<case_insensitive>
 {
 protected:
-  uint32_t namesCount = 0;
   typedef OAHashNameMap<case_insensitive> BaseNameMap;
-  mutable OSReadWriteLock lock; // Note: non reentrant
+  typedef typename BaseNameMap::hash_t hash_t;
+
+  static constexpr uint32_t FIRST_CHUNK_SHIFT = 8;
+  static constexpr int MAX_CHUNKS = 32 - FIRST_CHUNK_SHIFT + 1; // chunk 0 and chunk i>0 has 1<<(i-1+FIRST_CHUNK_SHIFT) names
+  static constexpr uint32_t MIN_TABLE_SIZE = 64;
+
+  struct Slot
+  {
+    volatile hash_t hash; // 0 - empty slot
+    uint32_t id;
+  };
+  struct LookupTable
+  {
+    uint32_t mask;
+    eastl::unique_ptr<Slot[]> slots;
+    LookupTable *retired; // previous generation
+  };
+
+  uint32_t namesCount = 0;
+  LookupTable *volatile table = nullptr;
+  const char **nameChunks[MAX_CHUNKS] = {};
+  mutable OSReadWriteLock lock; // Note: non reentrant; serializes writers and guards whole map operations (iterate, memInfo)
 
 public:
+  FastNameMapTS() = default;
+  FastNameMapTS(const FastNameMapTS &) = delete;
+  FastNameMapTS &operator=(const FastNameMapTS &) = delete;
+  ~FastNameMapTS() { freeLookup(); }
+
   int getNameId(const char *name, size_t name_len) const
   {
-    const typename BaseNameMap::hash_t hash = BaseNameMap::string_hash(name, name_len); // calc hash outside lock
-    lockRd();
-    int id = BaseNameMap::getNameId(name, name_len, hash);
-    unlockRd();
-    return id;
+    return findId(name, name_len, BaseNameMap::string_hash(name, name_len));
   }
   int getNameId(const char *name) const { return getNameId(name, strlen(name)); }
   int addNameId(const char *name, size_t name_len, typename BaseNameMap::hash_t hash) // optimized version. addNameId doesn't call for
                                                                                       // getNameId
   {
-    lockRd();
-    int it = -1;
-    bool foundCollision = false;
-    if (DAGOR_LIKELY(BaseNameMap::noCollisions()))
-    {
-      it = BaseNameMap::hashToStringId.findOr(hash, -1);
-      if (DAGOR_UNLIKELY(it != -1 && !BaseNameMap::string_equal(name, name_len, it)))
-      {
-        foundCollision = true;
-        it = -1;
-      }
-    }
-    else
-      it = BaseNameMap::hashToStringId.findOr(hash, -1, [&](uint32_t id) { return BaseNameMap::string_equal(name, name_len, id); });
-    unlockRd();
-
-    if (it == -1)
-    {
-      lockWr();
-      if (foundCollision)
-        BaseNameMap::noCollisions() = 0;
-      uint32_t id = BaseNameMap::addString(name, name_len);
-      BaseNameMap::hashToStringId.emplace(hash, eastl::move(id));
-      interlocked_increment(namesCount);
-      unlockWr();
-      return (int)id;
-    }
-    return it;
+    int id = findId(name, name_len, hash);
+    if (DAGOR_LIKELY(id != -1))
+      return id;
+    lockWr();
+    id = addLocked(name, name_len, hash);
+    unlockWr();
+    return id;
   }
   int addNameId(const char *name, size_t name_len) { return addNameId(name, name_len, BaseNameMap::string_hash(name, name_len)); }
   int addNameId(const char *name) { return addNameId(name, strlen(name)); }
 
-  // almost full copy paste of addNameId
-  // it is same as getName(addNameId(name)), but saves one lock (which can be expensive, especially in case of contention)
+  // it is same as getName(addNameId(name)), but saves id to name lookup
   const char *internName(const char *name, size_t name_len, typename BaseNameMap::hash_t hash) // optimized version. addNameId doesn't
                                                                                                // call for getNameId
   {
-    lockRd();
-    int it = -1;
-    bool foundCollision = false;
-    if (DAGOR_LIKELY(BaseNameMap::noCollisions()))
-    {
-      it = BaseNameMap::hashToStringId.findOr(hash, -1);
-      if (DAGOR_UNLIKELY(it != -1 && !BaseNameMap::string_equal(name, name_len, it)))
-      {
-        foundCollision = true;
-        it = -1;
-      }
-    }
-    else
-      it = BaseNameMap::hashToStringId.findOr(hash, -1, [&](uint32_t id) { return BaseNameMap::string_equal(name, name_len, id); });
-    if (it != -1)
-      name = BaseNameMap::getName(it);
-    unlockRd();
-
-    if (it == -1)
-    {
-      lockWr();
-      if (foundCollision)
-        BaseNameMap::noCollisions() = 0;
-      uint32_t id = BaseNameMap::addString(name, name_len);
-      BaseNameMap::hashToStringId.emplace(hash, eastl::move(id));
-      name = BaseNameMap::getName(id);
-      interlocked_increment(namesCount);
-      unlockWr();
-      return name;
-    }
-    return name;
+    int id = findId(name, name_len, hash);
+    if (DAGOR_LIKELY(id != -1))
+      return getNameUnsafe(id);
+    lockWr();
+    id = addLocked(name, name_len, hash);
+    unlockWr();
+    return getNameUnsafe(id);
   }
   const char *internName(const char *name)
   {
@@ -109,16 +91,11 @@ public:
   uint32_t nameCountRelaxed() const { return interlocked_relaxed_load(namesCount); }
   uint32_t nameCountAcquire() const { return interlocked_acquire_load(namesCount); }
   uint32_t nameCount() const { return nameCountAcquire(); }
-  const char *getName(int name_id) const
-  {
-    lockRd();
-    const char *s = BaseNameMap::getName(name_id);
-    unlockRd();
-    return s;
-  }
+  const char *getName(int name_id) const { return uint32_t(name_id) < nameCountAcquire() ? getNameUnsafe(name_id) : nullptr; }
   void reset(bool erase_only = false)
   {
     lockWr();
+    freeLookup();
     BaseNameMap::reset(erase_only);
     interlocked_relaxed_store(namesCount, 0);
     unlockWr();
@@ -134,6 +111,10 @@ public:
     lockRd();
     allocated = BaseNameMap::totalAllocated();
     used = BaseNameMap::totalUsed();
+    for (const LookupTable *t = table; t; t = t->retired)
+      allocated += (t->mask + 1) * sizeof(Slot);
+    for (uint32_t i = 0; i < MAX_CHUNKS && nameChunks[i]; i++)
+      allocated += chunkSize(i) * sizeof(const char *);
     unlockRd();
   }
 
@@ -147,6 +128,111 @@ public:
   }
 
 private:
+  static uint32_t chunkSize(uint32_t chunk) { return 1u << (chunk ? chunk - 1 + FIRST_CHUNK_SHIFT : FIRST_CHUNK_SHIFT); }
+  static uint32_t chunkIndex(uint32_t id, uint32_t &ofs)
+  {
+    const uint32_t c = id >> FIRST_CHUNK_SHIFT;
+    if (!c)
+    {
+      ofs = id;
+      return 0;
+    }
+    const uint32_t log2 = get_log2i_unsafe(c);
+    ofs = id - (1u << (log2 + FIRST_CHUNK_SHIFT));
+    return log2 + 1;
+  }
+  // id must be published (either found in table or less than acquired namesCount)
+  const char *getNameUnsafe(uint32_t id) const
+  {
+    uint32_t ofs;
+    const uint32_t chunk = chunkIndex(id, ofs);
+    return nameChunks[chunk][ofs];
+  }
+  static bool nameEqual(const char *str, const char *name, size_t name_len)
+  {
+    if (case_insensitive)
+    {
+      const unsigned char *to_lower_lut = dd_local_cmp_lwtab;
+      for (; name_len; ++name, ++str, --name_len)
+        if (to_lower_lut[uint8_t(*name)] != to_lower_lut[uint8_t(*str)])
+          return false;
+      return *str == 0;
+    }
+    return strncmp(str, name, name_len) == 0 && str[name_len] == 0;
+  }
+  static hash_t slotKey(hash_t hash) { return hash ? hash : 1; }
+
+  int findId(const char *name, size_t name_len, hash_t hash) const
+  {
+    const LookupTable *t = interlocked_acquire_load_ptr(table);
+    if (!t)
+      return -1;
+    const hash_t key = slotKey(hash);
+    for (uint32_t i = key & t->mask;; i = (i + 1) & t->mask) // load factor is kept below 1/2, so there is always empty slot
+    {
+      const hash_t h = interlocked_acquire_load(t->slots[i].hash);
+      if (!h)
+        return -1;
+      if (h == key && nameEqual(getNameUnsafe(t->slots[i].id), name, name_len))
+        return (int)t->slots[i].id;
+    }
+  }
+
+  static void insertSlot(LookupTable &t, hash_t key, uint32_t id)
+  {
+    uint32_t i = key & t.mask;
+    while (t.slots[i].hash)
+      i = (i + 1) & t.mask;
+    t.slots[i].id = id;
+    interlocked_release_store(t.slots[i].hash, key);
+  }
+
+  int addLocked(const char *name, size_t name_len, hash_t hash)
+  {
+    int existingId = findId(name, name_len, hash); // could be added by other thread while we were waiting for lock
+    if (existingId != -1)
+      return existingId;
+
+    const uint32_t id = BaseNameMap::addString(name, name_len);
+    uint32_t ofs;
+    const uint32_t chunk = chunkIndex(id, ofs);
+    if (!nameChunks[chunk])
+      nameChunks[chunk] = new const char *[chunkSize(chunk)];
+    nameChunks[chunk][ofs] = BaseNameMap::getStringDataUnsafe(id);
+
+    LookupTable *t = table;
+    if (!t || (id + 1) * 2 > t->mask + 1)
+    {
+      const uint32_t size = t ? (t->mask + 1) * 2 : MIN_TABLE_SIZE;
+      LookupTable *nt = new LookupTable{size - 1, eastl::unique_ptr<Slot[]>(new Slot[size]()), t};
+      if (t)
+        for (uint32_t i = 0; i <= t->mask; i++)
+          if (hash_t h = t->slots[i].hash)
+            insertSlot(*nt, h, t->slots[i].id);
+      interlocked_release_store_ptr(table, nt);
+      t = nt;
+    }
+    // count id before publishing it in table, so any id found by lock-free reader is valid for getName()
+    interlocked_release_store(namesCount, id + 1);
+    insertSlot(*t, slotKey(hash), id);
+    return (int)id;
+  }
+
+  void freeLookup()
+  {
+    for (LookupTable *t = table, *next; t; t = next)
+    {
+      next = t->retired;
+      delete t;
+    }
+    table = nullptr;
+    for (auto &c : nameChunks)
+    {
+      delete[] c;
+      c = nullptr;
+    }
+  }
+
   void lockRd() const { lock.lockRead(); }
   void unlockRd() const { lock.unlockRead(); }
   void lockWr() const { lock.lockWrite(); }
@@ -157,6 +157,8 @@ public:
     rd.resource = resource;
     rd.resId = res_id;
   }
+  bool isLoadDataThreadSafe() override { return true; }
+
   void createGameResource(int /*res_id*/, const int * /*reference_ids*/, int /*num_refs*/) override {}
 
   void reset() override
@@ -57,6 +57,7 @@
   ASSIGN_OP(boundingSphere);          \
   ASSIGN_OP(cachedMaxTmScale);        \
   ASSIGN_OP(convexPlanes);            \
+  ASSIGN_OP(bvh);                     \
   ASSIGN_OP(capsule);                 \
   ASSIGN_OP(nodeIndex);               \
   ASSIGN_OP(insideOfNode);            \
@@ -248,6 +249,11 @@ void CollisionResource::load(IGenLoad &_cb, int res_id)
         zcrd->read(n.indices.data(), data_size(n.indices));
       }
     }
+    if (collisionFlags & COLLISION_RES_FLAG_HAS_NODE_BVH)
+    {
+      reserve_and_resize(n.bvh, zcrd->readInt());
+      zcrd->readTabData(n.bvh);
+    }
     if (n.type == COLLISION_NODE_TYPE_CAPSULE)
     {
       n.capsule.set(n.modelBBox);
@@ -1751,12 +1757,162 @@ VECTORCALL bool CollisionResource::traceQuad(const CollisionNodeFilter &filter,
   return false;
 }
 
+// Calls leaf_cb(first_index, indices_count) for leaves of node BVH which boxes (extended by ext) are intersected by ray from 'from' to
+// 'from + dir * t', nearest first. Callback may shrink t and returns true to stop traversal (then function returns true too)
+template <typename LeafCb>
+static __forceinline bool trace_node_bvh(const CollisionNode &node, vec3f from, vec3f dir, const float &t, vec3f ext,
+  const LeafCb &leaf_cb)
+{
+  const CollisionBVHNode *__restrict nodes = node.bvh.data();
+  bbox3f box = v_ldu_bbox3(node.modelBBox);
+  vec3f qStep = v_mul(v_bbox3_size(box), v_splats(1.f / CollisionBVHNode::QUANT_MAX));
+  vec3f ofsMin = v_sub(v_sub(box.bmin, ext), from);
+  vec3f ofsMax = v_sub(v_add(box.bmin, ext), from);
+  vec3f invDir = v_rcp_safe(dir, V_C_MAX_VAL);
+  auto testBox = [&](const CollisionBVHNode &n, float &out_near) {
+    vec3f t0 = v_mul(v_madd(v_cvt_vec4f(v_lduush(n.bmin)), qStep, ofsMin), invDir);
+    vec3f t1 = v_mul(v_madd(v_cvt_vec4f(v_lduush(n.bmax)), qStep, ofsMax), invDir);
+    out_near = v_extract_x(v_hmax3(v_min(t0, t1)));
+    return v_extract_x(v_hmin3(v_max(t0, t1))) >= max(out_near, 0.f) && out_near <= t;
+  };
+
+  struct StackEntry
+  {
+    uint32_t nodeIdx;
+    float tNear;
+  } stack[CollisionBVHNode::MAX_DEPTH];
+  uint32_t sp = 0, cur = 0;
+  float tNear;
+  if (!testBox(nodes[0], tNear))
+    return false;
+  for (;;)
+  {
+    const CollisionBVHNode &n = nodes[cur];
+    if (n.isLeaf())
+    {
+      if (leaf_cb(n.getFirstTriangle() * 3, n.getTrianglesCount() * 3))
+        return true;
+    }
+    else
+    {
+      uint32_t first = cur + 1, second = n.getSecondChild();
+      float tFirst, tSecond;
+      bool hitFirst = testBox(nodes[first], tFirst), hitSecond = testBox(nodes[second], tSecond);
+      if (hitFirst && hitSecond)
+      {
+        if (tSecond < tFirst)
+        {
+          eastl::swap(first, second);
+          eastl::swap(tFirst, tSecond);
+        }
+        G_FAST_ASSERT(sp < CollisionBVHNode::MAX_DEPTH);
+        stack[sp++] = {second, tSecond};
+        cur = first;
+        continue;
+      }
+      if (hitFirst || hitSecond)
+      {
+        cur = hitFirst ? first : second;
+        continue;
+      }
+    }
+    do
+    {
+      if (!sp)
+        return false;
+      --sp;
+    } while (stack[sp].tNear > t); // t was shrunk after it was pushed
+    cur = stack[sp].nodeIdx;
+  }
+}
+
+static __forceinline uint32_t load_bvh_leaf(const CollisionNode &node, uint32_t first_index, uint32_t indices_count,
+  vec4f vert[CollisionBVHNode::LEAF_TRIANGLES][3])
+{
+  G_STATIC_ASSERT(CollisionBVHNode::LEAF_TRIANGLES == 4); // matches 4 triangles intersection functions
+  const uint16_t *__restrict indices = node.indices.data() + first_index;
+  const Point3_vec4 *__restrict vertices = node.vertices.data();
+  uint32_t count = indices_count / 3;
+  for (uint32_t j = 0; j < count; j++)
+  {
+    vert[j][0] = v_ld(&vertices[indices[j * 3 + 0]].x);
+    vert[j][1] = v_ld(&vertices[indices[j * 3 + 1]].x);
+    vert[j][2] = v_ld(&vertices[indices[j * 3 + 2]].x);
+  }
+  for (uint32_t j = count; j < CollisionBVHNode::LEAF_TRIANGLES; j++)
+    vert[j][0] = vert[j][1] = vert[j][2] = v_zero(); // degenerate, never hit
+  return count;
+}
+
+VECTORCALL DAGOR_NOINLINE bool CollisionResource::traceRayMeshNodeBVHLocalCullCCW(const CollisionNode &node, vec4f v_local_from,
+  vec4f v_local_dir, float &in_out_t, vec4f *v_out_norm)
+{
+  int resultIdx = -1;
+  trace_node_bvh(node, v_local_from, v_local_dir, in_out_t, v_zero(), [&](uint32_t first_index, uint32_t indices_count) {
+    alignas(EA_CACHE_LINE_SIZE) vec4f vert[CollisionBVHNode::LEAF_TRIANGLES][3];
+    uint32_t count = load_bvh_leaf(node, first_index, indices_count, vert);
+    int ret = traceray4TrianglesCullCCW(v_local_from, v_local_dir, in_out_t, vert, count);
+    if (ret >= 0)
+      resultIdx = first_index + ret * 3;
+    return false;
+  });
+
+  if (resultIdx >= 0 && v_out_norm)
+  {
+    const uint16_t *__restrict indices = node.indices.data();
+    const Point3_vec4 *__restrict vertices = node.vertices.data();
+    vec4f v0 = v_ld(&vertices[indices[resultIdx + 0]].x);
+    vec4f v1 = v_ld(&vertices[indices[resultIdx + 1]].x);
+    vec4f v2 = v_ld(&vertices[indices[resultIdx + 2]].x);
+    *v_out_norm = v_cross3(v_sub(v1, v0), v_sub(v2, v0));
+  }
+  return resultIdx >= 0;
+}
+
+VECTORCALL DAGOR_NOINLINE bool CollisionResource::rayHitMeshNodeBVHLocalCullCCW(const CollisionNode &node, vec4f v_local_from,
+  vec4f v_local_dir, float in_t)
+{
+  return trace_node_bvh(node, v_local_from, v_local_dir, in_t, v_zero(), [&](uint32_t first_index, uint32_t indices_count) {
+    alignas(EA_CACHE_LINE_SIZE) vec4f vert[CollisionBVHNode::LEAF_TRIANGLES][3];
+    uint32_t count = load_bvh_leaf(node, first_index, indices_count, vert);
+    return rayhit4TrianglesCullCCW(v_local_from, v_local_dir, in_t, vert, count) != 0;
+  });
+}
+
+VECTORCALL DAGOR_NOINLINE bool CollisionResource::traceRayMeshNodeBVHLocalAllHits(const CollisionNode &node, vec4f v_local_from,
+  vec4f v_local_dir, float in_t, bool calc_normal, bool no_cull, all_nodes_ret_t &ret_array)
+{
+  no_cull |= node.checkBehaviorFlags(CollisionNode::SOLID);
+  trace_node_bvh(node, v_local_from, v_local_dir, in_t, v_zero(), [&](uint32_t first_index, uint32_t indices_count) {
+    alignas(EA_CACHE_LINE_SIZE) vec4f vert[CollisionBVHNode::LEAF_TRIANGLES][3];
+    uint32_t count = load_bvh_leaf(node, first_index, indices_count, vert);
+    vec4f vInOutT = v_splats(in_t);
+    int ret = traceray4TrianglesMask(v_local_from, v_local_dir, vInOutT, vert, no_cull);
+    if (EASTL_UNLIKELY(ret != 0))
+    {
+      alignas(16) float outT[CollisionBVHNode::LEAF_TRIANGLES];
+      v_st(outT, vInOutT);
+      for (uint32_t j = 0; j < count; j++, ret >>= 1)
+        if (ret & 1u)
+        {
+          vec3f vNorm = calc_normal ? v_cross3(v_sub(vert[j][1], vert[j][0]), v_sub(vert[j][2], vert[j][0])) : v_zero();
+          ret_array.push_back(v_perm_xyzd(vNorm, v_splats(outT[j])));
+        }
+    }
+    return false;
+  });
+  return !ret_array.empty();
+}
+
 template <bool check_bounding>
 VECTORCALL DAGOR_NOINLINE bool CollisionResource::traceRayMeshNodeLocalCullCCW(const CollisionNode &node,
   const vec4f &v_local_from, // better to hold it in memory
   const vec4f &v_local_dir,  // it prevents inefficient loop optimizations
   float &in_out_t, vec4f *v_out_norm)
 {
+  if (!node.bvh.empty())
+    return traceRayMeshNodeBVHLocalCullCCW(node, v_local_from, v_local_dir, in_out_t, v_out_norm);
+
   int resultIdx = -1;
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
@@ -1822,28 +1978,41 @@ VECTORCALL DAGOR_NOINLINE bool CollisionResource::traceCapsuleMeshNodeLocalCullC
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
   const uint32_t indicesSize = node.indices.size();
+  const float inT = in_out_t, inRadius = radius;
+  uint32_t bestIndex = 0;
 
   // float bestScore = FLT_MIN;
 
-  for (uint32_t i = 0; EASTL_LIKELY(i < indicesSize); i += 3)
-  {
-    vec3f v0 = v_ld(&vertices[indices[i + 0]].x);
-    vec3f v1 = v_ld(&vertices[indices[i + 1]].x);
-    vec3f v2 = v_ld(&vertices[indices[i + 2]].x);
-    vec4f norm, pos;
-    float t = in_out_t;
-    if (!test_capsule_triangle_intersection(v_local_from, v_local_dir, v0, v1, v2, radius, t, norm, pos, false))
-      continue;
-    float hitRadius = v_extract_x(distance_to_line_x(pos, v_local_from, v_local_dir));
-    if (hitRadius < radius)
-    {
-      ret = true;
-      radius = hitRadius;
-      in_out_t = t;
-      v_out_norm = norm;
-      v_out_pos = pos;
+  // Every triangle is tested with initial capsule and the best hit is the nearest to capsule axis, then the nearest along it, then
+  // the first in indices, so result doesn't depend on order triangles are visited in (BVH leaves or linear)
+  auto traceTriangles = [&](uint32_t from_index, uint32_t to_index) {
+    for (uint32_t i = from_index; EASTL_LIKELY(i < to_index); i += 3)
+    {
+      vec3f v0 = v_ld(&vertices[indices[i + 0]].x);
+      vec3f v1 = v_ld(&vertices[indices[i + 1]].x);
+      vec3f v2 = v_ld(&vertices[indices[i + 2]].x);
+      vec4f norm, pos;
+      float t = inT;
+      if (!test_capsule_triangle_intersection(v_local_from, v_local_dir, v0, v1, v2, inRadius, t, norm, pos, false))
+        continue;
+      float hitRadius = v_extract_x(distance_to_line_x(pos, v_local_from, v_local_dir));
+      if (hitRadius < radius || (ret && hitRadius == radius && (t < in_out_t || (t == in_out_t && i < bestIndex))))
+      {
+        ret = true;
+        radius = hitRadius;
+        in_out_t = t;
+        bestIndex = i;
+        v_out_norm = norm;
+        v_out_pos = pos;
+      }
     }
-  }
+    return false;
+  };
+  if (!node.bvh.empty())
+    trace_node_bvh(node, v_local_from, v_local_dir, inT, v_splats(inRadius),
+      [&](uint32_t first_index, uint32_t indices_count) { return traceTriangles(first_index, first_index + indices_count); });
+  else
+    traceTriangles(0, indicesSize);
 
   return ret;
 }
@@ -1854,6 +2023,9 @@ VECTORCALL DAGOR_NOINLINE bool CollisionResource::traceRayMeshNodeLocalAllHits(c
   const vec4f &v_local_dir,  // it prevents inefficient loop optimizations
   float in_t, bool calc_normal, bool noCull, all_nodes_ret_t &ret_array)
 {
+  if (!node.bvh.empty())
+    return traceRayMeshNodeBVHLocalAllHits(node, v_local_from, v_local_dir, in_t, calc_normal, noCull, ret_array);
+
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
   const uint32_t indicesSize = node.indices.size();
@@ -1953,6 +2125,9 @@ template <bool check_bounding>
 VECTORCALL DAGOR_NOINLINE bool CollisionResource::rayHitMeshNodeLocalCullCCW(const CollisionNode &node, const vec3f &v_local_from,
   const vec3f &v_local_dir, float in_t)
 {
+  if (!node.bvh.empty())
+    return rayHitMeshNodeBVHLocalCullCCW(node, v_local_from, v_local_dir, in_t);
+
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
   const uint32_t indicesSize = node.indices.size();
@@ -2007,16 +2182,21 @@ VECTORCALL DAGOR_NOINLINE bool CollisionResource::capsuleHitMeshNodeLocalCullCCW
   const Point3_vec4 *__restrict vertices = node.vertices.data();
   const uint32_t indicesSize = node.indices.size();
 
-  for (uint32_t i = 0; EASTL_LIKELY(i < indicesSize); i += 3)
-  {
-    vec3f v0 = v_ld(&vertices[indices[i + 0]].x);
-    vec3f v1 = v_ld(&vertices[indices[i + 1]].x);
-    vec3f v2 = v_ld(&vertices[indices[i + 2]].x);
-    if (test_capsule_triangle_hit(v_local_from, v_local_dir, v0, v1, v2, radius, in_t, false))
-      return true;
-  }
-
-  return false;
+  auto hitTriangles = [&](uint32_t from_index, uint32_t to_index) {
+    for (uint32_t i = from_index; EASTL_LIKELY(i < to_index); i += 3)
+    {
+      vec3f v0 = v_ld(&vertices[indices[i + 0]].x);
+      vec3f v1 = v_ld(&vertices[indices[i + 1]].x);
+      vec3f v2 = v_ld(&vertices[indices[i + 2]].x);
+      if (test_capsule_triangle_hit(v_local_from, v_local_dir, v0, v1, v2, radius, in_t, false))
+        return true;
+    }
+    return false;
+  };
+  if (!node.bvh.empty())
+    return trace_node_bvh(node, v_local_from, v_local_dir, in_t, v_splats(radius),
+      [&](uint32_t first_index, uint32_t indices_count) { return hitTriangles(first_index, first_index + indices_count); });
+  return hitTriangles(0, indicesSize);
 }
 
 int CollisionResource::getNodeIndexByFaceId(int face_id, uint8_t behavior_filter) const
@@ -3102,6 +3282,128 @@ __forceinline mat44f CollisionResource::getMeshNodeTmInline(const CollisionNode
   return outTm;
 }
 
+namespace
+{
+struct CollisionNodeBVHBuilder
+{
+  Tab<CollisionBVHNode> nodes;
+  Tab<uint32_t> tris;
+  Tab<bbox3f> triBoxes;
+  Tab<vec4f> triCenters;
+  vec3f qBase, qScale;
+
+  CollisionNodeBVHBuilder() : nodes(framemem_ptr()), tris(framemem_ptr()), triBoxes(framemem_ptr()), triCenters(framemem_ptr()) {}
+
+  void build(CollisionNode &n)
+  {
+    const uint16_t *indices = n.indices.data();
+    const uint32_t trisCount = n.indices.size() / 3;
+    tris.resize(trisCount);
+    triBoxes.resize(trisCount);
+    triCenters.resize(trisCount);
+    for (uint32_t i = 0; i < trisCount; i++)
+    {
+      tris[i] = i;
+      v_bbox3_init(triBoxes[i], v_ld(&n.vertices[indices[i * 3 + 0]].x));
+      v_bbox3_add_pt(triBoxes[i], v_ld(&n.vertices[indices[i * 3 + 1]].x));
+      v_bbox3_add_pt(triBoxes[i], v_ld(&n.vertices[indices[i * 3 + 2]].x));
+      triCenters[i] = v_bbox3_center(triBoxes[i]);
+    }
+
+    // vertices out of modelBBox are culled by node bbox check anyway, so clamped quantization is fine
+    bbox3f box = v_ldu_bbox3(n.modelBBox);
+    vec3f size = v_bbox3_size(box);
+    qBase = box.bmin;
+    qScale = v_and(v_div(v_splats(CollisionBVHNode::QUANT_MAX), v_max(size, v_splats(1e-30f))), v_cmp_gt(size, v_zero()));
+    nodes.clear();
+    nodes.reserve(trisCount * 2 / CollisionBVHNode::LEAF_TRIANGLES + 1);
+    addNode(0, trisCount, 1);
+
+    Tab<uint16_t> srcIndices(framemem_ptr());
+    srcIndices.assign(n.indices.begin(), n.indices.end());
+    for (uint32_t i = 0; i < trisCount; i++)
+      memcpy(&n.indices[i * 3], &srcIndices[tris[i] * 3], sizeof(uint16_t) * 3);
+    n.bvh.assign(nodes.begin(), nodes.end());
+  }
+
+  uint32_t addNode(uint32_t from, uint32_t to, int depth)
+  {
+    bbox3f box, centersBox;
+    v_bbox3_init_empty(box);
+    v_bbox3_init_empty(centersBox);
+    for (uint32_t i = from; i < to; i++)
+    {
+      v_bbox3_add_box(box, triBoxes[tris[i]]);
+      v_bbox3_add_pt(centersBox, triCenters[tris[i]]);
+    }
+
+    const uint32_t idx = nodes.size();
+    CollisionBVHNode &node = nodes.push_back();
+    // one extra quantum on each side keeps box conservative regardless of rounding in dequantization
+    vec4i qMin = v_cvt_floori(v_sub(v_mul(v_sub(box.bmin, qBase), qScale), V_C_ONE));
+    vec4i qMax = v_cvt_ceili(v_add(v_mul(v_sub(box.bmax, qBase), qScale), V_C_ONE));
+    alignas(16) int q[2][4];
+    v_sti(q[0], v_mini(v_maxi(qMin, v_zeroi()), v_splatsi(0xFFFF)));
+    v_sti(q[1], v_mini(v_maxi(qMax, v_zeroi()), v_splatsi(0xFFFF)));
+    for (int a = 0; a < 3; a++)
+    {
+      node.bmin[a] = q[0][a];
+      node.bmax[a] = q[1][a];
+    }
+
+    const uint32_t count = to - from;
+    if (count <= CollisionBVHNode::LEAF_TRIANGLES)
+    {
+      node.data = (from << 3) | count;
+      return idx;
+    }
+
+    // median split along longest axis of triangle centers gives balanced tree with guaranteed depth
+    G_ASSERT(depth < CollisionBVHNode::MAX_DEPTH);
+    vec3f centersSize = v_bbox3_size(centersBox);
+    const int axis = v_extract_x(centersSize) >= max(v_extract_y(centersSize), v_extract_z(centersSize))
+                       ? 0
+                       : (v_extract_y(centersSize) >= v_extract_z(centersSize) ? 1 : 2);
+    const uint32_t mid = (from + to) / 2;
+    eastl::nth_element(tris.data() + from, tris.data() + mid, tris.data() + to, [&](uint32_t a, uint32_t b) {
+      alignas(16) float ca[4], cb[4];
+      v_st(ca, triCenters[a]);
+      v_st(cb, triCenters[b]);
+      return ca[axis] < cb[axis];
+    });
+    addNode(from, mid, depth + 1);
+    const uint32_t second = addNode(mid, to, depth + 1);
+    nodes[idx].data = second << 3;
+    return idx;
+  }
+};
+} // namespace
+
+void CollisionResource::buildNodesBVH()
+{
+  bool hasBVH = false;
+  for (CollisionNode &n : allNodesList)
+  {
+    if (n.type != COLLISION_NODE_TYPE_MESH && n.type != COLLISION_NODE_TYPE_CONVEX)
+      n.bvh.clear();
+    else if (n.flags & CollisionNode::FLAG_INDICES_ARE_REFS)
+      ; // triangles are shared with FRT and can't be reordered, BVH (if any) was built before FRT
+    else if (n.indices.size() / 3 < CollisionBVHNode::MIN_TRIANGLES)
+      n.bvh.clear();
+    else
+    {
+      FRAMEMEM_REGION;
+      CollisionNodeBVHBuilder builder;
+      builder.build(n);
+    }
+    hasBVH |= !n.bvh.empty();
+  }
+  if (hasBVH)
+    collisionFlags |= COLLISION_RES_FLAG_HAS_NODE_BVH;
+  else
+    collisionFlags &= ~COLLISION_RES_FLAG_HAS_NODE_BVH;
+}
+
 void CollisionResource::collapseAndOptimize(bool need_frt, bool frt_build_fast)
 {
   if (collisionFlags & COLLISION_RES_FLAG_OPTIMIZED)
@@ -3258,6 +3560,7 @@ void CollisionResource::collapseAndOptimize(bool need_frt, bool frt_build_fast)
   allNodesList = eastl::move(newAllNodes);
   sortNodesList();
   rebuildNodesLL();
+  buildNodesBVH(); // before FRT, as it may share reordered triangles
 
   gridForTraceable.reset();
   gridForCollidable.reset();
@@ -6,6 +6,9 @@ template <bool check_bounding>
 VECTORCALL bool CollisionResource::traceRayMeshNodeLocalCullCCW_AVX256(const CollisionNode &node, const vec4f &v_local_from,
   const vec4f &v_local_dir, float &in_out_t, vec4f *v_out_norm)
 {
+  if (!node.bvh.empty())
+    return traceRayMeshNodeBVHLocalCullCCW(node, v_local_from, v_local_dir, in_out_t, v_out_norm);
+
   int resultIdx = -1;
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
@@ -67,6 +70,9 @@ template <bool check_bounding>
 VECTORCALL bool CollisionResource::rayHitMeshNodeLocalCullCCW_AVX256(const CollisionNode &node, const vec4f &v_local_from,
   const vec4f &v_local_dir, float in_t)
 {
+  if (!node.bvh.empty())
+    return rayHitMeshNodeBVHLocalCullCCW(node, v_local_from, v_local_dir, in_t);
+
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
   const uint32_t indicesSize = node.indices.size();
@@ -118,6 +124,9 @@ template <bool check_bounding>
 VECTORCALL bool CollisionResource::traceRayMeshNodeLocalAllHits_AVX256(const CollisionNode &node, const vec4f &v_local_from,
   const vec4f &v_local_dir, float in_t, bool calc_normal, bool noCull, all_nodes_ret_t &ret_array)
 {
+  if (!node.bvh.empty())
+    return traceRayMeshNodeBVHLocalAllHits(node, v_local_from, v_local_dir, in_t, calc_normal, noCull, ret_array);
+
   const uint16_t *__restrict indices = node.indices.data();
   const Point3_vec4 *__restrict vertices = node.vertices.data();
   const uint32_t indicesSize = node.indices.size();
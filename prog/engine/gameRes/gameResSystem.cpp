@@ -37,6 +37,9 @@
 #include <3d/dag_drv3dReset.h>
 #include <startup/dag_globalSettings.h>
 #include <EASTL/string.h>
+#include <EASTL/sort.h>
+#include <EASTL/unique_ptr.h>
+#include <util/dag_threadPool.h>
 
 #include <debug/dag_log.h>
 #include <debug/dag_debug.h>
@@ -92,6 +95,7 @@ struct SetScopeNoFactoryFatal
   ~SetScopeNoFactoryFatal() { noFactoryFatal = prev; }
 };
 static int now_loading_res_id = -1;
+static bool gameres_in_loading = false;
 static enum { OGLE_ALWAYS, OGLE_ONE_ENABLED, OGLE_NOT_ENABLED } one_grp_load_enabled = OGLE_ALWAYS;
 static bool ignoreUnavailableResources = false;
 static bool loggingMissingResources = true;
@@ -217,6 +221,15 @@ void get_game_resource_name(int id, String &name) { return ::getGameResName(id,
 // ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ//
 
 
+// resource data read by concurrent GRP loader for factories that cannot load data in worker threads
+struct DeferredResData
+{
+  GameResourceFactory *fac;
+  unsigned classId;
+  int resId;
+  int ofs, size;
+};
+
 struct GameResPackInfo
 {
   SimpleString fileName;
@@ -228,7 +241,9 @@ struct GameResPackInfo
 
   bool processGrData();
 
+  void readDesc(IGenLoad &cb, int file_sz);
   void loadPack();
+  bool loadPackMT(Tab<char> &deferred_data, Tab<DeferredResData> &deferred_res);
 
   void endLoading()
   {
@@ -761,6 +776,54 @@ void GameResPackInfo::addRefResIds(int res_id, Tab<int> &res_ids)
   }
 }
 
+void GameResPackInfo::readDesc(IGenLoad &cb, int file_sz)
+{
+  using namespace gamerespackbin;
+
+  String cache_fname(0, "%scache.bin", fileName.str());
+  VromReadHandle dump_data = ::vromfs_get_file_data(cache_fname);
+
+  if (!dump_data.data())
+  {
+    GrpHeader ghdr;
+
+    // check id
+    cb.read(&ghdr, sizeof(ghdr));
+    if (ghdr.label != _MAKE4C('GRP2') && ghdr.label != _MAKE4C('GRP3'))
+    {
+      debug("no GRP2 label (hdr: 0x%x 0x%x 0x%x 0x%x)", ghdr.label, ghdr.descOnlySize, ghdr.fullDataSize, ghdr.restFileSize);
+#if (DAGOR_DBGLEVEL < 1) && DAGOR_FORCE_LOGS
+      fatal("no GRP2 label in %s", fileName.str());
+#endif
+      DAGOR_THROW(IGenLoad::LoadException("no GRP2 label", cb.tell()));
+    }
+    if (ghdr.restFileSize + sizeof(ghdr) != file_sz)
+    {
+      debug("Corrupt file: hdr+restFileSize=%u != filesz=%d", unsigned(ghdr.restFileSize + sizeof(ghdr)), file_sz);
+#if (DAGOR_DBGLEVEL < 1) && DAGOR_FORCE_LOGS
+      fatal("Corrupt file %s", fileName.str());
+#endif
+      DAGOR_THROW(IGenLoad::LoadException("Corrupt file: restFileSize", cb.tell()));
+    }
+
+    grData = (GrpData *)memalloc(ghdr.descOnlySize, inimem);
+    cb.read(grData, ghdr.descOnlySize);
+    grData->patchDescOnly(ghdr.label);
+  }
+  else
+  {
+    GrpHeader *__restrict ghdr = (GrpHeader *)dump_data.data();
+
+    grData = (GrpData *)memalloc(ghdr->descOnlySize, inimem);
+    memcpy(grData, dump_data.data() + sizeof(GrpHeader), ghdr->descOnlySize);
+    grData->patchDescOnly(ghdr->label);
+  }
+
+  // register all names and renew nameMap
+  for (int i = 0; i < grData->nameMap.size(); i++)
+    grData->nameMap[i] = ::addGameResId(grData->getName(i));
+}
+
 void GameResPackInfo::loadPack()
 {
   if (!refCount)
@@ -807,48 +870,7 @@ void GameResPackInfo::loadPack()
 
   DAGOR_TRY
   {
-    String cache_fname(0, "%scache.bin", fileName.str());
-    VromReadHandle dump_data = ::vromfs_get_file_data(cache_fname);
-
-    if (!dump_data.data())
-    {
-      GrpHeader ghdr;
-
-      // check id
-      cb.read(&ghdr, sizeof(ghdr));
-      if (ghdr.label != _MAKE4C('GRP2') && ghdr.label != _MAKE4C('GRP3'))
-      {
-        debug("no GRP2 label (hdr: 0x%x 0x%x 0x%x 0x%x)", ghdr.label, ghdr.descOnlySize, ghdr.fullDataSize, ghdr.restFileSize);
-#if (DAGOR_DBGLEVEL < 1) && DAGOR_FORCE_LOGS
-        fatal("no GRP2 label in %s", fileName.str());
-#endif
-        DAGOR_THROW(IGenLoad::LoadException("no GRP2 label", cb.tell()));
-      }
-      if (ghdr.restFileSize + sizeof(ghdr) != file_sz)
-      {
-        debug("Corrupt file: hdr+restFileSize=%u != filesz=%d", unsigned(ghdr.restFileSize + sizeof(ghdr)), file_sz);
-#if (DAGOR_DBGLEVEL < 1) && DAGOR_FORCE_LOGS
-        fatal("Corrupt file %s", fileName.str());
-#endif
-        DAGOR_THROW(IGenLoad::LoadException("Corrupt file: restFileSize", cb.tell()));
-      }
-
-      grData = (GrpData *)memalloc(ghdr.descOnlySize, inimem);
-      cb.read(grData, ghdr.descOnlySize);
-      grData->patchDescOnly(ghdr.label);
-    }
-    else
-    {
-      GrpHeader *__restrict ghdr = (GrpHeader *)dump_data.data();
-
-      grData = (GrpData *)memalloc(ghdr->descOnlySize, inimem);
-      memcpy(grData, dump_data.data() + sizeof(GrpHeader), ghdr->descOnlySize);
-      grData->patchDescOnly(ghdr->label);
-    }
-
-    // register all names and renew nameMap
-    for (int i = 0; i < grData->nameMap.size(); i++)
-      grData->nameMap[i] = ::addGameResId(grData->getName(i));
+    readDesc(cb, file_sz);
 
     // create real-res
     dag::ConstSpan<int> gdNameId = grData->nameMap;
@@ -969,6 +991,75 @@ void GameResPackInfo::loadPack()
 }
 
 
+bool GameResPackInfo::loadPackMT(Tab<char> &deferred_data, Tab<DeferredResData> &deferred_res)
+{
+  using namespace gamerespackbin;
+  FastSeqReadCB seq_cb;
+  VromReadHandle vrom_data = ::vromfs_get_file_data(fileName.str());
+  InPlaceMemLoadCB vrom_cb(vrom_data.data(), data_size(vrom_data));
+  IGenLoad &cb = vrom_data.data() ? static_cast<IGenLoad &>(vrom_cb) : static_cast<IGenLoad &>(seq_cb);
+  int this_packId = this - packInfo.data();
+
+  if (!vrom_data.data() && !seq_cb.open(fileName, 32 << 10))
+    return false; // serial loadPack() will report error in details
+  int file_sz = vrom_data.data() ? data_size(vrom_data) : seq_cb.getSize();
+  bool ok = true;
+
+  DAGOR_TRY
+  {
+    readDesc(cb, file_sz);
+
+    dag::ConstSpan<int> gdNameId = grData->nameMap;
+    const ResEntry *__restrict rre = grData->resTable.data(), *__restrict rre_end = rre + grData->resTable.size();
+    for (; rre != rre_end; rre++)
+    {
+      if (rre->offset == 0)
+        continue;
+      int gdni = gdNameId[rre->resId];
+      if (resRestrictionList.size() && ((uint32_t)gdni >= (uint32_t)resRestrictionList.size() || !resRestrictionList.get(gdni)))
+        continue;
+      if (resId_to_packId[gdni] != this_packId)
+        continue;
+
+      GameResourceFactory *fac = ::getFactoryByClassId(rre->classId);
+      cb.seekto(rre->offset);
+      if (fac && fac->isLoadDataThreadSafe())
+      {
+        fac->loadGameResourceData(gdni, cb);
+        continue;
+      }
+
+      // keep raw data to be fed to factory later in context of loading thread
+      DeferredResData &d = deferred_res.push_back();
+      d.fac = fac;
+      d.classId = rre->classId;
+      d.resId = gdni;
+      d.ofs = deferred_data.size();
+      d.size = fac ? ((rre + 1 == rre_end) ? file_sz : rre[1].offset) - rre->offset : 0;
+      if (d.size > 0)
+      {
+        append_items(deferred_data, d.size);
+        cb.read(&deferred_data[d.ofs], d.size);
+      }
+    }
+  }
+  DAGOR_CATCH(IGenLoad::LoadException)
+  {
+    debug("Error reading GameResPack file %s", fileName.str());
+    ok = false;
+  }
+  if (!vrom_data.data())
+    seq_cb.close();
+
+  if (!ok)
+  {
+    endLoading();
+    clear_and_shrink(deferred_data);
+    clear_and_shrink(deferred_res);
+  }
+  return ok;
+}
+
 static void loadGameResPack(int pack_id, int res_id)
 {
   if (pack_id < 0)
@@ -1148,16 +1239,14 @@ void load_game_resource_pack(int res_id)
     clearLoadedPacksList();
   }
 
-  static bool inLoading = false;
-
-  bool isFirst = !inLoading;
-  inLoading = true;
+  bool isFirst = !gameres_in_loading;
+  gameres_in_loading = true;
 
   ::loadGameResPack(resPackId, res_id);
 
   if (isFirst)
   {
-    inLoading = false;
+    gameres_in_loading = false;
     clearLoadedPacksList();
   }
 
@@ -1224,6 +1313,218 @@ void load_game_resource_pack_by_name(const char *fname, bool only_one_gameres_pa
   TRACE("load_game_resource_pack_by_name  finished\n");
 }
 
+namespace
+{
+struct GrpLoadJob final : public cpujobs::IJob
+{
+  int packId = -1;
+  bool loaded = false;
+  Tab<char> deferredData;
+  Tab<DeferredResData> deferredRes;
+
+  void doJob() override { loaded = packInfo[packId].loadPackMT(deferredData, deferredRes); }
+};
+} // namespace
+
+// returns number of leading packs whose referenced packs (of this batch) all come before them
+static int sort_packs_by_dependencies(Tab<int> &packs, const Tab<int> &pack_local_idx)
+{
+  // edges: (referenced pack, referencing pack) in local indices
+  Tab<eastl::pair<int, int>> edges(tmpmem);
+  for (const GameResInfo &info : grInfo)
+  {
+    if (info.packId < 0 || pack_local_idx[info.packId] < 0)
+      continue;
+    for (unsigned i = 0; i < info.refNum; i++)
+      if (const GameResInfo *ref = ::getGameResInfo(grInfoRefs[info.refStartIdx + i]))
+        if (ref->packId >= 0 && ref->packId != info.packId && pack_local_idx[ref->packId] >= 0)
+          edges.push_back(eastl::make_pair(pack_local_idx[ref->packId], pack_local_idx[info.packId]));
+  }
+  eastl::sort(edges.begin(), edges.end());
+  edges.erase(eastl::unique(edges.begin(), edges.end()), edges.end());
+
+  Tab<int> depCnt(tmpmem), order(tmpmem);
+  depCnt.resize(packs.size());
+  mem_set_0(depCnt);
+  for (auto &e : edges)
+    depCnt[e.second]++;
+  order.reserve(packs.size());
+  for (int i = 0; i < packs.size(); i++)
+    if (!depCnt[i])
+      order.push_back(i);
+  for (int oi = 0; oi < order.size(); oi++)
+  {
+    auto it = eastl::lower_bound(edges.begin(), edges.end(), eastl::make_pair(order[oi], -1));
+    for (; it != edges.end() && it->first == order[oi]; ++it)
+      if (--depCnt[it->second] == 0)
+        order.push_back(it->second);
+  }
+  const int orderedCnt = order.size();
+  if (orderedCnt < packs.size()) // cyclic references between GRPs; remaining packs go in original order
+  {
+    debug("load_game_resource_packs_mt: %d GRPs have cyclic references", packs.size() - order.size());
+    for (int i = 0; i < packs.size(); i++)
+      if (depCnt[i] > 0)
+        order.push_back(i);
+  }
+
+  Tab<int> sorted(tmpmem);
+  sorted.resize(packs.size());
+  for (int i = 0; i < order.size(); i++)
+    sorted[i] = packs[order[i]];
+  packs = eastl::move(sorted);
+  return orderedCnt;
+}
+
+int load_game_resource_packs_mt(dag::ConstSpan<const char *> res_names)
+{
+  Tab<int> res_ids(tmpmem);
+  res_ids.reserve(res_names.size());
+  for (const char *name : res_names)
+  {
+    int id = resNameMap.getNameId(name);
+    if (id >= 0)
+      res_ids.push_back(id);
+  }
+
+  if (gamereshooks::on_load_game_resource_pack || one_grp_load_enabled != OGLE_ALWAYS)
+  {
+    // hooks and one-GRP restrictions are handled by regular (serial) loading
+    for (int id : res_ids)
+      if (get_game_resource(id))
+        release_game_resource(id); // by id, so that on_release_game_resource hook gets reference taken via hook
+    return 0;
+  }
+
+  int64_t reft = profile_ref_ticks();
+  d3d::LoadingAutoLock loadingLock;
+
+  gameres_cs.lock();
+  int gameres_cs_cnt = gameres_cs.fullUnlock() - 1;
+  gameres_load_cs.lock();
+
+  // gather GRPs with not loaded resources (including referenced ones)
+  Tab<int> packs(tmpmem), packLocalIdx(tmpmem);
+  packLocalIdx.resize(packInfo.size());
+  mem_set_ff(packLocalIdx);
+  {
+    WinAutoLock lock(gameres_cs);
+    Bitarray visited;
+    visited.resize(resId_to_grInfo.size());
+    while (res_ids.size())
+    {
+      int rid = res_ids.back();
+      res_ids.pop_back();
+      if ((unsigned)rid >= visited.size() || visited.get(rid))
+        continue;
+      visited.set(rid);
+      if (resRestrictionList.size() && ((unsigned)rid >= resRestrictionList.size() || !resRestrictionList.get(rid)))
+        continue;
+      GameResInfo *info = ::getGameResInfo(rid);
+      if (!info || info->packId < 0)
+        continue;
+
+      for (unsigned i = 0; i < info->refNum; i++)
+        if (grInfoRefs[info->refStartIdx + i] >= 0)
+          res_ids.push_back(grInfoRefs[info->refStartIdx + i]);
+
+      if (packLocalIdx[info->packId] >= 0 || find_value_idx(loadedPacks, info->packId) >= 0)
+        continue;
+      GameResourceFactory *fac = ::getFactoryByClassId(grMap[info->grMapIdx].id.classId);
+      if (fac && fac->isResLoaded(rid))
+        continue;
+      packLocalIdx[info->packId] = packs.size();
+      packs.push_back(info->packId);
+    }
+  }
+  int orderedCnt = packs.size();
+  if (packs.size() > 1)
+    orderedCnt = sort_packs_by_dependencies(packs, packLocalIdx);
+
+  // read GRPs (and load data for thread-safe factories) in worker threads
+  bool isFirst = !gameres_in_loading;
+  gameres_in_loading = true;
+
+  eastl::unique_ptr<GrpLoadJob[]> jobs(new GrpLoadJob[packs.size()]);
+  uint32_t queuePos = 0;
+  bool use_threadpool = threadpool::get_num_workers() > 0;
+  for (int i = 0; i < packs.size(); i++)
+  {
+    jobs[i].packId = packs[i];
+    loadedPacks.push_back(packs[i]);
+    if (use_threadpool)
+      threadpool::add(&jobs[i], threadpool::PRIO_NORMAL, queuePos, threadpool::AddFlags::IgnoreNotDone);
+    else
+      jobs[i].doJob();
+  }
+  if (use_threadpool)
+    threadpool::wake_up_all();
+
+  // feed deferred data to non thread-safe factories; buffers are freed as soon as pack is processed
+  auto feedDeferred = [&](GrpLoadJob &j) {
+    if (!j.loaded)
+    {
+      erase_item_by_value(loadedPacks, j.packId);
+      ::loadGameResPack(j.packId, -1);
+      return;
+    }
+    for (const DeferredResData &d : j.deferredRes)
+    {
+      if (!d.fac)
+      {
+        String className, resName;
+        ::getResClassName(d.classId, className);
+        ::getGameResName(d.resId, resName);
+        if (noFactoryFatal)
+          fatal("No factory for game resource %s:%s", className.str(), resName.str());
+        else
+          logwarn("No factory for game resource %s:%s", className.str(), resName.str());
+        continue;
+      }
+      InPlaceMemLoadCB crd(&j.deferredData[d.ofs], d.size);
+      d.fac->loadGameResourceData(d.resId, crd);
+    }
+    clear_and_shrink(j.deferredData);
+    clear_and_shrink(j.deferredRes);
+  };
+
+  // create resources of each pack as soon as its data is loaded, while next packs are still read by workers; packs are sorted so
+  // that referenced packs are created first. Packs with cyclic references are all loaded before any of them is created, so
+  // resources pulled from other GRPs of the cycle are complete. gameres_cs is held, since workers add data to thread-safe
+  // factories under it (so it is not held while waiting for them), while created resources look these factories up
+  int64_t createUsec = 0;
+  for (int i = 0; i < packs.size(); i++)
+  {
+    const int readyFrom = i, readyTo = i < orderedCnt ? i + 1 : (i == orderedCnt ? packs.size() : i);
+    if (use_threadpool)
+      for (int k = readyFrom; k < readyTo; k++)
+        threadpool::wait(&jobs[k], 0, threadpool::PRIO_NORMAL);
+    WinAutoLock lock(gameres_cs);
+    for (int k = readyFrom; k < readyTo; k++)
+      feedDeferred(jobs[k]);
+    if (!jobs[i].loaded)
+      continue;
+    int64_t createReft = profile_ref_ticks();
+    packInfo[packs[i]].processGrData();
+    packInfo[packs[i]].surelyLoaded = true;
+    createUsec += profile_time_usec(createReft);
+  }
+
+  if (isFirst)
+  {
+    gameres_in_loading = false;
+    clearLoadedPacksList();
+  }
+
+  gameres_load_cs.unlock();
+  if (gameres_cs_cnt)
+    gameres_cs.reLock(gameres_cs_cnt);
+
+  debug("load_game_resource_packs_mt: %d GRPs loaded in %d usec (%d usec creating resources, %d workers)", packs.size(),
+    profile_time_usec(reft), int(createUsec), threadpool::get_num_workers());
+  return packs.size();
+}
+
 // ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ//
 
 
@@ -164,6 +164,8 @@ public:
   }
 
 
+  bool isLoadDataThreadSafe() override { return true; }
+
   void createGameResource(int /*res_id*/, const int * /*reference_ids*/, int /*num_refs*/) override {}
 
   void reset() override { treeData.clear(); }
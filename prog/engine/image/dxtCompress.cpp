@@ -30,6 +30,8 @@ typedef void *LPVOID;
 #include <stdlib.h>
 #include <perfMon/dag_cpuFreq.h>
 #include <math/dag_adjpow2.h>
+#include <util/dag_parallelForInline.h>
+#include <string.h>
 
 #define CV4(v) v.r, v.g, v.b, v.a
 #define INLINE __forceinline
@@ -71,7 +73,7 @@ void GenNextLevelMipMap(TexPixel32 *pSrc, int srcW, int srcH, TexPixel32 *pDst)
   }
 }
 
-void ManualDXT(int mode, TexPixel32 *pImage, int iWidth, int iHeight, int dxt_pitch, char *pCompressed, int algorithm)
+static void compress_dxt_image(int mode, TexPixel32 *pImage, int iWidth, int iHeight, int dxt_pitch, char *pCompressed, int algorithm)
 {
   if (algorithm != DXT_ALGORITHM_QUICK && mode != MODE_DXT5Alpha)
   {
@@ -86,7 +88,6 @@ void ManualDXT(int mode, TexPixel32 *pImage, int iWidth, int iHeight, int dxt_pi
       rygDXT::CompressImageDXT3((const unsigned char *)pImage, (unsigned char *)pCompressed, iWidth, iHeight, algo, dxt_pitch);
     return;
   }
-  G_ASSERT(is_pow_of2(iWidth) && is_pow_of2(iHeight));
   switch (mode)
   {
     case MODE_DXT1:
@@ -105,6 +106,13 @@ void ManualDXT(int mode, TexPixel32 *pImage, int iWidth, int iHeight, int dxt_pi
   }
 }
 
+void ManualDXT(int mode, TexPixel32 *pImage, int iWidth, int iHeight, int dxt_pitch, char *pCompressed, int algorithm)
+{
+  if (algorithm == DXT_ALGORITHM_QUICK || mode == MODE_DXT5Alpha)
+    G_ASSERT(is_pow_of2(iWidth) && is_pow_of2(iHeight));
+  compress_dxt_image(mode, pImage, iWidth, iHeight, dxt_pitch, pCompressed, algorithm);
+}
+
 void CompressBC4(unsigned char *image, int width, int height, int dxt_pitch, char *pCompressed, int pixel_stride, int pixel_offset)
 {
   fastDXT::CompressImageBC4(image, (unsigned char *)pCompressed, width, height, dxt_pitch, pixel_stride, pixel_offset);
@@ -115,6 +123,36 @@ void CompressBC5(unsigned char *image, int width, int height, int dxt_pitch, cha
   fastDXT::CompressImageBC5(image, (unsigned char *)pCompressed, width, height, dxt_pitch, pixel_stride, pixel_offset);
 }
 
+void dxt_parallel_block_rows(int block_rows, int block_cols, void (*compress_band)(void *ctx, int row0, int row1), void *ctx)
+{
+  // blocks are compressed independently, so any split gives the same output; bands are made big enough to amortize job overhead,
+  // and small images (as well as calls from threadpool workers, e.g. mips built in jobs) are compressed on current thread
+  const int bandRows = max(DXT_MT_MIN_BLOCKS_PER_BAND / max(block_cols, 1), 1);
+  if (block_rows <= bandRows || threadpool::get_num_workers() == 0 || threadpool::get_current_worker_id() >= 0)
+  {
+    if (block_rows > 0)
+      compress_band(ctx, 0, block_rows);
+    return;
+  }
+  threadpool::parallel_for_inline(0, block_rows, bandRows,
+    [compress_band, ctx](uint32_t row0, uint32_t row1, uint32_t) { compress_band(ctx, int(row0), int(row1)); });
+}
+
+void ManualDXT_MT(int mode, TexPixel32 *pImage, int width, int height, int dxt_pitch, char *pCompressed, int algorithm)
+{
+  struct Ctx
+  {
+    int mode, width, height, dxt_pitch, algorithm;
+    TexPixel32 *image;
+    char *out;
+  } ctx = {mode, width, height, dxt_pitch, algorithm, pImage, pCompressed};
+  dxt_parallel_block_rows((height + 3) / 4, (width + 3) / 4, [](void *p, int row0, int row1) {
+    const Ctx &c = *(const Ctx *)p;
+    compress_dxt_image(c.mode, c.image + row0 * 4 * c.width, c.width, min(row1 * 4, c.height) - row0 * 4, c.dxt_pitch,
+      c.out + row0 * c.dxt_pitch, c.algorithm);
+  }, &ctx);
+}
+
 void *CompressDXT(int mode, TexPixel32 *image, int /*stride_bytes*/, int width, int height, int levels, int *len, int /*algorithm*/,
   int zlib_lev)
 {
@@ -198,7 +236,7 @@ void *CompressDXT(int mode, TexPixel32 *image, int /*stride_bytes*/, int width,
   __int64 t0 = ref_time_ticks_qpc();
 
   int pitch = (mode == MODE_DXT1 ? width * 2 : width * 4);
-  ManualDXT(mode, image, width, height, pitch, pData + dataStartOffs);
+  ManualDXT_MT(mode, image, width, height, pitch, pData + dataStartOffs, DXT_ALGORITHM_QUICK);
   debug("Manual DXT for %dx%d (level 0): %d usec", width, height, get_time_usec_qpc(t0));
 
   t0 = ref_time_ticks_qpc();
@@ -231,7 +269,7 @@ void *CompressDXT(int mode, TexPixel32 *image, int /*stride_bytes*/, int width,
       //      save_tga32(String(64, "mip%02d.tga", iLevel), pMipMapBuf+iMipMapBufPos, iCurW/2, iCurH/2, iCurW/2*4);
 
       int pitch = (mode == MODE_DXT1 ? mipW * 2 : mipW * 4);
-      ManualDXT(mode, currentUncompressed, mipW, mipH, pitch, currentCompressed);
+      ManualDXT_MT(mode, currentUncompressed, mipW, mipH, pitch, currentCompressed, DXT_ALGORITHM_QUICK);
 
       // debug("Compressing image=%X to buffer=%X", pMipMapBuf+iMipMapBufPos, pCompressedMipMaps);
 
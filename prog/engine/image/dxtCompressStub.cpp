@@ -17,3 +17,13 @@ void CompressBC4(unsigned char * /*image*/, int /*width*/, int /*height*/, int /
 void CompressBC5(unsigned char * /*image*/, int /*width*/, int /*height*/, int /*dxt_pitch*/, char * /*pCompressed*/,
   int /*row_stride*/, int /*pixel_stride*/)
 {}
+
+void ManualDXT_MT(int /*mode*/, TexPixel32 * /*pImage*/, int /*width*/, int /*height*/, int /*dxt_pitch*/, char * /*pCompressed*/,
+  int /*algorithm*/)
+{}
+
+void dxt_parallel_block_rows(int block_rows, int /*block_cols*/, void (*compress_band)(void *ctx, int row0, int row1), void *ctx)
+{
+  if (block_rows > 0)
+    compress_band(ctx, 0, block_rows);
+}
@@ -0,0 +1,32 @@
+#include <image/dag_dxtCompress.h>
+#include <debug/dag_log.h>
+#include <string.h>
+
+// shared by dxtCompress.cpp and dxtCompressStub.cpp, so that quality names mean the same on all platforms
+
+int dxt_preset_to_algorithm(int preset)
+{
+  switch (preset)
+  {
+    case DXT_PRESET_FASTEST: return DXT_ALGORITHM_QUICK;
+    case DXT_PRESET_NORMAL: return DXT_ALGORITHM_PRECISE;
+    case DXT_PRESET_HIGHEST: return DXT_ALGORITHM_EXCELLENT;
+    default: return DXT_ALGORITHM_PRODUCTION;
+  }
+}
+
+int dxt_preset_from_name(const char *quality, int def_preset)
+{
+  if (!quality || !*quality)
+    return def_preset;
+  if (strcmp(quality, "fastest") == 0)
+    return DXT_PRESET_FASTEST;
+  if (strcmp(quality, "normal") == 0)
+    return DXT_PRESET_NORMAL;
+  if (strcmp(quality, "production") == 0)
+    return DXT_PRESET_PRODUCTION;
+  if (strcmp(quality, "highest") == 0)
+    return DXT_PRESET_HIGHEST;
+  logerr("unknown texture compression quality <%s>, using default", quality);
+  return def_preset;
+}
@@ -4,6 +4,8 @@
 #include <osApiWrappers/dag_localConv.h>
 #include <zlib.h>
 #include <ioSys/dag_zstdIo.h>
+#include <ioSys/dag_fileIo.h>
+#include <util/dag_string.h>
 #include <generic/dag_tab.h>
 #include <hash/md5.h>
 #include <util/dag_globDef.h>
@@ -308,6 +310,11 @@ VirtualRomFsData *load_vromfs_dump(const char *fname, IMemAlloc *mem, verify_sig
   file_ptr_t fp = open_vrom_fp(fname, file_flags, st);
   if (!fp || df_read(fp, &hdr, sizeof(hdr)) != sizeof(hdr))
     goto load_fail;
+  if (hdr.label == _MAKE4C('VRFd'))
+  {
+    df_close(fp);
+    return load_vromfs_dump_patched(NULL, fname, mem, sigcb, to_verify, file_flags);
+  }
   if (hdr.label != _MAKE4C('VRFs') && hdr.label != _MAKE4C('VRFx'))
     goto load_fail;
   if (!checkTargetCode(hdr.target))
@@ -433,6 +440,249 @@ load_fail:
   return NULL;
 }
 
+static bool read_vromfs_contents(const char *fname, int file_flags, Tab<char> &out_contents)
+{
+  VirtualRomFsDataHdr hdr;
+  Tab<char> packed;
+  file_ptr_t fp = df_open(fname, DF_READ | file_flags);
+  if (!fp || df_read(fp, &hdr, sizeof(hdr)) != sizeof(hdr))
+    goto load_fail;
+  if (hdr.label != _MAKE4C('VRFs') && hdr.label != _MAKE4C('VRFx'))
+    goto load_fail;
+  if (!checkTargetCode(hdr.target))
+    goto load_fail;
+  if (hdr.label == _MAKE4C('VRFx'))
+  {
+    VirtualRomFsExtHdr hdr_ext;
+    if (df_read(fp, &hdr_ext, sizeof(hdr_ext)) != sizeof(hdr_ext) || hdr_ext.size < sizeof(hdr_ext))
+      goto load_fail;
+    df_seek_rel(fp, hdr_ext.size - sizeof(hdr_ext));
+  }
+
+  out_contents.resize(hdr.fullSz);
+  if (hdr.packedSz())
+  {
+    packed.resize(hdr.packedSz());
+    if (df_read(fp, packed.data(), hdr.packedSz()) != hdr.packedSz())
+      goto load_fail;
+    if (hdr.zstdPacked())
+    {
+      DEOBFUSCATE_ZSTD_DATA(packed.data(), hdr.packedSz());
+      if (zstd_decompress(out_contents.data(), hdr.fullSz, packed.data(), hdr.packedSz()) != hdr.fullSz)
+        goto load_fail;
+    }
+    else
+    {
+      unsigned long sz = hdr.fullSz;
+      if (uncompress((unsigned char *)out_contents.data(), &sz, (unsigned char *)packed.data(), hdr.packedSz()) != Z_OK ||
+          sz != hdr.fullSz)
+        goto load_fail;
+    }
+  }
+  else if (df_read(fp, out_contents.data(), hdr.fullSz) != hdr.fullSz)
+    goto load_fail;
+  df_close(fp);
+  return true;
+
+load_fail:
+  if (fp)
+    df_close(fp);
+  return false;
+}
+
+static bool read_exact(IGenLoad &crd, void *ptr, int size)
+{
+  while (size > 0)
+  {
+    int rd_sz = crd.tryRead(ptr, size);
+    if (rd_sz <= 0)
+      return false;
+    ptr = (char *)ptr + rd_sz;
+    size -= rd_sz;
+  }
+  return true;
+}
+
+static bool check_md5(const void *data, unsigned sz, const unsigned char ref_md5[16])
+{
+  md5_state_t s;
+  md5_byte_t d[16];
+  md5_init(&s);
+  md5_append(&s, (const unsigned char *)data, sz);
+  md5_finish(&s, d);
+  return memcmp(d, ref_md5, sizeof(d)) == 0;
+}
+
+struct VromfsPatchData
+{
+  VirtualRomFsPatchHdr hdr;
+  Tab<char> dumpHdr, signature;
+};
+
+// reads patch and applies its ops to dest (provided by get_dest for resulting size) as they are unpacked;
+// base is loaded fully since ops reference it randomly
+template <typename F>
+static bool apply_vromfs_patch_ops(const char *base_fname, const char *patch_fname, int file_flags, VromfsPatchData &patch,
+  const F &get_dest)
+{
+  VirtualRomFsPatchHdr &hdr = patch.hdr;
+  FullFileLoadCB crd(patch_fname, DF_READ | file_flags);
+  if (!crd.fileHandle || !read_exact(crd, &hdr, sizeof(hdr)))
+    return false;
+  if (hdr.label != _MAKE4C('VRFd') || !checkTargetCode(hdr.target) || hdr.dumpHdrSz < sizeof(VirtualRomFsDataHdr) ||
+      hdr.sigSz > SIGNATURE_MAX_SIZE || !hdr.opsPackedSz)
+  {
+    logerr("%s: bad vromfs patch <%s>", __FUNCTION__, patch_fname);
+    return false;
+  }
+
+  String base_name;
+  patch.dumpHdr.resize(hdr.dumpHdrSz);
+  base_name.resize(hdr.baseNameLen + 1);
+  base_name[hdr.baseNameLen] = '\0';
+  patch.signature.resize(hdr.sigSz);
+  if (!read_exact(crd, patch.dumpHdr.data(), hdr.dumpHdrSz) || !read_exact(crd, base_name.data(), hdr.baseNameLen) ||
+      !read_exact(crd, patch.signature.data(), hdr.sigSz))
+    return false;
+
+  String base_path;
+  if (!base_fname) // base dump is expected to be near patch
+  {
+    base_path.printf(0, "%.*s%s", int(dd_get_fname(patch_fname) - patch_fname), patch_fname, base_name);
+    base_fname = base_path;
+  }
+
+  Tab<char> base;
+  if (!read_vromfs_contents(base_fname, file_flags, base) || data_size(base) != hdr.baseFullSz ||
+      !check_md5(base.data(), data_size(base), hdr.baseMD5))
+  {
+    logerr("%s: base <%s> doesn't match patch <%s>", __FUNCTION__, base_fname, patch_fname);
+    return false;
+  }
+
+  char *dest = get_dest(hdr.fullSz);
+  if (!dest)
+    return false;
+
+  ZstdLoadCB zcrd(crd, hdr.opsPackedSz);
+  for (unsigned pos = 0; pos < hdr.fullSz;)
+  {
+    uint8_t type = 0;
+    uint32_t len = 0, ofs = 0;
+    if (!read_exact(zcrd, &type, sizeof(type)) || !read_exact(zcrd, &len, sizeof(len)) || len > hdr.fullSz - pos)
+      return false;
+    switch (type)
+    {
+      case VirtualRomFsPatchHdr::VRFD_OP_ADD:
+        if (!read_exact(zcrd, dest + pos, len))
+          return false;
+        break;
+      case VirtualRomFsPatchHdr::VRFD_OP_COPY_BASE:
+        if (!read_exact(zcrd, &ofs, sizeof(ofs)) || ofs > hdr.baseFullSz || len > hdr.baseFullSz - ofs)
+          return false;
+        memcpy(dest + pos, base.data() + ofs, len);
+        break;
+      case VirtualRomFsPatchHdr::VRFD_OP_COPY_SELF:
+        if (!read_exact(zcrd, &ofs, sizeof(ofs)) || ofs > pos || len > pos - ofs)
+          return false;
+        memcpy(dest + pos, dest + ofs, len);
+        break;
+      default: return false;
+    }
+    pos += len;
+  }
+  zcrd.ceaseReading();
+
+  if (!check_md5(dest, hdr.fullSz, hdr.fullMD5))
+  {
+    logerr("%s: MD5 mismatch after applying <%s> to <%s>", __FUNCTION__, patch_fname, base_fname);
+    return false;
+  }
+  return true;
+}
+
+VirtualRomFsData *load_vromfs_dump_patched(const char *base_fname, const char *patch_fname, IMemAlloc *mem, verify_signature_cb sigcb,
+  const dag::ConstSpan<uint8_t> *to_verify, int file_flags)
+{
+  debug("%s <%s> <%s>", __FUNCTION__, base_fname ? base_fname : "", patch_fname);
+
+  VromfsPatchData patch;
+  VirtualRomFsData *fs = NULL;
+  bool ok = apply_vromfs_patch_ops(base_fname, patch_fname, file_flags, patch, [&](unsigned sz) -> char * {
+    fs = (VirtualRomFsData *)mem->tryAlloc(FS_OFFS + sz);
+    if (!fs)
+      return NULL;
+    new (fs, _NEW_INPLACE) VirtualRomFsData();
+    return (char *)fs + FS_OFFS;
+  });
+
+  if (ok)
+  {
+    const VirtualRomFsDataHdr &dump_hdr = *(const VirtualRomFsDataHdr *)patch.dumpHdr.data();
+    if (dump_hdr.label == _MAKE4C('VRFx') && data_size(patch.dumpHdr) >= sizeof(dump_hdr) + sizeof(VirtualRomFsExtHdr))
+    {
+      const VirtualRomFsExtHdr &hdr_ext = *(const VirtualRomFsExtHdr *)(&dump_hdr + 1);
+      fs->flags = hdr_ext.flags;
+      fs->version = hdr_ext.version;
+    }
+    DagorStat st;
+    if (df_stat(patch_fname, &st) == 0)
+      fs->mtime = st.mtime;
+
+    if (sigcb && patch.signature.size())
+    {
+      // resulting dump is not stored on disk, so only signature of contents can be verified
+      const void *tmpBuf[] = {(char *)fs + FS_OFFS, to_verify ? to_verify->data() : NULL, NULL};
+      unsigned bsizes[] = {patch.hdr.fullSz, to_verify ? (unsigned)to_verify->size() : 0, 0};
+      ok = dump_hdr.signedContents() && sigcb(tmpBuf, bsizes, (const unsigned char *)patch.signature.data(), data_size(patch.signature));
+    }
+    else if (sigcb)
+      ok = sigcb(NULL, NULL, NULL, 0);
+  }
+
+  if (!ok)
+  {
+    if (fs)
+      memfree(fs, mem);
+    return NULL;
+  }
+  return patch_fs(fs);
+}
+
+bool apply_vromfs_patch(const char *base_fname, const char *patch_fname, const char *dest_fname)
+{
+  VromfsPatchData patch;
+  Tab<char> contents;
+  if (!apply_vromfs_patch_ops(base_fname, patch_fname, 0, patch, [&](unsigned sz) {
+        contents.resize(sz);
+        return contents.data();
+      }))
+    return false;
+
+  VirtualRomFsDataHdr &dump_hdr = *(VirtualRomFsDataHdr *)patch.dumpHdr.data();
+  dump_hdr.fullSz = patch.hdr.fullSz;
+  dump_hdr.hw32 &= 0x80000000U; // stored non-packed, keep signedContents flag
+
+  // written to temp file and renamed, so dest_fname (that may be base_fname) is never left truncated
+  String tmpFname(0, "%s.tmp", dest_fname);
+  file_ptr_t fp = df_open(tmpFname, DF_WRITE | DF_CREATE);
+  if (!fp)
+  {
+    logerr("%s: failed to create <%s>", __FUNCTION__, tmpFname);
+    return false;
+  }
+  bool ok = df_write(fp, patch.dumpHdr.data(), data_size(patch.dumpHdr)) == data_size(patch.dumpHdr) &&
+            df_write(fp, contents.data(), data_size(contents)) == data_size(contents) &&
+            df_write(fp, patch.hdr.fullMD5, sizeof(patch.hdr.fullMD5)) == sizeof(patch.hdr.fullMD5) &&
+            df_write(fp, patch.signature.data(), data_size(patch.signature)) == data_size(patch.signature);
+  df_close(fp);
+  if (ok && dd_rename(tmpFname, dest_fname))
+    return true;
+  dd_erase(tmpFname);
+  logerr("%s: failed to write <%s>", __FUNCTION__, dest_fname);
+  return false;
+}
+
 VirtualRomFsData *load_crypted_vromfs_dump(const char *fname, IMemAlloc *mem)
 {
   (void)(fname);
@@ -0,0 +1,434 @@
+#include <ioSys/dag_zstdSeekableIo.h>
+#include <ioSys/dag_zstdIo.h>
+#include <util/dag_globDef.h>
+#include <util/dag_threadPool.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <debug/dag_debug.h>
+#define ZSTD_STATIC_LINKING_ONLY 1
+#include <arc/zstd-1.4.5/zstd.h>
+#include <EASTL/unique_ptr.h>
+
+static constexpr uint32_t SKIPPABLE_FRAME_MAGIC = 0x184D2A5E;
+static constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+static constexpr int SEEK_TABLE_FOOTER_SIZE = 9; // numFrames:u32, descriptor:u8, magic:u32
+static constexpr int SKIPPABLE_HEADER_SIZE = 8;  // magic:u32, size:u32
+static constexpr uint8_t DESC_CHECKSUM_FLAG = 0x80;
+
+static inline uint32_t read_u32(const char *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+ZstdSeekableSaveCB::ZstdSeekableSaveCB(IGenSave &dest_cwr, int compression_level, int frame_size) :
+  cwrDest(&dest_cwr), compressionLevel(compression_level), frameSize(frame_size > 0 ? frame_size : DEFAULT_FRAME_SIZE)
+{
+  cctx = zstd_create_cctx();
+  frameBuf.reserve(frameSize);
+}
+ZstdSeekableSaveCB::~ZstdSeekableSaveCB()
+{
+  G_ASSERTF(!frameBuf.size() && !cwrDest, "ZstdSeekableSaveCB destroyed without finish()");
+  zstd_destroy_cctx(cctx);
+  cctx = nullptr;
+}
+
+void ZstdSeekableSaveCB::write(const void *ptr, int size)
+{
+  const char *p = (const char *)ptr;
+  while (size > 0)
+  {
+    if (writePos < (int)frameBuf.size()) // overwrite after seekto()
+    {
+      int sz = min(size, int(frameBuf.size()) - writePos);
+      memcpy(&frameBuf[writePos], p, sz);
+      writePos += sz;
+      p += sz;
+      size -= sz;
+      continue;
+    }
+
+    int sz = blocks.size() ? size : min(size, frameSize - (int)frameBuf.size());
+    append_items(frameBuf, sz, p);
+    writePos += sz;
+    p += sz;
+    size -= sz;
+    if ((int)frameBuf.size() >= frameSize && !blocks.size())
+      compressFrame();
+  }
+}
+
+void ZstdSeekableSaveCB::seekto(int pos)
+{
+  if (pos < frameStartPos || pos > frameStartPos + frameBuf.size())
+  {
+    logerr_ctx("seekto(%d) outside of current frame [%d, %d]", pos, int(frameStartPos), int(frameStartPos + frameBuf.size()));
+    DAGOR_THROW(SaveException("seekto outside of current frame", tell()));
+    return;
+  }
+  writePos = int(pos - frameStartPos);
+}
+
+void ZstdSeekableSaveCB::flushFrame()
+{
+  G_ASSERTF_RETURN(!blocks.size(), , "cannot end frame inside block");
+  if (frameBuf.size())
+    compressFrame();
+}
+
+void ZstdSeekableSaveCB::compressFrame()
+{
+  comprBuf.resize(zstd_compress_bound(frameBuf.size()));
+  size_t enc_sz = ZSTD_compressCCtx(cctx, comprBuf.data(), comprBuf.size(), frameBuf.data(), frameBuf.size(), compressionLevel);
+  if (ZSTD_isError(enc_sz))
+  {
+    DAGOR_THROW(SaveException("ZSTD_compressCCtx error", (int)enc_sz));
+    return;
+  }
+  cwrDest->write(comprBuf.data(), (int)enc_sz);
+
+  FrameEntry &e = frames.push_back();
+  e.compSize = (uint32_t)enc_sz;
+  e.decompSize = frameBuf.size();
+  frameStartPos += frameBuf.size();
+  frameBuf.clear();
+  writePos = 0;
+}
+
+void ZstdSeekableSaveCB::finish()
+{
+  G_ASSERTF_RETURN(cwrDest, , "finish() called twice");
+  flushFrame();
+
+  uint32_t hdr[2] = {SKIPPABLE_FRAME_MAGIC, uint32_t(frames.size() * sizeof(FrameEntry) + SEEK_TABLE_FOOTER_SIZE)};
+  cwrDest->write(hdr, sizeof(hdr));
+  cwrDest->write(frames.data(), data_size(frames));
+
+  char footer[SEEK_TABLE_FOOTER_SIZE];
+  uint32_t num_frames = frames.size(), magic = SEEKABLE_MAGIC;
+  memcpy(footer, &num_frames, sizeof(num_frames));
+  footer[4] = 0; // no checksums
+  memcpy(footer + 5, &magic, sizeof(magic));
+  cwrDest->write(footer, sizeof(footer));
+
+  clear_and_shrink(frameBuf);
+  clear_and_shrink(comprBuf);
+  cwrDest = nullptr;
+}
+
+
+ZstdSeekableLoadCB::ZstdSeekableLoadCB(dag::ConstSpan<char> enc_data)
+{
+  if (!open(enc_data))
+    logerr("failed to open seekable zstd stream in memory (%d bytes)", (int)enc_data.size());
+}
+ZstdSeekableLoadCB::ZstdSeekableLoadCB(IGenLoad &in_crd, int in_size)
+{
+  if (!open(in_crd, in_size))
+    logerr("failed to open seekable zstd stream (%d bytes) in %s", in_size, in_crd.getTargetName());
+}
+
+bool ZstdSeekableLoadCB::open(IGenLoad &in_crd, int in_size)
+{
+  close();
+  srcCrd = &in_crd;
+  srcBase = in_crd.tell();
+  if (readSeekTable(in_size))
+    return true;
+  close();
+  return false;
+}
+bool ZstdSeekableLoadCB::open(dag::ConstSpan<char> enc_data)
+{
+  close();
+  srcData = enc_data;
+  if (readSeekTable(enc_data.size()))
+    return true;
+  close();
+  return false;
+}
+void ZstdSeekableLoadCB::close()
+{
+  if (dctx)
+    zstd_destroy_dctx(dctx);
+  dctx = nullptr;
+  srcCrd = nullptr;
+  srcBase = 0;
+  srcData.reset();
+  clear_and_shrink(frameCOfs);
+  clear_and_shrink(frameDOfs);
+  clear_and_shrink(frameBuf);
+  clear_and_shrink(comprBuf);
+  uniformFrameSize = 0;
+  curPos = 0;
+  curFrame = -1;
+  blocks.clear();
+}
+
+bool ZstdSeekableLoadCB::readSeekTable(int64_t total_size)
+{
+  if (total_size < SKIPPABLE_HEADER_SIZE + SEEK_TABLE_FOOTER_SIZE)
+    return false;
+
+  char footer[SEEK_TABLE_FOOTER_SIZE];
+  Tab<char> table;
+  auto readSrc = [&](int64_t ofs, void *dst, int sz) {
+    if (srcCrd)
+    {
+      srcCrd->seekto(int(srcBase + ofs));
+      srcCrd->read(dst, sz);
+    }
+    else
+      memcpy(dst, srcData.data() + ofs, sz);
+  };
+
+  readSrc(total_size - SEEK_TABLE_FOOTER_SIZE, footer, sizeof(footer));
+  uint32_t num_frames = read_u32(footer);
+  uint8_t desc = footer[4];
+  if (read_u32(footer + 5) != SEEKABLE_MAGIC || (desc & 0x7C))
+  {
+    logerr("%s: bad seekable zstd footer", getTargetName());
+    return false;
+  }
+  const int entry_sz = (desc & DESC_CHECKSUM_FLAG) ? 12 : 8;
+  const int64_t table_sz = SKIPPABLE_HEADER_SIZE + int64_t(num_frames) * entry_sz + SEEK_TABLE_FOOTER_SIZE;
+  if (table_sz > total_size)
+  {
+    logerr("%s: seek table size %lld exceeds stream size %lld", getTargetName(), (long long)table_sz, (long long)total_size);
+    return false;
+  }
+
+  table.resize(table_sz);
+  readSrc(total_size - table_sz, table.data(), table.size());
+  if (read_u32(table.data()) != SKIPPABLE_FRAME_MAGIC || read_u32(table.data() + 4) != table_sz - SKIPPABLE_HEADER_SIZE)
+  {
+    logerr("%s: bad seek table header", getTargetName());
+    return false;
+  }
+
+  frameCOfs.resize(num_frames + 1);
+  frameDOfs.resize(num_frames + 1);
+  frameCOfs[0] = frameDOfs[0] = 0;
+  uniformFrameSize = 0;
+  bool uniform = true;
+  for (uint32_t i = 0; i < num_frames; i++)
+  {
+    const char *e = table.data() + SKIPPABLE_HEADER_SIZE + i * entry_sz;
+    uint32_t c_sz = read_u32(e), d_sz = read_u32(e + 4);
+    frameCOfs[i + 1] = frameCOfs[i] + c_sz;
+    frameDOfs[i + 1] = frameDOfs[i] + d_sz;
+    if (i == 0)
+      uniformFrameSize = d_sz;
+    else if (i + 1 < num_frames && d_sz != uniformFrameSize)
+      uniform = false;
+  }
+  if (!uniform || (num_frames > 1 && frameDOfs[num_frames] - frameDOfs[num_frames - 1] > uniformFrameSize))
+    uniformFrameSize = 0;
+  if (frameCOfs[num_frames] + table_sz != total_size)
+  {
+    logerr("%s: frames size %lld + seek table %lld != stream size %lld", getTargetName(), (long long)frameCOfs[num_frames],
+      (long long)table_sz, (long long)total_size);
+    return false;
+  }
+
+  dctx = zstd_create_dctx();
+  curPos = 0;
+  curFrame = -1;
+  return true;
+}
+
+int ZstdSeekableLoadCB::findFrame(int64_t pos) const
+{
+  const int n = getFramesCount();
+  if (uniformFrameSize > 0)
+    return min(int(pos / uniformFrameSize), n - 1);
+  int lo = 0, hi = n - 1;
+  while (lo < hi)
+  {
+    int mid = (lo + hi + 1) / 2;
+    if (frameDOfs[mid] <= pos)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  return lo;
+}
+
+void ZstdSeekableLoadCB::readCompressed(int frame, Tab<char> &buf)
+{
+  int sz = int(frameCOfs[frame + 1] - frameCOfs[frame]);
+  buf.resize(sz);
+  srcCrd->seekto(int(srcBase + frameCOfs[frame]));
+  srcCrd->read(buf.data(), sz);
+}
+
+bool ZstdSeekableLoadCB::decodeFrame(int frame)
+{
+  if (frame == curFrame)
+    return true;
+  const char *cdata = srcData.data() + frameCOfs[frame];
+  if (srcCrd)
+  {
+    readCompressed(frame, comprBuf);
+    cdata = comprBuf.data();
+  }
+  frameBuf.resize(int(frameDOfs[frame + 1] - frameDOfs[frame]));
+  size_t dec_sz = ZSTD_decompressDCtx(dctx, frameBuf.data(), frameBuf.size(), cdata, frameCOfs[frame + 1] - frameCOfs[frame]);
+  if (dec_sz != frameBuf.size())
+  {
+    curFrame = -1;
+    return false;
+  }
+  curFrame = frame;
+  return true;
+}
+
+int ZstdSeekableLoadCB::tryRead(void *ptr, int size)
+{
+  char *dst = (char *)ptr;
+  int rd = 0;
+  while (size > 0 && curPos < getSize())
+  {
+    int frame = findFrame(curPos);
+    if (!decodeFrame(frame))
+      break;
+    int ofs = int(curPos - frameDOfs[frame]);
+    int sz = min(size, int(frameBuf.size()) - ofs);
+    memcpy(dst, frameBuf.data() + ofs, sz);
+    dst += sz;
+    rd += sz;
+    size -= sz;
+    curPos += sz;
+  }
+  return rd;
+}
+
+void ZstdSeekableLoadCB::read(void *ptr, int size)
+{
+  int rd = tryRead(ptr, size);
+  if (rd != size)
+  {
+    logerr("Zstd seekable read error: rd=%d != size=%d at pos=%lld of %lld", rd, size, (long long)curPos, (long long)getSize());
+    DAGOR_THROW(LoadException("Zstd seekable read error", tell()));
+  }
+}
+
+void ZstdSeekableLoadCB::seekto(int pos)
+{
+  if (pos < 0 || pos > getSize())
+  {
+    DAGOR_THROW(LoadException("seek out of range", tell()));
+    return;
+  }
+  curPos = pos;
+}
+
+namespace
+{
+struct FramesDecodeContext
+{
+  const char *cdata;    // compressed data of frames [firstFrame, lastFrame]
+  const int64_t *cOfs;  // frame compressed offsets (relative to cdata start at firstFrame)
+  const int64_t *dOfs;  // frame decompressed offsets
+  int64_t rangeStart, rangeEnd;
+  char *dest;
+  int firstFrame, lastFrame;
+  volatile int nextFrame;
+  volatile int failed = 0;
+
+  void run()
+  {
+    ZSTD_DCtx_s *ctx = nullptr;
+    Tab<char> tmp;
+    for (int f = interlocked_increment(nextFrame) - 1; f <= lastFrame; f = interlocked_increment(nextFrame) - 1)
+    {
+      if (!ctx)
+        ctx = zstd_create_dctx();
+      const char *src = cdata + (cOfs[f] - cOfs[firstFrame]);
+      size_t src_sz = cOfs[f + 1] - cOfs[f];
+      size_t d_sz = dOfs[f + 1] - dOfs[f];
+      int64_t from = max(dOfs[f], rangeStart), to = min(dOfs[f + 1], rangeEnd);
+      if (from == dOfs[f] && to == dOfs[f + 1]) // whole frame is inside range, decode directly to dest
+      {
+        if (ZSTD_decompressDCtx(ctx, dest + (from - rangeStart), d_sz, src, src_sz) != d_sz)
+          interlocked_increment(failed);
+        continue;
+      }
+      tmp.resize(d_sz);
+      if (ZSTD_decompressDCtx(ctx, tmp.data(), d_sz, src, src_sz) != d_sz)
+        interlocked_increment(failed);
+      else
+        memcpy(dest + (from - rangeStart), tmp.data() + (from - dOfs[f]), to - from);
+    }
+    if (ctx)
+      zstd_destroy_dctx(ctx);
+  }
+};
+
+struct FramesDecodeJob final : public cpujobs::IJob
+{
+  FramesDecodeContext *ctx = nullptr;
+  void doJob() override { ctx->run(); }
+};
+} // namespace
+
+int64_t ZstdSeekableLoadCB::readRange(void *dest, int64_t ofs, int64_t size, bool use_threadpool)
+{
+  if (ofs < 0 || ofs >= getSize() || size <= 0)
+    return 0;
+  if (ofs + size > getSize())
+    size = getSize() - ofs;
+
+  FramesDecodeContext ctx;
+  ctx.firstFrame = findFrame(ofs);
+  ctx.lastFrame = findFrame(ofs + size - 1);
+  ctx.nextFrame = ctx.firstFrame;
+  ctx.cOfs = frameCOfs.data();
+  ctx.dOfs = frameDOfs.data();
+  ctx.rangeStart = ofs;
+  ctx.rangeEnd = ofs + size;
+  ctx.dest = (char *)dest;
+
+  Tab<char> cdata;
+  if (srcCrd)
+  {
+    cdata.resize(int(frameCOfs[ctx.lastFrame + 1] - frameCOfs[ctx.firstFrame]));
+    srcCrd->seekto(int(srcBase + frameCOfs[ctx.firstFrame]));
+    srcCrd->read(cdata.data(), cdata.size());
+    ctx.cdata = cdata.data();
+  }
+  else
+    ctx.cdata = srcData.data() + frameCOfs[ctx.firstFrame];
+
+  int frames_cnt = ctx.lastFrame - ctx.firstFrame + 1;
+  int jobs_cnt = use_threadpool ? min(threadpool::get_num_workers(), frames_cnt - 1) : 0;
+  if (jobs_cnt > 0)
+  {
+    eastl::unique_ptr<FramesDecodeJob[]> jobs(new FramesDecodeJob[jobs_cnt]);
+    uint32_t queuePos = 0;
+    for (int i = 0; i < jobs_cnt; i++)
+    {
+      jobs[i].ctx = &ctx;
+      threadpool::add(&jobs[i], threadpool::PRIO_HIGH, queuePos, threadpool::AddFlags::IgnoreNotDone);
+    }
+    threadpool::wake_up_all();
+    ctx.run();
+    threadpool::barrier_active_wait_for_job(&jobs[jobs_cnt - 1], threadpool::PRIO_HIGH, queuePos);
+    for (int i = 0; i < jobs_cnt; i++)
+      threadpool::wait(&jobs[i]);
+  }
+  else
+    ctx.run();
+
+  if (ctx.failed)
+  {
+    logerr("%s: failed to decompress %d frame(s) of [%lld, %lld)", getTargetName(), ctx.failed, (long long)ofs,
+      (long long)(ofs + size));
+    return 0;
+  }
+  return size;
+}
+
+#define EXPORT_PULL dll_pull_iosys_zstdSeekableIo
+#include <supp/exportPull.h>
@@ -82,10 +82,11 @@ static struct CritSecGlobal : public CritSecStorage
 {
   CritSecGlobal() { create_critical_section(this); }
 } writeCS; // never destroyed b/c it can be used really late (after all static dtors) (TODO: do noop locking in this case)
-void debug_internal::write_stream_flush_locked(write_stream_t stream)
+void debug_internal::write_stream_flush_locked(write_stream_t &stream)
 {
   WinAutoLock lock(writeCS);
-  write_stream_flush(stream);
+  if (write_stream_t fp = stream) // can be reopened by log rotation
+    write_stream_flush(fp);
 }
 
 #if DAGOR_FORCE_LOGS
@@ -268,7 +269,32 @@ static bool prepare_file_impl(const char *path, write_stream_t &fpout, int lev_b
 
 #define MAX_CRYPTO_LINE (4 << 10)
 
-static void out_file(write_stream_t fp, int lc, int t, bool term, int ik, const char *format, const void *arg, int anum)
+static void fill_line_info(LogLineInfo &info, int lev, int lc, int t, bool term)
+{
+  debug_internal::Context *ctx = &debug_internal::dbg_ctx;
+  info.lev = lev;
+  info.lc = lc;
+  info.t = t;
+  info.term = term;
+  info.newThread = false;
+  const int enabled_bits = interlocked_acquire_load(debug_enabled_bits);
+  if (!(enabled_bits & THREAD_IDS_BIT) || ctx->threadId)
+    ; // do nothing
+  else if (is_main_thread())
+    ctx->threadId = 1;
+  else
+  {
+    ctx->threadId = interlocked_increment(next_thread_id);
+    info.newThread = true;
+  }
+  info.threadId = (enabled_bits & THREAD_IDS_BIT) ? ctx->threadId - 1 : -1;
+  info.threadName = ctx->threadName;
+  info.ctxFile = ctx->file;
+  info.ctxLine = ctx->line;
+}
+
+// fp is read under lock since async writer can reopen it on rotation
+static void out_file(write_stream_t &fp, LogLineInfo &info, int ik, const char *format, const void *arg, int anum)
 {
   if (logsMaxSize && ik != LOGLEVEL_FATAL && logFileSizes[ik] >= logsMaxSize)
     return;
@@ -276,18 +302,14 @@ static void out_file(write_stream_t fp, int lc, int t, bool term, int ik, const
   char sbuf[MAX_CRYPTO_LINE];
 
   int sz = 0;
-  const int enabled_bits = interlocked_acquire_load(debug_enabled_bits);
-  if (!(enabled_bits & THREAD_IDS_BIT) || (&dbg_ctx)->threadId)
-    ; // do nothing
-  else if (is_main_thread())
-    (&dbg_ctx)->threadId = 1;
-  else
+  const int lc = info.lc, t = info.t, thread_id = info.threadId;
+  const bool term = info.term;
+  if (info.newThread) // header is written only to the first file
   {
-    (&dbg_ctx)->threadId = interlocked_increment(next_thread_id);
-    sz = snprintf(sbuf, sizeof(sbuf), "---$%02X %s ---\n", (&dbg_ctx)->threadId - 1, (&dbg_ctx)->threadName);
+    sz = snprintf(sbuf, sizeof(sbuf), "---$%02X %s ---\n", thread_id, info.threadName);
+    info.newThread = false;
   }
 
-  int thread_id = (enabled_bits & THREAD_IDS_BIT) ? (&dbg_ctx)->threadId - 1 : -1;
   if (override_timestamp_cb)
   {
     sz += override_timestamp_cb(sbuf, sizeof(sbuf) - sz - 1, t);
@@ -303,9 +325,8 @@ static void out_file(write_stream_t fp, int lc, int t, bool term, int ik, const
   else if (lc != debug_internal::stdTags[LOGLEVEL_DEBUG])
     sz += _snprintf(sbuf + sz, sizeof(sbuf) - sz - 1, "%c%c%c%c ", _DUMP4C(lc));
 
-  debug_internal::Context *ctx = &debug_internal::dbg_ctx;
-  if (ctx->file)
-    sz += _snprintf(sbuf + sz, sizeof(sbuf) - sz - 1, ". %s,%d: ", ctx->file, ctx->line);
+  if (info.ctxFile)
+    sz += _snprintf(sbuf + sz, sizeof(sbuf) - sz - 1, ". %s,%d: ", info.ctxFile, info.ctxLine);
 
   int left = sizeof(sbuf) - sz - (term ? 2 : 1);
   int ret = DagorSafeArg::mixed_print_fmt(sbuf + sz, left, format, arg, anum);
@@ -338,7 +359,8 @@ static void out_file(write_stream_t fp, int lc, int t, bool term, int ik, const
 #if MEASURE_WRITE_TIME
     int64_t ref = ref_time_ticks();
 #endif
-    write_stream_write(final_sbuf, sz, fp);
+    if (fp)
+      write_stream_write(final_sbuf, sz, fp);
 #if MEASURE_WRITE_TIME
     totalWriteCalls++;
     if (int spent = get_time_usec(ref))
@@ -366,9 +388,21 @@ void debug_internal::vlog(int lev, const char *fmt, const void *arg, int anum)
   bool term = !(&dbg_ctx)->holdLine;
 
   int t = (!(&dbg_ctx)->lastHoldLine && timestampEnabled) ? get_time_msec() : -1;
+  LogLineInfo info;
+  fill_line_info(info, lev, lc, t, term);
+  if (interlocked_relaxed_load(async_log_enabled) && lev != LOGLEVEL_FATAL && prepare_file(dbgFilepath, dbgFile, 1 << LOGLEVEL_DEBUG) &&
+      async_log_push(info, fmt, arg, anum)) // formatted and written by writer thread (fatal messages are always written immediately)
+  {
+    (&dbg_ctx)->reset();
+    (&dbg_ctx)->holdLine = false;
+    return;
+  }
+  if (lev == LOGLEVEL_FATAL && interlocked_relaxed_load(async_log_enabled))
+    async_log_flush(); // keep order of messages preceding fatal
+
   if (prepare_file(dbgFilepath, dbgFile, 1 << LOGLEVEL_DEBUG))
   {
-    out_file(dbgFile, lc, t, term, LOGLEVEL_DEBUG, fmt, arg, anum);
+    out_file(dbgFile, info, LOGLEVEL_DEBUG, fmt, arg, anum);
 
     if (flush_debug)
       write_stream_flush_locked(dbgFile);
@@ -401,13 +435,13 @@ void debug_internal::vlog(int lev, const char *fmt, const void *arg, int anum)
   {
     if (lev == LOGLEVEL_ERR && prepare_file(logerrFilepath, logerrFile, 1 << LOGLEVEL_ERR))
     {
-      out_file(logerrFile, lc, t, term, LOGLEVEL_ERR, fmt, arg, anum);
+      out_file(logerrFile, info, LOGLEVEL_ERR, fmt, arg, anum);
       if (flush_debug)
         write_stream_flush_locked(logerrFile);
     }
     else if (lev == LOGLEVEL_WARN && prepare_file(logwarnFilepath, logwarnFile, 1 << LOGLEVEL_WARN))
     {
-      out_file(logwarnFile, lc, t, term, LOGLEVEL_WARN, fmt, arg, anum);
+      out_file(logwarnFile, info, LOGLEVEL_WARN, fmt, arg, anum);
       if (flush_debug)
         write_stream_flush_locked(logwarnFile);
     }
@@ -416,7 +450,7 @@ void debug_internal::vlog(int lev, const char *fmt, const void *arg, int anum)
       write_stream_t fp = file2stream(fopen(fatalerrFilepath, "at"));
       if (fp)
       {
-        out_file(fp, lc, t, term, LOGLEVEL_FATAL, fmt, arg, anum);
+        out_file(fp, info, LOGLEVEL_FATAL, fmt, arg, anum);
         write_stream_close(fp);
       }
     }
@@ -433,6 +467,52 @@ void debug_internal::vlog(int lev, const char *fmt, const void *arg, int anum)
   (&dbg_ctx)->holdLine = false;
 }
 
+// called by async writer with writeCS held
+static void rotate_debug_file()
+{
+  write_stream_t fp = dbgFile;
+  interlocked_release_store_ptr(dbgFile, (write_stream_t)NULL);
+  write_stream_close(fp);
+
+  char src[DAGOR_MAX_PATH + 16], dst[DAGOR_MAX_PATH + 16];
+  const int keep = max(async_log_params.rotateKeepFiles, 1);
+  SNPRINTF(dst, sizeof(dst), "%s.%d", dbgFilepath, keep);
+  dd_erase(dst);
+  for (int i = keep - 1; i > 0; i--)
+  {
+    SNPRINTF(src, sizeof(src), "%s.%d", dbgFilepath, i);
+    SNPRINTF(dst, sizeof(dst), "%s.%d", dbgFilepath, i + 1);
+    dd_rename(src, dst);
+  }
+  SNPRINTF(dst, sizeof(dst), "%s.1", dbgFilepath);
+  if (dd_rename(dbgFilepath, dst) && async_log_params.onRotated)
+    async_log_params.onRotated(dst);
+  logFileSizes[LOGLEVEL_DEBUG].store(0, std::memory_order_relaxed);
+  prepare_file(dbgFilepath, dbgFile, 1 << LOGLEVEL_DEBUG);
+}
+
+static void write_async_line(LogLineInfo &info, const char *fmt, const DagorSafeArg *arg, int anum)
+{
+  if (dbgFile)
+    out_file(dbgFile, info, LOGLEVEL_DEBUG, fmt, arg, anum);
+  if (debug_internal::level_files)
+  {
+    if (info.lev == LOGLEVEL_ERR && prepare_file(logerrFilepath, logerrFile, 1 << LOGLEVEL_ERR))
+      out_file(logerrFile, info, LOGLEVEL_ERR, fmt, arg, anum);
+    else if (info.lev == LOGLEVEL_WARN && prepare_file(logwarnFilepath, logwarnFile, 1 << LOGLEVEL_WARN))
+      out_file(logwarnFile, info, LOGLEVEL_WARN, fmt, arg, anum);
+  }
+  if (async_log_params.rotateSize && info.term && dbgFilepath[0] != '*' &&
+      (unsigned)logFileSizes[LOGLEVEL_DEBUG].load(std::memory_order_relaxed) >= async_log_params.rotateSize)
+    rotate_debug_file();
+}
+
+void debug_internal::async_log_write_pending()
+{
+  WinAutoLock lock(writeCS);
+  async_log_consume(&write_async_line);
+}
+
 #if _TARGET_APPLE | _TARGET_PC_LINUX | _TARGET_ANDROID | _TARGET_C3
 
 static void get_home_or_temp_dir_name(char *buf, int size)
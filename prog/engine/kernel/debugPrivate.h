@@ -51,7 +51,7 @@ static constexpr int MAX_TAGS = 32;
 extern int allowed_tags[MAX_TAGS], ignored_tags[MAX_TAGS], promoted_tags[MAX_TAGS];
 extern int stdTags[LOGLEVEL_REMARK + 1];
 
-void write_stream_flush_locked(write_stream_t stream);
+void write_stream_flush_locked(write_stream_t &stream);
 void setupCrashDumpFileName();
 extern int maxWriteTimeUs; // max time of single log write
 extern int64_t totalWriteTimeUs, totalWriteCalls;
@@ -65,6 +65,29 @@ inline const char *get_logging_directory() { return ""; }
 #endif
 
 bool on_log_handler(int tag, const char *fmt, const void *arg, int anum);
+
+// everything needed to write log line besides message itself (captured on calling thread)
+struct LogLineInfo
+{
+  int lev, lc, t; // t is -1 when timestamp is not printed
+  int threadId;   // -1 when thread ids are disabled
+  bool term, newThread;
+  const char *threadName;
+  const char *ctxFile;
+  int ctxLine;
+};
+
+// asynchronous logging (logAsync.cpp)
+extern volatile int async_log_enabled;
+extern DebugAsyncLogParams async_log_params;
+// packs message to buffer of current thread; returns false if message must be written synchronously (e.g. it doesn't fit buffer)
+bool async_log_push(const LogLineInfo &info, const char *fmt, const void *arg, int anum);
+// writes all pending messages (in the same order they were logged), called with write lock held
+void async_log_consume(void (*write_cb)(LogLineInfo &info, const char *fmt, const DagorSafeArg *arg, int anum));
+// writes all pending messages, doesn't wait for writer thread (so can be used from crash handler)
+void async_log_flush();
+// implemented by platform backend (debug.cpp or logimpl.cpp): locks writes and calls async_log_consume() with its write callback
+void async_log_write_pending();
 } // namespace debug_internal
 
 extern "C" const char *dagor_get_build_stamp_str(char *buf, size_t bufsz, const char *suffix);
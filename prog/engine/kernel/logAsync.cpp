@@ -0,0 +1,364 @@
+#include <debug/dag_logSys.h>
+#include <debug/dag_debug.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_events.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <math/dag_adjpow2.h>
+#include <math/dag_Point2.h>
+#include <math/dag_Point3.h>
+#include <math/dag_Point4.h>
+#include <math/dag_bounds2.h>
+#include <math/dag_bounds3.h>
+#include <math/dag_TMatrix.h>
+#include <math/dag_color.h>
+#include <math/integer/dag_IPoint2.h>
+#include <math/integer/dag_IPoint3.h>
+#include <math/integer/dag_IPoint4.h>
+#include <math/integer/dag_IBBox2.h>
+#include <math/integer/dag_IBBox3.h>
+#include <stdlib.h>
+#include <string.h>
+#include "debugPrivate.h"
+
+// Asynchronous logging: each thread owns single-producer/single-consumer ring of packed records, so logging thread never takes
+// locks nor formats (unless message can't be deferred, then it is formatted to text and still queued).
+// Record keeps format string and copies of all data referenced by args (strings, vectors, matrices), and ticks used to merge
+// rings in logging order. Records are consumed (by writer thread or by flush) with backend's write lock held.
+// When ring is full message is dropped and counted, writer reports count of dropped messages to log.
+
+#if DAGOR_DBGLEVEL > 0 || DAGOR_FORCE_LOGS
+
+using namespace debug_internal;
+
+volatile int debug_internal::async_log_enabled = 0;
+DebugAsyncLogParams debug_internal::async_log_params;
+
+static constexpr uint32_t WRAP_MARK = 0xFFFFFFFFu;
+static constexpr int MAX_DEFERRED_ARGS = 32;
+static constexpr int MAX_TEXT_LEN = 4 << 10;
+static constexpr uint16_t REC_TEXT = 1; // message is already formatted
+
+struct AsyncLogRing
+{
+  AsyncLogRing *next;
+  char *data;
+  uint32_t cap;
+  volatile int owned;
+  volatile uint32_t head, tail; // free running offsets: head is written by owner thread only, tail - by consumer only
+  volatile int dropped;
+  volatile int wakeRequested;
+};
+
+// followed by DagorSafeArg[argsCount] (with offsets of payload instead of pointers), format string and payload
+struct AsyncLogRecHeader
+{
+  uint32_t size; // aligned, WRAP_MARK means rest of ring is unused and next record is at ring start
+  uint16_t argsCount;
+  uint16_t flags;
+  int64_t orderKey;
+  LogLineInfo info;
+};
+
+static AsyncLogRing *volatile async_rings = nullptr; // rings are never freed, ring of exited thread is reused by new threads
+static volatile int dropped_total = 0;
+static os_event_t writer_event;
+static bool writer_event_inited = false;
+static DaThread *writer_thread = nullptr;
+
+static thread_local struct AsyncLogRingRef
+{
+  AsyncLogRing *ring = nullptr;
+  ~AsyncLogRingRef()
+  {
+    if (ring)
+      interlocked_release_store(ring->owned, 0);
+  }
+} tls_ring;
+
+static inline uint32_t align8(uint32_t v) { return (v + 7) & ~7u; }
+
+// size of data referenced by arg that must be copied, -1 if arg can't be deferred
+static int payload_size(const DagorSafeArg &a)
+{
+  switch (a.varType)
+  {
+    case DagorSafeArg::TYPE_STR: return a.varValue.s ? (int)strlen(a.varValue.s) + 1 : 0;
+    case DagorSafeArg::TYPE_COL4: return sizeof(Color4);
+    case DagorSafeArg::TYPE_COL3: return sizeof(Color3);
+    case DagorSafeArg::TYPE_P2: return sizeof(Point2);
+    case DagorSafeArg::TYPE_P3: return sizeof(Point3);
+    case DagorSafeArg::TYPE_P4: return sizeof(Point4);
+    case DagorSafeArg::TYPE_IP2: return sizeof(IPoint2);
+    case DagorSafeArg::TYPE_IP3: return sizeof(IPoint3);
+    case DagorSafeArg::TYPE_IP4: return sizeof(IPoint4);
+    case DagorSafeArg::TYPE_TM: return sizeof(TMatrix);
+    case DagorSafeArg::TYPE_BB2: return sizeof(BBox2);
+    case DagorSafeArg::TYPE_BB3: return sizeof(BBox3);
+    case DagorSafeArg::TYPE_IBB2: return sizeof(IBBox2);
+    case DagorSafeArg::TYPE_IBB3: return sizeof(IBBox3);
+    case DagorSafeArg::TYPE_CUSTOM: return -1;
+    default: return 0;
+  }
+}
+static inline bool has_payload(const DagorSafeArg &a) { return a.varType == a.TYPE_STR || (a.varType > a.TYPE_PTR && a.varType < a.TYPE_CUSTOM); }
+
+// "%.*s" and "%.Ns" are used to print strings that are not null-terminated, so their length is unknown here
+static bool has_string_precision(const char *fmt)
+{
+  for (const char *p = strchr(fmt, '%'); p; p = strchr(p + 1, '%'))
+  {
+    if (p[1] == '%')
+    {
+      p++;
+      continue;
+    }
+    bool prec = false;
+    const char *c = p + 1;
+    for (; *c && strchr("-+ #0123456789.*lhzjtLI", *c); c++)
+      prec |= *c == '.';
+    if (prec && *c == 's')
+      return true;
+    if (!*c)
+      break;
+  }
+  return false;
+}
+
+static AsyncLogRing *get_thread_ring()
+{
+  if (AsyncLogRing *r = tls_ring.ring)
+    return r;
+  for (AsyncLogRing *r = interlocked_acquire_load_ptr(async_rings); r; r = r->next)
+    if (!interlocked_relaxed_load(r->owned) && interlocked_compare_exchange(r->owned, 1, 0) == 0)
+      return tls_ring.ring = r;
+
+  // malloc is used to be independent from memory manager (that can log too)
+  AsyncLogRing *r = (AsyncLogRing *)malloc(sizeof(AsyncLogRing));
+  memset(r, 0, sizeof(*r));
+  r->cap = get_bigger_pow2(max(async_log_params.threadBufSize, 4 << 10));
+  r->data = (char *)malloc(r->cap);
+  r->owned = 1;
+  do
+    r->next = interlocked_acquire_load_ptr(async_rings);
+  while (interlocked_compare_exchange_ptr(async_rings, r, r->next) != r->next);
+  return tls_ring.ring = r;
+}
+
+static void wake_writer(AsyncLogRing *r)
+{
+  if (writer_thread && !interlocked_relaxed_load(r->wakeRequested) && !interlocked_exchange(r->wakeRequested, 1))
+    os_event_set(&writer_event);
+}
+
+bool debug_internal::async_log_push(const LogLineInfo &info, const char *fmt, const void *arg, int anum)
+{
+  const DagorSafeArg *args = (const DagorSafeArg *)arg;
+  char text[MAX_TEXT_LEN];
+  uint16_t flags = 0;
+  uint32_t payload = 0;
+  bool deferred = anum >= 0 && anum <= MAX_DEFERRED_ARGS && !has_string_precision(fmt);
+  for (int i = 0; i < anum && deferred; i++)
+  {
+    int sz = payload_size(args[i]);
+    deferred = sz >= 0;
+    payload += align8(sz);
+  }
+  if (!deferred) // va_list or custom printers: format now, but still write asynchronously
+  {
+    int len = DagorSafeArg::mixed_print_fmt(text, sizeof(text), fmt, arg, anum);
+    if ((unsigned)len >= sizeof(text) - 1)
+      return false;
+    fmt = text;
+    anum = 0;
+    payload = 0;
+    flags = REC_TEXT;
+  }
+  const uint32_t fmtLen = (uint32_t)strlen(fmt) + 1;
+  const uint32_t payloadOfs = align8(sizeof(AsyncLogRecHeader) + anum * sizeof(DagorSafeArg) + fmtLen);
+  const uint32_t size = payloadOfs + payload;
+
+  AsyncLogRing *r = get_thread_ring();
+  if (size > r->cap / 2)
+    return false;
+  uint32_t head = r->head;
+  const uint32_t tail = interlocked_acquire_load(r->tail);
+  const uint32_t toEnd = r->cap - (head & (r->cap - 1));
+  if (head + size + (toEnd < size ? toEnd : 0) - tail > r->cap)
+  {
+    interlocked_increment(r->dropped);
+    wake_writer(r);
+    return true;
+  }
+  if (toEnd < size)
+  {
+    *(uint32_t *)(r->data + (head & (r->cap - 1))) = WRAP_MARK;
+    head += toEnd;
+  }
+
+  char *dst = r->data + (head & (r->cap - 1));
+  AsyncLogRecHeader *h = (AsyncLogRecHeader *)dst;
+  h->size = size;
+  h->argsCount = (uint16_t)anum;
+  h->flags = flags;
+  h->orderKey = ref_time_ticks();
+  h->info = info;
+  DagorSafeArg *dstArgs = (DagorSafeArg *)(h + 1);
+  memcpy(dstArgs + anum, fmt, fmtLen);
+  uint32_t ofs = payloadOfs;
+  for (int i = 0; i < anum; i++)
+  {
+    dstArgs[i] = args[i];
+    if (has_payload(args[i]) && args[i].varValue.p)
+    {
+      const int sz = payload_size(args[i]);
+      memcpy(dst + ofs, args[i].varValue.p, sz);
+      dstArgs[i].varValue.i = ofs;
+      ofs += align8(sz);
+    }
+  }
+  interlocked_release_store(r->head, head + size);
+  if (head + size - tail > r->cap / 2)
+    wake_writer(r);
+  return true;
+}
+
+void debug_internal::async_log_consume(void (*write_cb)(LogLineInfo &info, const char *fmt, const DagorSafeArg *arg, int anum))
+{
+  DagorSafeArg args[MAX_DEFERRED_ARGS];
+  for (;;)
+  {
+    AsyncLogRing *best = nullptr;
+    const AsyncLogRecHeader *bestRec = nullptr;
+    for (AsyncLogRing *r = interlocked_acquire_load_ptr(async_rings); r; r = r->next)
+    {
+      if (int dropped = interlocked_relaxed_load(r->dropped))
+      {
+        interlocked_add(r->dropped, -dropped);
+        interlocked_add(dropped_total, dropped);
+        LogLineInfo info = {LOGLEVEL_WARN, stdTags[LOGLEVEL_WARN], get_time_msec(), -1, true, false, nullptr, nullptr, 0};
+        DagorSafeArg a(dropped);
+        write_cb(info, "async log: %d messages dropped due to full thread buffer", &a, 1);
+      }
+      interlocked_relaxed_store(r->wakeRequested, 0);
+
+      uint32_t tail = r->tail;
+      const uint32_t head = interlocked_acquire_load(r->head);
+      if (tail == head)
+        continue;
+      const AsyncLogRecHeader *h = (const AsyncLogRecHeader *)(r->data + (tail & (r->cap - 1)));
+      if (h->size == WRAP_MARK)
+      {
+        tail += r->cap - (tail & (r->cap - 1));
+        interlocked_release_store(r->tail, tail);
+        if (tail == head)
+          continue;
+        h = (const AsyncLogRecHeader *)r->data;
+      }
+      if (!bestRec || h->orderKey < bestRec->orderKey)
+      {
+        best = r;
+        bestRec = h;
+      }
+    }
+    if (!best)
+      break;
+
+    LogLineInfo info = bestRec->info;
+    const DagorSafeArg *src = (const DagorSafeArg *)(bestRec + 1);
+    const char *fmt = (const char *)(src + bestRec->argsCount);
+    if (bestRec->flags & REC_TEXT)
+    {
+      args[0] = DagorSafeArg(fmt);
+      write_cb(info, "%s", args, 1);
+    }
+    else
+    {
+      for (int i = 0; i < bestRec->argsCount; i++)
+      {
+        args[i] = src[i];
+        if (has_payload(args[i]) && args[i].varValue.i)
+          args[i].varValue.p = (const char *)bestRec + args[i].varValue.i;
+      }
+      write_cb(info, fmt, args, bestRec->argsCount);
+    }
+    interlocked_release_store(best->tail, best->tail + bestRec->size);
+  }
+}
+
+void debug_internal::async_log_flush()
+{
+  if (interlocked_acquire_load_ptr(async_rings))
+    async_log_write_pending();
+}
+
+class AsyncLogWriterThread final : public DaThread
+{
+public:
+  AsyncLogWriterThread() : DaThread("AsyncLogWriter", 128 << 10) {}
+
+  void execute() override
+  {
+    int nextFlushT = get_time_msec() + async_log_params.flushPeriodMs;
+    while (!interlocked_acquire_load(terminating))
+    {
+      os_event_wait(&writer_event, async_log_params.writerPeriodMs);
+      async_log_write_pending();
+#if _TARGET_PC
+      bool flushNow = debug_internal::flush_debug;
+#else
+      bool flushNow = false;
+#endif
+      if (flushNow || get_time_msec() >= nextFlushT)
+      {
+        flush_debug_file();
+        nextFlushT = get_time_msec() + async_log_params.flushPeriodMs;
+      }
+    }
+    async_log_write_pending();
+  }
+};
+
+void debug_enable_async_mode(const DebugAsyncLogParams &params)
+{
+  debug_disable_async_mode();
+  async_log_params = params;
+  if (!writer_event_inited)
+  {
+    os_event_create(&writer_event, NULL);
+    writer_event_inited = true;
+  }
+  writer_thread = new AsyncLogWriterThread;
+  if (!writer_thread->start())
+  {
+    writer_thread->destroy();
+    writer_thread = nullptr;
+    logerr("async log: failed to start writer thread");
+    return;
+  }
+  interlocked_release_store(async_log_enabled, 1);
+}
+
+void debug_disable_async_mode()
+{
+  if (!writer_thread)
+    return;
+  interlocked_release_store(async_log_enabled, 0);
+  writer_thread->terminate(true, -1, &writer_event);
+  writer_thread->destroy();
+  writer_thread = nullptr;
+  async_log_flush(); // messages pushed after last drain of writer
+}
+
+bool debug_is_async_mode() { return interlocked_acquire_load(async_log_enabled) != 0; }
+
+int64_t debug_get_async_dropped_count()
+{
+  int64_t cnt = interlocked_acquire_load(dropped_total);
+  for (AsyncLogRing *r = interlocked_acquire_load_ptr(async_rings); r; r = r->next)
+    cnt += interlocked_relaxed_load(r->dropped);
+  return cnt;
+}
+
+#endif // DAGOR_DBGLEVEL > 0 || DAGOR_FORCE_LOGS
@@ -343,6 +343,19 @@ void debug_internal::vlog(int tag, const char *format, const void *arg, int anum
     }
 #endif
 
+#if !CRYPT_LOG_AVAILABLE
+    // line is already formatted here, so only writing is deferred (crypted log keeps writing synchronously to stay ordered)
+    DagorSafeArg lineArg(buf);
+    LogLineInfo info = {tag, rt, t, thread_id, false, false, nullptr, nullptr, 0};
+    if (tag == LOGLEVEL_FATAL && interlocked_relaxed_load(debug_internal::async_log_enabled))
+      debug_internal::async_log_flush();
+    else if (interlocked_relaxed_load(debug_internal::async_log_enabled) && debug_internal::async_log_push(info, "%s", &lineArg, 1))
+    {
+      buf[0] = 0;
+      (&dbg_ctx)->nextSameLine = false;
+      return;
+    }
+#endif
     log_write(buf, bufLen + (int)addSlashN);
     buf[0] = 0;
   }
@@ -354,10 +367,31 @@ void debug_internal::vlog(int tag, const char *format, const void *arg, int anum
 
 #undef PFUN
 
+static void write_async_line(debug_internal::LogLineInfo &info, const char *fmt, const DagorSafeArg *arg, int anum)
+{
+  static char buf[8 << 10]; // used under writeCS only
+  int len = DagorSafeArg::mixed_print_fmt(buf, sizeof(buf) - 2, fmt, arg, anum);
+  len = clamp(len, 0, (int)sizeof(buf) - 3);
+  if (info.term)
+    buf[len++] = '\n';
+  buf[len] = 0;
+  log_write(buf, len);
+}
+
+void debug_internal::async_log_write_pending()
+{
+  WinAutoLock lock(writeCS);
+  async_log_consume(&write_async_line);
+}
+
 void debug_override_log_timestamp_format(debug_override_timestamp_cb_t) {}
 
 #if DAGOR_DBGLEVEL > 0 || DAGOR_FORCE_LOGS
-int tail_debug_file(char *out_buf, int buf_size) { return GET_FROM_TAIL_BUF(out_buf, buf_size); }
+int tail_debug_file(char *out_buf, int buf_size)
+{
+  debug_internal::async_log_flush();
+  return GET_FROM_TAIL_BUF(out_buf, buf_size);
+}
 #endif
 
 #endif // !_TARGET_PC
@@ -509,10 +543,11 @@ void debug_enable_timestamps(bool e, bool hhmmss_fmt, int hhmmss_subsec)
 #define DIF(x) debug_internal::x##File
 void flush_debug_file()
 {
-  debug_internal::write_stream_t files[] = {DIF(dbg), DIF(logerr), DIF(logwarn)};
+  debug_internal::async_log_flush(); // pending messages of async mode (this is also called on crash)
+  debug_internal::write_stream_t *files[] = {&DIF(dbg), &DIF(logerr), &DIF(logwarn)};
   for (int i = 0; i < countof(files); ++i)
-    if (files[i])
-      debug_internal::write_stream_flush_locked(files[i]);
+    if (*files[i])
+      debug_internal::write_stream_flush_locked(*files[i]);
 }
 
 void close_debug_files()
@@ -525,6 +560,7 @@ void close_debug_files()
     debug_internal::totalWriteTimeUs = 0;
     debug_internal::totalWriteCalls = 0;
   }
+  debug_internal::async_log_flush();
 
   debug_internal::write_stream_t *files[] = {&DIF(dbg), &DIF(logerr), &DIF(logwarn)};
   for (int i = 0; i < countof(files); ++i)
@@ -563,6 +599,7 @@ void debug_allow_level_files(bool en) { debug_internal::level_files = en; }
 #elif _TARGET_IOS | _TARGET_TVOS
 void flush_debug_file()
 {
+  debug_internal::async_log_flush();
   if (ios_global_fp)
   {
     out_debug_str_fmt("flushing %s", ios_global_log_fname);
@@ -588,6 +625,7 @@ void force_debug_flush(bool) {}
 
 void flush_debug_file()
 {
+  debug_internal::async_log_flush();
   if (xbox_debug_file)
     df_flush(xbox_debug_file);
 }
@@ -611,7 +649,7 @@ void debug_allow_level_files(bool) {}
 
 #else
 
-void flush_debug_file() {}
+void flush_debug_file() { debug_internal::async_log_flush(); }
 void debug_flush(bool) {}
 void force_debug_flush(bool) {}
 void close_debug_files() {}
@@ -0,0 +1,157 @@
+#include <math/dag_frustumCullSoA.h>
+#include <math/dag_frustum.h>
+#include <vecmath/dag_vecMath.h>
+#include <osApiWrappers/dag_cpuDispatch.h>
+#include "frustumCullSoAVec8.h"
+
+using namespace soacull;
+
+// 4-wide code, used as is without AVX2 and for the rest of range after 8-wide variants. Last incomplete 4 objects are copied
+// to zero padded arrays and masked out
+
+namespace
+{
+struct Vec4Planes
+{
+  vec4f x[6], y[6], z[6], w[6];
+  vec4f absX[6], absY[6], absZ[6];
+
+  Vec4Planes(const vec4f *planes)
+  {
+    for (int p = 0; p < 6; ++p)
+    {
+      x[p] = v_splat_x(planes[p]);
+      y[p] = v_splat_y(planes[p]);
+      z[p] = v_splat_z(planes[p]);
+      w[p] = v_splat_w(planes[p]);
+      absX[p] = v_abs(x[p]);
+      absY[p] = v_abs(y[p]);
+      absZ[p] = v_abs(z[p]);
+    }
+  }
+};
+
+struct Vec4Distance
+{
+  vec4f posX, posY, posZ, distScale, maxDistSq;
+
+  Vec4Distance(const SoACullParams &params)
+  {
+    posX = v_splat_x(params.posDistScale);
+    posY = v_splat_y(params.posDistScale);
+    posZ = v_splat_z(params.posDistScale);
+    distScale = v_splat_w(params.posDistScale);
+    maxDistSq = v_splats(params.maxDistSq);
+  }
+
+  VECTORCALL vec4f test(vec4f cx, vec4f cy, vec4f cz, vec4f max_dist_sq) const
+  {
+    vec4f dx = v_sub(cx, posX), dy = v_sub(cy, posY), dz = v_sub(cz, posZ);
+    vec4f distSq = v_madd(dx, dx, v_madd(dy, dy, v_mul(dz, dz)));
+    return v_sub(max_dist_sq, v_mul(distSq, distScale));
+  }
+};
+} // namespace
+
+static inline vec4f load4(const float *data, int i, int end)
+{
+  if (i + 4 <= end)
+    return v_ldu(data + i);
+  alignas(16) float padded[4] = {0, 0, 0, 0};
+  for (int j = i; j < end; ++j)
+    padded[j - i] = data[j];
+  return v_ld(padded);
+}
+
+static inline int append_visible(uint32_t *out_visible, int visible_count, int first, int lanes, int visible_mask)
+{
+  for (int lane = 0; lane < lanes; ++lane)
+  {
+    out_visible[visible_count] = first + lane;
+    visible_count += (visible_mask >> lane) & 1;
+  }
+  return visible_count;
+}
+
+static int cull_spheres_vec4(const vec4f *planes_, const SoASpheres &spheres, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible)
+{
+  const Vec4Planes planes(planes_);
+  const Vec4Distance distance(params);
+  int visibleCount = 0;
+  for (int i = start; i < end; i += 4)
+  {
+    vec4f cx = load4(spheres.x, i, end), cy = load4(spheres.y, i, end), cz = load4(spheres.z, i, end);
+    vec4f r = load4(spheres.r, i, end);
+    vec4f maxDistSq = params.maxDistSqPerObject ? load4(params.maxDistSqPerObject, i, end) : distance.maxDistSq;
+    vec4f res = distance.test(cx, cy, cz, maxDistSq);
+    for (int p = 0; p < 6; ++p)
+      res = v_or(res, v_madd(cx, planes.x[p], v_madd(cy, planes.y[p], v_madd(cz, planes.z[p], v_add(planes.w[p], r)))));
+    int lanes = min(end - i, 4);
+    int visibleMask = ~v_signmask(res) & ((1 << lanes) - 1);
+    if (visibleMask)
+      visibleCount = append_visible(out_visible, visibleCount, i, lanes, visibleMask);
+  }
+  return visibleCount;
+}
+
+static int cull_boxes_vec4(const vec4f *planes_, const SoABoxes &boxes, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible)
+{
+  const Vec4Planes planes(planes_);
+  const Vec4Distance distance(params);
+  int visibleCount = 0;
+  for (int i = start; i < end; i += 4)
+  {
+    vec4f cx = load4(boxes.cx, i, end), cy = load4(boxes.cy, i, end), cz = load4(boxes.cz, i, end);
+    vec4f ex = load4(boxes.ex, i, end), ey = load4(boxes.ey, i, end), ez = load4(boxes.ez, i, end);
+    vec4f maxDistSq = params.maxDistSqPerObject ? load4(params.maxDistSqPerObject, i, end) : distance.maxDistSq;
+    vec4f res = distance.test(cx, cy, cz, maxDistSq);
+    for (int p = 0; p < 6; ++p)
+    {
+      vec4f dist = v_madd(cx, planes.x[p], v_madd(cy, planes.y[p], v_madd(cz, planes.z[p], planes.w[p])));
+      vec4f projectedExtent = v_madd(ex, planes.absX[p], v_madd(ey, planes.absY[p], v_mul(ez, planes.absZ[p])));
+      res = v_or(res, v_add(dist, projectedExtent));
+    }
+    int lanes = min(end - i, 4);
+    int visibleMask = ~v_signmask(res) & ((1 << lanes) - 1);
+    if (visibleMask)
+      visibleCount = append_visible(out_visible, visibleCount, i, lanes, visibleMask);
+  }
+  return visibleCount;
+}
+
+#if _TARGET_SIMD_SSE
+static const CpuDispatch<CullSpheresVec8Fn> cull_spheres_vec8 = {
+  {nullptr, nullptr, vec8_kernels_avx2.cullSpheres, vec8_kernels_avx512.cullSpheres}};
+static const CpuDispatch<CullBoxesVec8Fn> cull_boxes_vec8 = {
+  {nullptr, nullptr, vec8_kernels_avx2.cullBoxes, vec8_kernels_avx512.cullBoxes}};
+#endif
+
+int frustum_cull_soa(const Frustum &frustum, const SoASpheres &spheres, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible)
+{
+  int visibleCount = 0;
+#if _TARGET_SIMD_SSE
+  if (CullSpheresVec8Fn cull8 = cull_spheres_vec8.get())
+  {
+    visibleCount = cull8(frustum.camPlanes, spheres, start, end, params, out_visible);
+    start += (end - start) & ~7;
+  }
+#endif
+  return visibleCount + cull_spheres_vec4(frustum.camPlanes, spheres, start, end, params, out_visible + visibleCount);
+}
+
+int frustum_cull_soa(const Frustum &frustum, const SoABoxes &boxes, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible)
+{
+  int visibleCount = 0;
+#if _TARGET_SIMD_SSE
+  if (CullBoxesVec8Fn cull8 = cull_boxes_vec8.get())
+  {
+    visibleCount = cull8(frustum.camPlanes, boxes, start, end, params, out_visible);
+    start += (end - start) & ~7;
+  }
+#endif
+  return visibleCount + cull_boxes_vec4(frustum.camPlanes, boxes, start, end, params, out_visible + visibleCount);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <math/dag_frustumCullSoA.h>
+
+// 8-wide variants of frustum_cull_soa kernels compiled for different SIMD levels (frustumCullSoA_*.cpp), selected with
+// CpuDispatch. Planes are Frustum::camPlanes (passed as array, so inline Frustum methods are never compiled with AVX options).
+// They process objects by 8 and return number of visible ones, rest of range (end - start) % 8 is done by generic 4-wide code
+
+namespace soacull
+{
+typedef int (*CullSpheresVec8Fn)(const vec4f *planes, const SoASpheres &spheres, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible);
+typedef int (*CullBoxesVec8Fn)(const vec4f *planes, const SoABoxes &boxes, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible);
+
+struct Vec8Kernels
+{
+  CullSpheresVec8Fn cullSpheres;
+  CullBoxesVec8Fn cullBoxes;
+};
+
+extern const Vec8Kernels vec8_kernels_avx2;
+extern const Vec8Kernels vec8_kernels_avx512;
+} // namespace soacull
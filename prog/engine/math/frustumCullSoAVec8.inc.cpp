@@ -0,0 +1,133 @@
+// included to frustumCullSoA_*.cpp, compiled with different target options
+#include <vecmath/dag_vecMath8.h>
+
+// Same math as 4-wide code in frustumCullSoA.cpp: distances to all 6 planes (plus radius or projected extent) and
+// maxDistSq - scaled distance squared are OR-ed, so sign bit of result is set for culled objects
+
+namespace
+{
+struct Vec8Planes
+{
+  vec8f x[6], y[6], z[6], w[6];
+  vec8f absX[6], absY[6], absZ[6];
+
+  Vec8Planes(const vec4f *planes)
+  {
+    for (int p = 0; p < 6; ++p)
+    {
+      alignas(16) float plane[4];
+      v_st(plane, planes[p]);
+      x[p] = v8_splats(plane[0]);
+      y[p] = v8_splats(plane[1]);
+      z[p] = v8_splats(plane[2]);
+      w[p] = v8_splats(plane[3]);
+      absX[p] = v8_abs(x[p]);
+      absY[p] = v8_abs(y[p]);
+      absZ[p] = v8_abs(z[p]);
+    }
+  }
+};
+
+struct Vec8Distance
+{
+  vec8f posX, posY, posZ, distScale, maxDistSq;
+
+  Vec8Distance(const SoACullParams &params)
+  {
+    alignas(16) float posDistScale[4];
+    v_st(posDistScale, params.posDistScale);
+    posX = v8_splats(posDistScale[0]);
+    posY = v8_splats(posDistScale[1]);
+    posZ = v8_splats(posDistScale[2]);
+    distScale = v8_splats(posDistScale[3]);
+    maxDistSq = v8_splats(params.maxDistSq);
+  }
+
+  VECTORCALL vec8f test(vec8f cx, vec8f cy, vec8f cz, const float *max_dist_sq_per_object) const
+  {
+    vec8f dx = v8_sub(cx, posX), dy = v8_sub(cy, posY), dz = v8_sub(cz, posZ);
+    vec8f distSq = v8_madd(dx, dx, v8_madd(dy, dy, v8_mul(dz, dz)));
+    vec8f maxDist = max_dist_sq_per_object ? v8_ldu(max_dist_sq_per_object) : maxDistSq;
+    return v8_sub(maxDist, v8_mul(distSq, distScale));
+  }
+};
+
+// indices of set bits of 8-bit mask, so visible indices are stored with one unaligned store
+struct CompressTable
+{
+  uint8_t lanes[256][8];
+  uint8_t count[256];
+
+  constexpr CompressTable() : lanes(), count()
+  {
+    for (int mask = 0; mask < 256; ++mask)
+    {
+      int n = 0;
+      for (int lane = 0; lane < 8; ++lane)
+        if (mask & (1 << lane))
+          lanes[mask][n++] = lane;
+      count[mask] = n;
+    }
+  }
+};
+static constexpr CompressTable compress_table;
+} // namespace
+
+// out_visible has room for 8 indices past visible_count, as it has room for all objects
+static VECMATH_FINLINE int append_visible(uint32_t *out_visible, int visible_count, int first, int visible_mask)
+{
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  v8_stui(out_visible + visible_count, _mm256_maskz_compress_epi32((__mmask8)visible_mask, v8_addi(v8_splatsi(first), lanes)));
+#else
+  v8_stui(out_visible + visible_count, v8_addi(v8_splatsi(first), v8_ldui_u8(compress_table.lanes[visible_mask])));
+#endif
+  return visible_count + compress_table.count[visible_mask];
+}
+
+static int cull_spheres_vec8(const vec4f *planes_, const SoASpheres &spheres, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible)
+{
+  const Vec8Planes planes(planes_);
+  const Vec8Distance distance(params);
+  const int count = (end - start) & ~7;
+  int visibleCount = 0;
+  for (int i = start; i < start + count; i += 8)
+  {
+    vec8f cx = v8_ldu(spheres.x + i), cy = v8_ldu(spheres.y + i), cz = v8_ldu(spheres.z + i), r = v8_ldu(spheres.r + i);
+    vec8f res = distance.test(cx, cy, cz, params.maxDistSqPerObject ? params.maxDistSqPerObject + i : nullptr);
+    for (int p = 0; p < 6; ++p)
+      res = v8_or(res, v8_madd(cx, planes.x[p], v8_madd(cy, planes.y[p], v8_madd(cz, planes.z[p], v8_add(planes.w[p], r)))));
+    int visibleMask = ~v8_signmask(res) & 0xFF;
+    if (visibleMask)
+      visibleCount = append_visible(out_visible, visibleCount, i, visibleMask);
+  }
+  return visibleCount;
+}
+
+static int cull_boxes_vec8(const vec4f *planes_, const SoABoxes &boxes, int start, int end, const SoACullParams &params,
+  uint32_t *out_visible)
+{
+  const Vec8Planes planes(planes_);
+  const Vec8Distance distance(params);
+  const int count = (end - start) & ~7;
+  int visibleCount = 0;
+  for (int i = start; i < start + count; i += 8)
+  {
+    vec8f cx = v8_ldu(boxes.cx + i), cy = v8_ldu(boxes.cy + i), cz = v8_ldu(boxes.cz + i);
+    vec8f ex = v8_ldu(boxes.ex + i), ey = v8_ldu(boxes.ey + i), ez = v8_ldu(boxes.ez + i);
+    vec8f res = distance.test(cx, cy, cz, params.maxDistSqPerObject ? params.maxDistSqPerObject + i : nullptr);
+    for (int p = 0; p < 6; ++p)
+    {
+      vec8f dist = v8_madd(cx, planes.x[p], v8_madd(cy, planes.y[p], v8_madd(cz, planes.z[p], planes.w[p])));
+      vec8f projectedExtent = v8_madd(ex, planes.absX[p], v8_madd(ey, planes.absY[p], v8_mul(ez, planes.absZ[p])));
+      res = v8_or(res, v8_add(dist, projectedExtent));
+    }
+    int visibleMask = ~v8_signmask(res) & 0xFF;
+    if (visibleMask)
+      visibleCount = append_visible(out_visible, visibleCount, i, visibleMask);
+  }
+  return visibleCount;
+}
+
+#define FRUSTUM_CULL_SOA_VEC8_KERNELS {&cull_spheres_vec8, &cull_boxes_vec8}
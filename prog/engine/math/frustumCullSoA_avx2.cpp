@@ -0,0 +1,8 @@
+#include "frustumCullSoAVec8.h"
+
+#if defined(__AVX2__)
+#include "frustumCullSoAVec8.inc.cpp"
+const soacull::Vec8Kernels soacull::vec8_kernels_avx2 = FRUSTUM_CULL_SOA_VEC8_KERNELS;
+#else
+const soacull::Vec8Kernels soacull::vec8_kernels_avx2 = {};
+#endif
@@ -0,0 +1,8 @@
+#include "frustumCullSoAVec8.h"
+
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+#include "frustumCullSoAVec8.inc.cpp"
+const soacull::Vec8Kernels soacull::vec8_kernels_avx512 = FRUSTUM_CULL_SOA_VEC8_KERNELS;
+#else
+const soacull::Vec8Kernels soacull::vec8_kernels_avx512 = {};
+#endif
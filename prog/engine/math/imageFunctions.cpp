@@ -3,6 +3,10 @@
 #include <supp/dag_prefetch.h>
 #include <math/dag_mathBase.h>
 #include <vecmath/dag_vecMath.h>
+#if _TARGET_SIMD_SSE
+#include <osApiWrappers/dag_cpuDispatch.h>
+#include "imageFunctionsVec8.h"
+#endif
 namespace imagefunctions
 {
 
@@ -206,6 +210,13 @@ void convert_to_linear_c(const float *__restrict data, unsigned char *__restrict
 
 
 #if _TARGET_SIMD_SSE
+// 8-wide variants process pixels by 8, 4-wide code below does the rest.
+// No SSE4 variant: same kernel on pairs of vec4f is slower than 4-wide code here
+static const CpuDispatch<ConvertToLinearVec8Fn> convert_to_linear_vec8 = {
+  {nullptr, nullptr, vec8_kernels_avx2.convertToLinear, vec8_kernels_avx512.convertToLinear}};
+static const CpuDispatch<Exponentiate4Vec8Fn> exponentiate4_vec8 = {
+  {nullptr, nullptr, vec8_kernels_avx2.exponentiate4, vec8_kernels_avx512.exponentiate4}};
+
 void convert_to_float_simda(const unsigned char *__restrict data, float *__restrict dest, int num)
 {
   // todo: our vec math
@@ -338,6 +349,11 @@ void exponentiate4_simda(const unsigned char *__restrict data, float *__restrict
 // SoA
 void convert_to_linear_simda(const float *__restrict data, unsigned char *__restrict dest, int num, float power)
 {
+  if (ConvertToLinearVec8Fn vec8 = convert_to_linear_vec8.get())
+  {
+    int done = vec8(data, dest, num, power);
+    data += done * 4, dest += done * 4, num -= done;
+  }
   // todo: our vec math
   const float *enddata = data + num * 4;
   __m128 powVal = _mm_setr_ps(power, power, power, power);
@@ -377,6 +393,11 @@ void convert_to_linear_simda(const float *__restrict data, unsigned char *__rest
 
 void exponentiate4_simda(const unsigned char *__restrict data, float *__restrict dest, int num, float power)
 {
+  if (Exponentiate4Vec8Fn vec8 = exponentiate4_vec8.get())
+  {
+    int done = vec8(data, dest, num, power);
+    data += done * 4, dest += done * 4, num -= done;
+  }
   // todo: our vec math
   const unsigned char *enddata = data + num * 4;
   __m128 powVal = _mm_setr_ps(power, power, power, power);
@@ -423,6 +444,11 @@ void exponentiate4_simda(const unsigned char *__restrict data, float *__restrict
 
 void exponentiate4_simdu(const unsigned char *__restrict data, float *__restrict dest, int num, float power)
 {
+  if (Exponentiate4Vec8Fn vec8 = exponentiate4_vec8.get())
+  {
+    int done = vec8(data, dest, num, power);
+    data += done * 4, dest += done * 4, num -= done;
+  }
   // todo: our vec math
   const unsigned char *enddata = data + num * 4;
   __m128 powVal = _mm_setr_ps(power, power, power, power);
@@ -0,0 +1,19 @@
+#pragma once
+
+// 8-wide variants of imagefunctions kernels compiled for different SIMD levels (imageFunctions_*.cpp), selected with CpuDispatch.
+// They process pixels by 8 and return number of processed pixels, rest is done by generic 4-wide code
+
+namespace imagefunctions
+{
+typedef int (*ConvertToLinearVec8Fn)(const float *__restrict data, unsigned char *__restrict dest, int num, float power);
+typedef int (*Exponentiate4Vec8Fn)(const unsigned char *__restrict data, float *__restrict dest, int num, float power);
+
+struct Vec8Kernels
+{
+  ConvertToLinearVec8Fn convertToLinear;
+  Exponentiate4Vec8Fn exponentiate4;
+};
+
+extern const Vec8Kernels vec8_kernels_avx2;
+extern const Vec8Kernels vec8_kernels_avx512;
+} // namespace imagefunctions
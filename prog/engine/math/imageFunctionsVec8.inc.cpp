@@ -0,0 +1,57 @@
+// included to imageFunctions_*.cpp, compiled with different target options
+#include <vecmath/dag_vecMath8.h>
+
+// 8 pixels are loaded as 4 rows of 2 pixels, so transposing 4x4 halves gives channels of pixels 0,2,4,6 and 1,3,5,7
+// (order doesn't matter, as it is restored by transposing back). Same math as 4-wide SoA code in imageFunctions.cpp
+
+static int convert_to_linear_vec8(const float *__restrict data, unsigned char *__restrict dest, int num, float power)
+{
+  const int count = num & ~7;
+  const vec8f powVal = v8_splats(power);
+  const vec8f val255 = v8_splats(255.0f);
+  for (int i = 0; i < count; i += 8, data += 32, dest += 32)
+  {
+    vec8f col0 = v8_ldu(data);
+    vec8f col1 = v8_ldu(data + 8);
+    vec8f col2 = v8_ldu(data + 16);
+    vec8f col3 = v8_ldu(data + 24);
+    v8_transpose4(col0, col1, col2, col3);
+    col0 = v8_mul(v8_pow_est(v8_max(col0, v8_zero()), powVal), val255);
+    col1 = v8_mul(v8_pow_est(v8_max(col1, v8_zero()), powVal), val255);
+    col2 = v8_mul(v8_pow_est(v8_max(col2, v8_zero()), powVal), val255);
+    col3 = v8_mul(col3, val255);
+    v8_transpose4(col0, col1, col2, col3);
+    v8_stui_packus_u8(dest, v8_cvt_roundi(col0));
+    v8_stui_packus_u8(dest + 8, v8_cvt_roundi(col1));
+    v8_stui_packus_u8(dest + 16, v8_cvt_roundi(col2));
+    v8_stui_packus_u8(dest + 24, v8_cvt_roundi(col3));
+  }
+  return count;
+}
+
+static int exponentiate4_vec8(const unsigned char *__restrict data, float *__restrict dest, int num, float power)
+{
+  const int count = num & ~7;
+  const vec8f powVal = v8_splats(power);
+  const vec8f valinv255 = v8_splats(1.0f / 255.0f);
+  for (int i = 0; i < count; i += 8, data += 32, dest += 32)
+  {
+    vec8f col0 = v8_cvt_vec8f(v8_ldui_u8(data));
+    vec8f col1 = v8_cvt_vec8f(v8_ldui_u8(data + 8));
+    vec8f col2 = v8_cvt_vec8f(v8_ldui_u8(data + 16));
+    vec8f col3 = v8_cvt_vec8f(v8_ldui_u8(data + 24));
+    v8_transpose4(col0, col1, col2, col3);
+    col0 = v8_pow_est(v8_mul(col0, valinv255), powVal);
+    col1 = v8_pow_est(v8_mul(col1, valinv255), powVal);
+    col2 = v8_pow_est(v8_mul(col2, valinv255), powVal);
+    col3 = v8_mul(col3, valinv255);
+    v8_transpose4(col0, col1, col2, col3);
+    v8_stu(dest, col0);
+    v8_stu(dest + 8, col1);
+    v8_stu(dest + 16, col2);
+    v8_stu(dest + 24, col3);
+  }
+  return count;
+}
+
+#define IMAGE_FUNCTIONS_VEC8_KERNELS {&convert_to_linear_vec8, &exponentiate4_vec8}
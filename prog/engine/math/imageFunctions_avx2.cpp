@@ -0,0 +1,8 @@
+#include "imageFunctionsVec8.h"
+
+#if defined(__AVX2__)
+#include "imageFunctionsVec8.inc.cpp"
+const imagefunctions::Vec8Kernels imagefunctions::vec8_kernels_avx2 = IMAGE_FUNCTIONS_VEC8_KERNELS;
+#else
+const imagefunctions::Vec8Kernels imagefunctions::vec8_kernels_avx2 = {};
+#endif
@@ -0,0 +1,8 @@
+#include "imageFunctionsVec8.h"
+
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+#include "imageFunctionsVec8.inc.cpp"
+const imagefunctions::Vec8Kernels imagefunctions::vec8_kernels_avx512 = IMAGE_FUNCTIONS_VEC8_KERNELS;
+#else
+const imagefunctions::Vec8Kernels imagefunctions::vec8_kernels_avx512 = {};
+#endif
@@ -14,6 +14,7 @@
 #include <memory/dag_dbgMem.h>
 #include <memory/dag_memStat.h>
 #include "allocStep.h"
+#include "heapSampler.h"
 #include <3d/3dMemStat.h>
 #include <errno.h>
 #include <startup/dag_globalSettings.h>
@@ -837,12 +838,14 @@ public:
       dumpUsedMem(), fatal("Not enough memory to alloc %llu bytes", sz);
     }
     memory_tracker.addBlock(this, p, sz);
+    heap_sampler::on_alloc(p, sz);
     return p;
   }
   void *tryAlloc(size_t sz) override
   {
     void *p = mt_dlmalloc(sz);
     memory_tracker.addBlock(this, p, sz);
+    heap_sampler::on_alloc(p, sz);
     return p;
   }
   void *allocAligned(size_t sz, size_t alignment) override
@@ -854,29 +857,35 @@ public:
       dumpUsedMem(), fatal("Not enough memory to alloc %llu bytes (alignment: %u)", sz, alignment);
     }
     memory_tracker.addBlock(this, p, sz);
+    heap_sampler::on_alloc(p, sz);
     return p;
   }
   void free(void *p) override
   {
     memory_tracker.removeBlock(this, p);
+    heap_sampler::on_free(p);
     mt_dlfree(p);
   }
   void freeAligned(void *p) override
   {
     memory_tracker.removeBlock(this, p);
+    heap_sampler::on_free(p);
     mt_dlfree_aligned(p);
   }
   size_t getSize(void *p) override { return p ? sys_malloc_usable_size(p) : 0; }
   bool resizeInplace(void *p, size_t sz) override
   {
     memory_tracker.removeBlock(this, p);
+    heap_sampler::on_free(p);
     bool res = mt_expand(p, sz);
     memory_tracker.addBlock(this, p, sz);
+    heap_sampler::on_alloc(p, sz);
     return res;
   }
   void *realloc(void *p, size_t sz) override
   {
     memory_tracker.removeBlock(this, p);
+    heap_sampler::on_free(p);
 #if MEASURE_EXPAND_EFF
     size_t asz = sys_malloc_usable_size(p);
     if (asz > 2048 && sz > asz)
@@ -888,6 +897,7 @@ public:
         interlocked_decrement(asz <= (16 << 10) ? cnt_expand_ok_16K : cnt_expand_ok);
         interlocked_increment(asz <= (16 << 10) ? cnt_expand_r_ok_16K : cnt_expand_r_ok);
         memory_tracker.addBlock(this, p, sz);
+        heap_sampler::on_alloc(p, sz);
         return p;
       }
     }
@@ -899,6 +909,7 @@ public:
       dumpUsedMem(), fatal("Not enough memory in realloc(%p,%llu) call", p, sz);
     }
     memory_tracker.addBlock(this, np, sz);
+    heap_sampler::on_alloc(np, sz);
     return np;
   }
 
@@ -1092,6 +1103,7 @@ static void real_init_memory()
 void memfree_anywhere(void *p)
 {
   memory_tracker.removeBlock(nullptr, p, 0, true);
+  heap_sampler::on_free(p);
   // measureFree(p) is not called
   mt_dlfree(p);
 }
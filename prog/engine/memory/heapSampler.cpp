@@ -0,0 +1,261 @@
+#include "heapSampler.h"
+#include <memory/dag_heapSampler.h>
+#include <osApiWrappers/dag_stackHlp.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <util/dag_globDef.h>
+#include <debug/dag_log.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// All state lives in static tables so that sampling never allocates (it is called from inside of allocator).
+// Unique call stacks are interned into open-addressing table with lock-free insertion (slot state 0->1->2),
+// sampled live pointers are kept in another open-addressing table (CAS on pointer, tombstones on removal)
+// fronted by counting bloom filter, so free() of not sampled pointer costs one load.
+// Slot 0 of stack table is reserved for samples that didn't fit into the table.
+
+#ifndef MEM_DEBUGALLOC
+#define MEM_DEBUGALLOC 0 // same default as in dlmalloc-setup.h
+#endif
+
+namespace heap_sampler
+{
+static constexpr int MAX_DEPTH = 32;
+static constexpr int SKIP_FRAMES = 2; // stackhlp_fill_stack() + on_alloc_sampled()
+static constexpr int STACK_TABLE_SIZE = 4096;
+static constexpr int LIVE_TABLE_BITS = LIVE_BLOOM_BITS;
+static constexpr int LIVE_TABLE_SIZE = 1 << LIVE_TABLE_BITS;
+static constexpr int MAX_PROBES = 64;
+
+struct StackEntry
+{
+  volatile int state; // 0 - free, 1 - being filled, 2 - ready
+  int depth;
+  uint64_t hash;
+  void *frames[MAX_DEPTH];
+  volatile uint64_t allocCnt, allocBytes, freeCnt, freeBytes;
+};
+
+struct LiveEntry
+{
+  void *volatile ptr; // nullptr - never used, TOMBSTONE - removed
+  uint32_t stackIdx;
+  uint64_t size;
+};
+static void *const TOMBSTONE = (void *)uintptr_t(1);
+
+volatile int sample_interval = 0;
+volatile int live_samples = 0;
+thread_local intptr_t bytes_until_sample = 0;
+volatile uint16_t live_bloom[1 << LIVE_BLOOM_BITS];
+
+static StackEntry stacks[STACK_TABLE_SIZE];
+static LiveEntry live[LIVE_TABLE_SIZE];
+static volatile int unique_stacks = 0, dropped_samples = 0, rng_seed = 0;
+static thread_local uint64_t rng_state = 0;
+static thread_local bool in_sampler = false;
+
+static intptr_t next_sample_interval(int mean)
+{
+  if (!rng_state)
+    rng_state = ((uint64_t(uintptr_t(&rng_state)) * 0x9E3779B97F4A7C15ull) ^ uint64_t(interlocked_increment(rng_seed))) | 1;
+  // xorshift64*, exponential distribution of intervals keeps sampling unbiased for periodic allocation patterns
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  double u = double((rng_state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+  return intptr_t(-log(1.0 - u) * mean) + 1;
+}
+
+static uint32_t find_stack(void *const *frames, int depth)
+{
+  uint64_t h = 14695981039346656037ull;
+  for (int i = 0; i < depth; i++)
+    h = (h ^ uint64_t(uintptr_t(frames[i]))) * 1099511628211ull;
+
+  uint32_t idx = 1 + uint32_t(h % (STACK_TABLE_SIZE - 1));
+  for (int probe = 0; probe < MAX_PROBES; probe++, idx = idx + 1 < STACK_TABLE_SIZE ? idx + 1 : 1)
+  {
+    StackEntry &e = stacks[idx];
+    int st = interlocked_acquire_load(e.state);
+    if (st == 0)
+    {
+      if (interlocked_compare_exchange(e.state, 1, 0) == 0)
+      {
+        e.hash = h;
+        e.depth = depth;
+        memcpy(e.frames, frames, depth * sizeof(void *));
+        interlocked_increment(unique_stacks);
+        interlocked_release_store(e.state, 2);
+        return idx;
+      }
+      st = interlocked_acquire_load(e.state);
+    }
+    while (st == 1)
+    {
+      cpu_yield();
+      st = interlocked_acquire_load(e.state);
+    }
+    if (e.hash == h && e.depth == depth && memcmp(e.frames, frames, depth * sizeof(void *)) == 0)
+      return idx;
+  }
+  return 0;
+}
+
+static bool add_live(void *p, uint32_t stack_idx, size_t sz)
+{
+  uint32_t idx = ptr_hash(p, LIVE_TABLE_BITS);
+  for (int probe = 0; probe < MAX_PROBES; probe++, idx = (idx + 1) & (LIVE_TABLE_SIZE - 1))
+  {
+    LiveEntry &e = live[idx];
+    void *cur = interlocked_relaxed_load_ptr(e.ptr);
+    if ((cur == nullptr || cur == TOMBSTONE) && interlocked_compare_exchange_ptr(e.ptr, p, cur) == cur)
+    {
+      // pointer can't be freed before allocator returns it, so filling entry after publishing it is safe
+      e.stackIdx = stack_idx;
+      e.size = sz;
+      interlocked_increment(live_bloom[ptr_hash(p, LIVE_BLOOM_BITS)]);
+      interlocked_increment(live_samples);
+      return true;
+    }
+  }
+  return false;
+}
+
+DAGOR_NOINLINE void on_alloc_sampled(void *p, size_t sz)
+{
+  int mean = interlocked_relaxed_load(sample_interval);
+  bool armed = rng_state != 0; // countdown of new thread starts at 0, so its first allocation only arms sampling
+  bytes_until_sample = next_sample_interval(mean ? mean : 1);
+  if (!armed || !mean || in_sampler) // stack walker may allocate on first use
+    return;
+
+  in_sampler = true;
+  void *frames[MAX_DEPTH + SKIP_FRAMES];
+  int depth = (int)stackhlp_fill_stack(frames, countof(frames), 0);
+  depth = depth > SKIP_FRAMES ? depth - SKIP_FRAMES : 0;
+
+  uint32_t stackIdx = find_stack(frames + SKIP_FRAMES, depth);
+  StackEntry &e = stacks[stackIdx];
+  interlocked_increment(e.allocCnt);
+  interlocked_add(e.allocBytes, uint64_t(sz));
+  if (!stackIdx)
+    interlocked_increment(dropped_samples);
+  if (!add_live(p, stackIdx, sz)) // not tracked as live, so account it as freed right away
+  {
+    interlocked_increment(e.freeCnt);
+    interlocked_add(e.freeBytes, uint64_t(sz));
+    interlocked_increment(dropped_samples);
+  }
+  in_sampler = false;
+}
+
+DAGOR_NOINLINE void on_free_maybe_sampled(void *p)
+{
+  uint32_t idx = ptr_hash(p, LIVE_TABLE_BITS);
+  for (int probe = 0; probe < MAX_PROBES; probe++, idx = (idx + 1) & (LIVE_TABLE_SIZE - 1))
+  {
+    LiveEntry &e = live[idx];
+    void *cur = interlocked_acquire_load_ptr(e.ptr);
+    if (cur == p)
+    {
+      StackEntry &s = stacks[e.stackIdx];
+      uint64_t sz = e.size;
+      interlocked_release_store_ptr(e.ptr, TOMBSTONE);
+      interlocked_decrement(live_bloom[ptr_hash(p, LIVE_BLOOM_BITS)]);
+      interlocked_decrement(live_samples);
+      interlocked_increment(s.freeCnt);
+      interlocked_add(s.freeBytes, sz);
+      return;
+    }
+    if (!cur)
+      return;
+  }
+}
+
+// debug allocator (MEM_DEBUGALLOC > 0) tracks every block itself and has no sampler hooks
+bool is_supported() { return MEM_DEBUGALLOC <= 0; }
+
+void set_sample_interval(size_t mean_bytes)
+{
+  if (mean_bytes && !is_supported())
+  {
+    logerr("heap_sampler: not supported with debug memory allocator (MEM_DEBUGALLOC=%d), sampling stays disabled", MEM_DEBUGALLOC);
+    return;
+  }
+  interlocked_release_store(sample_interval, int(min<size_t>(mean_bytes, 1u << 30)));
+}
+size_t get_sample_interval() { return interlocked_relaxed_load(sample_interval); }
+
+static bool get_entry(int idx, uint64_t &alloc_cnt, uint64_t &alloc_bytes, uint64_t &live_cnt, uint64_t &live_bytes)
+{
+  StackEntry &e = stacks[idx];
+  if (idx && interlocked_acquire_load(e.state) != 2)
+    return false;
+  alloc_cnt = interlocked_relaxed_load(e.allocCnt);
+  if (!alloc_cnt)
+    return false;
+  alloc_bytes = interlocked_relaxed_load(e.allocBytes);
+  uint64_t freeCnt = interlocked_relaxed_load(e.freeCnt), freeBytes = interlocked_relaxed_load(e.freeBytes);
+  live_cnt = alloc_cnt > freeCnt ? alloc_cnt - freeCnt : 0;
+  live_bytes = alloc_bytes > freeBytes ? alloc_bytes - freeBytes : 0;
+  return true;
+}
+
+void get_stats(Stats &out_stats)
+{
+  memset(&out_stats, 0, sizeof(out_stats));
+  for (int i = 0; i < STACK_TABLE_SIZE; i++)
+  {
+    uint64_t allocCnt, allocBytes, liveCnt, liveBytes;
+    if (!get_entry(i, allocCnt, allocBytes, liveCnt, liveBytes))
+      continue;
+    out_stats.liveSamples += liveCnt;
+    out_stats.liveBytes += liveBytes;
+    out_stats.totalSamples += allocCnt;
+    out_stats.totalBytes += allocBytes;
+  }
+  out_stats.uniqueStacks = interlocked_relaxed_load(unique_stacks);
+  out_stats.droppedSamples = interlocked_relaxed_load(dropped_samples);
+}
+
+bool dump_profile(const char *fname)
+{
+  FILE *fp = fopen(fname, "wt");
+  if (!fp)
+    return false;
+
+  Stats st;
+  get_stats(st);
+  // legacy pprof heap profile: "<live objs>: <live bytes> [<alloc objs>: <alloc bytes>] @ <stack>" per unique stack
+  fprintf(fp, "heap profile: %lld: %lld [%lld: %lld] @ heap_v2/%d\n", (long long)st.liveSamples, (long long)st.liveBytes,
+    (long long)st.totalSamples, (long long)st.totalBytes, interlocked_relaxed_load(sample_interval));
+  for (int i = 0; i < STACK_TABLE_SIZE; i++)
+  {
+    uint64_t allocCnt, allocBytes, liveCnt, liveBytes;
+    if (!get_entry(i, allocCnt, allocBytes, liveCnt, liveBytes))
+      continue;
+    fprintf(fp, "%llu: %llu [%llu: %llu] @", (unsigned long long)liveCnt, (unsigned long long)liveBytes,
+      (unsigned long long)allocCnt, (unsigned long long)allocBytes);
+    if (i == 0) // overflow samples are attributed to sampler itself
+      fprintf(fp, " %p", (void *)&on_alloc_sampled);
+    for (int j = 0; j < stacks[i].depth; j++)
+      fprintf(fp, " %p", stacks[i].frames[j]);
+    fputc('\n', fp);
+  }
+
+#if _TARGET_PC_LINUX
+  fputs("\nMAPPED_LIBRARIES:\n", fp);
+  if (FILE *maps = fopen("/proc/self/maps", "rt"))
+  {
+    char buf[4096];
+    for (size_t len; (len = fread(buf, 1, sizeof(buf), maps)) > 0;)
+      fwrite(buf, 1, len, fp);
+    fclose(maps);
+  }
+#endif
+  bool ok = !ferror(fp);
+  fclose(fp);
+  return ok;
+}
+} // namespace heap_sampler
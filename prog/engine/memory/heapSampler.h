@@ -0,0 +1,42 @@
+#pragma once
+
+#include <osApiWrappers/dag_atomic.h>
+#include <util/dag_stdint.h>
+#include <util/dag_compilerDefs.h>
+
+// allocator hooks of heap sampler (see <memory/dag_heapSampler.h>), inline part is kept minimal:
+// one load when sampling is off, thread-local countdown on alloc and one bloom filter probe on free otherwise
+namespace heap_sampler
+{
+extern volatile int sample_interval; //< 0 when sampling is off
+extern volatile int live_samples;
+extern thread_local intptr_t bytes_until_sample;
+extern volatile uint16_t live_bloom[];
+static constexpr int LIVE_BLOOM_BITS = 16;
+
+void on_alloc_sampled(void *p, size_t sz);
+void on_free_maybe_sampled(void *p);
+
+inline uint32_t ptr_hash(const void *p, int bits)
+{
+  return uint32_t((uint64_t(uintptr_t(p) >> 4) * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+inline void on_alloc(void *p, size_t sz)
+{
+  if (DAGOR_LIKELY(!interlocked_relaxed_load(sample_interval)) || !p)
+    return;
+  if (DAGOR_LIKELY((bytes_until_sample -= intptr_t(sz)) > 0))
+    return;
+  on_alloc_sampled(p, sz);
+}
+
+inline void on_free(void *p)
+{
+  if (DAGOR_LIKELY(!interlocked_relaxed_load(live_samples)) || !p)
+    return;
+  if (DAGOR_LIKELY(!interlocked_relaxed_load(live_bloom[ptr_hash(p, LIVE_BLOOM_BITS)])))
+    return;
+  on_free_maybe_sampled(p);
+}
+} // namespace heap_sampler
@@ -2,6 +2,7 @@
 #include <malloc.h>
 #endif
 #include <mimalloc.h>
+#include "../heapSampler.h"
 
 #ifdef _MSC_VER
 #if _MSC_VER >= 1900
@@ -25,13 +26,31 @@
 
 MEMEXP void *__cdecl malloc(size_t sz) { return mi_malloc(sz); }
 MEMEXP void *__cdecl calloc(size_t n, size_t c) { return mi_calloc(n, c); }
-MEMEXP void *__cdecl realloc(void *p, size_t s) { return mi_realloc(p, s); }
-MEMEXP2 void __cdecl free(void *ptr) { mi_free(ptr); }
+// blocks of IMemAlloc (sampled in dagmem.cpp) share this heap and may be released by plain free()/realloc(), so those must
+// drop sampled pointers too; plain malloc() is not sampled, as IMemAlloc calls it and would sample the same block twice
+MEMEXP void *__cdecl realloc(void *p, size_t s)
+{
+  heap_sampler::on_free(p);
+  return mi_realloc(p, s);
+}
+MEMEXP2 void __cdecl free(void *ptr)
+{
+  heap_sampler::on_free(ptr);
+  mi_free(ptr);
+}
 MEMEXP3 size_t __cdecl _msize(void *ptr) { return mi_usable_size(ptr); }
 MEMEXP3 size_t __cdecl _msize_base(void *ptr) { return _msize(ptr); }
 MEMEXP void *__cdecl _aligned_malloc(size_t sz, size_t al) { return mi_malloc_aligned(sz, al); }
-MEMEXP2 void __cdecl _aligned_free(void *ptr) { mi_free(ptr); }
-MEMEXP void *__cdecl _aligned_realloc(void *ptr, size_t sz, size_t al) { return mi_realloc_aligned(ptr, sz, al); }
+MEMEXP2 void __cdecl _aligned_free(void *ptr)
+{
+  heap_sampler::on_free(ptr);
+  mi_free(ptr);
+}
+MEMEXP void *__cdecl _aligned_realloc(void *ptr, size_t sz, size_t al)
+{
+  heap_sampler::on_free(ptr);
+  return mi_realloc_aligned(ptr, sz, al);
+}
 MEMEXP2 size_t __cdecl _aligned_msize(void *ptr, size_t, size_t) { return mi_usable_size(ptr); }
 MEMEXP3 void *__cdecl _expand(void *ptr, size_t sz) { return mi_expand(ptr, sz); }
 
@@ -1,5 +1,6 @@
 #include "osApiWrappers/dag_cpuFeatures.h"
 #include "osApiWrappers/dag_xstateFeatures.h"
+#include "osApiWrappers/dag_cpuDispatch.h"
 #include <cstdint>
 
 bool cpu_feature_sse41_checked = false;
@@ -8,7 +9,10 @@ bool cpu_feature_popcnt_checked = false;
 bool cpu_feature_fma_checked = false;
 bool cpu_feature_avx_checked = false;
 bool cpu_feature_avx2_checked = false;
+bool cpu_feature_avx512_checked = false;
 bool cpu_feature_fast_256bit_avx_checked = false;
+CpuSimdLevel cpu_simd_level_checked = CPU_SIMD_BASE;
+static CpuSimdLevel cpu_simd_level_limit = CPU_SIMD_AVX512;
 
 #ifdef _TARGET_SIMD_SSE
 
@@ -37,6 +41,17 @@ static inline void __get_cpuid_count(uint32_t l, uint32_t sl, uint32_t *eax, uin
 }
 #endif // !_MSC_VER || defined(__clang__)
 
+static uint64_t get_xcr0() // OS-enabled register states, valid only when OSXSAVE is set
+{
+#if _MSC_VER && !defined(__clang__)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax | (uint64_t(edx) << 32);
+#endif
+}
+
 static bool dag_check_cpu_features()
 {
   enum CpuFeatures1Ecx : uint32_t // eax=1
@@ -50,8 +65,13 @@ static bool dag_check_cpu_features()
   };
   enum CpuFeatures70Ebx : uint32_t // eax=7, ecx=0
   {
-    AVX2_BIT = 1 << 5
+    AVX2_BIT = 1 << 5,
+    AVX512F_BIT = 1 << 16,
+    AVX512DQ_BIT = 1 << 17,
+    AVX512BW_BIT = 1 << 30,
+    AVX512VL_BIT = 1u << 31
   };
+  const uint64_t XCR0_AVX512_STATE = 0xE6; // SSE, AVX, opmask, upper halves of ZMM0-15 and ZMM16-31
   uint32_t eax, ebx, ecx, edx;
 
 #if defined(_TARGET_64BIT)
@@ -82,11 +102,29 @@ static bool dag_check_cpu_features()
 
   __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
   cpu_feature_avx2_checked = (ebx & CpuFeatures70Ebx::AVX2_BIT) && osxsave;
+  const uint32_t avx512Bits = AVX512F_BIT | AVX512DQ_BIT | AVX512BW_BIT | AVX512VL_BIT;
+  cpu_feature_avx512_checked =
+    (ebx & avx512Bits) == avx512Bits && osxsave && (get_xcr0() & XCR0_AVX512_STATE) == XCR0_AVX512_STATE && isX64;
+
+  if (cpu_feature_sse41_checked && cpu_feature_sse42_checked && cpu_feature_popcnt_checked)
+    cpu_simd_level_checked = CPU_SIMD_SSE4;
+  if (cpu_simd_level_checked == CPU_SIMD_SSE4 && cpu_feature_avx2_checked && cpu_feature_fma_checked &&
+      cpu_feature_fast_256bit_avx_checked)
+    cpu_simd_level_checked = CPU_SIMD_AVX2;
+  if (cpu_simd_level_checked == CPU_SIMD_AVX2 && cpu_feature_avx512_checked)
+    cpu_simd_level_checked = CPU_SIMD_AVX512;
   return true;
 }
 static bool initialized = dag_check_cpu_features();
 
 #endif // _TARGET_SIMD_SSE
 
+CpuSimdLevel get_cpu_simd_level()
+{
+  return cpu_simd_level_checked < cpu_simd_level_limit ? cpu_simd_level_checked : cpu_simd_level_limit;
+}
+
+void set_cpu_simd_level_limit(CpuSimdLevel level) { cpu_simd_level_limit = level; }
+
 #define EXPORT_PULL dll_pull_osapiwrappers_cpuFeatures
 #include <supp/exportPull.h>
@@ -0,0 +1,784 @@
+#include <sceneRay/dag_sceneRayBvh.h>
+#include <sceneRay/dag_sceneRay.h>
+#include <math/dag_traceRayTriangle.h>
+#include <util/dag_parallelForInline.h>
+#include <util/dag_bitArray.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <ioSys/dag_genIo.h>
+#include <ioSys/dag_zlibIo.h>
+#include <ioSys/dag_zstdIo.h>
+#include <util/dag_hash.h>
+#include <debug/dag_debug.h>
+#include <debug/dag_log.h>
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+#include <float.h>
+#include <string.h>
+#include "version.h"
+
+static inline unsigned get_u32(const SceneRayI24F8 &fi) { return fi.u32; }
+static inline unsigned get_u32(const uint16_t &) { return StaticSceneRayTracer::CULL_CCW << 24; }
+
+#if (__cplusplus >= 201703L) || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define IF_CONSTEXPR if constexpr
+#else
+#define IF_CONSTEXPR if
+#endif
+
+// 4-wide depth is not more than binary depth, which is MAX_SAH_DEPTH + log2(faces) at most, and each level pushes 3 entries at most
+static constexpr int TRAVERSAL_STACK_SIZE = 256;
+
+namespace
+{
+struct BvhBuildNode
+{
+  bbox3f box;
+  int first, count; // range in order[] for leaf
+  int left, right;  // -1 for leaf
+  bool isLeaf() const { return left < 0; }
+};
+
+struct BvhBuilder
+{
+  static constexpr int BINS = 16;
+  static constexpr int MAX_SAH_DEPTH = 40; // deeper ranges are split by median, which bounds depth (and traversal stack)
+  static constexpr int TASK_FACES = 4096;  // subtrees of about that size are built as separate threadpool jobs
+  static constexpr int MAX_LEAF_FACES = StaticSceneRayBvh::MAX_LEAF_FACES;
+
+  Tab<bbox3f> faceBox;
+  Tab<vec4f> center;
+  Tab<int> order; // faces, reordered during build so that each leaf owns continuous range
+
+  struct Task
+  {
+    int first, count, depth, node;
+    Tab<BvhBuildNode> nodes;
+  };
+  Tab<Task> tasks;
+
+  static float half_area(bbox3f_cref b)
+  {
+    vec3f d = v_max(v_sub(b.bmax, b.bmin), v_zero());
+    return v_extract_x(v_dot3_x(d, v_perm_yzxw(d)));
+  }
+  float centerAt(int face, int axis) const { return ((const float *)&center[face])[axis]; }
+
+  // returns end of left part in order[] or -1 to make leaf; computes box of whole range
+  int split(int first, int count, int depth, bbox3f &box)
+  {
+    bbox3f cbox;
+    v_bbox3_init_empty(box);
+    v_bbox3_init_empty(cbox);
+    for (int i = first, e = first + count; i < e; i++)
+    {
+      v_bbox3_add_box(box, faceBox[order[i]]);
+      v_bbox3_add_pt(cbox, center[order[i]]);
+    }
+    if (count <= 4)
+      return -1;
+
+    alignas(16) float cmin[4], ext[4];
+    v_st(cmin, cbox.bmin);
+    v_st(ext, v_sub(cbox.bmax, cbox.bmin));
+    int longest = ext[0] >= ext[1] ? (ext[0] >= ext[2] ? 0 : 2) : (ext[1] >= ext[2] ? 1 : 2);
+    if (ext[longest] <= 0) // all centers are the same, any halves are as good
+      return count <= MAX_LEAF_FACES ? -1 : first + count / 2;
+    if (depth >= MAX_SAH_DEPTH)
+      return medianSplit(first, count, longest);
+
+    const float leafCost = count;
+    float bestCost = FLT_MAX, parentArea = max(half_area(box), 1e-12f);
+    int bestAxis = -1, bestBin = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      if (ext[axis] <= 0)
+        continue;
+      bbox3f binBox[BINS];
+      int binCnt[BINS];
+      for (int b = 0; b < BINS; b++)
+      {
+        v_bbox3_init_empty(binBox[b]);
+        binCnt[b] = 0;
+      }
+      const float scale = BINS * (1.f - 1e-6f) / ext[axis];
+      for (int i = first, e = first + count; i < e; i++)
+      {
+        int b = min(int((centerAt(order[i], axis) - cmin[axis]) * scale), BINS - 1);
+        v_bbox3_add_box(binBox[b], faceBox[order[i]]);
+        binCnt[b]++;
+      }
+
+      float rightArea[BINS];
+      int rightCnt[BINS];
+      bbox3f acc;
+      v_bbox3_init_empty(acc);
+      for (int b = BINS - 1, cnt = 0; b > 0; b--)
+      {
+        v_bbox3_add_box(acc, binBox[b]);
+        cnt += binCnt[b];
+        rightArea[b] = half_area(acc);
+        rightCnt[b] = cnt;
+      }
+      v_bbox3_init_empty(acc);
+      for (int b = 1, cnt = 0; b < BINS; b++) // split between bin b-1 and b
+      {
+        v_bbox3_add_box(acc, binBox[b - 1]);
+        cnt += binCnt[b - 1];
+        if (!cnt || !rightCnt[b])
+          continue;
+        float cost = 1.f + (half_area(acc) * cnt + rightArea[b] * rightCnt[b]) / parentArea;
+        if (cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = b;
+        }
+      }
+    }
+
+    if (bestAxis < 0)
+      return count <= MAX_LEAF_FACES ? -1 : medianSplit(first, count, longest);
+    if (count <= MAX_LEAF_FACES && leafCost <= bestCost)
+      return -1;
+
+    const float scale = BINS * (1.f - 1e-6f) / ext[bestAxis], axisMin = cmin[bestAxis];
+    int *mid = eastl::partition(order.data() + first, order.data() + first + count, [&](int f) {
+      return min(int((centerAt(f, bestAxis) - axisMin) * scale), BINS - 1) < bestBin;
+    });
+    return int(mid - order.data());
+  }
+
+  int medianSplit(int first, int count, int axis)
+  {
+    int *b = order.data() + first, *m = b + count / 2;
+    eastl::nth_element(b, m, b + count, [&](int f0, int f1) {
+      float c0 = centerAt(f0, axis), c1 = centerAt(f1, axis);
+      return c0 < c1 || (c0 == c1 && f0 < f1);
+    });
+    return int(m - order.data());
+  }
+
+  int buildNode(Tab<BvhBuildNode> &out, int first, int count, int depth, bool spawn_tasks)
+  {
+    int idx = out.size();
+    BvhBuildNode &n = out.push_back();
+    n.first = first;
+    n.count = count;
+    n.left = n.right = -1;
+    if (spawn_tasks && count <= TASK_FACES)
+    {
+      Task &t = tasks.push_back();
+      t.first = first;
+      t.count = count;
+      t.depth = depth;
+      t.node = idx;
+      return idx;
+    }
+    bbox3f box;
+    int mid = split(first, count, depth, box);
+    out[idx].box = box;
+    if (mid < 0)
+      return idx;
+    int left = buildNode(out, first, mid - first, depth + 1, spawn_tasks);
+    int right = buildNode(out, mid, first + count - mid, depth + 1, spawn_tasks);
+    out[idx].left = left;
+    out[idx].right = right;
+    out[idx].count = 0;
+    return idx;
+  }
+};
+} // namespace
+
+template <typename FI>
+void StaticSceneRayBvhT<FI>::clear()
+{
+  clear_and_shrink(nodes);
+  clear_and_shrink(packs);
+  clear_and_shrink(packFaces);
+  v_bbox3_init_empty(rootBox);
+}
+
+template <typename FI>
+bool StaticSceneRayBvhT<FI>::build(const Tracer &rt, bool use_threadpool)
+{
+  clear();
+  tracer = &rt;
+
+  // only faces referenced by tracer's grid are traceable; take face flags from there too
+  Tab<FaceIndex> faceRef;
+  Bitarray used;
+  faceRef.resize(rt.getFacesCount());
+  used.resize(rt.getFacesCount());
+  used.reset();
+  BvhBuilder b;
+  b.order.reserve(rt.getFacesCount());
+  for (int i = 0, ie = rt.getFaceIndicesCount(); i < ie; i++)
+  {
+    int fi = int(rt.faceIndices(i));
+    if (fi >= rt.getFacesCount() || used.get(fi))
+      continue;
+    used.set(fi);
+    faceRef[fi] = rt.faceIndices(i);
+    b.order.push_back(fi);
+  }
+  if (b.order.empty())
+    return false;
+  eastl::sort(b.order.begin(), b.order.end());
+
+  const threadpool::JobPriority prio = is_main_thread() ? threadpool::PRIO_HIGH : threadpool::PRIO_NORMAL;
+  const bool parallel = use_threadpool && threadpool::get_num_workers() > 0;
+  b.faceBox.resize(rt.getFacesCount());
+  b.center.resize(rt.getFacesCount());
+  auto calcBounds = [&](uint32_t begin, uint32_t end, uint32_t) {
+    for (uint32_t i = begin; i < end; i++)
+    {
+      int f = b.order[i];
+      const typename Tracer::RTface &face = rt.faces(f);
+      vec3f v0 = v_ld(&rt.verts(face.v[0]).x), v1 = v_ld(&rt.verts(face.v[1]).x), v2 = v_ld(&rt.verts(face.v[2]).x);
+      bbox3f &box = b.faceBox[f];
+      v_bbox3_init(box, v0);
+      v_bbox3_add_pt(box, v1);
+      v_bbox3_add_pt(box, v2);
+      b.center[f] = v_bbox3_center(box);
+    }
+  };
+  if (parallel)
+    threadpool::parallel_for_inline(0, b.order.size(), 4096, calcBounds, 0, prio);
+  else
+    calcBounds(0, b.order.size(), 0);
+
+  // top of tree is split serially, subtrees go to threadpool; node order doesn't matter, as wide nodes are emitted depth-first
+  Tab<BvhBuildNode> bnodes;
+  int root = b.buildNode(bnodes, 0, b.order.size(), 0, parallel);
+  if (b.tasks.size())
+  {
+    threadpool::parallel_for_inline(0, b.tasks.size(), 1,
+      [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t i = begin; i < end; i++)
+        {
+          BvhBuilder::Task &t = b.tasks[i];
+          b.buildNode(t.nodes, t.first, t.count, t.depth, false);
+        }
+      },
+      0, prio);
+    for (BvhBuilder::Task &t : b.tasks)
+    {
+      int ofs = bnodes.size();
+      for (BvhBuildNode n : t.nodes)
+      {
+        if (!n.isLeaf())
+          n.left += ofs, n.right += ofs;
+        bnodes.push_back(n);
+      }
+      bnodes[t.node] = bnodes[ofs];
+    }
+    clear_and_shrink(b.tasks);
+  }
+  rootBox = bnodes[root].box;
+
+  // collapse binary tree to 4-wide: repeatedly open the largest inner child
+  auto emitLeaf = [&](const BvhBuildNode &n) -> uint32_t {
+    int firstPack = packs.size(), packsCnt = (n.count + 3) / 4;
+    G_ASSERT(packsCnt >= 1 && packsCnt <= (1 << LEAF_PACKS_BITS));
+    for (int k = 0; k < packsCnt; k++)
+    {
+      vec4f v[3][4];
+      for (int lane = 0; lane < 4; lane++)
+      {
+        int f = b.order[n.first + min(k * 4 + lane, n.count - 1)];
+        const typename Tracer::RTface &face = rt.faces(f);
+        for (int vi = 0; vi < 3; vi++)
+          v[vi][lane] = v_ld(&rt.verts(face.v[vi]).x);
+        packFaces.push_back(faceRef[f]);
+      }
+      TriPack &tp = packs.push_back();
+      v_mat44_transpose_to_mat43(v[0][0], v[0][1], v[0][2], v[0][3], tp.p0.row0, tp.p0.row1, tp.p0.row2);
+      v_mat44_transpose_to_mat43(v[1][0], v[1][1], v[1][2], v[1][3], tp.p1.row0, tp.p1.row1, tp.p1.row2);
+      v_mat44_transpose_to_mat43(v[2][0], v[2][1], v[2][2], v[2][3], tp.p2.row0, tp.p2.row1, tp.p2.row2);
+    }
+    return LEAF_BIT | (uint32_t(firstPack) << LEAF_PACKS_BITS) | uint32_t(packsCnt - 1);
+  };
+  auto emitNode = [&](auto &self, int bn) -> uint32_t {
+    int cand[WIDTH], cnt = 0;
+    if (bnodes[bn].isLeaf())
+      cand[cnt++] = bn;
+    else
+    {
+      cand[cnt++] = bnodes[bn].left;
+      cand[cnt++] = bnodes[bn].right;
+    }
+    while (cnt < WIDTH)
+    {
+      int best = -1;
+      float bestArea = -1;
+      for (int i = 0; i < cnt; i++)
+        if (!bnodes[cand[i]].isLeaf() && BvhBuilder::half_area(bnodes[cand[i]].box) > bestArea)
+          bestArea = BvhBuilder::half_area(bnodes[cand[best = i]].box);
+      if (best < 0)
+        break;
+      int opened = cand[best];
+      memmove(&cand[best + 2], &cand[best + 1], (cnt - best - 1) * sizeof(int));
+      cand[best] = bnodes[opened].left;
+      cand[best + 1] = bnodes[opened].right;
+      cnt++;
+    }
+
+    uint32_t wi = nodes.size();
+    Node &wn = nodes.push_back();
+    for (int c = 0; c < WIDTH; c++)
+    {
+      for (int a = 0; a < 3; a++)
+      {
+        wn.box[0][a][c] = FLT_MAX;
+        wn.box[1][a][c] = -FLT_MAX;
+      }
+      wn.child[c] = EMPTY_CHILD;
+    }
+    for (int c = 0; c < cnt; c++)
+    {
+      const BvhBuildNode &n = bnodes[cand[c]];
+      alignas(16) float bmin[4], bmax[4];
+      v_st(bmin, n.box.bmin);
+      v_st(bmax, n.box.bmax);
+      uint32_t child = n.isLeaf() ? emitLeaf(n) : self(self, cand[c]);
+      Node &dst = nodes[wi];
+      for (int a = 0; a < 3; a++)
+      {
+        dst.box[0][a][c] = bmin[a];
+        dst.box[1][a][c] = bmax[a];
+      }
+      dst.child[c] = child;
+    }
+    return wi;
+  };
+  emitNode(emitNode, root);
+  nodes.shrink_to_fit();
+  packs.shrink_to_fit();
+  packFaces.shrink_to_fit();
+  return true;
+}
+
+template <typename FI>
+__forceinline int StaticSceneRayBvhT<FI>::packLanes(int pack, unsigned use_flags, unsigned skip_flags) const
+{
+  IF_CONSTEXPR (sizeof(FaceIndex) > 2)
+  {
+    const FaceIndex *f = &packFaces[pack * 4];
+    int lanes = 0;
+    for (int i = 0; i < 4; i++)
+      if (!(get_u32(f[i]) & skip_flags) && (get_u32(f[i]) & use_flags))
+        lanes |= 1 << i;
+    return lanes;
+  }
+  return 0xF;
+}
+
+template <typename FI>
+template <bool any_hit>
+VECTORCALL __forceinline int StaticSceneRayBvhT<FI>::traceLeaf(vec3f p, vec3f dir, float &mint, uint32_t leaf, unsigned use_flags,
+  unsigned skip_flags) const
+{
+  int first = (leaf & ~LEAF_BIT) >> LEAF_PACKS_BITS, last = first + (leaf & ((1 << LEAF_PACKS_BITS) - 1));
+  int hit = -1;
+  for (int pk = first; pk <= last; pk++)
+  {
+    const TriPack &tp = packs[pk];
+    int lanes = packLanes(pk, use_flags, skip_flags);
+    if (!lanes)
+      continue;
+    vec4f mask = V_CI_MASK1111;
+    if (lanes != 0xF)
+    {
+      vec4i laneBits = v_make_vec4i(1, 2, 4, 8);
+      mask = v_cast_vec4f(v_cmp_eqi(v_andi(v_splatsi(lanes), laneBits), laneBits));
+    }
+    IF_CONSTEXPR (any_hit)
+    {
+      if (int hitLanes = rayhit4Triangles(p, dir, mint, tp.p0, tp.p1, tp.p2, true, mask))
+        return int(packFaces[pk * 4 + __bsf_unsafe(hitLanes)]);
+    }
+    else
+    {
+      int lane = traceray4Triangles(p, dir, mint, tp.p0, tp.p1, tp.p2, true, mask);
+      if (lane >= 0)
+        hit = int(packFaces[pk * 4 + lane]);
+    }
+  }
+  return hit;
+}
+
+static __forceinline vec3f safe_inv_dir(vec3f dir)
+{
+  vec3f tiny = v_splats(1e-20f);
+  vec3f safeDir = v_sel(v_or(tiny, v_and(dir, v_cast_vec4f(V_CI_SIGN_MASK))), dir, v_cmp_gt(v_abs(dir), tiny));
+  return v_div(V_C_ONE, safeDir);
+}
+
+template <typename FI>
+template <bool any_hit>
+VECTORCALL inline int StaticSceneRayBvhT<FI>::traceSingle(vec3f p, vec3f dir, float &mint) const
+{
+  if (mint <= 0 || nodes.empty())
+    return -1;
+  const unsigned useFlags = tracer->getUseFlags() << 24, skipFlags = tracer->getSkipFlags() << 24;
+  vec3f inv = safe_inv_dir(dir), pInv = v_mul(p, inv);
+  const int signs = v_signmask(inv);
+  const int sx = signs & 1, sy = (signs >> 1) & 1, sz = (signs >> 2) & 1;
+  vec4f ix = v_splat_x(inv), iy = v_splat_y(inv), iz = v_splat_z(inv);
+  vec4f px = v_splat_x(pInv), py = v_splat_y(pInv), pz = v_splat_z(pInv);
+
+  struct Entry
+  {
+    uint32_t node;
+    float tnear;
+  } stack[TRAVERSAL_STACK_SIZE];
+  int sp = 0;
+  stack[sp++] = {0, 0.f};
+  int hit = -1;
+  while (sp)
+  {
+    const Entry e = stack[--sp];
+    if (e.tnear > mint)
+      continue;
+    if (e.node & LEAF_BIT)
+    {
+      int ret = traceLeaf<any_hit>(p, dir, mint, e.node, useFlags, skipFlags);
+      if (ret >= 0)
+      {
+        hit = ret;
+        IF_CONSTEXPR (any_hit)
+          return hit;
+      }
+      continue;
+    }
+    const Node &n = nodes[e.node];
+    vec4f tn = v_max(v_max(v_msub(v_ld(n.box[sx][0]), ix, px), v_msub(v_ld(n.box[sy][1]), iy, py)),
+      v_max(v_msub(v_ld(n.box[sz][2]), iz, pz), v_zero()));
+    vec4f tf = v_min(v_min(v_msub(v_ld(n.box[sx ^ 1][0]), ix, px), v_msub(v_ld(n.box[sy ^ 1][1]), iy, py)),
+      v_min(v_msub(v_ld(n.box[sz ^ 1][2]), iz, pz), v_splats(mint)));
+    int mask = v_signmask(v_cmp_ge(tf, tn));
+    if (!mask)
+      continue;
+    alignas(16) float tnear[WIDTH];
+    v_st(tnear, tn);
+    // push in far to near order, so nearest child is traversed first
+    int base = sp;
+    for (; mask; mask &= mask - 1)
+    {
+      int c = __bsf_unsafe(mask), at = sp++;
+      for (; at > base && stack[at - 1].tnear < tnear[c]; at--)
+        stack[at] = stack[at - 1];
+      stack[at] = {n.child[c], tnear[c]};
+    }
+    G_FAST_ASSERT(sp <= TRAVERSAL_STACK_SIZE);
+  }
+  return hit;
+}
+
+// 4 rays of the same direction octant traverse nodes together, each child box is tested against all 4 rays at once
+template <typename FI>
+template <bool any_hit>
+inline void StaticSceneRayBvhT<FI>::tracePacket4(const Point3 *p, const Point3 *dir, float *t, int *out_face) const
+{
+  const unsigned useFlags = tracer->getUseFlags() << 24, skipFlags = tracer->getSkipFlags() << 24;
+  vec3f rp[4], rd[4];
+  int active = 0;
+  for (int r = 0; r < 4; r++)
+  {
+    rp[r] = v_ldu_p3(&p[r].x);
+    rd[r] = v_ldu_p3(&dir[r].x);
+    out_face[r] = -1;
+    active |= t[r] > 0 ? 1 << r : 0;
+  }
+  if (!active)
+    return;
+
+  vec4f ox = v_make_vec4f(p[0].x, p[1].x, p[2].x, p[3].x);
+  vec4f oy = v_make_vec4f(p[0].y, p[1].y, p[2].y, p[3].y);
+  vec4f oz = v_make_vec4f(p[0].z, p[1].z, p[2].z, p[3].z);
+  vec4f ix = safe_inv_dir(v_make_vec4f(dir[0].x, dir[1].x, dir[2].x, dir[3].x));
+  vec4f iy = safe_inv_dir(v_make_vec4f(dir[0].y, dir[1].y, dir[2].y, dir[3].y));
+  vec4f iz = safe_inv_dir(v_make_vec4f(dir[0].z, dir[1].z, dir[2].z, dir[3].z));
+  vec4f px = v_mul(ox, ix), py = v_mul(oy, iy), pz = v_mul(oz, iz);
+  const int signs = v_signmask(safe_inv_dir(rd[0]));
+  const int sx = signs & 1, sy = (signs >> 1) & 1, sz = (signs >> 2) & 1;
+  vec4f tmax = v_ldu(t);
+
+  struct Entry
+  {
+    uint32_t node;
+    int rays;
+    float tnear;
+  } stack[TRAVERSAL_STACK_SIZE];
+  int sp = 0;
+  stack[sp++] = {0, active, 0.f};
+  while (sp)
+  {
+    const Entry e = stack[--sp];
+    int rays = e.rays & active;
+    if (!rays)
+      continue;
+    if (e.node & LEAF_BIT)
+    {
+      for (; rays; rays &= rays - 1)
+      {
+        int r = __bsf_unsafe(rays);
+        int ret = traceLeaf<any_hit>(rp[r], rd[r], t[r], e.node, useFlags, skipFlags);
+        if (ret < 0)
+          continue;
+        out_face[r] = ret;
+        IF_CONSTEXPR (any_hit)
+          active &= ~(1 << r);
+      }
+      IF_CONSTEXPR (any_hit)
+      {
+        if (!active)
+          return;
+      }
+      tmax = v_ldu(t);
+      continue;
+    }
+    const Node &n = nodes[e.node];
+    int base = sp;
+    for (int c = 0; c < WIDTH; c++)
+    {
+      vec4f tn = v_max(v_max(v_msub(v_splats(n.box[sx][0][c]), ix, px), v_msub(v_splats(n.box[sy][1][c]), iy, py)),
+        v_max(v_msub(v_splats(n.box[sz][2][c]), iz, pz), v_zero()));
+      vec4f tf = v_min(v_min(v_msub(v_splats(n.box[sx ^ 1][0][c]), ix, px), v_msub(v_splats(n.box[sy ^ 1][1][c]), iy, py)),
+        v_min(v_msub(v_splats(n.box[sz ^ 1][2][c]), iz, pz), tmax));
+      vec4f hitMask = v_cmp_ge(tf, tn);
+      int childRays = v_signmask(hitMask) & rays;
+      if (!childRays)
+        continue;
+      float tnear = v_extract_x(v_hmin(v_sel(V_C_MAX_VAL, tn, hitMask)));
+      int at = sp++;
+      for (; at > base && stack[at - 1].tnear < tnear; at--)
+        stack[at] = stack[at - 1];
+      stack[at] = {n.child[c], childRays, tnear};
+    }
+    G_FAST_ASSERT(sp <= TRAVERSAL_STACK_SIZE);
+  }
+}
+
+template <typename FI>
+VECTORCALL int StaticSceneRayBvhT<FI>::tracerayNormalized(vec3f p, vec3f dir, real &mint) const
+{
+  return traceSingle<false>(p, dir, mint);
+}
+
+template <typename FI>
+VECTORCALL int StaticSceneRayBvhT<FI>::rayhitNormalizedIdx(vec3f p, vec3f dir, real mint) const
+{
+  return traceSingle<true>(p, dir, mint);
+}
+
+static __forceinline int dir_octant(const Point3 &dir) { return v_signmask(v_ldu_p3(&dir.x)) & 7; }
+
+template <typename FI>
+int StaticSceneRayBvhT<FI>::tracerayNormalizedStream(const Point3 *p, const Point3 *dir, float *t, int *out_face, int cnt) const
+{
+  int hits = 0;
+  for (int i = 0; i < cnt;)
+  {
+    int face[4];
+    if (i + 4 <= cnt && !nodes.empty())
+    {
+      int oct = dir_octant(dir[i]);
+      if (dir_octant(dir[i + 1]) == oct && dir_octant(dir[i + 2]) == oct && dir_octant(dir[i + 3]) == oct)
+      {
+        tracePacket4<false>(p + i, dir + i, t + i, face);
+        for (int r = 0; r < 4; r++, i++)
+        {
+          hits += face[r] >= 0;
+          if (out_face)
+            out_face[i] = face[r];
+        }
+        continue;
+      }
+    }
+    face[0] = traceSingle<false>(v_ldu_p3(&p[i].x), v_ldu_p3(&dir[i].x), t[i]);
+    hits += face[0] >= 0;
+    if (out_face)
+      out_face[i] = face[0];
+    i++;
+  }
+  return hits;
+}
+
+template <typename FI>
+int StaticSceneRayBvhT<FI>::rayhitNormalizedStream(const Point3 *p, const Point3 *dir, const float *t, uint32_t *out_hit_mask,
+  int cnt) const
+{
+  if (out_hit_mask)
+    memset(out_hit_mask, 0, ((cnt + 31) / 32) * sizeof(uint32_t));
+  int hits = 0;
+  for (int i = 0; i < cnt;)
+  {
+    int face[4];
+    float len[4];
+    int packetSize = 1;
+    if (i + 4 <= cnt && !nodes.empty())
+    {
+      int oct = dir_octant(dir[i]);
+      if (dir_octant(dir[i + 1]) == oct && dir_octant(dir[i + 2]) == oct && dir_octant(dir[i + 3]) == oct)
+        packetSize = 4;
+    }
+    if (packetSize == 4)
+    {
+      memcpy(len, t + i, sizeof(len));
+      tracePacket4<true>(p + i, dir + i, len, face);
+    }
+    else
+    {
+      len[0] = t[i];
+      face[0] = traceSingle<true>(v_ldu_p3(&p[i].x), v_ldu_p3(&dir[i].x), len[0]);
+    }
+    for (int r = 0; r < packetSize; r++, i++)
+      if (face[r] >= 0)
+      {
+        hits++;
+        if (out_hit_mask)
+          out_hit_mask[i >> 5] |= 1u << (i & 31);
+      }
+  }
+  return hits;
+}
+
+///============Serialization=================================
+
+// dump is valid only for the same geometry, same counts are not enough (e.g. edited geometry of the same size)
+template <typename FI>
+static uint64_t calc_geom_hash(const StaticSceneRayTracerT<FI> &rt)
+{
+  uint64_t hash = FNV1Params<64>::offset_basis;
+  if (rt.getFacesCount())
+    hash = mem_hash_fnv1<64>((const char *)&rt.faces(0), rt.getFacesCount() * sizeof(rt.faces(0)), hash);
+  for (int i = 0, ie = rt.getVertsCount(); i < ie; i++)
+    hash = mem_hash_fnv1<64>((const char *)&rt.verts(i).x, sizeof(Point3), hash);
+  if (rt.getFaceIndicesCount())
+    hash = mem_hash_fnv1<64>((const char *)&rt.faceIndices(0), rt.getFaceIndicesCount() * sizeof(FI), hash);
+  return hash;
+}
+
+template <typename FI>
+bool StaticSceneRayBvhT<FI>::serialize(IGenSave &cb, bool zcompr) const
+{
+  const uint16_t ver = get_bvh_full_version(zcompr ? ZstdCompression : NoCompression);
+  const uint32_t pos = cb.tell();
+  cb.writeInt(0);
+  cb.write((void *)"RTbvh4", 6);
+  cb.write(&ver, 2);
+
+  Header hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.box = rootBox;
+  hdr.facesCount = tracer ? tracer->getFacesCount() : 0;
+  hdr.vertsCount = tracer ? tracer->getVertsCount() : 0;
+  hdr.geomHash = tracer ? calc_geom_hash(*tracer) : 0;
+  hdr.nodesCount = nodes.size();
+  hdr.packsCount = packs.size();
+  size_t dumpLen = sizeof(hdr) + data_size(nodes) + data_size(packs) + data_size(packFaces);
+  G_ASSERT(dumpLen < 0x7FFFFFFF);
+  cb.writeInt(int(dumpLen));
+
+  IGenSave *data_cwr = &cb;
+  ZstdSaveCB *zstd_cwr = NULL;
+  if (zcompr)
+    data_cwr = zstd_cwr = new ZstdSaveCB(cb, ZSTD_DEFAULT_COMPRESSION_LEVEL);
+  data_cwr->write(&hdr, sizeof(hdr));
+  data_cwr->write(nodes.data(), data_size(nodes));
+  data_cwr->write(packs.data(), data_size(packs));
+  data_cwr->write(packFaces.data(), data_size(packFaces));
+  if (zstd_cwr)
+  {
+    zstd_cwr->finish();
+    delete zstd_cwr;
+  }
+
+  int new_pos = cb.tell();
+  cb.seekto(pos);
+  cb.writeInt(new_pos - pos - 4);
+  cb.seekto(new_pos);
+  return true;
+}
+
+template <typename FI>
+bool StaticSceneRayBvhT<FI>::serializedLoad(IGenLoad &cb, const Tracer &rt)
+{
+  clear();
+  unsigned block_rest = cb.readInt();
+  uint16_t ver = 0;
+  uint32_t n = 0;
+  char sign[6];
+  cb.read(sign, 6);
+  cb.read(&ver, 2);
+  const int version = ver >> 3;
+  FrtCompression compression = FrtCompression(ver & 7);
+  if (memcmp(sign, "RTbvh4", 6) != 0 || version != BVH_VERSION || !is_supported_compression(compression))
+  {
+    debug_ctx("bad signature or version mismatch (sign=%.6s version=%d compression %d ver=%0x)", sign, version, (int)compression, ver);
+    cb.seekrel(block_rest - 8);
+    return false;
+  }
+  cb.read(&n, 4);
+
+  auto loadData = [&](IGenLoad &crd) {
+    Header hdr;
+    crd.read(&hdr, sizeof(hdr));
+    if (n != sizeof(hdr) + hdr.nodesCount * sizeof(Node) + hdr.packsCount * (sizeof(TriPack) + 4 * sizeof(FaceIndex)))
+    {
+      logerr("corrupted BVH dump: size=%d nodes=%d packs=%d", n, hdr.nodesCount, hdr.packsCount);
+      return false;
+    }
+    nodes.resize(hdr.nodesCount);
+    packs.resize(hdr.packsCount);
+    packFaces.resize(hdr.packsCount * 4);
+    crd.read(nodes.data(), data_size(nodes));
+    crd.read(packs.data(), data_size(packs));
+    crd.read(packFaces.data(), data_size(packFaces));
+    rootBox = hdr.box;
+    if (hdr.facesCount != rt.getFacesCount() || hdr.vertsCount != rt.getVertsCount())
+    {
+      debug("BVH dump doesn't match raytracer (faces %d/%d, verts %d/%d)", hdr.facesCount, rt.getFacesCount(), hdr.vertsCount,
+        rt.getVertsCount());
+      return false;
+    }
+    if (hdr.geomHash != calc_geom_hash(rt))
+    {
+      debug("BVH dump doesn't match raytracer geometry (hash %016llx/%016llx)", (unsigned long long)hdr.geomHash,
+        (unsigned long long)calc_geom_hash(rt));
+      return false;
+    }
+    return true;
+  };
+
+  bool ret = false;
+  switch ((int)compression)
+  {
+    case NoCompression: ret = loadData(cb); break;
+    case ZlibCompression:
+    {
+      ZlibLoadCB zlib_crd(cb, block_rest - 12);
+      ret = loadData(zlib_crd);
+      break;
+    }
+    case ZstdCompression:
+    {
+      ZstdLoadCB zstd_crd(cb, block_rest - 12);
+      ret = loadData(zstd_crd);
+      break;
+    }
+    default: G_ASSERT(0);
+  }
+  if (!ret)
+  {
+    clear();
+    return false;
+  }
+  tracer = &rt;
+  debug("ray tracer BVH loaded, %d nodes, %d triangle packs, size = %dK", nodes.size(), packs.size(), n >> 10);
+  return true;
+}
+
+template class StaticSceneRayBvhT<SceneRayI24F8>;
+template class StaticSceneRayBvhT<uint16_t>;
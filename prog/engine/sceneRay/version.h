@@ -12,3 +12,6 @@ enum FrtCompression
 inline bool is_supported_compression(FrtCompression c) { return c == NoCompression || c == ZlibCompression || c == ZstdCompression; }
 
 inline uint16_t get_full_version(FrtCompression c) { return (CURRENT_VERSION << 3) | uint16_t(c); }
+
+#define BVH_VERSION 2
+inline uint16_t get_bvh_full_version(FrtCompression c) { return (BVH_VERSION << 3) | uint16_t(c); }
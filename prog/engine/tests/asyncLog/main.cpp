@@ -0,0 +1,196 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <debug/dag_logSys.h>
+#include <debug/dag_debug.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <generic/dag_tab.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: testAsyncLog
+// Checks asynchronous logging mode (debug_enable_async_mode) by reading back debug log: messages of several threads are written
+// in logging order with string args copied at call, messages dropped on full thread buffer are counted and reported, and pending
+// messages are written by flush_debug_file(), before fatal message and by close_debug_files()
+
+static constexpr int DROP_MESSAGES = 20000;
+static constexpr int ORDER_THREADS = 8;
+static constexpr int ORDER_MESSAGES_PER_THREAD = 1000;
+static constexpr int WRITER_IDLE_MS = 1000000; // writer thread wakes only when thread buffer gets half full
+
+static Tab<char> read_log()
+{
+  Tab<char> text;
+  if (FILE *fp = fopen(get_log_filename(), "rb"))
+  {
+    fseek(fp, 0, SEEK_END);
+    text.resize(ftell(fp));
+    fseek(fp, 0, SEEK_SET);
+    text.resize(fread(text.data(), 1, text.size(), fp));
+    fclose(fp);
+  }
+  text.push_back(0);
+  return text;
+}
+
+static int count_lines(const Tab<char> &text, const char *prefix)
+{
+  int cnt = 0;
+  for (const char *p = strstr(text.data(), prefix); p; p = strstr(p + 1, prefix))
+    cnt++;
+  return cnt;
+}
+
+// position of line after from, or -1
+static int find_line(const Tab<char> &text, const char *line, int from = 0)
+{
+  const char *p = strstr(text.data() + from, line);
+  return p ? int(p - text.data()) : -1;
+}
+
+static int test_dropped_count()
+{
+  DebugAsyncLogParams params;
+  params.threadBufSize = 4 << 10;
+  params.writerPeriodMs = WRITER_IDLE_MS;
+  debug_enable_async_mode(params);
+  const int64_t droppedBefore = debug_get_async_dropped_count();
+  for (int i = 0; i < DROP_MESSAGES; i++)
+    debug("ASYNCTEST drop %d of %d: message long enough to overflow small thread buffer before writer wakes up", i, DROP_MESSAGES);
+  flush_debug_file(); // also reports dropped count to log
+  const int dropped = int(debug_get_async_dropped_count() - droppedBefore);
+
+  Tab<char> text = read_log();
+  const int written = count_lines(text, "ASYNCTEST drop ");
+  int reported = 0;
+  static const char *report = "async log: ";
+  for (const char *p = strstr(text.data(), report); p; p = strstr(p + 1, report))
+    reported += atoi(p + strlen(report));
+  logdbg("dropped: %d written, %d dropped, %d reported", written, dropped, reported);
+  int errors = 0;
+  errors += dropped <= 0;
+  errors += written + dropped != DROP_MESSAGES;
+  errors += reported != dropped;
+  return errors;
+}
+
+static volatile int order_turn = 0;
+static int64_t order_last_ticks = 0; // guarded by order_turn
+
+class OrderThread final : public DaThread
+{
+public:
+  int threadNo;
+
+  OrderThread(int no) : DaThread("asyncLogOrder"), threadNo(no) {}
+  void execute() override
+  {
+    char name[32];
+    for (int i = 0; i < ORDER_MESSAGES_PER_THREAD; i++)
+    {
+      const int seq = i * ORDER_THREADS + threadNo;
+      while (interlocked_acquire_load(order_turn) != seq)
+        cpu_yield();
+      // records are merged by ticks, so equal ticks of different threads have no defined order
+      while (ref_time_ticks() <= order_last_ticks)
+        ;
+      _snprintf(name, sizeof(name), "thread%d", threadNo);
+      debug("ASYNCTEST order %d %s", seq, name);
+      memset(name, 'x', sizeof(name) - 1); // string arg must be copied at call
+      order_last_ticks = ref_time_ticks();
+      interlocked_release_store(order_turn, seq + 1);
+    }
+  }
+};
+
+static int test_order()
+{
+  debug_enable_async_mode();
+  interlocked_release_store(order_turn, 0);
+  order_last_ticks = ref_time_ticks();
+  const int64_t droppedBefore = debug_get_async_dropped_count();
+  Tab<OrderThread *> threads;
+  for (int i = 0; i < ORDER_THREADS; i++)
+  {
+    threads.push_back(new OrderThread(i));
+    threads.back()->start();
+  }
+  for (auto *t : threads)
+  {
+    t->terminate(true);
+    t->destroy();
+  }
+  debug_disable_async_mode();
+
+  Tab<char> text = read_log();
+  int errors = int(debug_get_async_dropped_count() - droppedBefore), expectedSeq = 0;
+  static const char *prefix = "ASYNCTEST order ";
+  for (const char *p = strstr(text.data(), prefix); p; p = strstr(p + 1, prefix))
+  {
+    int seq = -1;
+    char name[32] = "";
+    sscanf(p + strlen(prefix), "%d %31s", &seq, name);
+    char expectedName[32];
+    _snprintf(expectedName, sizeof(expectedName), "thread%d", expectedSeq % ORDER_THREADS);
+    errors += seq != expectedSeq || strcmp(name, expectedName) != 0;
+    expectedSeq++;
+  }
+  errors += expectedSeq != ORDER_THREADS * ORDER_MESSAGES_PER_THREAD;
+  logdbg("order: %d of %d messages, %d errors", expectedSeq, ORDER_THREADS * ORDER_MESSAGES_PER_THREAD, errors);
+  return errors;
+}
+
+static int test_flush()
+{
+  DebugAsyncLogParams params;
+  params.writerPeriodMs = WRITER_IDLE_MS;
+  debug_enable_async_mode(params);
+  int errors = 0;
+
+  debug("ASYNCTEST flush marker");
+  flush_debug_file();
+  errors += find_line(read_log(), "ASYNCTEST flush marker") < 0;
+
+  // fatal message is written at once, after pending ones
+  for (int i = 0; i < 10; i++)
+    debug("ASYNCTEST before fatal %d", i);
+  logmessage(LOGLEVEL_FATAL, "ASYNCTEST fatal marker");
+  flush_debug_file();
+  {
+    Tab<char> text = read_log();
+    int fatalPos = find_line(text, "ASYNCTEST fatal marker");
+    errors += fatalPos < 0;
+    for (int i = 0, pos = 0; i < 10 && pos >= 0; i++)
+    {
+      char line[64];
+      _snprintf(line, sizeof(line), "ASYNCTEST before fatal %d", i);
+      pos = find_line(text, line, pos);
+      errors += pos < 0 || pos > fatalPos;
+    }
+  }
+  logdbg("flush and fatal: %d errors", errors);
+
+  // log files are not reopened after close, so this goes last
+  debug("ASYNCTEST close marker");
+  close_debug_files();
+  errors += find_line(read_log(), "ASYNCTEST close marker") < 0;
+  debug_disable_async_mode();
+  return errors;
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  if (!*get_log_filename())
+  {
+    printf("no debug log file\n");
+    return 1;
+  }
+  int errors = 0;
+  errors += test_dropped_count(); // first, as thread buffers are reused and main thread buffer should be small
+  errors += test_order();
+  errors += test_flush();
+  printf("%s: %d errors\n", errors ? "FAILED" : "OK", errors);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,356 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <gameRes/dag_collisionResource.h>
+#include <ioSys/dag_memIo.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathUtils.h>
+#include <math/dag_bounds3.h>
+#include <debug/dag_log.h>
+#include <string.h>
+
+// Usage: testCollResBvh [rays]
+// Builds synthetic collision resource (bumpy terrain and sphere mesh nodes big enough for BVH, the sphere with rotated and scaled
+// tm, and small box mesh node without BVH), traces the same random rays and capsules through it with mesh node BVH and with BVH
+// stripped and checks that traceRay, rayHit, all-hits traceRay and traceCapsule give identical results. Then saves resource in
+// precooked format, loads it back and checks that BVH is restored and gives the same results. Reports trace times.
+// Collision factory is not registered, so AVX mesh api stays off and linear trace tests triangles with the same 4-wide code as BVH
+// leaves, hence t, normals and hit positions must match exactly
+
+static uint32_t rnd_seed = 1;
+static float rnd01()
+{
+  rnd_seed = rnd_seed * 1664525u + 1013904223u;
+  return (rnd_seed >> 8) * (1.f / (1 << 24));
+}
+
+static Point3 rnd_dir()
+{
+  Point3 d(rnd01() - 0.5f, rnd01() - 0.5f, rnd01() - 0.5f);
+  return lengthSq(d) > 1e-6f ? normalize(d) : Point3(0, 1, 0);
+}
+
+// (w x h) grid of quads, 2 triangles each, with vertices at pos(u, v) for u, v in [0..1]
+template <typename F>
+static void make_grid(int w, int h, const F &pos, Tab<Point3> &verts, Tab<int> &indices)
+{
+  verts.clear();
+  indices.clear();
+  for (int y = 0; y <= h; y++)
+    for (int x = 0; x <= w; x++)
+      verts.push_back(pos(float(x) / w, float(y) / h));
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++)
+    {
+      int v0 = y * (w + 1) + x, v1 = v0 + 1, v2 = v0 + w + 1, v3 = v2 + 1;
+      int tri[6] = {v0, v2, v1, v1, v2, v3};
+      append_items(indices, 6, tri);
+    }
+}
+
+static void make_box(const BBox3 &box, Tab<Point3> &verts, Tab<int> &indices)
+{
+  static const int quads[6][4] = {{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+  verts.clear();
+  indices.clear();
+  for (int i = 0; i < 8; i++)
+    verts.push_back(box.point(i));
+  for (const int *q : quads)
+  {
+    int tri[6] = {q[0], q[1], q[2], q[0], q[2], q[3]};
+    append_items(indices, 6, tri);
+  }
+}
+
+// mesh node in legacy raw format (see CollisionResource::loadLegacyRawFormat), flags and boxes are computed by loader
+static void write_legacy_mesh_node(IGenSave &cwr, const char *name, const TMatrix &tm, const Tab<Point3> &verts,
+  const Tab<int> &indices)
+{
+  BBox3 box;
+  for (const Point3 &v : verts)
+    box += v;
+  BSphere3 sphere(box.center(), length(box.width()) * 0.5f);
+
+  cwr.writeString(name);
+  cwr.writeString(""); // default physmat
+  cwr.writeInt(COLLISION_NODE_TYPE_MESH);
+  cwr.write(&tm, sizeof(tm));
+  cwr.write(&sphere, sizeof(sphere));
+  cwr.write(&box, sizeof(box));
+  cwr.writeTab(verts);
+  cwr.writeTab(indices);
+}
+
+static CollisionResource *make_synthetic_resource()
+{
+  DynamicMemGeneralSaveCB cwr(tmpmem, 0, 64 << 10);
+  cwr.writeInt(0xACE50000);
+  cwr.writeInt(0x20180510);
+  cwr.beginBlock();
+  BSphere3 sphere(Point3(0, 1, 0), 12.f);
+  cwr.write(&sphere, sizeof(sphere));
+  cwr.endBlock();
+
+  cwr.beginBlock();
+  cwr.writeInt(0); // collision flags
+  cwr.writeInt(3); // nodes
+
+  Tab<Point3> verts;
+  Tab<int> indices;
+  make_grid(
+    16, 16,
+    [](float u, float v) {
+      return Point3(u * 16.f - 8.f, 0.8f * sinf(u * 7.f) * cosf(v * 5.f) + 0.3f * sinf(u * v * 23.f), v * 16.f - 8.f);
+    },
+    verts, indices);
+  write_legacy_mesh_node(cwr, "terrain", TMatrix::IDENT, verts, indices);
+
+  make_grid(
+    16, 12,
+    [](float u, float v) {
+      float phi = u * TWOPI, theta = v * PI, r = 1.f + 0.1f * sinf(phi * 5.f) * sinf(theta * 3.f);
+      return Point3(r * sinf(theta) * cosf(phi), r * cosf(theta), r * sinf(theta) * sinf(phi));
+    },
+    verts, indices);
+  TMatrix tm = rotyTM(0.5f) * rotxTM(0.3f) * 1.5f;
+  tm.setcol(3, Point3(3.f, 2.f, -1.f));
+  write_legacy_mesh_node(cwr, "sphere", tm, verts, indices);
+
+  make_box(BBox3(Point3(-0.5f, -0.5f, -0.5f), Point3(0.5f, 0.5f, 0.5f)), verts, indices);
+  tm = TMatrix::IDENT;
+  tm.setcol(3, Point3(-4.f, 1.5f, 3.f));
+  write_legacy_mesh_node(cwr, "box", tm, verts, indices);
+  cwr.endBlock();
+
+  InPlaceMemLoadCB crd(cwr.data(), cwr.size());
+  CollisionResource *res = CollisionResource::loadResource(crd, -1);
+  res->buildNodesBVH();
+  return res;
+}
+
+// the same layout as written by collision exporter (writeCollisionData), without FRT and relative geom node tms
+static void save_precooked(const CollisionResource &res, IGenSave &cwr)
+{
+  G_ASSERT(!(res.collisionFlags & (COLLISION_RES_FLAG_HAS_TRACE_FRT | COLLISION_RES_FLAG_HAS_COLL_FRT)));
+  G_ASSERT(!(res.collisionFlags & COLLISION_RES_FLAG_HAS_REL_GEOM_NODE_ID));
+  cwr.writeInt(0xACE50001);
+  cwr.beginBlock();
+  cwr.write(&res.vFullBBox, sizeof(res.vFullBBox));
+  cwr.write(&res.vBoundingSphere, sizeof(res.vBoundingSphere));
+  cwr.write(&res.boundingBox, sizeof(res.boundingBox));
+  cwr.writeReal(res.boundingSphereRad);
+  cwr.writeInt(res.collisionFlags);
+
+  dag::ConstSpan<CollisionNode> nodes = res.getAllNodes();
+  cwr.writeInt(nodes.size());
+  for (const CollisionNode &n : nodes)
+  {
+    G_ASSERT(!(n.flags & (n.FLAG_VERTICES_ARE_REFS | n.FLAG_INDICES_ARE_REFS)));
+    cwr.writeString(n.name.str());
+    cwr.writeString(""); // default physmat
+    cwr.write(&n.modelBBox, sizeof(n.modelBBox));
+    cwr.write(&n.boundingSphere, sizeof(n.boundingSphere));
+    cwr.writeIntP<2>(n.behaviorFlags);
+    cwr.writeIntP<1>(n.flags);
+    cwr.writeIntP<1>(n.type);
+    cwr.writeReal(n.cachedMaxTmScale);
+    cwr.write(&n.tm, sizeof(n.tm));
+    cwr.writeIntP<2>(n.insideOfNode);
+    cwr.writeIntP<2>(n.convexPlanes.size());
+    cwr.writeTabData(n.convexPlanes);
+    cwr.writeTab(n.vertices);
+    cwr.writeTab(n.indices);
+    if (res.collisionFlags & COLLISION_RES_FLAG_HAS_NODE_BVH)
+      cwr.writeTab(n.bvh);
+  }
+  cwr.endBlock();
+}
+
+struct Rays
+{
+  Tab<Point3> from, dir;
+  Tab<float> len;
+};
+
+// rays start on bounding sphere and go through random point of bounding box, so most of them cross the resource
+static void make_rays(const CollisionResource &res, int count, Rays &rays)
+{
+  const BBox3 &box = res.boundingBox;
+  const Point3 c = res.getBoundingSphereCenter();
+  const float r = res.getBoundingSphereRad();
+  rays.from.resize(count);
+  rays.dir.resize(count);
+  rays.len.resize(count);
+  for (int i = 0; i < count; i++)
+  {
+    Point3 target(lerp(box[0].x, box[1].x, rnd01()), lerp(box[0].y, box[1].y, rnd01()), lerp(box[0].z, box[1].z, rnd01()));
+    rays.from[i] = c + rnd_dir() * r;
+    rays.len[i] = length(target - rays.from[i]) * 2.f;
+    rays.dir[i] = rays.len[i] > 1e-6f ? (target - rays.from[i]) * (2.f / rays.len[i]) : Point3(0, 1, 0);
+  }
+}
+
+struct TraceResult
+{
+  bool traceHit = false, rayHit = false, capsuleHit = false;
+  float t = 0;
+  Point3 norm = Point3(0, 0, 0);
+  int matId = -1;
+  IntersectedNode capsule = {};
+  Tab<IntersectedNode> allHits;
+};
+
+struct TraceStats
+{
+  int traceUsec = 0, rayHitUsec = 0, allHitsUsec = 0, capsuleUsec = 0;
+  int hits = 0;
+};
+
+static TraceStats trace_all(const CollisionResource &res, const Rays &rays, float capsule_rad, Tab<TraceResult> &out)
+{
+  TraceStats st;
+  const int cnt = rays.from.size();
+  out.clear();
+  out.resize(cnt);
+  mat44f tm;
+  v_mat44_ident(tm);
+
+  int64_t reft = profile_ref_ticks();
+  for (int i = 0; i < cnt; i++)
+  {
+    TraceResult &r = out[i];
+    r.t = rays.len[i];
+    r.traceHit = res.traceRay(TMatrix::IDENT, rays.from[i], rays.dir[i], r.t, &r.norm, r.matId);
+    st.hits += r.traceHit;
+  }
+  st.traceUsec = profile_time_usec(reft);
+
+  reft = profile_ref_ticks();
+  for (int i = 0; i < cnt; i++)
+  {
+    int matId;
+    out[i].rayHit = res.rayHit(tm, rays.from[i], rays.dir[i], rays.len[i], -1, matId);
+  }
+  st.rayHitUsec = profile_time_usec(reft);
+
+  reft = profile_ref_ticks();
+  CollResIntersectionsType list;
+  for (int i = 0; i < cnt; i++)
+  {
+    res.traceRay(TMatrix::IDENT, nullptr, rays.from[i], rays.dir[i], rays.len[i], list, true);
+    out[i].allHits.assign(list.begin(), list.end());
+  }
+  st.allHitsUsec = profile_time_usec(reft);
+
+  reft = profile_ref_ticks();
+  for (int i = 0; i < cnt; i++)
+    out[i].capsuleHit = res.traceCapsule(TMatrix::IDENT, nullptr, rays.from[i], rays.dir[i], rays.len[i], capsule_rad, out[i].capsule);
+  st.capsuleUsec = profile_time_usec(reft);
+  return st;
+}
+
+static bool same_node_hit(const IntersectedNode &a, const IntersectedNode &b)
+{
+  return a.intersectionT == b.intersectionT && a.collisionNodeId == b.collisionNodeId && a.normal == b.normal &&
+         a.intersectionPos == b.intersectionPos;
+}
+
+static bool same_result(const TraceResult &a, const TraceResult &b)
+{
+  if (a.traceHit != b.traceHit || a.rayHit != b.rayHit || a.capsuleHit != b.capsuleHit)
+    return false;
+  if (a.traceHit && (a.t != b.t || a.norm != b.norm || a.matId != b.matId))
+    return false;
+  if (a.capsuleHit && !same_node_hit(a.capsule, b.capsule))
+    return false;
+  if (a.allHits.size() != b.allHits.size())
+    return false;
+  for (int i = 0, n = a.allHits.size(); i < n; i++)
+    if (!same_node_hit(a.allHits[i], b.allHits[i]))
+      return false;
+  return true;
+}
+
+static int count_mismatches(const char *name, const Tab<TraceResult> &res, const Tab<TraceResult> &ref, const Rays &rays)
+{
+  int mismatches = 0;
+  for (int i = 0, n = res.size(); i < n; i++)
+    if (!same_result(res[i], ref[i]))
+    {
+      if (++mismatches <= 8)
+        logerr("%s: ray %d (%@)-(%@) len %g: trace %d/%d t=%g/%g, rayhit %d/%d, capsule %d/%d t=%g/%g, all hits %d/%d", name, i,
+          rays.from[i], rays.dir[i], rays.len[i], res[i].traceHit, ref[i].traceHit, res[i].t, ref[i].t, res[i].rayHit, ref[i].rayHit,
+          res[i].capsuleHit, ref[i].capsuleHit, res[i].capsule.intersectionT, ref[i].capsule.intersectionT, res[i].allHits.size(),
+          ref[i].allHits.size());
+    }
+  if (mismatches)
+    logerr("%s: %d of %d rays mismatch", name, mismatches, res.size());
+  return mismatches;
+}
+
+static bool same_bvh(const CollisionResource &a, const CollisionResource &b)
+{
+  dag::ConstSpan<CollisionNode> na = a.getAllNodes(), nb = b.getAllNodes();
+  if (na.size() != nb.size())
+    return false;
+  for (int i = 0, n = na.size(); i < n; i++)
+    if (na[i].bvh.size() != nb[i].bvh.size() || memcmp(na[i].bvh.data(), nb[i].bvh.data(), data_size(na[i].bvh)) != 0 ||
+        na[i].indices.size() != nb[i].indices.size() ||
+        memcmp(na[i].indices.data(), nb[i].indices.data(), data_size(na[i].indices)) != 0)
+      return false;
+  return true;
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  const int raysCount = dgs_argc > 1 ? max(atoi(dgs_argv[1]), 1) : 10000;
+
+  Ptr<CollisionResource> res = make_synthetic_resource();
+  dag::Span<CollisionNode> nodes = res->getAllNodes();
+  int bvhNodes = 0, bvhTris = 0;
+  for (const CollisionNode &n : nodes)
+    if (!n.bvh.empty())
+    {
+      bvhNodes++;
+      bvhTris += n.indices.size() / 3;
+    }
+  if (!(res->getCollisionFlags() & COLLISION_RES_FLAG_HAS_NODE_BVH) || bvhNodes != 2 ||
+      res->checkGridAvailable(CollisionNode::TRACEABLE))
+  {
+    logerr("expected BVH in 2 of %d nodes and no FRT, got %d (flags %#x)", nodes.size(), bvhNodes, res->getCollisionFlags());
+    return 1;
+  }
+
+  Rays rays;
+  make_rays(*res, raysCount, rays);
+  const float capsuleRad = res->getBoundingSphereRad() * 0.02f;
+  Tab<TraceResult> resBvh, resRef, resLoaded;
+  TraceStats stBvh = trace_all(*res, rays, capsuleRad, resBvh);
+
+  Tab<SmallTab<CollisionBVHNode, MidmemAlloc>> stripped;
+  stripped.resize(nodes.size());
+  for (int i = 0, n = nodes.size(); i < n; i++)
+    eastl::swap(stripped[i], nodes[i].bvh);
+  TraceStats stRef = trace_all(*res, rays, capsuleRad, resRef);
+  for (int i = 0, n = nodes.size(); i < n; i++)
+    eastl::swap(stripped[i], nodes[i].bvh);
+  int mismatches = count_mismatches("BVH vs linear", resBvh, resRef, rays);
+
+  DynamicMemGeneralSaveCB cwr(tmpmem, 0, 64 << 10);
+  save_precooked(*res, cwr);
+  InPlaceMemLoadCB crd(cwr.data(), cwr.size());
+  Ptr<CollisionResource> loaded = CollisionResource::loadResource(crd, -1);
+  if (loaded->getCollisionFlags() != res->getCollisionFlags() || !same_bvh(*res, *loaded))
+  {
+    logerr("precooked BVH is not restored: flags %#x/%#x", loaded->getCollisionFlags(), res->getCollisionFlags());
+    mismatches++;
+  }
+  trace_all(*loaded, rays, capsuleRad, resLoaded);
+  mismatches += count_mismatches("loaded vs built", resLoaded, resBvh, rays);
+
+  logdbg("%d/%d BVH nodes, %d tris, %d rays, %d hits: trace %d/%d usec, rayhit %d/%d usec, all hits %d/%d usec, "
+         "capsule %d/%d usec (BVH/linear), %d mismatches",
+    bvhNodes, nodes.size(), bvhTris, raysCount, stBvh.hits, stBvh.traceUsec, stRef.traceUsec, stBvh.rayHitUsec, stRef.rayHitUsec,
+    stBvh.allHitsUsec, stRef.allHitsUsec, stBvh.capsuleUsec, stRef.capsuleUsec, mismatches);
+  return mismatches ? 1 : 0;
+}
@@ -0,0 +1,126 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <util/dag_threadPool.h>
+#include <image/dag_dxtCompress.h>
+#include <image/dag_texPixel.h>
+#include <image/dag_tga.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathBase.h>
+#include <math/dag_adjpow2.h>
+#include <debug/dag_log.h>
+#include <string.h>
+
+// Usage: testDxtCompress [image.tga] [runs]
+// Compares single-threaded block compressor (ManualDXT) with threadpool one (ManualDXT_MT) for all quality presets:
+// checks that outputs are identical (returns non-zero if not) and reports throughput (Mpix/s) and PSNR of decoded image
+// (synthetic image when no TGA given)
+
+extern void decompress_dxt1(unsigned char *decompressedData, int lw, int lh, int row_pitch, unsigned char *src_data);
+extern void decompress_dxt5(unsigned char *decompressedData, int lw, int lh, int row_pitch, unsigned char *src_data);
+
+static const char *preset_names[] = {"fastest", "normal", "production", "highest"};
+
+static void make_synthetic_image(Tab<TexPixel32> &pix, int w, int h)
+{
+  // smooth gradients with sharp edges and noise, roughly like albedo/normal textures
+  uint32_t seed = 12345;
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      int noise = int(seed >> 28) - 8;
+      bool edge = ((x / 37) + (y / 23)) & 1;
+      TexPixel32 &p = pix[y * w + x];
+      p.r = clamp(int(128 + 100 * sinf(x * 0.013f) + noise), 0, 255);
+      p.g = clamp(int(128 + 100 * cosf(y * 0.021f) + noise) ^ (edge ? 0x40 : 0), 0, 255);
+      p.b = clamp((x ^ y) & 0xFF, 0, 255);
+      p.a = clamp(int(255 * (0.5f + 0.5f * sinf((x + y) * 0.005f))), 0, 255);
+    }
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, int pixels, int pixel_stride, int channels)
+{
+  double sum = 0;
+  for (int i = 0; i < pixels; i++, a += pixel_stride, b += pixel_stride)
+    for (int c = 0; c < channels; c++)
+    {
+      double d = double(a[c]) - double(b[c]);
+      sum += d * d;
+    }
+  double mse = sum / (double(pixels) * channels);
+  return mse > 0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+template <typename F>
+static int measure_usec(int runs, const F &f)
+{
+  int best = INT_MAX;
+  for (int i = 0; i < runs; i++)
+  {
+    int64_t reft = profile_ref_ticks();
+    f();
+    best = min(best, profile_time_usec(reft));
+  }
+  return max(best, 1);
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  const char *fn = dgs_argc > 1 ? dgs_argv[1] : nullptr;
+  int runs = dgs_argc > 2 ? max(atoi(dgs_argv[2]), 1) : 3;
+
+  cpujobs::init();
+  threadpool::init(eastl::min(cpujobs::get_core_count(), 64), 2048, 256 << 10);
+
+  int w = 2048, h = 2048;
+  Tab<TexPixel32> src;
+  if (TexImage32 *img = fn ? load_tga32(fn, tmpmem) : nullptr)
+  {
+    // ManualDXT() with fastest preset needs power-of-2 sizes, so image is cropped
+    w = 1 << get_log2i(max<int>(img->w, 4)), h = 1 << get_log2i(max<int>(img->h, 4));
+    src.resize(w * h);
+    for (int y = 0; y < h; y++)
+      memcpy(&src[y * w], img->getPixels() + y * img->w, w * sizeof(TexPixel32));
+    memfree(img, tmpmem);
+  }
+  else
+  {
+    if (fn)
+      logerr("can't load %s, using synthetic image", fn);
+    src.resize(w * h);
+    make_synthetic_image(src, w, h);
+  }
+  const double mpix = double(w) * h / 1e6;
+  logdbg("%dx%d image, %d runs, %d workers", w, h, runs, threadpool::get_num_workers());
+
+  Tab<char> outST, outMT;
+  Tab<TexPixel32> decoded;
+  decoded.resize(w * h);
+  outST.resize(w * h);
+  outMT.resize(w * h);
+
+  int mismatches = 0;
+  for (int mode : {MODE_DXT1, MODE_DXT5})
+    for (int preset = DXT_PRESET_FASTEST; preset <= DXT_PRESET_HIGHEST; preset++)
+    {
+      const int algo = dxt_preset_to_algorithm(preset);
+      const int pitch = (mode == MODE_DXT1 ? 8 : 16) * (w / 4);
+      int st_t = measure_usec(runs, [&] { ManualDXT(mode, src.data(), w, h, pitch, outST.data(), algo); });
+      int mt_t = measure_usec(runs, [&] { ManualDXT_MT(mode, src.data(), w, h, pitch, outMT.data(), algo); });
+      bool same = memcmp(outST.data(), outMT.data(), pitch * (h / 4)) == 0;
+      mismatches += same ? 0 : 1;
+      if (mode == MODE_DXT1)
+        decompress_dxt1((uint8_t *)decoded.data(), w, h, w * 4, (uint8_t *)outMT.data());
+      else
+        decompress_dxt5((uint8_t *)decoded.data(), w, h, w * 4, (uint8_t *)outMT.data());
+      logdbg("%s %-10s: ST %7.1f Mpix/s, MT %7.1f Mpix/s (%.2fx), PSNR %.2f dB%s", mode == MODE_DXT1 ? "BC1" : "BC3",
+        preset_names[preset], mpix * 1e6 / st_t, mpix * 1e6 / mt_t, double(st_t) / mt_t,
+        psnr((uint8_t *)src.data(), (uint8_t *)decoded.data(), w * h, 4, mode == MODE_DXT1 ? 3 : 4), same ? "" : ", MISMATCH!");
+    }
+
+  threadpool::shutdown();
+  cpujobs::term(false);
+  return mismatches ? 1 : 0;
+}
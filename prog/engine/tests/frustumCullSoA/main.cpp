@@ -0,0 +1,160 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuDispatch.h>
+#include <math/dag_frustumCullSoA.h>
+#include <math/dag_frustum.h>
+#include <math/dag_occlusionTest.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathUtils.h>
+#include <debug/dag_log.h>
+
+// Usage: testFrustumCullSoA [instances] [runs]
+// Culls random boxes and spheres around camera (frustum, distance and software occlusion tests) object by object, as
+// Frustum::testBoxExtentB()/testSphereB() callers do, and with frustum_cull_soa on each SIMD level up to one supported by CPU,
+// checks that visible lists match and reports time per pass. Returns non-zero if they don't
+
+static const char *level_names[CPU_SIMD_LEVEL_COUNT] = {"base", "sse4", "avx2", "avx512"};
+
+typedef OcclusionTest<OCCLUSION_W, OCCLUSION_H> SoftOcclusion;
+static SoftOcclusion soft_occlusion;
+
+template <typename F>
+static int measure_usec(int runs, const F &f)
+{
+  int best = INT_MAX;
+  for (int i = 0; i < runs; i++)
+  {
+    int64_t reft = profile_ref_ticks();
+    f();
+    best = min(best, profile_time_usec(reft));
+  }
+  return max(best, 1);
+}
+
+// fused tests can differ from per object ones for objects exactly touching plane or max distance (rounding, FMA)
+static int count_mismatches(const Tab<uint32_t> &ref, int ref_count, const Tab<uint32_t> &visible, int count)
+{
+  int mismatches = 0, i = 0, j = 0;
+  while (i < ref_count || j < count)
+  {
+    if (j >= count || (i < ref_count && ref[i] < visible[j]))
+      i++, mismatches++;
+    else if (i >= ref_count || visible[j] < ref[i])
+      j++, mismatches++;
+    else
+      i++, j++;
+  }
+  return mismatches;
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  int count = dgs_argc > 1 ? max(atoi(dgs_argv[1]), 1) : (1 << 20) + 3; // not multiple of 8 to check tail
+  int runs = dgs_argc > 2 ? max(atoi(dgs_argv[2]), 1) : 10;
+  logdbg("%d instances, %d runs, CPU SIMD level %s", count, runs, level_names[cpu_simd_level_checked]);
+
+  Tab<float> cx, cy, cz, ex, ey, ez, r, maxDistSq;
+  for (Tab<float> *t : {&cx, &cy, &cz, &ex, &ey, &ez, &r, &maxDistSq})
+    t->resize(count);
+  uint32_t seed = 12345;
+  auto rnd = [&seed](float from, float to) {
+    seed = seed * 1664525u + 1013904223u;
+    return from + (to - from) * ((seed >> 8) / float(1 << 24));
+  };
+  for (int i = 0; i < count; i++)
+  {
+    cx[i] = rnd(-1000, 1000);
+    cy[i] = rnd(-10, 50);
+    cz[i] = rnd(-1000, 1000);
+    ex[i] = rnd(0.2f, 5);
+    ey[i] = rnd(0.2f, 5);
+    ez[i] = rnd(0.2f, 5);
+    r[i] = sqrtf(ex[i] * ex[i] + ey[i] * ey[i] + ez[i] * ez[i]);
+    maxDistSq[i] = sqr(rnd(100, 1500));
+  }
+  const SoABoxes boxes = {cx.data(), cy.data(), cz.data(), ex.data(), ey.data(), ez.data()};
+  const SoASpheres spheres = {cx.data(), cy.data(), cz.data(), r.data()};
+
+  mat44f view, proj, globtm;
+  vec3f viewPos = v_make_vec4f(0, 2, 0, 0);
+  v_mat44_make_look_at(view, viewPos, v_make_vec4f(300, 0, 400, 0), V_C_UNIT_0100);
+  v_mat44_make_persp(proj, 1.f, 16.f / 9.f, 0.1f, 5000.f);
+  v_mat44_mul(globtm, proj, view);
+  Frustum frustum(globtm);
+  SoACullParams params;
+  params.posDistScale = v_perm_xyzd(viewPos, v_splats(1.f));
+  params.maxDistSqPerObject = maxDistSq.data();
+
+  // occluder covering left half of screen 150m away
+  SoftOcclusion::clear();
+  for (int y = 0; y < OCCLUSION_H; y++)
+    for (int x = 0; x < OCCLUSION_W / 2; x++)
+      SoftOcclusion::getZbuffer()[y * OCCLUSION_W + x] = 1.f / 150.f;
+  SoftOcclusion::buildMips();
+  auto occlusionTest = [&](uint32_t i) {
+    vec3f c = v_make_vec4f(cx[i], cy[i], cz[i], 0), e = v_make_vec4f(ex[i], ey[i], ez[i], 0);
+    return SoftOcclusion::testVisibility(v_sub(c, e), v_add(c, e), v_zero(), globtm, 2) == SoftOcclusion::VISIBLE;
+  };
+
+  Tab<uint32_t> refBoxes, refSpheres, refOccluded, visible;
+  for (Tab<uint32_t> *t : {&refBoxes, &refSpheres, &refOccluded, &visible})
+    t->resize(count);
+  int refBoxesCount = 0, refSpheresCount = 0, refOccludedCount = 0;
+  int refBoxesUsec = measure_usec(runs, [&] {
+    refBoxesCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+      vec3f c = v_make_vec4f(cx[i], cy[i], cz[i], 0), e = v_make_vec4f(ex[i], ey[i], ez[i], 0);
+      if (!frustum.testBoxExtentB(v_add(c, c), v_add(e, e)) || v_extract_x(v_length3_sq_x(v_sub(c, viewPos))) > maxDistSq[i])
+        continue;
+      refBoxes[refBoxesCount++] = i;
+    }
+  });
+  int refSpheresUsec = measure_usec(runs, [&] {
+    refSpheresCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+      vec3f c = v_make_vec4f(cx[i], cy[i], cz[i], 0);
+      if (!frustum.testSphereB(c, v_splats(r[i])) || v_extract_x(v_length3_sq_x(v_sub(c, viewPos))) > maxDistSq[i])
+        continue;
+      refSpheres[refSpheresCount++] = i;
+    }
+  });
+  int refOccludedUsec = measure_usec(runs, [&] {
+    refOccludedCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+      vec3f c = v_make_vec4f(cx[i], cy[i], cz[i], 0), e = v_make_vec4f(ex[i], ey[i], ez[i], 0);
+      if (!frustum.testBoxExtentB(v_add(c, c), v_add(e, e)) || v_extract_x(v_length3_sq_x(v_sub(c, viewPos))) > maxDistSq[i] ||
+          !occlusionTest(i))
+        continue;
+      refOccluded[refOccludedCount++] = i;
+    }
+  });
+  logdbg("per object: boxes %6.2f ms (%d visible), spheres %6.2f ms (%d visible), boxes+occlusion %6.2f ms (%d visible)",
+    refBoxesUsec / 1000.f, refBoxesCount, refSpheresUsec / 1000.f, refSpheresCount, refOccludedUsec / 1000.f, refOccludedCount);
+
+  int failedLevels = 0;
+  for (int level = CPU_SIMD_BASE; level <= cpu_simd_level_checked; level++)
+  {
+    set_cpu_simd_level_limit(CpuSimdLevel(level));
+    int boxesCount = 0, spheresCount = 0, occludedCount = 0;
+    int boxesUsec = measure_usec(runs, [&] { boxesCount = frustum_cull_soa(frustum, boxes, 0, count, params, visible.data()); });
+    int boxesMismatches = count_mismatches(refBoxes, refBoxesCount, visible, boxesCount);
+    int spheresUsec = measure_usec(runs, [&] { spheresCount = frustum_cull_soa(frustum, spheres, 0, count, params, visible.data()); });
+    int spheresMismatches = count_mismatches(refSpheres, refSpheresCount, visible, spheresCount);
+    int occludedUsec =
+      measure_usec(runs, [&] { occludedCount = frustum_cull_soa(frustum, boxes, 0, count, params, visible.data(), occlusionTest); });
+    int occludedMismatches = count_mismatches(refOccluded, refOccludedCount, visible, occludedCount);
+    const int maxMismatches = count / 10000;
+    bool ok = boxesMismatches <= maxMismatches && spheresMismatches <= maxMismatches && occludedMismatches <= maxMismatches;
+    failedLevels += ok ? 0 : 1;
+    logdbg("%-6s: boxes %6.2f ms (%.2fx), spheres %6.2f ms (%.2fx), boxes+occlusion %6.2f ms (%.2fx), mismatches %d/%d/%d%s",
+      level_names[level], boxesUsec / 1000.f, double(refBoxesUsec) / boxesUsec, spheresUsec / 1000.f,
+      double(refSpheresUsec) / spheresUsec, occludedUsec / 1000.f, double(refOccludedUsec) / occludedUsec, boxesMismatches,
+      spheresMismatches, occludedMismatches, ok ? "" : ", MISMATCH!");
+  }
+  set_cpu_simd_level_limit(CPU_SIMD_AVX512);
+  return failedLevels ? 1 : 0;
+}
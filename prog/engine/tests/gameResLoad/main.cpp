@@ -0,0 +1,81 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <util/dag_threadPool.h>
+#include <gameRes/dag_gameResources.h>
+#include <gameRes/dag_gameResSystem.h>
+#include <gameRes/dag_stdGameResId.h>
+#include <gameRes/dag_collisionResource.h>
+#include <gameRes/dag_collisionResourceClassId.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <util/dag_string.h>
+#include <debug/dag_log.h>
+#include <EASTL/functional.h>
+
+// Usage: testGameResLoad <grp-folder/> [runs]
+// Compares serial per-resource GRP loading with load_game_resource_packs_mt() over the same resource set
+
+extern void register_geom_node_tree_gameres_factory();
+extern void register_phys_sys_gameres_factory();
+
+static void scan_packs(const char *dir, Tab<String> &names)
+{
+  scan_for_game_resources(dir, true, false);
+  names.clear();
+  for (unsigned cls : {CollisionGameResClassId, GeomNodeTreeGameResClassId, PhysSysGameResClassId})
+    iterate_gameres_names_by_class(cls, [&names](const char *nm) { names.push_back(String(nm)); });
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  if (dgs_argc < 2)
+  {
+    logdbg("usage: %s <grp-folder/> [runs]", dgs_argv[0]);
+    return 1;
+  }
+  const char *dir = dgs_argv[1];
+  int runs = dgs_argc > 2 ? atoi(dgs_argv[2]) : 3;
+
+  cpujobs::init();
+  threadpool::init(eastl::min(cpujobs::get_core_count(), 64), 2048, 256 << 10);
+
+  CollisionResource::registerFactory();
+  register_geom_node_tree_gameres_factory();
+  register_phys_sys_gameres_factory();
+
+  Tab<String> names;
+  Tab<const char *> namePtrs;
+  int64_t serial_total = 0, mt_total = 0;
+  for (int run = 0; run < runs; run++)
+  {
+    scan_packs(dir, names);
+    int64_t reft = profile_ref_ticks();
+    for (const String &nm : names)
+      if (GameResource *r = get_game_resource(GAMERES_HANDLE_FROM_STRING(nm.str())))
+        release_game_resource(r);
+    int serial_t = profile_time_usec(reft);
+    reset_game_resources();
+
+    scan_packs(dir, names);
+    namePtrs.resize(names.size());
+    for (int i = 0; i < names.size(); i++)
+      namePtrs[i] = names[i].str();
+    reft = profile_ref_ticks();
+    int grp_cnt = load_game_resource_packs_mt(namePtrs);
+    int mt_t = profile_time_usec(reft);
+    reset_game_resources();
+
+    logdbg("run %d: %d resources, serial %d usec, mt %d usec (%d GRPs, %d workers)", run, names.size(), serial_t, mt_t, grp_cnt,
+      threadpool::get_num_workers());
+    serial_total += serial_t;
+    mt_total += mt_t;
+  }
+  if (runs > 0)
+    logdbg("average: serial %d usec, mt %d usec, speedup %.2fx", int(serial_total / runs), int(mt_total / runs),
+      mt_total ? double(serial_total) / mt_total : 0.0);
+
+  threadpool::shutdown();
+  cpujobs::term(false);
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <memory/dag_heapSampler.h>
+#include <memory/dag_mem.h>
+#include <util/dag_globDef.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Usage: testHeapSampler
+// Checks heap_sampler of memory manager: number of samples matches allocated bytes divided by sample interval, and freed sampled
+// blocks (via IMemAlloc, memfree_anywhere and operator delete) are removed from live counts of the call stack that allocated them
+
+static constexpr int SAMPLE_INTERVAL = 64 << 10;
+static constexpr int RATE_ALLOCS = 100000;
+static constexpr int LIVE_ALLOCS = 20000;
+static constexpr int SIZE_A = 1000, SIZE_B = 3000;
+static const char *PROFILE_FNAME = "testHeapSampler.heap";
+static void *ptrs_a[LIVE_ALLOCS], *ptrs_b[LIVE_ALLOCS]; // static, so only blocks of SIZE_A and SIZE_B are sampled
+
+static uint32_t rnd_seed = 1;
+static uint32_t rnd() { return (rnd_seed = rnd_seed * 1664525u + 1013904223u) >> 8; }
+
+static int64_t live_samples()
+{
+  heap_sampler::Stats st;
+  heap_sampler::get_stats(st);
+  return st.liveSamples;
+}
+
+// expected samples count is allocated bytes / interval, with ~4600 samples 10% tolerance is over 6 sigma
+static int test_rate()
+{
+  heap_sampler::Stats st0, st1;
+  heap_sampler::get_stats(st0);
+  int64_t allocated = 0;
+  for (int i = 0; i < RATE_ALLOCS; i++)
+  {
+    int sz = 16 + rnd() % 6000;
+    void *p = tmpmem->alloc(sz);
+    allocated += sz;
+    tmpmem->free(p);
+  }
+  heap_sampler::get_stats(st1);
+
+  const double expected = double(allocated) / SAMPLE_INTERVAL;
+  const int64_t samples = st1.totalSamples - st0.totalSamples;
+  printf("rate: %lld samples of %lld bytes, %.0f expected, %lld live\n", (long long)samples, (long long)allocated, expected,
+    (long long)st1.liveSamples);
+  int errors = 0;
+  errors += fabs(samples - expected) > expected * 0.1;
+  errors += st1.liveSamples != st0.liveSamples; // all sampled blocks are freed
+  errors += st1.droppedSamples != st0.droppedSamples;
+  return errors;
+}
+
+static DAGOR_NOINLINE void alloc_a(void **ptrs)
+{
+  for (int i = 0; i < LIVE_ALLOCS; i++)
+    ptrs[i] = tmpmem->alloc(SIZE_A);
+}
+
+static DAGOR_NOINLINE void alloc_b(void **ptrs)
+{
+  for (int i = 0; i < LIVE_ALLOCS; i++)
+    ptrs[i] = (i % 3) == 2 ? (void *)new char[SIZE_B] : memalloc(SIZE_B, tmpmem);
+}
+
+// sums live counts of all stacks from dumped profile, returns false if some stack has live blocks of other than block_size
+static bool check_profile(int block_size, int64_t &out_live)
+{
+  out_live = 0;
+  if (!heap_sampler::dump_profile(PROFILE_FNAME))
+    return false;
+  FILE *fp = fopen(PROFILE_FNAME, "rt");
+  if (!fp)
+    return false;
+  bool ok = true;
+  char line[4096];
+  if (!fgets(line, sizeof(line), fp)) // header
+    ok = false;
+  while (fgets(line, sizeof(line), fp) && line[0] != '\n')
+  {
+    unsigned long long liveCnt = 0, liveBytes = 0, allocCnt = 0, allocBytes = 0;
+    if (sscanf(line, "%llu: %llu [%llu: %llu]", &liveCnt, &liveBytes, &allocCnt, &allocBytes) != 4)
+    {
+      ok = false;
+      break;
+    }
+    ok &= liveBytes == liveCnt * block_size;
+    out_live += liveCnt;
+  }
+  fclose(fp);
+  remove(PROFILE_FNAME);
+  return ok;
+}
+
+static int test_free_attribution()
+{
+  const int64_t live0 = live_samples();
+  int errors = 0;
+
+  alloc_a(ptrs_a);
+  alloc_b(ptrs_b);
+  const int64_t liveAB = live_samples() - live0;
+
+  // B blocks are freed via different paths, only A blocks stay live
+  for (int i = 0; i < LIVE_ALLOCS; i++)
+    if ((i % 3) == 2)
+      delete[] (char *)ptrs_b[i];
+    else if (i & 1)
+      memfree_anywhere(ptrs_b[i]);
+    else
+      memfree(ptrs_b[i], tmpmem);
+  int64_t liveA = 0;
+  errors += !check_profile(SIZE_A, liveA);
+  errors += liveA != live_samples() - live0;
+  // expected ~LIVE_ALLOCS * SIZE_A / SAMPLE_INTERVAL
+  errors += liveA <= 0 || liveA >= liveAB;
+
+  for (int i = 0; i < LIVE_ALLOCS; i++)
+    tmpmem->free(ptrs_a[i]);
+  heap_sampler::Stats st;
+  heap_sampler::get_stats(st);
+  errors += st.liveSamples != live0;
+
+  printf("free attribution: %lld live samples of A and B, %lld of A, %lld after free (%lld bytes), %d stacks\n", (long long)liveAB,
+    (long long)liveA, (long long)(st.liveSamples - live0), (long long)st.liveBytes, st.uniqueStacks);
+  return errors;
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  if (!heap_sampler::is_supported())
+  {
+    printf("heap sampler is not supported by this memory manager\n");
+    return 0;
+  }
+  heap_sampler::set_sample_interval(SAMPLE_INTERVAL);
+  int errors = 0;
+  errors += test_rate();
+  errors += test_free_attribution();
+  heap_sampler::set_sample_interval(0);
+  printf("%s: %d errors\n", errors ? "FAILED" : "OK", errors);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <util/dag_fastNameMapTS.h>
+#include <util/dag_string.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <debug/dag_log.h>
+#include <stdlib.h>
+
+// Usage: testNameMapTS [lookups_per_thread]
+// Contention benchmark of FastNameMapTS: 1..32 threads resolve names (mostly hits, as resource and shader var lookups do at load
+// time, with some misses adding new names); compares with read-write locked OAHashNameMap (previous FastNameMapTS implementation)
+// and checks that all threads got the same ids for the same names
+
+static constexpr int BASE_NAMES = 20000;
+static constexpr int NEW_NAMES_PER_THREAD = 500;
+static constexpr int MAX_THREADS = 32;
+
+// reference: every call takes read lock, adding takes write lock
+struct RwLockedNameMap
+{
+  FastNameMap nm;
+  mutable OSReadWriteLock lock;
+
+  int getNameId(const char *name) const
+  {
+    lock.lockRead();
+    int id = nm.getNameId(name);
+    lock.unlockRead();
+    return id;
+  }
+  int addNameId(const char *name)
+  {
+    int id = getNameId(name);
+    if (id >= 0)
+      return id;
+    lock.lockWrite();
+    id = nm.addNameId(name);
+    lock.unlockWrite();
+    return id;
+  }
+};
+
+// name of id just got from addNameId: must be available at once, even if id was added by other thread
+static const char *name_of_new_id(RwLockedNameMap &, int) { return ""; }
+static const char *name_of_new_id(FastNameMapTS<false> &nm, int id) { return nm.getName(id); }
+
+static Tab<String> names;
+static volatile int start_flag = 0, ready_threads = 0;
+
+template <typename NM>
+class LookupThread final : public DaThread
+{
+public:
+  NM &nm;
+  int threadNo, lookups;
+  Tab<int> newIds;
+  int64_t hashSum = 0;
+  int unnamedNewIds = 0;
+
+  LookupThread(NM &m, int no, int cnt) : DaThread("lookup"), nm(m), threadNo(no), lookups(cnt) {}
+  void execute() override
+  {
+    String newName;
+    uint32_t seed = threadNo * 7919 + 1;
+    interlocked_increment(ready_threads);
+    while (!interlocked_acquire_load(start_flag))
+      cpu_yield();
+    for (int i = 0; i < lookups; i++)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      if ((seed >> 8) % 64 == 0) // ~1.5% of calls add names, half of them shared with other threads
+      {
+        int n = (seed >> 16) % NEW_NAMES_PER_THREAD;
+        newName.printf(0, (seed & 0x80) ? "new/shared/%d" : "new/thread%d/%d", (seed & 0x80) ? n : threadNo, n);
+        newIds.push_back(nm.addNameId(newName));
+        unnamedNewIds += name_of_new_id(nm, newIds.back()) == nullptr;
+      }
+      else
+        hashSum += nm.getNameId(names[(seed >> 8) % BASE_NAMES]);
+    }
+  }
+};
+
+template <typename NM>
+static double run_threads(NM &nm, int threads_cnt, int lookups, Tab<LookupThread<NM> *> &threads)
+{
+  interlocked_release_store(start_flag, 0);
+  interlocked_release_store(ready_threads, 0);
+  for (int i = 0; i < threads_cnt; i++)
+  {
+    threads.push_back(new LookupThread<NM>(nm, i, lookups));
+    threads.back()->start();
+  }
+  while (interlocked_acquire_load(ready_threads) < threads_cnt)
+    sleep_msec(0);
+  int64_t reft = profile_ref_ticks();
+  interlocked_release_store(start_flag, 1);
+  for (auto *t : threads)
+    t->terminate(true);
+  int usec = max(profile_time_usec(reft), 1);
+  return double(lookups) * threads_cnt / usec;
+}
+
+template <typename NM>
+static void fill_base(NM &nm)
+{
+  for (const String &n : names)
+    nm.addNameId(n);
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  int lookups = dgs_argc > 1 ? max(atoi(dgs_argv[1]), 1000) : 2000000;
+
+  names.resize(BASE_NAMES);
+  for (int i = 0; i < BASE_NAMES; i++)
+    names[i].printf(0, "%s/res_%05d_%s", (i % 3) ? "models" : "textures", i, (i & 1) ? "lod0" : "tex_d");
+
+  int errors = 0;
+  for (int threadsCnt = 1; threadsCnt <= MAX_THREADS; threadsCnt *= 2)
+  {
+    RwLockedNameMap rwMap;
+    FastNameMapTS<false> tsMap;
+    fill_base(rwMap);
+    fill_base(tsMap);
+
+    Tab<LookupThread<RwLockedNameMap> *> rwThreads;
+    Tab<LookupThread<FastNameMapTS<false>> *> tsThreads;
+    double rwMops = run_threads(rwMap, threadsCnt, lookups, rwThreads);
+    double tsMops = run_threads(tsMap, threadsCnt, lookups, tsThreads);
+
+    // same names must resolve to the same ids in all threads, and ids must be dense
+    for (auto *t : tsThreads)
+    {
+      errors += t->hashSum != rwThreads[t->threadNo]->hashSum;
+      errors += t->unnamedNewIds;
+      for (int id : t->newIds)
+        errors += id < BASE_NAMES || id >= (int)tsMap.nameCount() || tsMap.getNameId(tsMap.getName(id)) != id;
+    }
+    for (int i = 0; i < BASE_NAMES; i++)
+      errors += tsMap.getNameId(names[i]) != i || strcmp(tsMap.getName(i), names[i]) != 0;
+    errors += tsMap.nameCount() != (uint32_t)rwMap.nm.nameCount();
+
+    logdbg("%2d threads: rwlock %7.2f Mlookups/s, lock-free %7.2f Mlookups/s (%.2fx), %d names", threadsCnt, rwMops, tsMops,
+      tsMops / rwMops, tsMap.nameCount());
+    for (auto *t : rwThreads)
+      t->destroy();
+    for (auto *t : tsThreads)
+      t->destroy();
+  }
+  if (errors)
+    logerr("%d lookup mismatches", errors);
+  return errors ? 1 : 0;
+}
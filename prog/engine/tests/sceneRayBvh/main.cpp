@@ -0,0 +1,277 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <util/dag_threadPool.h>
+#include <sceneRay/dag_sceneRay.h>
+#include <sceneRay/dag_sceneRayBvh.h>
+#include <ioSys/dag_memIo.h>
+#include <ioSys/dag_fileIo.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathBase.h>
+#include <math/dag_mathUtils.h>
+#include <math/dag_traceRayTriangle.h>
+#include <debug/dag_log.h>
+#include <string.h>
+#include <limits.h>
+
+// Usage: testSceneRayBvh [rt_dump.bin] [runs]
+// Builds 4-wide SAH BVH over static scene ray tracer (synthetic level: terrain, buildings and props, or dump written by
+// StaticSceneRayTracer::serialize()), checks that serial and threadpool builds and serialized copy are identical and that it
+// hits the same faces as grid tracer; reports build time and ray throughput (Mrays/s) for incoherent and coherent rays
+
+static uint32_t rnd_seed = 1;
+static float rnd01()
+{
+  rnd_seed = rnd_seed * 1664525u + 1013904223u;
+  return (rnd_seed >> 8) * (1.f / (1 << 24));
+}
+
+static void add_box(Tab<Point3> &verts, Tab<unsigned> &faces, Tab<unsigned> &flags, const BBox3 &box, unsigned face_flags)
+{
+  static const int quads[6][4] = {{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+  unsigned base = verts.size();
+  for (int i = 0; i < 8; i++)
+    verts.push_back(box.point(i));
+  for (const int *q : quads)
+  {
+    unsigned tri[6] = {base + q[0], base + q[1], base + q[2], base + q[0], base + q[2], base + q[3]};
+    append_items(faces, 6, tri);
+    flags.push_back(face_flags);
+    flags.push_back(face_flags);
+  }
+}
+
+// terrain grid with rolling hills, buildings (boxes) and small scattered props, some of them invisible for tracing
+static BuildableStaticSceneRayTracer *make_synthetic_level()
+{
+  static constexpr int GRID = 400;
+  static constexpr float CELL = 4.f;
+  Tab<Point3> verts;
+  Tab<unsigned> faces, flags;
+  auto height = [](float x, float z) { return 12.f * sinf(x * 0.011f) * cosf(z * 0.007f) + 3.f * sinf(x * 0.05f + z * 0.03f); };
+  for (int z = 0; z <= GRID; z++)
+    for (int x = 0; x <= GRID; x++)
+      verts.push_back(Point3(x * CELL, height(x * CELL, z * CELL), z * CELL));
+  for (int z = 0; z < GRID; z++)
+    for (int x = 0; x < GRID; x++)
+    {
+      unsigned v0 = z * (GRID + 1) + x, v1 = v0 + 1, v2 = v0 + GRID + 1, v3 = v2 + 1;
+      unsigned tri[6] = {v0, v2, v1, v1, v2, v3};
+      append_items(faces, 6, tri);
+      flags.push_back(StaticSceneRayTracer::CULL_CCW);
+      flags.push_back(StaticSceneRayTracer::CULL_CCW);
+    }
+
+  const float size = GRID * CELL;
+  for (int i = 0; i < 3000; i++)
+  {
+    Point3 c(size * (0.05f + 0.9f * rnd01()), 0, size * (0.05f + 0.9f * rnd01()));
+    c.y = height(c.x, c.z);
+    Point3 ext =
+      i % 3 ? Point3(0.3f + rnd01(), 0.5f + rnd01(), 0.3f + rnd01()) : Point3(6 + 10 * rnd01(), 5 + 25 * rnd01(), 6 + 10 * rnd01());
+    unsigned fl = StaticSceneRayTracer::CULL_CCW | (i % 17 == 0 ? StaticSceneRayTracer::USER_INVISIBLE : 0);
+    add_box(verts, faces, flags, BBox3(c - Point3(ext.x, 1.f, ext.z), c + Point3(ext.x, ext.y, ext.z)), fl);
+  }
+
+  BuildableStaticSceneRayTracer *rt = create_buildable_staticmeshscene_raytracer(Point3(16, 16, 16), 8);
+  rt->addmesh(verts.data(), verts.size(), faces.data(), sizeof(unsigned) * 3, faces.size() / 3, flags.data(), true);
+  return rt;
+}
+
+struct Rays
+{
+  Tab<Point3> pos, dir;
+  Tab<float> len;
+};
+
+// incoherent: random segments over the level (bullets, AI visibility); coherent: fans from a few points (shadows, sound occlusion)
+static void make_rays(const StaticSceneRayTracer &rt, Rays &rays, int count, bool coherent)
+{
+  const BBox3 &box = rt.getBox();
+  const Point3 size = box.width();
+  rays.pos.resize(count);
+  rays.dir.resize(count);
+  rays.len.resize(count);
+  Point3 eye(0, 0, 0);
+  for (int i = 0; i < count; i++)
+  {
+    if (!coherent || i % 256 == 0)
+      eye = Point3(box[0].x + size.x * rnd01(), box[0].y + size.y * (0.3f + 0.7f * rnd01()), box[0].z + size.z * rnd01());
+    Point3 dir;
+    if (coherent)
+    {
+      int j = i % 256;
+      float yaw = (j % 16) * 0.02f + (i / 256) * 0.7f, pitch = -0.05f - (j / 16) * 0.01f;
+      dir = Point3(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch));
+    }
+    else
+      dir = normalize(Point3(rnd01() - 0.5f, (rnd01() - 0.7f) * 0.5f, rnd01() - 0.5f));
+    rays.pos[i] = eye;
+    rays.dir[i] = dir;
+    rays.len[i] = max(size.x, size.z) * (0.05f + 0.4f * rnd01());
+  }
+}
+
+template <typename F>
+static int measure_usec(int runs, const F &f)
+{
+  int best = INT_MAX;
+  for (int i = 0; i < runs; i++)
+  {
+    int64_t reft = profile_ref_ticks();
+    f();
+    best = min(best, profile_time_usec(reft));
+  }
+  return max(best, 1);
+}
+
+static bool save_bvh(const StaticSceneRayBvh &bvh, Tab<char> &out)
+{
+  DynamicMemGeneralSaveCB cwr(tmpmem, 0, 64 << 10);
+  if (!bvh.serialize(cwr, false))
+    return false;
+  out.resize(cwr.size());
+  memcpy(out.data(), cwr.data(), cwr.size());
+  return true;
+}
+
+// faces hit by grid and BVH may differ only when ray hits both at the same distance (shared edge or vertex)
+static bool same_hit_face(const StaticSceneRayTracer &rt, const Point3 &p, const Point3 &dir, float t, int face_grid, int face_bvh)
+{
+  if (face_grid == face_bvh)
+    return true;
+  if (face_grid < 0 || face_bvh < 0)
+    return false;
+  const StaticSceneRayTracer::RTface &f = rt.faces(face_bvh);
+  const Point3 v0 = rt.verts(f.v[0]), v1 = rt.verts(f.v[1]), v2 = rt.verts(f.v[2]);
+  float faceT = t * 1.001f + 1e-3f, u, v;
+  return traceRayToTriangleNoCull(p, dir, faceT, v0, v1 - v0, v2 - v0, u, v) && fabsf(faceT - t) <= 1e-3f * max(t, 1.f);
+}
+
+// grid tracer is reference; t may differ in last bits as it starts rays at border of scene box
+static int check_rays(const StaticSceneRayTracer &rt, const StaticSceneRayBvh &bvh, const Rays &rays)
+{
+  const int cnt = rays.pos.size();
+  Tab<float> t(rays.len);
+  Tab<int> faceIdx;
+  faceIdx.resize(cnt);
+  Tab<uint32_t> hitMask;
+  hitMask.resize((cnt + 31) / 32);
+  bvh.tracerayNormalizedStream(rays.pos.data(), rays.dir.data(), t.data(), faceIdx.data(), cnt);
+  bvh.rayhitNormalizedStream(rays.pos.data(), rays.dir.data(), rays.len.data(), hitMask.data(), cnt);
+
+  int mismatches = 0;
+  for (int i = 0; i < cnt; i++)
+  {
+    float tGrid = rays.len[i], tBvh = rays.len[i];
+    int faceGrid = rt.tracerayNormalized(rays.pos[i], rays.dir[i], tGrid);
+    int faceBvh = bvh.tracerayNormalized(rays.pos[i], rays.dir[i], tBvh);
+    const float eps = 1e-3f * max(tGrid, 1.f);
+    bool same = same_hit_face(rt, rays.pos[i], rays.dir[i], tGrid, faceGrid, faceBvh) && fabsf(tGrid - tBvh) <= eps;
+    same &= faceBvh == faceIdx[i] && tBvh == t[i];
+    same &= (faceGrid >= 0) == bool(hitMask[i >> 5] & (1u << (i & 31)));
+    same &= (faceGrid >= 0) == rt.rayhitNormalized(rays.pos[i], rays.dir[i], rays.len[i]);
+    same &= (faceGrid >= 0) == bvh.rayhitNormalized(rays.pos[i], rays.dir[i], rays.len[i]);
+    mismatches += !same;
+  }
+  return mismatches;
+}
+
+static void bench_rays(const char *name, const StaticSceneRayTracer &rt, const StaticSceneRayBvh &bvh, const Rays &rays, int runs)
+{
+  const int cnt = rays.pos.size();
+  Tab<float> t;
+  Tab<int> faceIdx;
+  faceIdx.resize(cnt);
+  Tab<uint32_t> hitMask;
+  hitMask.resize((cnt + 31) / 32);
+  int hits = 0;
+  int gridUsec = measure_usec(runs, [&]() {
+    hits = 0;
+    for (int i = 0; i < cnt; i++)
+    {
+      float len = rays.len[i];
+      hits += rt.tracerayNormalized(rays.pos[i], rays.dir[i], len) >= 0;
+    }
+  });
+  int bvhUsec = measure_usec(runs, [&]() {
+    for (int i = 0; i < cnt; i++)
+    {
+      float len = rays.len[i];
+      bvh.tracerayNormalized(rays.pos[i], rays.dir[i], len);
+    }
+  });
+  int streamUsec = measure_usec(runs, [&]() {
+    t = rays.len;
+    bvh.tracerayNormalizedStream(rays.pos.data(), rays.dir.data(), t.data(), faceIdx.data(), cnt);
+  });
+  int gridHitUsec = measure_usec(runs, [&]() {
+    for (int i = 0; i < cnt; i++)
+      rt.rayhitNormalized(rays.pos[i], rays.dir[i], rays.len[i]);
+  });
+  int streamHitUsec = measure_usec(runs, [&]() {
+    bvh.rayhitNormalizedStream(rays.pos.data(), rays.dir.data(), rays.len.data(), hitMask.data(), cnt);
+  });
+  logdbg("%-10s %d rays, %d hits: traceray grid %6.2f, bvh %6.2f, bvh stream %6.2f Mrays/s; "
+         "rayhit grid %6.2f, bvh stream %6.2f Mrays/s",
+    name, cnt, hits, double(cnt) / gridUsec, double(cnt) / bvhUsec, double(cnt) / streamUsec, double(cnt) / gridHitUsec,
+    double(cnt) / streamHitUsec);
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  const char *fn = dgs_argc > 1 ? dgs_argv[1] : nullptr;
+  int runs = dgs_argc > 2 ? max(atoi(dgs_argv[2]), 1) : 3;
+
+  cpujobs::init();
+  threadpool::init(eastl::min(cpujobs::get_core_count(), 64), 2048, 256 << 10);
+
+  StaticSceneRayTracer *rt = nullptr;
+  if (fn)
+  {
+    FullFileLoadCB crd(fn);
+    if (crd.fileHandle)
+      rt = create_staticmeshscene_raytracer(crd);
+    if (!rt)
+      logerr("can't load ray tracer dump %s, using synthetic level", fn);
+  }
+  if (!rt)
+    rt = make_synthetic_level();
+  logdbg("%d faces, %d verts, %d workers", rt->getFacesCount(), rt->getVertsCount(), threadpool::get_num_workers());
+
+  StaticSceneRayBvh bvhST, bvhMT, bvhLoaded;
+  int stUsec = measure_usec(runs, [&]() { bvhST.build(*rt, false); });
+  int mtUsec = measure_usec(runs, [&]() { bvhMT.build(*rt, true); });
+  Tab<char> dumpST, dumpMT;
+  bool same = save_bvh(bvhST, dumpST) && save_bvh(bvhMT, dumpMT) && dumpST.size() == dumpMT.size() &&
+              memcmp(dumpST.data(), dumpMT.data(), dumpST.size()) == 0;
+  InPlaceMemLoadCB crd(dumpMT.data(), dumpMT.size());
+  same &= bvhLoaded.serializedLoad(crd, *rt);
+  // dump must be rejected when tracer geometry differs (hash check)
+  StaticSceneRayBvh bvhStale;
+  rt->verts(0).y += 1.f;
+  InPlaceMemLoadCB crdStale(dumpMT.data(), dumpMT.size());
+  same &= !bvhStale.serializedLoad(crdStale, *rt);
+  rt->verts(0).y -= 1.f;
+  logdbg("BVH build: ST %.1f ms, MT %.1f ms (%.2fx), %d nodes, %d triangle packs, %dK%s", stUsec / 1000.0, mtUsec / 1000.0,
+    double(stUsec) / mtUsec, bvhMT.getNodesCount(), bvhMT.getTriPacksCount(), (int)dumpMT.size() >> 10,
+    same ? "" : ", MISMATCH of ST/MT/loaded or stale dump accepted!");
+
+  Rays incoherent, coherent;
+  make_rays(*rt, incoherent, 1 << 16, false);
+  make_rays(*rt, coherent, 1 << 16, true);
+  int mismatches = check_rays(*rt, bvhLoaded, incoherent) + check_rays(*rt, bvhLoaded, coherent);
+  if (mismatches)
+    logerr("%d rays differ from grid tracer", mismatches);
+  bench_rays("incoherent", *rt, bvhLoaded, incoherent, runs);
+  bench_rays("coherent", *rt, bvhLoaded, coherent, runs);
+
+  bvhST.clear();
+  bvhMT.clear();
+  bvhLoaded.clear();
+  delete rt;
+  threadpool::shutdown();
+  cpujobs::term(false);
+  return same && !mismatches ? 0 : 1;
+}
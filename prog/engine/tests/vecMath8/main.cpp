@@ -0,0 +1,87 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuDispatch.h>
+#include <math/dag_imageFunctions.h>
+#include <perfMon/dag_perfTimer.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathBase.h>
+#include <debug/dag_log.h>
+#include <string.h>
+
+// Usage: testVecMath8 [pixels] [runs]
+// Runs imagefunctions kernels which have 8-wide (vec8f) variants with each SIMD level up to one supported by CPU, checks results
+// against 4-wide baseline code (exits with 1 on mismatch) and reports throughput (Mpix/s)
+
+static const char *level_names[CPU_SIMD_LEVEL_COUNT] = {"base", "sse4", "avx2", "avx512"};
+
+template <typename F>
+static int measure_usec(int runs, const F &f)
+{
+  int best = INT_MAX;
+  for (int i = 0; i < runs; i++)
+  {
+    int64_t reft = profile_ref_ticks();
+    f();
+    best = min(best, profile_time_usec(reft));
+  }
+  return max(best, 1);
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  int pixels = dgs_argc > 1 ? max(atoi(dgs_argv[1]), 4) & ~3 : (1 << 20) + 4; // simda functions work by 4 pixels
+  int runs = dgs_argc > 2 ? max(atoi(dgs_argv[2]), 1) : 5;
+  const double mpix = pixels / 1e6;
+  logdbg("%d pixels, %d runs, CPU SIMD level %s", pixels, runs, level_names[cpu_simd_level_checked]);
+
+  // pixels count not multiple of 8 checks that tail after 8-wide part is processed by 4-wide code
+  Tab<float> linear, linearRef, floats;
+  Tab<uint8_t> bytes, bytesRef, srgb;
+  for (Tab<float> *t : {&linear, &linearRef, &floats})
+    t->resize(pixels * 4);
+  for (Tab<uint8_t> *t : {&bytes, &bytesRef, &srgb})
+    t->resize(pixels * 4);
+  uint32_t seed = 12345;
+  for (int i = 0; i < pixels * 4; i++)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    srgb[i] = seed >> 24;
+    floats[i] = (seed & 0xFFFFFF) / float(0xFFFFFF);
+  }
+
+  int refToLinearUsec = 0, refToSrgbUsec = 0, failedLevels = 0;
+  for (int level = CPU_SIMD_BASE; level <= cpu_simd_level_checked; level++)
+  {
+    set_cpu_simd_level_limit(CpuSimdLevel(level));
+    int toLinearUsec = measure_usec(runs, [&] { imagefunctions::exponentiate4_simda(srgb.data(), linear.data(), pixels, 2.2f); });
+    int toSrgbUsec =
+      measure_usec(runs, [&] { imagefunctions::convert_to_linear_simda(floats.data(), bytes.data(), pixels, 1.f / 2.2f); });
+    if (level == CPU_SIMD_BASE)
+    {
+      linearRef = linear;
+      bytesRef = bytes;
+      refToLinearUsec = toLinearUsec;
+      refToSrgbUsec = toSrgbUsec;
+    }
+    float maxLinearDiff = 0;
+    int maxByteDiff = 0;
+    for (int i = 0; i < pixels * 4; i++)
+    {
+      maxLinearDiff = max(maxLinearDiff, fabsf(linear[i] - linearRef[i]));
+      maxByteDiff = max(maxByteDiff, abs(int(bytes[i]) - int(bytesRef[i])));
+    }
+    // FMA in 8-wide variants changes rounding of pow estimate a bit
+    bool ok = maxLinearDiff < 1e-4f && maxByteDiff <= 1;
+    logdbg("%-6s: exponentiate4 %7.1f Mpix/s (%.2fx), convert_to_linear %7.1f Mpix/s (%.2fx), max diff %g / %d%s", level_names[level],
+      mpix * 1e6 / toLinearUsec, double(refToLinearUsec) / toLinearUsec, mpix * 1e6 / toSrgbUsec, double(refToSrgbUsec) / toSrgbUsec,
+      maxLinearDiff, maxByteDiff, ok ? "" : ", MISMATCH!");
+    failedLevels += !ok;
+  }
+  set_cpu_simd_level_limit(CPU_SIMD_AVX512);
+
+  int lutUsec = measure_usec(runs, [&] { imagefunctions::exponentiate4_c(srgb.data(), linear.data(), pixels, 2.2f); });
+  logdbg("exponentiate4_c (LUT): %7.1f Mpix/s", mpix * 1e6 / lutUsec);
+  if (failedLevels)
+    logerr("%d SIMD levels differ from baseline", failedLevels);
+  return failedLevels ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+#include <startup/dag_mainCon.inc.cpp>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <util/dag_threadPool.h>
+#include <ioSys/dag_zstdSeekableIo.h>
+#include <ioSys/dag_memIo.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathBase.h>
+#include <debug/dag_log.h>
+#include <arc/zstd-1.4.5/zstd.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: testZstdSeekable [random_reads]
+// Round trip of seekable zstd stream: writes data with uniform frames and with frames cut at random points, then checks
+// sequential reading, reads at random offsets after seekto(), readRange() with and without threadpool (from memory and from
+// IGenLoad source) and plain zstd decoding of the whole stream
+
+static constexpr int DATA_SIZE = (3 << 20) + 12345;
+static constexpr int FRAME_SIZE = 64 << 10;
+
+static uint32_t rnd_seed = 1;
+static uint32_t rnd() { return (rnd_seed = rnd_seed * 1664525u + 1013904223u) >> 8; }
+
+// compressible, but not trivially: runs of repeated earlier data mixed with noise
+static void make_data(Tab<char> &data)
+{
+  data.resize(DATA_SIZE);
+  for (int i = 0; i < DATA_SIZE;)
+  {
+    int len = min<int>(1 + rnd() % 300, DATA_SIZE - i);
+    if (i > 1024 && (rnd() & 3))
+      memmove(&data[i], &data[i - 1 - rnd() % 1024], len);
+    else
+      for (int j = 0; j < len; j++)
+        data[i + j] = char(rnd());
+    i += len;
+  }
+}
+
+static void write_stream(DynamicMemGeneralSaveCB &cwr, const Tab<char> &data, bool random_frames)
+{
+  ZstdSeekableSaveCB zcwr(cwr, 3, FRAME_SIZE);
+  for (int ofs = 0, size = data.size(); ofs < size;)
+  {
+    int sz = min<int>(1 + rnd() % (FRAME_SIZE / 2), size - ofs);
+    zcwr.write(&data[ofs], sz);
+    ofs += sz;
+    if (random_frames && (rnd() & 7) == 0)
+      zcwr.flushFrame();
+  }
+  zcwr.finish();
+}
+
+static int check_reads(ZstdSeekableLoadCB &crd, const Tab<char> &data, int random_reads)
+{
+  const int size = data.size();
+  int errors = 0;
+  errors += crd.getSize() != size;
+
+  Tab<char> buf;
+  buf.resize(size);
+  crd.seekto(0);
+  crd.read(buf.data(), size);
+  errors += memcmp(buf.data(), data.data(), size) != 0;
+  errors += crd.tell() != size;
+  errors += crd.tryRead(buf.data(), 1) != 0;
+
+  for (int i = 0; i < random_reads; i++)
+  {
+    int ofs = rnd() % size, sz = min<int>(1 + rnd() % (FRAME_SIZE * 3), size - ofs);
+    crd.seekto(ofs);
+    crd.read(buf.data(), sz);
+    errors += memcmp(buf.data(), &data[ofs], sz) != 0 || crd.tell() != ofs + sz;
+  }
+
+  for (bool useThreadpool : {false, true})
+  {
+    int ofs = rnd() % (size / 2), sz = size - ofs;
+    memset(buf.data(), 0, size);
+    errors += crd.readRange(buf.data(), ofs, sz, useThreadpool) != sz;
+    errors += memcmp(buf.data(), &data[ofs], sz) != 0;
+  }
+  return errors;
+}
+
+static int test_stream(const Tab<char> &data, bool random_frames, int random_reads)
+{
+  DynamicMemGeneralSaveCB cwr(tmpmem, 0, 1 << 20);
+  write_stream(cwr, data, random_frames);
+  dag::ConstSpan<char> enc((const char *)cwr.data(), cwr.size());
+  int errors = 0;
+
+  ZstdSeekableLoadCB memCrd(enc);
+  errors += !memCrd.isOpen();
+  if (memCrd.isOpen())
+    errors += check_reads(memCrd, data, random_reads);
+
+  InPlaceMemLoadCB src(enc.data(), enc.size());
+  ZstdSeekableLoadCB streamCrd(src, enc.size());
+  errors += !streamCrd.isOpen();
+  if (streamCrd.isOpen())
+    errors += check_reads(streamCrd, data, random_reads);
+
+  // still a valid zstd stream (sequence of frames), seek table is skippable frame
+  Tab<char> plain;
+  plain.resize(data.size() + 1);
+  errors += ZSTD_decompress(plain.data(), plain.size(), enc.data(), enc.size()) != data.size();
+  errors += memcmp(plain.data(), data.data(), data.size()) != 0;
+
+  logdbg("%s frames: %d bytes in %d frames -> %d bytes, %d errors", random_frames ? "random" : "uniform", data.size(),
+    memCrd.getFramesCount(), enc.size(), errors);
+  return errors;
+}
+
+int DagorWinMain(bool /*debugmode*/)
+{
+  int randomReads = dgs_argc > 1 ? max(atoi(dgs_argv[1]), 1) : 1000;
+
+  cpujobs::init();
+  threadpool::init(eastl::min(cpujobs::get_core_count(), 64), 2048, 256 << 10);
+
+  Tab<char> data;
+  make_data(data);
+  int errors = test_stream(data, false, randomReads) + test_stream(data, true, randomReads);
+  if (errors)
+    logerr("%d errors", errors);
+  return errors ? 1 : 0;
+}
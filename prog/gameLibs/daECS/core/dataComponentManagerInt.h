@@ -3,6 +3,7 @@
 #include <daECS/core/internal/dataComponentManager.h>
 #include "specialized_memcpy.h"
 #include <vecmath/dag_vecMathDecl.h>
+#include <math/dag_adjpow2.h>
 
 namespace ecs
 {
@@ -57,6 +58,24 @@ inline void DataComponentManager::removeChunk(uint32_t c)
   workingChunk = 0;
 }
 
+inline void DataComponentManager::resetToUsed(uint32_t entity_size, uint32_t used_count)
+{
+  aliasedChunks = AliasedChunk(); // old chunks are freed with temporary
+  totalEntitiesUsed = 0;
+  currentCapacityBits = initialBits;
+  setEmpty();
+  // all chunks but last are full, so entity at index i is (i >> MAX_CAPACITY_BITS, i & (MAX_CAPACITY - 1))
+  while (used_count)
+  {
+    const uint32_t cnt = eastl::min(used_count, (uint32_t)MAX_CAPACITY);
+    Chunk &chunk = getChunk(allocateChunk(entity_size, get_bigger_log2(cnt)));
+    chunk.entitiesUsed = cnt;
+    totalEntitiesUsed += cnt;
+    used_count -= cnt;
+  }
+  workingChunk = getChunksCount() - 1;
+}
+
 inline DataComponentManager::Chunk &DataComponentManager::allocateEmpty(chunk_type_t &chunkId, uint32_t &id, uint32_t entity_size)
 {
   // select suitable chunk
@@ -5,6 +5,8 @@
 #include "tokenize_const_string.h"
 #include "check_es_optional.h"
 #include "ecsPerformQueryInline.h"
+#include <util/dag_stlqsort.h>
+#include <util/dag_radix.h>
 
 namespace ecs
 {
@@ -52,6 +54,102 @@ __forceinline void EntityManager::callESEvent(es_index_type esIndex, const Event
     es.ops.onEvent(evt, qv);
 }
 
+uint16_t EntityManager::findEsEventIndex(event_type_t type) const
+{
+  if (esEventSlots.empty())
+    return INVALID_ES_EVENT_INDEX;
+  const uint32_t mask = esEventSlots.size() - 1;
+  for (uint32_t i = type & mask;; i = (i + 1) & mask)
+  {
+    const EsEventSlot &slot = esEventSlots[i];
+    if (slot.index == INVALID_ES_EVENT_INDEX || slot.type == type)
+      return slot.index;
+  }
+}
+
+void EntityManager::addEsEventIndex(event_type_t type)
+{
+  if (findEsEventIndex(type) != INVALID_ES_EVENT_INDEX)
+    return;
+  G_ASSERT_RETURN(esEventTypes.size() < INVALID_ES_EVENT_INDEX, );
+  esEventTypes.push_back(type);
+  auto insertSlot = [this](event_type_t type, uint16_t index) {
+    const uint32_t mask = esEventSlots.size() - 1;
+    uint32_t i = type & mask;
+    while (esEventSlots[i].index != INVALID_ES_EVENT_INDEX)
+      i = (i + 1) & mask;
+    esEventSlots[i] = EsEventSlot{type, index};
+  };
+  if (esEventTypes.size() * 2 <= esEventSlots.size())
+  {
+    insertSlot(type, esEventTypes.size() - 1);
+    return;
+  }
+  esEventSlots.assign(max<size_t>(esEventSlots.size() * 2, 64), EsEventSlot{0, INVALID_ES_EVENT_INDEX});
+  for (uint32_t i = 0, e = esEventTypes.size(); i < e; ++i)
+    insertSlot(esEventTypes[i], i);
+}
+
+void EntityManager::clearEsEventIndices()
+{
+  esEventSlots.clear();
+  esEventTypes.clear();
+  resetArchetypesEventsES();
+}
+
+__forceinline uint32_t EntityManager::getArchetypeEventES(uint32_t archetype, uint16_t event_index)
+{
+  if (archetype < archetypesEventsES.size())
+  {
+    const auto &lists = archetypesEventsES[archetype].lists;
+    if (event_index < lists.size() && lists[event_index] != ArchetypeEventsEs::NOT_BUILT)
+      return lists[event_index];
+  }
+  return buildArchetypeEventES(archetype, event_index);
+}
+
+uint32_t EntityManager::buildArchetypeEventES(uint32_t archetype, uint16_t event_index)
+{
+  // queries are not updated to that archetype yet, or events can be sent from other threads
+  if (archetype >= allQueriesUpdatedToArch || isConstrainedMTMode())
+    return ArchetypeEventsEs::NOT_BUILT;
+  if (archetypesEventsES.size() <= archetype)
+    archetypesEventsES.resize(archetype + 1);
+  ArchetypeEventsEs &archEs = archetypesEventsES[archetype];
+  if (archEs.lists.size() <= event_index)
+    archEs.lists.resize(esEventTypes.size(), ArchetypeEventsEs::NOT_BUILT);
+  auto esListIt = esEvents.find(esEventTypes[event_index]);
+  if (esListIt == esEvents.end())
+    return ArchetypeEventsEs::NOT_BUILT;
+  const uint32_t first = archEs.es.size();
+  for (es_index_type esIndex : esListIt->second)
+  {
+    QueryId queryId = esListQueries[esIndex];
+#if DAECS_EXTENSIVE_CHECKS
+    if (!isQueryValid(queryId))
+    {
+      logerr("Currently supporting of 'empty' ES for unicast messages is not available."
+             " If ever really neded, just remove this logerr and guards"
+             " Or, likely, you somehow unintentionally made empty ES and it is a bug {%s}",
+        esList[esIndex]->name);
+      continue;
+    }
+#else
+    if (!queryId) // this should not be not needed, if we would never allow to ADD 'empty' ES for unicast messages
+      continue;
+#endif
+    const archetype_t archSubQuery = getEidQueryArchSubQuery(queryId, archetype);
+    if (archSubQuery != INVALID_ARCHETYPE)
+      archEs.es.push_back(ArchetypeEventEs{esIndex, archSubQuery});
+  }
+  if (archEs.es.size() > 0xFFFF) // doesn't fit to list, keep checking each ES of event
+  {
+    archEs.es.resize(first);
+    return ArchetypeEventsEs::NOT_BUILT;
+  }
+  return archEs.lists[event_index] = (first << 16) | (archEs.es.size() - first);
+}
+
 void EntityManager::notifyESEventHandlers(EntityId eid, const Event &evt)
 {
   auto eventType = evt.getType();
@@ -67,21 +165,53 @@ void EntityManager::notifyESEventHandlers(EntityId eid, const Event &evt)
   }
   G_ASSERT(eventType != EventComponentChanged::staticType());
 #endif
-  auto esListIt = esEvents.find(eventType); // this is extremely slow, and should not be needed. We can register all events with flat
-                                            // arrays, not search.
-  // todo: optimize. need to write event idx instead of name though
-  if (esListIt == esEvents.end())
-    return;
-  auto &list = esListIt->second;
-  if (allow_create_sync_within_es && list.empty()) // to be removed when no instantiate templates is happening within ES
+  const uint16_t eventIndex = findEsEventIndex(eventType);
+  if (eventIndex == INVALID_ES_EVENT_INDEX)
     return;
   const uint32_t idx = eid.index();
+  const uint32_t archetype = entDescs[idx].archetype;
+  const uint32_t list = getArchetypeEventES(archetype, eventIndex);
+  if (EASTL_UNLIKELY(list == ArchetypeEventsEs::NOT_BUILT))
+  {
+    const auto &allEs = esEvents.find(eventType)->second;
+    if (!allEs.empty())
+      notifyESEventHandlersAllES(eid, evt, allEs.begin(), allEs.end());
+    return;
+  }
+  if (!(list & 0xFFFF))
+    return;
 
   QueryView qv(*this);
   QueryView::ComponentsData componentData[MAX_ONE_EID_QUERY_COMPONENTS];
   qv.componentData = componentData;
   RaiiOptionalCounter nested(!isConstrainedMTMode(), nestedQuery); // it is correcly to put it around es call, but it is faster
-  es_index_type const *es_start = list.begin(), *es_end = list.end();
+  const uint32_t generation = archetypesEventsESGeneration;
+  es_index_type lastEsIndex = 0;
+  for (uint32_t i = list >> 16, ie = i + (list & 0xFFFF); i != ie; ++i)
+  {
+    // intentionally get entDescs[idx] and list again. ES can create archetypes, register ES and even sync re-create current entity
+    const EntityDesc entDesc = entDescs[idx];
+    if (EASTL_UNLIKELY(entDesc.archetype != archetype || generation != archetypesEventsESGeneration))
+    {
+      // rest of ES subscribed to event are checked one by one, against new archetype of entity
+      notifyESEventHandlersAfter(eid, evt, lastEsIndex);
+      return;
+    }
+    const ArchetypeEventEs es = archetypesEventsES[archetype].es[i];
+    fillEidQueryViewArchSubQuery(eid, entDesc, esListQueries[es.esIndex], es.archSubQuery, qv);
+    callESEvent(lastEsIndex = es.esIndex, evt, qv);
+  }
+}
+
+// checks each ES subscribed to event, for entities of archetypes not known to queries yet, or events sent from other threads
+void EntityManager::notifyESEventHandlersAllES(EntityId eid, const Event &evt, const es_index_type *es_start,
+  const es_index_type *es_end)
+{
+  const uint32_t idx = eid.index();
+  QueryView qv(*this);
+  QueryView::ComponentsData componentData[MAX_ONE_EID_QUERY_COMPONENTS];
+  qv.componentData = componentData;
+  RaiiOptionalCounter nested(!isConstrainedMTMode(), nestedQuery); // it is correcly to put it around es call, but it is faster
   do
   {
     es_index_type esIndex = *es_start;
@@ -107,6 +237,177 @@ void EntityManager::notifyESEventHandlers(EntityId eid, const Event &evt)
   } while (++es_start != es_end);
 }
 
+void EntityManager::notifyESEventHandlersAfter(EntityId eid, const Event &evt, es_index_type last_es)
+{
+  auto esListIt = esEvents.find(evt.getType());
+  if (esListIt == esEvents.end())
+    return;
+  const es_index_type *restEs = eastl::upper_bound(esListIt->second.begin(), esListIt->second.end(), last_es);
+  if (restEs != esListIt->second.end())
+    notifyESEventHandlersAllES(eid, evt, restEs, esListIt->second.end());
+}
+
+static constexpr uint32_t NOT_SENT_SEPARATELY = ~0u, NO_ES_CALLED = ~0u - 1;
+static constexpr uint32_t MAX_BATCHED_EVENTS_RUN = 256;
+
+void EntityManager::batchDeferredEvent(EntityId eid, Event &evt)
+{
+  const EntityDesc &entDesc = entDescs[eid.index()];
+  const uint64_t bucketKey = (uint64_t(evt.getType()) << 32) | entDesc.archetype;
+  auto bucketIt = batchedEventsBucketsMap.find(bucketKey);
+  if (bucketIt == batchedEventsBucketsMap.end())
+  {
+    bucketIt = batchedEventsBucketsMap.emplace(bucketKey, (uint32_t)batchedEventsBuckets.size()).first;
+    batchedEventsBuckets.push_back(bucketKey);
+  }
+  Event &batched = emplaceUntypedEvent(batchedEventsStorage, eid, evt);
+  const uint32_t position = (uint32_t(entDesc.chunkId) << 16) | entDesc.idInChunk;
+  const uint32_t order = (uint32_t)batchedEvents.size();
+  batchedEventsPositionsMask |= position;
+  batchedEvents.push_back(BatchedEvent{&batched, eid, bucketIt->second, position, order, NOT_SENT_SEPARATELY, 1});
+}
+
+void EntityManager::sendBatchedEvents()
+{
+  TIME_PROFILE_DEV(ecs_send_batched_events);
+  batchedEventsState = BATCHED_EVENTS_SENDING;
+  // order by bucket and then by place of entity in archetype, keeping order of arrival for each entity
+  BatchedEvent *sorted;
+  // 32-bit radix key is bucket in high 8 bits and position in low 24 bits, so it is used only when both fit (chunkId < 256)
+  if (batchedEventsBuckets.size() <= 256 && batchedEventsPositionsMask < (1u << 24))
+  {
+    batchedEventsSorted.resize(batchedEvents.size());
+    sorted = radix_sort_3pass(batchedEvents.data(), batchedEventsSorted.data(), batchedEvents.size(),
+      [](const BatchedEvent &e) { return (e.bucket << 24) | e.position; }); // radix sort is stable
+  }
+  else
+  {
+    stlsort::sort(batchedEvents.begin(), batchedEvents.end(), [](const BatchedEvent &a, const BatchedEvent &b) {
+      if (a.bucket != b.bucket)
+        return a.bucket < b.bucket;
+      return a.position != b.position ? a.position < b.position : a.order < b.order;
+    });
+    sorted = batchedEvents.data();
+  }
+  for (BatchedEvent *bucket = sorted, *end = sorted + batchedEvents.size(); bucket != end;)
+  {
+    BatchedEvent *bucketEnd = bucket + 1;
+    while (bucketEnd != end && bucketEnd->bucket == bucket->bucket)
+      ++bucketEnd;
+    sendBatchedEventsBucket(bucket, bucketEnd);
+    bucket = bucketEnd;
+  }
+  batchedEvents.clear();
+  batchedEventsSorted.clear();
+  batchedEventsBuckets.clear();
+  batchedEventsBucketsMap.clear();
+  batchedEventsPositionsMask = 0;
+  destroyEvents(batchedEventsStorage);
+  batchedEventsStorage.active.normalize();
+  batchedEventsState = BATCHED_EVENTS_IDLE;
+}
+
+void EntityManager::sendBatchedEventsBucket(BatchedEvent *begin, BatchedEvent *end)
+{
+  const uint32_t archetype = uint32_t(batchedEventsBuckets[begin->bucket]);
+  const uint16_t eventIndex = findEsEventIndex(begin->evt->getType());
+  if (eventIndex == INVALID_ES_EVENT_INDEX)
+    return;
+  const uint32_t list = getArchetypeEventES(archetype, eventIndex);
+  if (list == ArchetypeEventsEs::NOT_BUILT || end - begin == 1)
+  {
+    for (BatchedEvent *be = begin; be != end; ++be)
+      dispatchEventImmediate(be->eid, *be->evt);
+    return;
+  }
+
+  // identical events sent to entities following one after another in chunk are passed to ES at once
+  for (BatchedEvent *be = begin; be != end; be += be->runLength)
+    if (!(be->evt->getFlags() & EVFLG_DESTROY))
+      for (const BatchedEvent *next = be + 1; next != end && be->runLength < MAX_BATCHED_EVENTS_RUN; ++next, ++be->runLength)
+        if (next->position != be->position + be->runLength || memcmp(be->evt, next->evt, be->evt->getLength()) != 0)
+          break;
+
+  QueryView qv(*this);
+  QueryView::ComponentsData componentData[MAX_ONE_EID_QUERY_COMPONENTS];
+  qv.componentData = componentData;
+  EntityId runEids[MAX_BATCHED_EVENTS_RUN];
+  const uint32_t generation = archetypesEventsESGeneration;
+  uint32_t lastEsIndex = NO_ES_CALLED;
+  uint32_t i = list >> 16;
+  const uint32_t ie = i + (list & 0xFFFF);
+  {
+    RaiiOptionalCounter nested(!isConstrainedMTMode(), nestedQuery); // it is correcly to put it around es call, but it is faster
+    for (; i != ie && generation == archetypesEventsESGeneration; ++i)
+    {
+      const ArchetypeEventEs es = archetypesEventsES[archetype].es[i];
+      const QueryId queryId = esListQueries[es.esIndex];
+      for (BatchedEvent *be = begin; be != end;)
+      {
+        if (EASTL_UNLIKELY(generation != archetypesEventsESGeneration))
+        {
+          // ES lists and queries were reset from ES, events not sent to this ES yet get the rest of ES one by one
+          for (; be != end; ++be)
+            if (be->sentUpToEs == NOT_SENT_SEPARATELY)
+              be->sentUpToEs = lastEsIndex;
+          break;
+        }
+        // intentionally get entDescs again for each ES, as ES can create entities and even sync re-create or destroy them
+        uint32_t inPlace = 0;
+        for (; inPlace < be->runLength; ++inPlace)
+        {
+          const BatchedEvent &runEvent = be[inPlace];
+          const EntityDesc &entDesc = entDescs[runEvent.eid.index()];
+          const uint32_t position = (uint32_t(entDesc.chunkId) << 16) | entDesc.idInChunk;
+          if (runEvent.sentUpToEs != NOT_SENT_SEPARATELY || entDesc.archetype != archetype ||
+              entDesc.generation != runEvent.eid.generation() || position != runEvent.position)
+            break;
+          runEids[inPlace] = runEvent.eid;
+        }
+        if (inPlace == be->runLength)
+        {
+          fillEidsQueryViewArchSubQuery(runEids, inPlace, entDescs[be->eid.index()], queryId, es.archSubQuery, qv);
+          callESEvent(es.esIndex, *be->evt, qv);
+          be += inPlace;
+          continue;
+        }
+        // some entities of run were moved, re-created or destroyed, send rest of its events one by one
+        for (BatchedEvent *runEnd = be + be->runLength; be != runEnd && generation == archetypesEventsESGeneration; ++be)
+        {
+          if (be->sentUpToEs != NOT_SENT_SEPARATELY)
+            continue;
+          const EntityDesc entDesc = entDescs[be->eid.index()];
+          if (entDesc.archetype != archetype || entDesc.generation != be->eid.generation())
+          {
+            be->sentUpToEs = lastEsIndex;
+            continue;
+          }
+          fillEidsQueryViewArchSubQuery(&be->eid, 1, entDesc, queryId, es.archSubQuery, qv);
+          callESEvent(es.esIndex, *be->evt, qv);
+        }
+      }
+      lastEsIndex = es.esIndex;
+    }
+  }
+
+  // events which can't be sent with bucket anymore (entity was re-created, or ES were registered from ES) get the rest of ES
+  const bool allEsCalled = i == ie;
+  for (BatchedEvent *be = begin; be != end; ++be)
+  {
+    uint32_t sentUpToEs = be->sentUpToEs;
+    if (sentUpToEs == NOT_SENT_SEPARATELY)
+    {
+      if (allEsCalled)
+        continue;
+      sentUpToEs = lastEsIndex;
+    }
+    if (sentUpToEs == NO_ES_CALLED)
+      dispatchEventImmediate(be->eid, *be->evt);
+    else if (entDescs.getEntityState(be->eid) == EntitiesDescriptors::EntityState::Alive)
+      notifyESEventHandlersAfter(be->eid, *be->evt, es_index_type(sentUpToEs));
+  }
+}
+
 void EntityManager::notifyESEventHandlersInternal(EntityId eid, const Event &evt, const es_index_type *__restrict es_start,
   const es_index_type *__restrict es_end)
 {
@@ -247,6 +548,8 @@ void EntityManager::registerEsEvent(int j)
     if (evt == EventComponentChanged::staticType()) // legacy
       continue;
     esEvents[evt].insert(j);
+    addEsEventIndex(evt);
+    resetArchetypesEventsES();
     if (evtId != eventDb.invalid_event_id && eventDb.getEventFlags(evtId) & EVFLG_PROFILE)
       es->cacheProfileTokensOnce();
   }
@@ -307,6 +610,7 @@ void EntityManager::registerEsEvents()
   G_ASSERT(ECS_HASH("name").hash == ecs_hash("name") && ECS_HASH("name").hash == ECS_HASH_SLOW("name").hash);
   esEvents.clear();
   esOnChangeEvents.clear();
+  clearEsEventIndices();
   for (int j = 0, ej = esList.size(); j < ej; ++j)
   {
     QueryId h = esListQueries[j];
@@ -37,7 +37,10 @@ __forceinline void EntityManager::dispatchEventImmediate(EntityId eid, Event &ev
     else
     {
       DAECS_EXT_ASSERT(!(evt.getFlags() & EVFLG_CORE));
-      notifyESEventHandlers(eid, evt);
+      if (EASTL_UNLIKELY(evt.getFlags() & EVFLG_BATCHED) && batchedEventsState == BATCHED_EVENTS_COLLECTING)
+        batchDeferredEvent(eid, evt);
+      else
+        notifyESEventHandlers(eid, evt);
     }
   }
   else
@@ -98,10 +101,20 @@ inline void ecs::EntityManager::sendQueuedEvents(uint32_t top_send_count)
   if (!deferredEventsCount)
     return;
   TIME_PROFILE_DEV(ecs_send_queued_events);
+  // nested drains (from ES) only add to batched events of outer one, and events sent from batched ES are not batched
+  const bool collectBatched = batchedEventsState == BATCHED_EVENTS_IDLE;
+  if (collectBatched)
+    batchedEventsState = BATCHED_EVENTS_COLLECTING;
   uint32_t processed = processEventsAnyway(top_send_count, eventsStorage);
   // it can be less than that, if we face data race, which is assume to be covered by mutex OR if we process 'end markers' events
   deferredEventsCount = max((int)deferredEventsCount - (int)processed, (int)0); // event left
   current_tick_events += processed;
+  if (collectBatched)
+  {
+    batchedEventsState = BATCHED_EVENTS_IDLE;
+    if (EASTL_UNLIKELY(!batchedEvents.empty()))
+      sendBatchedEvents();
+  }
 }
 
 } // namespace ecs
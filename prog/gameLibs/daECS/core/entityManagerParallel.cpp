@@ -0,0 +1,320 @@
+#include <daECS/core/updateStage.h>
+#include <daECS/core/entityManager.h>
+#include <daECS/core/entitySystem.h>
+#include "entityManagerEvent.h"
+#include <util/dag_parallelForInline.h>
+#include <util/dag_stlqsort.h>
+#include <util/dag_hash.h>
+#include <perfMon/dag_perfTimer.h>
+#include <perfMon/dag_statDrv.h>
+#include <memory/dag_framemem.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <EASTL/bitvector.h>
+#include "ecsPerformQueryInline.h"
+
+// Parallel update stages.
+// ES of stage are grouped into waves, so that ES within one wave do not conflict with each other (see setParallelUpdateStages).
+// Wave of ES is one more than maximum wave of conflicting ES that are earlier in update order, so order of conflicting ES is kept.
+
+namespace ecs
+{
+
+typedef dag::Vector<component_t, framemem_allocator> fm_components_list_t;
+
+// scripted ES and ES that do not access data components are likely to work with globals, so they are never run with others
+static inline bool is_parallel_barrier(const EntitySystemDesc &es)
+{
+  return es.isDynamic() || es.isEmpty() || (es.componentsRW.empty() && es.componentsRO.empty());
+}
+
+static void append_sorted(fm_components_list_t &to, dag::ConstSpan<ComponentDesc> comps)
+{
+  const uint32_t from = to.size();
+  for (const ComponentDesc &c : comps)
+    to.push_back(c.name);
+  stlsort::sort(to.begin() + from, to.end());
+  to.erase(eastl::unique(to.begin() + from, to.end()), to.end());
+}
+
+static bool intersects(const component_t *a, const component_t *ae, const component_t *b, const component_t *be)
+{
+  while (a != ae && b != be)
+  {
+    if (*a < *b)
+      ++a;
+    else if (*b < *a)
+      ++b;
+    else
+      return true;
+  }
+  return false;
+}
+
+void EntityManager::buildParallelSchedule(uint32_t stage, ParallelStageSchedule &sch) const
+{
+  FRAMEMEM_REGION;
+  dag::Vector<es_index_type, framemem_allocator> list; // in update order
+  list.insert(list.end(), esUpdates[stage].begin(), esUpdates[stage].end());
+  const uint32_t cnt = list.size();
+
+  // declared access, each list is sorted
+  struct EsAccess
+  {
+    uint32_t rw, ro, end;
+    bool barrier;
+  };
+  dag::Vector<EsAccess, framemem_allocator> access(cnt);
+  fm_components_list_t comps;
+  for (uint32_t i = 0; i < cnt; ++i)
+  {
+    const EntitySystemDesc &es = *esList[list[i]];
+    access[i].barrier = is_parallel_barrier(es);
+    access[i].rw = comps.size();
+    append_sorted(comps, es.componentsRW);
+    access[i].ro = comps.size();
+    append_sorted(comps, es.componentsRO);
+    access[i].end = comps.size();
+  }
+
+  // ES are ordered if one of them is reachable from another in ES order graph
+  const int nodesCount = max(int(esGraphEdgesOfs.size()) - 1, 0);
+  dag::Vector<int, framemem_allocator> nodeToStageEs(nodesCount, -1);
+  for (uint32_t i = 0; i < cnt; ++i)
+  {
+    const int node = list[i] < esGraphNode.size() ? esGraphNode[list[i]] : -1;
+    if (node < 0 || node >= nodesCount)
+      continue;
+    if (nodeToStageEs[node] >= 0) // ES with same name (allowed within one module), we can't tell their order
+      access[i].barrier = access[nodeToStageEs[node]].barrier = true;
+    else
+      nodeToStageEs[node] = i;
+  }
+  eastl::bitvector<framemem_allocator> ordered(cnt * cnt, false), visited;
+  dag::Vector<int, framemem_allocator> stack;
+  for (uint32_t i = 0; i < cnt; ++i)
+  {
+    const int from = list[i] < esGraphNode.size() ? esGraphNode[list[i]] : -1;
+    if (from < 0 || from >= nodesCount)
+      continue;
+    visited.clear();
+    visited.resize(nodesCount, false);
+    visited.set(from, true);
+    stack.push_back(from);
+    while (!stack.empty())
+    {
+      const int node = stack.back();
+      stack.pop_back();
+      for (int e = esGraphEdgesOfs[node], ee = esGraphEdgesOfs[node + 1]; e < ee; ++e)
+      {
+        const int to = esGraphEdges[e];
+        if (to >= nodesCount || visited[to])
+          continue;
+        visited.set(to, true);
+        stack.push_back(to);
+        if (nodeToStageEs[to] >= 0)
+        {
+          ordered.set(i * cnt + nodeToStageEs[to], true);
+          ordered.set(nodeToStageEs[to] * cnt + i, true);
+        }
+      }
+    }
+  }
+
+  auto conflicts = [&](uint32_t i, uint32_t j) {
+    const EsAccess &a = access[i], &b = access[j];
+    const component_t *c = comps.data();
+    return a.barrier || b.barrier || ordered[i * cnt + j] || intersects(c + a.rw, c + a.ro, c + b.rw, c + b.end) ||
+           intersects(c + a.ro, c + a.end, c + b.rw, c + b.ro);
+  };
+
+  dag::Vector<uint16_t, framemem_allocator> wave(cnt, 0);
+  uint32_t wavesCount = 0;
+  for (uint32_t i = 0; i < cnt; ++i)
+  {
+    for (uint32_t j = 0; j < i; ++j)
+      if (wave[j] + 1 > wave[i] && conflicts(i, j))
+        wave[i] = wave[j] + 1;
+    wavesCount = max(wavesCount, wave[i] + 1u);
+  }
+
+  // counting sort by wave, keeping update order within wave
+  dag::Vector<uint16_t, framemem_allocator> waveFill(wavesCount + 1, 0), orderPos(cnt);
+  for (uint32_t i = 0; i < cnt; ++i)
+    waveFill[wave[i] + 1]++;
+  for (uint32_t w = 0; w < wavesCount; ++w) // starts of waves
+    waveFill[w + 1] += waveFill[w];
+  sch.order.resize(cnt);
+  for (uint32_t i = 0; i < cnt; ++i)
+    sch.order[orderPos[i] = waveFill[wave[i]]++] = list[i];
+  sch.waveEnds.assign(waveFill.begin(), waveFill.begin() + wavesCount); // starts became ends after filling
+
+  // validation: ES can't change components other ES of wave access, unless it declared them as RW
+  sch.watchedOfs.assign(cnt + 1, 0);
+  sch.watchedComps.clear();
+  if (!parallelStagesValidate)
+    return;
+  dag::Vector<uint16_t, framemem_allocator> orderToList(cnt);
+  for (uint32_t i = 0; i < cnt; ++i)
+    orderToList[orderPos[i]] = i;
+  fm_components_list_t watched;
+  for (uint32_t w = 0, from = 0; w < wavesCount; from = sch.waveEnds[w++])
+    for (uint32_t o = from, to = sch.waveEnds[w]; o < to; ++o)
+    {
+      sch.watchedOfs[o] = sch.watchedComps.size();
+      const EsAccess &self = access[orderToList[o]];
+      watched.clear();
+      for (uint32_t other = from; other < to; ++other)
+        if (other != o)
+          watched.insert(watched.end(), comps.data() + access[orderToList[other]].rw, comps.data() + access[orderToList[other]].end);
+      stlsort::sort(watched.begin(), watched.end());
+      watched.erase(eastl::unique(watched.begin(), watched.end()), watched.end());
+      for (component_t c : watched)
+        if (!eastl::binary_search(comps.data() + self.rw, comps.data() + self.ro, c))
+          sch.watchedComps.push_back(c);
+    }
+  sch.watchedOfs[cnt] = sch.watchedComps.size();
+}
+
+const EntityManager::ParallelStageSchedule &EntityManager::getParallelSchedule(uint32_t stage)
+{
+  if (parallelSchedules.size() <= stage)
+    parallelSchedules.resize(esUpdates.size());
+  if (parallelStageStats.size() <= stage)
+    parallelStageStats.resize(esUpdates.size());
+  ParallelStageSchedule &sch = parallelSchedules[stage];
+  if (sch.valid)
+    return sch;
+  buildParallelSchedule(stage, sch);
+  sch.valid = true;
+
+  ParallelStageStats &stats = parallelStageStats[stage];
+  stats.systems = sch.order.size();
+  stats.waves = sch.waveEnds.size();
+  stats.maxWaveSize = 0;
+  for (uint32_t w = 0, from = 0; w < sch.waveEnds.size(); from = sch.waveEnds[w++])
+    stats.maxWaveSize = max<uint32_t>(stats.maxWaveSize, sch.waveEnds[w] - from);
+  debug("ecs: parallel stage %s: %d ES in %d waves (max %d ES in wave)", stage < US_COUNT ? es_stage_names[stage] : "US_USER",
+    stats.systems, stats.waves, stats.maxWaveSize);
+  return sch;
+}
+
+int EntityManager::runUpdateEs(es_index_type es_index, const UpdateStageInfo &info)
+{
+  const EntitySystemDesc &es = *esList[es_index];
+#if TIME_PROFILER_ENABLED && DAGOR_DBGLEVEL > 0
+  DA_PROFILE_EVENT_DESC(es.dapToken);
+#endif
+  const int64_t reft = profile_ref_ticks();
+  performQueryEmptyAllowed(esListQueries[es_index], (ESFuncType)es.ops.onUpdate, (const ESPayLoad &)info, es.userData, es.quant);
+  return profile_time_usec(reft);
+}
+
+void EntityManager::updateParallel(const UpdateStageInfo &info)
+{
+  const ParallelStageSchedule &sch = getParallelSchedule(info.stage);
+  const int64_t stageReft = profile_ref_ticks();
+  uint64_t esUsec = 0;
+  for (uint32_t w = 0, from = 0; w < sch.waveEnds.size(); from = sch.waveEnds[w++])
+  {
+    const uint32_t to = sch.waveEnds[w];
+    if (to - from == 1) // nothing to run in parallel with, run it as in usual stage
+      esUsec += runUpdateEs(sch.order[from], info);
+    else if (parallelStagesValidate)
+      runParallelWaveValidated(info, sch, from, to, esUsec);
+    else
+    {
+      updateAllQueriesAnyMT(); // queries are not updated in Constrained MT mode
+      ScopeSetMtConstrained constrained(*this);
+      int waveUsec = 0;
+      auto runEs = [&](uint32_t b, uint32_t e, uint32_t) {
+        for (; b < e; ++b)
+          interlocked_add(waveUsec, runUpdateEs(sch.order[b], info));
+      };
+      if (maxNumJobs)
+        threadpool::parallel_for_inline(from, to, 1, runEs, maxNumJobs,
+          is_main_thread() ? threadpool::PRIO_HIGH : threadpool::PRIO_NORMAL);
+      else
+        runEs(from, to, 0);
+      esUsec += waveUsec;
+    }
+    if (current_tick_events < average_tick_events_uint) // let's try to send events as early, as possible
+      sendQueuedEvents(average_tick_events_uint - current_tick_events);
+  }
+  ParallelStageStats &stats = parallelStageStats[info.stage];
+  stats.runs++;
+  stats.wallUsec += profile_time_usec(stageReft);
+  stats.esUsec += esUsec;
+}
+
+uint64_t EntityManager::hashComponentData(component_t name) const
+{
+  uint64_t hash = FNV1Params<64>::offset_basis;
+  const component_index_t cidx = dataComponents.findComponentId(name);
+  if (cidx == INVALID_COMPONENT_INDEX)
+    return hash;
+  for (uint32_t arch = 0, ae = archetypes.size(); arch < ae; ++arch)
+  {
+    const archetype_component_id id = archetypes.getArchetypeComponentIdUnsafe(arch, cidx);
+    if (id == INVALID_ARCHETYPE_COMPONENT_ID)
+      continue;
+    const uint32_t ofs = archetypes.getComponentOfsUnsafe(arch, id), sz = archetypes.getComponentSizeUnsafe(arch, id);
+    for (const auto &chunk : archetypes.getArchetype(arch).manager.getChunksConst())
+      if (chunk.getUsed())
+        hash = mem_hash_fnv1<64>((const char *)chunk.getCompDataUnsafe(ofs), sz * chunk.getUsed(), hash);
+  }
+  return hash;
+}
+
+void EntityManager::runParallelWaveValidated(const UpdateStageInfo &info, const ParallelStageSchedule &sch, uint32_t from,
+  uint32_t to, uint64_t &es_usec)
+{
+  updateAllQueriesAnyMT();
+  ScopeSetMtConstrained constrained(*this);
+  FRAMEMEM_REGION;
+  dag::Vector<uint64_t, framemem_allocator> hashes;
+  for (uint32_t o = from; o < to; ++o)
+  {
+    const component_t *watched = sch.watchedComps.data() + sch.watchedOfs[o];
+    const uint32_t watchedCnt = sch.watchedOfs[o + 1] - sch.watchedOfs[o];
+    hashes.resize(watchedCnt);
+    for (uint32_t i = 0; i < watchedCnt; ++i)
+      hashes[i] = hashComponentData(watched[i]);
+    es_usec += runUpdateEs(sch.order[o], info);
+    for (uint32_t i = 0; i < watchedCnt; ++i)
+      if (hashes[i] != hashComponentData(watched[i]))
+        logerr("ES <%s> has changed component <%s> not declared as RW, while other ES of same wave access it (parallel stage %s)",
+          esList[sch.order[o]]->name, dataComponents.findComponentName(watched[i]),
+          info.stage < US_COUNT ? es_stage_names[info.stage] : "US_USER");
+  }
+}
+
+void EntityManager::setParallelUpdateStages(uint32_t stages_mask, bool validate)
+{
+  DAECS_EXT_ASSERT_RETURN(!isConstrainedMTMode(), );
+  if (parallelStagesValidate != validate)
+    parallelSchedules.clear();
+  parallelStagesMask = stages_mask;
+  parallelStagesValidate = validate;
+}
+
+EntityManager::ParallelStageStats EntityManager::getParallelStageStats(uint32_t stage) const
+{
+  return stage < parallelStageStats.size() ? parallelStageStats[stage] : ParallelStageStats();
+}
+
+void EntityManager::dumpParallelStageStats(bool reset)
+{
+  for (uint32_t stage = 0; stage < parallelStageStats.size(); ++stage)
+  {
+    ParallelStageStats &stats = parallelStageStats[stage];
+    if (!stats.runs)
+      continue;
+    debug("ecs: parallel stage %s: %d ES in %d waves (max %d ES in wave), %d runs, avg %d us, ES time %d us, speedup %.2f",
+      stage < US_COUNT ? es_stage_names[stage] : "US_USER", stats.systems, stats.waves, stats.maxWaveSize, stats.runs,
+      int(stats.wallUsec / stats.runs), int(stats.esUsec / stats.runs), stats.wallUsec ? double(stats.esUsec) / stats.wallUsec : 1.0);
+    if (reset)
+      stats.runs = 0, stats.wallUsec = stats.esUsec = 0;
+  }
+}
+
+}; // namespace ecs
@@ -710,6 +710,7 @@ void EntityManager::invalidatePersistentQueries()
     vl.clear();
   for (auto &vl : archetypesRecreateES)
     vl.clear();
+  resetArchetypesEventsES();
   allQueriesUpdatedToArch = 0;
   lastQueriesResolvedComponents = 0;
 }
@@ -1044,34 +1045,38 @@ __forceinline void EntityManager::schedule_tracked_changes(const ScheduledArchet
   } while (++trackedI != trackedE && trackedI->archetype == archetype);
 }
 
-bool EntityManager::fillEidQueryView(ecs::EntityId eid, EntityDesc entDesc, QueryId h, QueryView &__restrict qv)
+archetype_t EntityManager::getEidQueryArchSubQuery(QueryId h, uint32_t archetype) const
 {
   DAECS_EXT_ASSERT(isQueryValid(h));
   const uint32_t qIndex = h.index();
   auto &__restrict archDesc = archetypeQueries[qIndex];
   if (!archDesc.archSubQueriesCount)
-    return false;
+    return INVALID_ARCHETYPE;
+  const uint32_t archSubQueryId = archetype - uint32_t(archDesc.firstArch);
+  if (archSubQueryId == 0) // around 2% of all queries has one archetype, so avoid cache miss in this case with a cost of branch
+    return 0;
+  if (archSubQueryId >= archDesc.archSubQueriesCount)
+    return INVALID_ARCHETYPE;
+  return archSubQueriesContainer[archetypeEidQueries[qIndex].archSubQueriesAt + archSubQueryId]; // cache miss
+}
+
+void EntityManager::fillEidQueryViewArchSubQuery(ecs::EntityId eid, EntityDesc entDesc, QueryId h, archetype_t itId,
+  QueryView &__restrict qv)
+{
+  fillEidsQueryViewArchSubQuery(&eid, 1, entDesc, h, itId, qv);
+}
+
+void EntityManager::fillEidsQueryViewArchSubQuery(const ecs::EntityId *eids, uint32_t count, EntityDesc entDesc, QueryId h,
+  archetype_t itId, QueryView &__restrict qv)
+{
+  const uint32_t qIndex = h.index();
+  auto &__restrict archDesc = archetypeQueries[qIndex];
   auto &__restrict archEidDesc = archetypeEidQueries[qIndex];
   auto archetype = entDesc.archetype;
   uint32_t idInChunk = entDesc.idInChunk;
   uint32_t chunkId = entDesc.chunkId;
-  const uint32_t archSubQueryId = uint32_t(archetype) - uint32_t(archDesc.firstArch);
-  archetype_t itId;
-  if (archSubQueryId == 0) // around 2% of all queries has one archetype, so avoid cache miss in this case with a cost of branch
-    itId = 0;
-  else
-  {
-    if (archSubQueryId >= archDesc.archSubQueriesCount)
-      return false;
-
-    itId = archSubQueriesContainer[archEidDesc.archSubQueriesAt + archSubQueryId]; // cache miss
-    if (itId == INVALID_ARCHETYPE)
-      return false;
-  }
-  // up to this it is doesEsApplyToArch, and we know for sure for coreevents, that it always passes.
-  // todo: split function into two, and replace core events from fillEidQueryView into two: (itId to be part of the list)
   qv.chunkEntitiesStart = 0;
-  qv.chunkEntitiesEnd = 1;
+  qv.chunkEntitiesEnd = count;
   qv.roRW = archDesc.roRW;
   qv.id = h;
   const uint32_t totalComponentsCount = archDesc.getComponentsCount();
@@ -1081,14 +1086,25 @@ bool EntityManager::fillEidQueryView(ecs::EntityId eid, EntityDesc entDesc, Quer
   // totalComponentsCount*itId;
 
   const auto &manager = archetypes.getArchetype(archetype).manager;
-  DAECS_EXT_ASSERT(manager.getChunksCount() > chunkId && manager.getChunk(chunkId).getUsed() > idInChunk);
+  DAECS_EXT_ASSERT(manager.getChunksCount() > chunkId && manager.getChunk(chunkId).getUsed() >= idInChunk + count);
 
   DataComponentsManagerAccess::process_eid_components_data(totalComponentsCount,
     const_cast<QueryView::ComponentsData *>(qv.componentData), archDesc.getArchetypeOffsetsPtr() + totalComponentsCount * itId,
     manager.getChunk(chunkId), idInChunk, archComponentsSizeContainers.data() + archEidDesc.componentsSizesAt);
 
   if (trackedChangesCount) // todo:can be also made template. We know for issue our core events do not have RW components
-    schedule_tracked_changes(archDesc.trackedBegin(), trackedChangesCount, eid, archetype);
+    for (const ecs::EntityId *eid = eids, *eidE = eids + count; eid != eidE; ++eid)
+      schedule_tracked_changes(archDesc.trackedBegin(), trackedChangesCount, *eid, archetype);
+}
+
+bool EntityManager::fillEidQueryView(ecs::EntityId eid, EntityDesc entDesc, QueryId h, QueryView &__restrict qv)
+{
+  const archetype_t itId = getEidQueryArchSubQuery(h, entDesc.archetype);
+  if (itId == INVALID_ARCHETYPE)
+    return false;
+  // up to this it is doesEsApplyToArch, and we know for sure for coreevents, that it always passes.
+  // todo: replace core events from fillEidQueryView with fillEidQueryViewArchSubQuery (itId to be part of the list), as unicast events
+  fillEidQueryViewArchSubQuery(eid, entDesc, h, itId, qv);
   return true;
 }
 
@@ -1143,6 +1159,8 @@ void EntityManager::updateAllQueriesInternal()
   TIME_PROFILE_DEV(updateAllQueries);
   DAECS_EXT_ASSERT(allQueriesUpdatedToArch < archetypes.size());
   const bool shouldResolveQueries = lastQueriesResolvedComponents != dataComponents.size();
+  if (shouldResolveQueries) // queries which weren't resolved can now apply to already listed archetypes
+    resetArchetypesEventsES();
   for (int index = 0, e = queriesReferences.size(); index < e; ++index)
   {
     if (queriesReferences[index] && updatePersistentQueryInternal(allQueriesUpdatedToArch, index, shouldResolveQueries))
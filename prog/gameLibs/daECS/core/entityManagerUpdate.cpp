@@ -44,6 +44,13 @@ void EntityManager::update(const ecs::UpdateStageInfo &info)
   DA_PROFILE_EVENT_DESC(dap_stage_tokens[eastl::min(info.stage, (int)US_COUNT)]);
 #endif
   createQueuedEntities(); // if entities were scheduled for creation outside ES
+  if (DAGOR_UNLIKELY(parallelStagesMask & (1u << info.stage)) && !isConstrainedMTMode())
+  {
+    updateParallel(info); // see entityManagerParallel.cpp
+    if (hasQueuedEntitiesCreation())
+      performDelayedCreation(false);
+    return;
+  }
   for (auto esIndex : esUpdates[info.stage])
   {
     const EntitySystemDesc &es = *esList[esIndex];
@@ -350,6 +350,21 @@ void EntityManager::resetEsOrder()
       }
     }
 
+    // keep graph, parallel update stages need to know if ES are ordered
+    esGraphNode.resize(prio.size());
+    for (int i = 0; i < prio.size(); ++i)
+      esGraphNode[i] = prio[i].id < esToGraphNodeMap.size() ? esToGraphNodeMap[prio[i].id] : -1;
+    esGraphEdgesOfs.resize(graphNodesCount + 1);
+    esGraphEdges.clear();
+    for (int n = 0; n < graphNodesCount; ++n)
+    {
+      esGraphEdgesOfs[n] = esGraphEdges.size();
+      if (n < edgesFrom.size())
+        esGraphEdges.insert(esGraphEdges.end(), edgesFrom[n].begin(), edgesFrom[n].end());
+    }
+    esGraphEdgesOfs[graphNodesCount] = esGraphEdges.size();
+    parallelSchedules.clear();
+
     if (mask) // total amount of stages
       esUpdates.resize(__bsr(mask) + 1);
     // todo: match with existent
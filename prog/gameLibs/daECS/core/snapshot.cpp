@@ -0,0 +1,598 @@
+#include <daECS/core/entityManager.h>
+#include <daECS/core/baseIo.h>
+#include <memory/dag_framemem.h>
+#include <perfMon/dag_statDrv.h>
+#include "ecsInternal.h"
+#include "ecsQueryInternal.h"
+
+// Snapshot layout (all in native byte order, it is not meant to be moved between platforms):
+//   SnapshotHeader
+//   EntityDesc[entitiesCount], entity_id_t[freeCount], entity_id_t[freeReservedCount], SnapshotSingleton[singletonsCount]
+//   templatesCount times: template_t saved id, uint16_t name length (with zero), name
+//   archetypesCount times: SnapshotArchetype, SnapshotComponent[componentsCount], uint32_t used[chunksCount], columns
+// Pod column is values of all entities of archetype in chunks order (so restore is one memcpy per destination chunk),
+// IO column is uint32_t size and bit stream of component serializer, other columns are not stored and are recreated on restore.
+
+namespace ecs
+{
+
+static constexpr uint32_t SNAPSHOT_MAGIC = _MAKE4C('ECSS');
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+static constexpr uint32_t SNAPSHOT_ALIGN = 4; // every part of variable size is padded
+
+enum SnapshotColumn : uint16_t
+{
+  SNAPSHOT_COLUMN_POD,      // memcpy of data (pod components and shadow copies of tracked pods)
+  SNAPSHOT_COLUMN_IO,       // non trivial component with io
+  SNAPSHOT_COLUMN_TEMPLATE, // non trivial component without io, copied from template or created
+  SNAPSHOT_COLUMN_COPY      // shadow copy of tracked non trivial component, copied from restored component
+};
+
+struct SnapshotHeader
+{
+  uint32_t magic, version;
+  uint32_t entitiesCount, freeCount, freeReservedCount, singletonsCount;
+  uint32_t templatesCount, templatesTotal, archetypesCount, archetypesTotal;
+  uint32_t nextResevedEidIndex;
+  uint8_t globalGen, _resv[3];
+};
+
+struct SnapshotSingleton
+{
+  hash_str_t hash;
+  entity_id_t eid;
+};
+
+struct SnapshotArchetype
+{
+  uint32_t entitiesCount;
+  archetype_t archetype; // in saved world
+  template_t templ;      // any template of archetype in saved world
+  uint16_t componentsCount, chunksCount;
+};
+
+struct SnapshotComponent
+{
+  component_t name;
+  uint16_t size;
+  uint16_t column; // SnapshotColumn
+};
+
+class SnapshotSerializer final : public SerializerCb
+{
+public:
+  SnapshotSerializer(dag::Vector<uint8_t> &out_) : out(out_) {}
+  void write(const void *data, size_t sz_in_bits, component_type_t) override
+  {
+    const uint8_t *src = (const uint8_t *)data;
+    if (!(bitPos & 7) && !(sz_in_bits & 7))
+    {
+      const size_t at = out.size();
+      out.resize_noinit(at + (sz_in_bits >> 3));
+      memcpy(out.data() + at, src, sz_in_bits >> 3);
+      bitPos += sz_in_bits;
+      return;
+    }
+    for (size_t i = 0; i < sz_in_bits; ++i, ++bitPos)
+    {
+      if (!(bitPos & 7))
+        out.push_back(0);
+      if (src[i >> 3] & (1 << (i & 7)))
+        out.back() |= uint8_t(1 << (bitPos & 7));
+    }
+  }
+
+private:
+  dag::Vector<uint8_t> &out;
+  size_t bitPos = 0;
+};
+
+class SnapshotDeserializer final : public DeserializerCb
+{
+public:
+  SnapshotDeserializer(const uint8_t *data_, uint32_t size) : data(data_), sizeInBits(size_t(size) << 3) {}
+  bool read(void *to, size_t sz_in_bits, component_type_t) const override
+  {
+    if (bitPos + sz_in_bits > sizeInBits)
+      return false;
+    uint8_t *dst = (uint8_t *)to;
+    if (!(bitPos & 7) && !(sz_in_bits & 7))
+    {
+      memcpy(dst, data + (bitPos >> 3), sz_in_bits >> 3);
+      bitPos += sz_in_bits;
+      return true;
+    }
+    for (size_t i = 0; i < sz_in_bits; ++i, ++bitPos)
+    {
+      const uint8_t mask = uint8_t(1 << (i & 7));
+      if (data[bitPos >> 3] & (1 << (bitPos & 7)))
+        dst[i >> 3] |= mask;
+      else
+        dst[i >> 3] &= ~mask;
+    }
+    return true;
+  }
+
+private:
+  const uint8_t *data;
+  size_t sizeInBits;
+  mutable size_t bitPos = 0;
+};
+
+struct SnapshotReader
+{
+  const uint8_t *at, *end;
+  template <typename T>
+  const T *take(uint32_t cnt)
+  {
+    const size_t sz = size_t(cnt) * sizeof(T);
+    if (size_t(end - at) < sz)
+    {
+      at = end;
+      failed = true;
+      return nullptr;
+    }
+    const T *ret = (const T *)at;
+    at += sz;
+    return ret;
+  }
+  void align(const uint8_t *base) { take<uint8_t>(uint32_t(-intptr_t(at - base) & (SNAPSHOT_ALIGN - 1))); }
+  bool failed = false;
+};
+
+template <typename T>
+static T *snapshot_append(dag::Vector<uint8_t> &out, uint32_t cnt)
+{
+  const size_t at = out.size();
+  out.resize_noinit(at + size_t(cnt) * sizeof(T));
+  return (T *)(out.data() + at);
+}
+
+static void snapshot_align(dag::Vector<uint8_t> &out) { out.resize(out.size() + (-out.size() & (SNAPSHOT_ALIGN - 1)), 0); }
+
+template <typename T>
+static void snapshot_write(dag::Vector<uint8_t> &out, const T *data, uint32_t cnt)
+{
+  if (cnt)
+    memcpy(snapshot_append<T>(out, cnt), data, size_t(cnt) * sizeof(T));
+}
+
+static ComponentSerializer *get_snapshot_io(const DataComponents &data_components, const ComponentTypes &component_types,
+  component_index_t cidx, type_index_t type_index)
+{
+  if (ComponentSerializer *io = data_components.getComponentIO(cidx))
+    return io;
+  return has_io(component_types.getTypeInfo(type_index).flags) ? component_types.getTypeIO(type_index) : nullptr;
+}
+
+template <typename Creatables>
+static void get_snapshot_columns(const Creatables &creatables, const Creatables &creatable_trackeds,
+  const DataComponents &data_components, const ComponentTypes &component_types, uint32_t components_count, uint16_t *columns)
+{
+  memset(columns, 0, components_count * sizeof(*columns)); // SNAPSHOT_COLUMN_POD
+  for (auto &c : creatables)
+    columns[c.archComponentId] =
+      get_snapshot_io(data_components, component_types, c.originalCidx, c.typeIndex) ? SNAPSHOT_COLUMN_IO : SNAPSHOT_COLUMN_TEMPLATE;
+  for (auto &c : creatable_trackeds)
+    columns[c.archComponentId] = SNAPSHOT_COLUMN_COPY;
+}
+
+bool EntityManager::saveSnapshot(dag::Vector<uint8_t> &out) const
+{
+  G_ASSERT_RETURN(!isConstrainedMTMode(), false);
+  TIME_PROFILE(ecs_save_snapshot);
+  out.clear();
+
+  SnapshotHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = SNAPSHOT_MAGIC;
+  hdr.version = SNAPSHOT_VERSION;
+  hdr.entitiesCount = entDescs.allocated_size();
+  hdr.templatesTotal = templates.size();
+  hdr.archetypesTotal = archetypes.size();
+  hdr.nextResevedEidIndex = nextResevedEidIndex;
+  hdr.globalGen = entDescs.globalGen;
+  snapshot_write(out, &hdr, 1);
+
+  // entities which are not created yet are saved as destroyed
+  FRAMEMEM_REGION;
+  dag::Vector<entity_id_t, framemem_allocator> notCreated, notCreatedReserved;
+  eastl::bitvector<framemem_allocator> templUsed(templates.size(), false);
+  dag::Vector<template_t, framemem_allocator> archTemplate(archetypes.size(), INVALID_TEMPLATE_INDEX);
+  size_t reserveSize = out.size() + hdr.entitiesCount * sizeof(EntityDesc);
+  for (uint32_t a = 0, ae = archetypes.size(); a < ae; ++a)
+    reserveSize += archetypes.getArchetype(a).manager.getTotalEntities() * archetypes.getArchetypeSize(a);
+  out.reserve(reserveSize);
+  snapshot_write(out, entDescs.entDescs.data(), hdr.entitiesCount);
+  EntityDesc *descs = (EntityDesc *)(out.data() + sizeof(SnapshotHeader)); // valid until out grows
+  for (uint32_t i = 1; i < hdr.entitiesCount; ++i)                        // zero index is INVALID_ENTITY_ID
+  {
+    EntityDesc &desc = descs[i];
+    if (desc.archetype != INVALID_ARCHETYPE)
+    {
+      templUsed.set(desc.template_id, true);
+      archTemplate[desc.archetype] = desc.template_id;
+    }
+    else if (entDescs.isCurrentlyCreating(i))
+    {
+      if (i > MAX_RESERVED_EID_IDX_CONST)
+        notCreated.push_back(make_eid(i, desc.generation));
+      else if (i < nextResevedEidIndex)
+        notCreatedReserved.push_back(make_eid(i, desc.generation));
+      desc.generation++;
+      desc.reset();
+    }
+  }
+
+  auto writeFreeList = [&](const eastl::deque<entity_id_t> &list, const dag::Vector<entity_id_t, framemem_allocator> &extra) {
+    entity_id_t *dst = snapshot_append<entity_id_t>(out, uint32_t(list.size() + extra.size()));
+    dst = eastl::copy(list.begin(), list.end(), dst);
+    eastl::copy(extra.begin(), extra.end(), dst);
+    return uint32_t(list.size() + extra.size());
+  };
+  const uint32_t freeCount = writeFreeList(freeIndices, notCreated);
+  const uint32_t freeReservedCount = writeFreeList(freeIndicesReserved, notCreatedReserved);
+  for (auto &s : singletonEntities)
+  {
+    SnapshotSingleton singleton{s.first, (entity_id_t)s.second};
+    snapshot_write(out, &singleton, 1);
+  }
+
+  uint32_t templatesCount = 0;
+  for (uint32_t t = 0; t < hdr.templatesTotal; ++t)
+  {
+    if (!templUsed.test(t, false))
+      continue;
+    const char *name = getTemplateName(t);
+    const uint16_t len = uint16_t(strlen(name) + 1);
+    const template_t id = t;
+    snapshot_write(out, &id, 1);
+    snapshot_write(out, &len, 1);
+    snapshot_write(out, name, len);
+    snapshot_align(out);
+    templatesCount++;
+  }
+
+  uint32_t archetypesCount = 0;
+  dag::Vector<uint16_t, framemem_allocator> columns;
+  for (uint32_t a = 0, ae = archetypes.size(); a < ae; ++a)
+  {
+    const DataComponentManager &manager = archetypes.getArchetype(a).manager;
+    if (!manager.getTotalEntities())
+      continue;
+    G_ASSERT_CONTINUE(archTemplate[a] != INVALID_TEMPLATE_INDEX);
+    const uint32_t componentsCount = archetypes.getComponentsCount(a);
+    auto chunks = manager.getChunksConst();
+    SnapshotArchetype arch{manager.getTotalEntities(), archetype_t(a), archTemplate[a], uint16_t(componentsCount),
+      uint16_t(chunks.size())};
+    snapshot_write(out, &arch, 1);
+
+    columns.resize(componentsCount);
+    get_snapshot_columns(archetypes.getCreatables(a), archetypes.getCreatableTrackeds(a), dataComponents, componentTypes,
+      componentsCount, columns.data());
+    const component_index_t *cidx = archetypes.componentIndices(a);
+    const uint16_t *sizes = archetypes.componentDataSizes(a), *offsets = archetypes.componentDataOffsets(a);
+    SnapshotComponent *comps = snapshot_append<SnapshotComponent>(out, componentsCount);
+    for (uint32_t i = 0; i < componentsCount; ++i)
+      comps[i] = SnapshotComponent{dataComponents.getComponentTpById(cidx[i]), sizes[i], columns[i]};
+    uint32_t *used = snapshot_append<uint32_t>(out, arch.chunksCount);
+    for (auto &chunk : chunks)
+      *(used++) = chunk.getUsed();
+
+    for (uint32_t i = 0; i < componentsCount; ++i)
+    {
+      if (columns[i] == SNAPSHOT_COLUMN_POD)
+      {
+        uint8_t *dst = snapshot_append<uint8_t>(out, arch.entitiesCount * sizes[i]);
+        for (auto &chunk : chunks)
+          if (const uint32_t cnt = chunk.getUsed())
+          {
+            memcpy(dst, chunk.getCompDataUnsafe(offsets[i]), cnt * sizes[i]);
+            dst += cnt * sizes[i];
+          }
+        snapshot_align(out);
+      }
+      else if (columns[i] == SNAPSHOT_COLUMN_IO)
+      {
+        const type_index_t typeIndex = dataComponents.getComponentById(cidx[i]).componentType;
+        const component_type_t typeName = dataComponents.getComponentById(cidx[i]).componentTypeName;
+        const ComponentType typeInfo = componentTypes.getTypeInfo(typeIndex);
+        const bool isBoxed = (typeInfo.flags & COMPONENT_TYPE_BOXED) != 0;
+        ComponentSerializer *io = get_snapshot_io(dataComponents, componentTypes, cidx[i], typeIndex);
+        const size_t sizeAt = out.size();
+        snapshot_append<uint32_t>(out, 1);
+        SnapshotSerializer serializer(out);
+        for (auto &chunk : chunks)
+        {
+          const uint8_t *data = chunk.getCompDataUnsafe(offsets[i]);
+          for (uint32_t id = 0, ide = chunk.getUsed(); id < ide; ++id, data += sizes[i])
+            io->serialize(serializer, isBoxed ? *(void *const *)data : data, typeInfo.size, typeName);
+        }
+        const uint32_t streamSize = uint32_t(out.size() - sizeAt - sizeof(uint32_t));
+        memcpy(out.data() + sizeAt, &streamSize, sizeof(streamSize));
+        snapshot_align(out);
+      }
+    }
+    archetypesCount++;
+  }
+
+  SnapshotHeader *outHdr = (SnapshotHeader *)out.data();
+  outHdr->freeCount = freeCount;
+  outHdr->freeReservedCount = freeReservedCount;
+  outHdr->singletonsCount = uint32_t(singletonEntities.size());
+  outHdr->templatesCount = templatesCount;
+  outHdr->archetypesCount = archetypesCount;
+  if (!notCreated.empty() || !notCreatedReserved.empty())
+    logwarn("ecs snapshot: %d entities are not created yet and saved as destroyed",
+      int(notCreated.size() + notCreatedReserved.size()));
+  return true;
+}
+
+bool EntityManager::restoreSnapshot(dag::ConstSpan<uint8_t> data)
+{
+  G_ASSERT_RETURN(!isConstrainedMTMode() && nestedQuery == 0, false);
+  TIME_PROFILE(ecs_restore_snapshot);
+  SnapshotReader rd{data.data(), data.data() + data.size()};
+  const SnapshotHeader *hdr = rd.take<SnapshotHeader>(1);
+  if (!hdr || hdr->magic != SNAPSHOT_MAGIC || hdr->version != SNAPSHOT_VERSION)
+  {
+    logerr("ecs snapshot: invalid header");
+    return false;
+  }
+  const EntityDesc *descs = rd.take<EntityDesc>(hdr->entitiesCount);
+  const entity_id_t *freeList = rd.take<entity_id_t>(hdr->freeCount);
+  const entity_id_t *freeReservedList = rd.take<entity_id_t>(hdr->freeReservedCount);
+  const SnapshotSingleton *singletons = rd.take<SnapshotSingleton>(hdr->singletonsCount);
+
+  // everything is validated before current entities are destroyed
+  FRAMEMEM_REGION;
+  dag::Vector<template_t, framemem_allocator> remapTemplates(hdr->templatesTotal, INVALID_TEMPLATE_INDEX);
+  for (uint32_t i = 0; i < hdr->templatesCount && !rd.failed; ++i)
+  {
+    const template_t *id = rd.take<template_t>(1);
+    const uint16_t *len = rd.take<uint16_t>(1);
+    const char *name = rd.failed ? nullptr : rd.take<char>(*len);
+    if (!name || !*len || name[*len - 1] || *id >= hdr->templatesTotal)
+    {
+      rd.failed = true;
+      break;
+    }
+    rd.align(data.data());
+    remapTemplates[*id] = templateByName(name, hasSingletoneEntity(name));
+    if (remapTemplates[*id] == INVALID_TEMPLATE_INDEX)
+    {
+      logerr("ecs snapshot: can't instantiate template <%s>", name);
+      return false;
+    }
+  }
+
+  struct ArchetypeBlock
+  {
+    const SnapshotArchetype *arch;
+    uint32_t firstChunk, firstColumn; // in chunkStart and columnData
+    archetype_t archetype;
+  };
+  dag::Vector<ArchetypeBlock, framemem_allocator> blocks;
+  dag::Vector<uint32_t, framemem_allocator> chunkStart; // first row of saved chunk
+  dag::Vector<const uint8_t *, framemem_allocator> columnData;
+  dag::Vector<uint32_t, framemem_allocator> columnSize;
+  dag::Vector<uint16_t, framemem_allocator> archBlock(hdr->archetypesTotal, uint16_t(~0u)), columns;
+  dag::Vector<uint16_t, framemem_allocator> dstBlock(archetypes.size(), uint16_t(~0u)); // all templates are instantiated already
+  blocks.reserve(hdr->archetypesCount);
+  for (uint32_t b = 0; b < hdr->archetypesCount && !rd.failed; ++b)
+  {
+    const SnapshotArchetype *arch = rd.take<SnapshotArchetype>(1);
+    const SnapshotComponent *comps = rd.failed ? nullptr : rd.take<SnapshotComponent>(arch->componentsCount);
+    const uint32_t *used = rd.failed ? nullptr : rd.take<uint32_t>(arch->chunksCount);
+    if (rd.failed || arch->archetype >= hdr->archetypesTotal || arch->templ >= hdr->templatesTotal ||
+        remapTemplates[arch->templ] == INVALID_TEMPLATE_INDEX)
+    {
+      rd.failed = true;
+      break;
+    }
+    const archetype_t dstArch = templates.getTemplate(remapTemplates[arch->templ]).archetype;
+    const uint32_t componentsCount = archetypes.getComponentsCount(dstArch);
+    bool match = componentsCount == arch->componentsCount && dstBlock[dstArch] == uint16_t(~0u);
+    if (match)
+    {
+      columns.resize(componentsCount);
+      get_snapshot_columns(archetypes.getCreatables(dstArch), archetypes.getCreatableTrackeds(dstArch), dataComponents,
+        componentTypes, componentsCount, columns.data());
+      const component_index_t *cidx = archetypes.componentIndices(dstArch);
+      const uint16_t *sizes = archetypes.componentDataSizes(dstArch);
+      for (uint32_t i = 0; i < componentsCount && match; ++i)
+        match = comps[i].name == dataComponents.getComponentTpById(cidx[i]) && comps[i].size == sizes[i] &&
+                comps[i].column == columns[i];
+    }
+    if (!match)
+    {
+      logerr("ecs snapshot: components of template <%s> differ from saved ones", getTemplateName(remapTemplates[arch->templ]));
+      return false;
+    }
+
+    archBlock[arch->archetype] = dstBlock[dstArch] = uint16_t(blocks.size());
+    blocks.push_back(ArchetypeBlock{arch, uint32_t(chunkStart.size()), uint32_t(columnData.size()), dstArch});
+    uint32_t rows = 0;
+    for (uint32_t c = 0; c < arch->chunksCount; ++c)
+    {
+      chunkStart.push_back(rows);
+      rows += used[c];
+    }
+    if (rows != arch->entitiesCount || rows > (MAX_CHUNKS_COUNT << DataComponentManager::MAX_CAPACITY_BITS))
+      rd.failed = true;
+    for (uint32_t i = 0; i < arch->componentsCount && !rd.failed; ++i)
+    {
+      const uint32_t *streamSize = comps[i].column == SNAPSHOT_COLUMN_IO ? rd.take<uint32_t>(1) : nullptr;
+      const uint32_t size =
+        comps[i].column == SNAPSHOT_COLUMN_POD ? arch->entitiesCount * comps[i].size : (streamSize ? *streamSize : 0);
+      columnData.push_back(rd.take<uint8_t>(size));
+      columnSize.push_back(size);
+      rd.align(data.data());
+    }
+  }
+  for (uint32_t i = 1; i < hdr->entitiesCount && !rd.failed; ++i)
+  {
+    const EntityDesc &desc = descs[i];
+    if (desc.archetype == INVALID_ARCHETYPE)
+      continue;
+    if (desc.archetype >= hdr->archetypesTotal || archBlock[desc.archetype] >= blocks.size() ||
+        desc.template_id >= hdr->templatesTotal || remapTemplates[desc.template_id] == INVALID_TEMPLATE_INDEX)
+    {
+      rd.failed = true;
+      break;
+    }
+    const ArchetypeBlock &block = blocks[archBlock[desc.archetype]];
+    const uint32_t *used = (const uint32_t *)((const SnapshotComponent *)(block.arch + 1) + block.arch->componentsCount);
+    if (desc.chunkId >= block.arch->chunksCount || desc.idInChunk >= used[desc.chunkId] ||
+        templates.getTemplate(remapTemplates[desc.template_id]).archetype != block.archetype)
+      rd.failed = true;
+  }
+  if (rd.failed)
+  {
+    logerr("ecs snapshot: data is corrupted");
+    return false;
+  }
+
+  // destroy current entities without any events
+  clearCreationQueue();
+  loadingEntities.clear();
+  for (auto &e : eventsForLoadingEntities)
+    destroyEvents(e.events);
+  eventsForLoadingEntities.clear();
+  eidTrackingQueue.clear();
+  archetypeTrackingQueue.clear();
+  for (uint32_t a = 0, ae = archetypes.size(); a < ae; ++a)
+  {
+    Archetype &arch = archetypes.getArchetype(a);
+    if (!arch.manager.getTotalEntities())
+      continue;
+    if (archetypes.getArchetypeCombinedTypeFlags(a) & COMPONENT_TYPE_NON_TRIVIAL_CREATE)
+      for (uint32_t c = 0, ce = arch.manager.getChunksCount(); c < ce; ++c)
+        for (uint32_t id = 0, ide = arch.manager.getChunkUsed(c); id < ide; ++id)
+          destroyComponents(a, c, id, [](int, component_index_t) { return false; });
+  }
+  for (uint32_t a = 0, ae = archetypes.size(); a < ae; ++a)
+  {
+    Archetype &arch = archetypes.getArchetype(a);
+    if (arch.manager.getTotalEntities() || dstBlock[a] < blocks.size())
+      arch.manager.resetToUsed(arch.entitySize, dstBlock[a] < blocks.size() ? blocks[dstBlock[a]].arch->entitiesCount : 0);
+  }
+
+  // pod columns
+  for (ArchetypeBlock &block : blocks)
+  {
+    const SnapshotComponent *comps = (const SnapshotComponent *)(block.arch + 1);
+    const DataComponentManager &manager = archetypes.getArchetype(block.archetype).manager;
+    const uint16_t *offsets = archetypes.componentDataOffsets(block.archetype);
+    for (uint32_t i = 0; i < block.arch->componentsCount; ++i)
+      if (comps[i].column == SNAPSHOT_COLUMN_POD)
+      {
+        const uint8_t *src = columnData[block.firstColumn + i];
+        for (auto &chunk : manager.getChunksConst())
+        {
+          memcpy(chunk.getCompDataUnsafe(offsets[i]), src, chunk.getUsed() * comps[i].size);
+          src += chunk.getUsed() * comps[i].size;
+        }
+      }
+  }
+
+  // entities, with chunks and ids of destination chunks
+  entDescs.globalGen = hdr->globalGen;
+  entDescs.resize(hdr->entitiesCount);
+  for (uint32_t i = 0; i < hdr->entitiesCount; ++i)
+  {
+    const EntityDesc &desc = descs[i];
+    EntityDesc &dst = entDescs[i];
+    dst.generation = desc.generation;
+    if (desc.archetype == INVALID_ARCHETYPE)
+      continue;
+    const ArchetypeBlock &block = blocks[archBlock[desc.archetype]];
+    const uint32_t row = chunkStart[block.firstChunk + desc.chunkId] + desc.idInChunk;
+    dst.archetype = block.archetype;
+    dst.template_id = remapTemplates[desc.template_id];
+    dst.chunkId = chunk_type_t(row >> DataComponentManager::MAX_CAPACITY_BITS);
+    dst.idInChunk = id_in_chunk_type_t(row & (DataComponentManager::MAX_CAPACITY - 1));
+  }
+  freeIndices.assign(freeList, freeList + hdr->freeCount);
+  freeIndicesReserved.assign(freeReservedList, freeReservedList + hdr->freeReservedCount);
+  nextResevedEidIndex = hdr->nextResevedEidIndex;
+  singletonEntities.clear();
+  for (uint32_t i = 0; i < hdr->singletonsCount; ++i)
+    singletonEntities[singletons[i].hash] = EntityId(singletons[i].eid);
+
+  // non trivial components, in same order as on creation
+  ComponentsMap emptyMap;
+  uint32_t failedIO = 0;
+#if DAECS_EXTENSIVE_CHECKS
+  CreatingEntity oldCreatingTop = creatingEntityTop;
+#endif
+  for (ArchetypeBlock &block : blocks)
+  {
+    const archetype_t a = block.archetype;
+    if (!(archetypes.getArchetypeCombinedTypeFlags(a) & COMPONENT_TYPE_NON_TRIVIAL_CREATE))
+      continue;
+    const SnapshotComponent *comps = (const SnapshotComponent *)(block.arch + 1);
+    const DataComponentManager &manager = archetypes.getArchetype(a).manager;
+    const uint16_t eidOfs = archetypes.componentDataOffsets(a)[0];
+    for (auto &component : archetypes.getCreatables(a))
+    {
+      ComponentTypeManager *typeManager = componentTypes.getTypeManager(component.typeIndex);
+      const ComponentType typeInfo = componentTypes.getTypeInfo(component.typeIndex);
+      const bool isBoxed = (typeInfo.flags & COMPONENT_TYPE_BOXED) != 0;
+      const uint32_t column = block.firstColumn + component.archComponentId;
+      ComponentSerializer *io = comps[component.archComponentId].column == SNAPSHOT_COLUMN_IO
+                                  ? get_snapshot_io(dataComponents, componentTypes, component.originalCidx, component.typeIndex)
+                                  : nullptr;
+      const component_type_t typeName = dataComponents.getComponentById(component.originalCidx).componentTypeName;
+      SnapshotDeserializer deserializer(columnData[column], columnSize[column]);
+      for (auto &chunk : manager.getChunksConst())
+      {
+        const EntityId *eids = (const EntityId *)chunk.getCompDataUnsafe(eidOfs);
+        uint8_t *cData = chunk.getCompDataUnsafe(component.dataOffset);
+        for (uint32_t id = 0, ide = chunk.getUsed(); id < ide; ++id, cData += component.size)
+        {
+          const EntityId eid = eids[id];
+          const InstantiatedTemplate &templ = templates.getTemplate(entDescs[eid.index()].template_id);
+#if DAECS_EXTENSIVE_CHECKS
+          creatingEntityTop = CreatingEntity{eid, component.originalCidx};
+#endif
+          if (!InstantiatedTemplate::isInited(templ.hasData.get(), component.archComponentId) ||
+              !typeManager->copy(cData, templ.initialData.get() + component.trackedFromOfs, component.originalCidx, eid))
+            typeManager->create(cData, *this, eid, emptyMap, component.originalCidx);
+          if (io && !io->deserialize(deserializer, isBoxed ? *(void **)cData : cData, typeInfo.size, typeName))
+            failedIO++;
+        }
+      }
+    }
+    for (auto &component : archetypes.getCreatableTrackeds(a))
+    {
+      ComponentTypeManager *typeManager = componentTypes.getTypeManager(component.typeIndex);
+      for (auto &chunk : manager.getChunksConst())
+      {
+        const EntityId *eids = (const EntityId *)chunk.getCompDataUnsafe(eidOfs);
+        uint8_t *copyData = chunk.getCompDataUnsafe(component.dataOffset);
+        const uint8_t *fromData = chunk.getCompDataUnsafe(component.trackedFromOfs);
+        for (uint32_t id = 0, ide = chunk.getUsed(); id < ide; ++id, copyData += component.size, fromData += component.size)
+        {
+#if DAECS_EXTENSIVE_CHECKS
+          creatingEntityTop = CreatingEntity{eids[id], component.originalCidx};
+#endif
+          if (!typeManager->copy(copyData, fromData, component.originalCidx, eids[id]))
+          {
+            typeManager->create(copyData, *this, eids[id], emptyMap, component.originalCidx);
+            if (!typeManager->assign(copyData, fromData))
+              typeManager->replicateCompare(copyData, fromData);
+          }
+        }
+      }
+    }
+  }
+#if DAECS_EXTENSIVE_CHECKS
+  creatingEntityTop = oldCreatingTop;
+#endif
+  if (failedIO)
+    logerr("ecs snapshot: %d components failed to deserialize, left as in template", failedIO);
+  return true;
+}
+
+} // namespace ecs
@@ -25,6 +25,9 @@
 
 #include <ioSys/dag_dataBlock.h>
 #include <ecs/io/blk.h>
+#include <dag/dag_vector.h>
+#include <util/dag_string.h>
+#include <util/dag_stlqsort.h>
 
 #include <daScript/misc/platform.h>
 #include <daScript/daScriptModule.h>
@@ -88,14 +91,453 @@ static void my_fatal_handler(const char *title, const char *msg, const char *cal
   exit(1);
 }
 
-static int log_callback(int lev_tag, const char * /*fmt*/, const void * /*arg*/, int /*anum*/, const char * /*ctx_file*/,
+static int parallel_conflicts_reported = 0;
+static bool parallel_conflicts_expected = false;
+static int log_callback(int lev_tag, const char *fmt, const void * /*arg*/, int /*anum*/, const char * /*ctx_file*/,
   int /*ctx_line*/)
 {
-  if (lev_tag == LOGLEVEL_ERR || lev_tag == LOGLEVEL_FATAL)
+  if (parallel_conflicts_expected && lev_tag == LOGLEVEL_ERR && fmt && strstr(fmt, "not declared as RW"))
+    parallel_conflicts_reported++;
+  else if (lev_tag == LOGLEVEL_ERR || lev_tag == LOGLEVEL_FATAL)
     had_errors = true;
   return 1;
 }
 
+// creates 100k entities (pod components, and string component with io for each SNAPSHOT_NAMED_EVERY entity), saves world
+// snapshot, destroys half of them and changes the rest, restores snapshot and checks that everything is as it was saved
+static void snapshot_benchmark()
+{
+  static constexpr int SNAPSHOT_ENTITIES = 100000, SNAPSHOT_NAMED_EVERY = 100;
+  dag::Vector<ecs::EntityId> eids;
+  eids.reserve(SNAPSHOT_ENTITIES);
+  for (int i = 0; i < SNAPSHOT_ENTITIES; ++i)
+  {
+    ecs::ComponentsInitializer init;
+    init[ECS_HASH("snapshot_pos")] = Point3(i, 0, 0);
+    init[ECS_HASH("snapshot_index")] = i;
+    const bool named = i % SNAPSHOT_NAMED_EVERY == 0;
+    if (named)
+      init[ECS_HASH("snapshot_name")] = ecs::string(String(0, "e%d", i).str());
+    eids.push_back(g_entity_mgr->createEntitySync(named ? "snapshotBenchNamed" : "snapshotBench", eastl::move(init)));
+  }
+
+  dag::Vector<uint8_t> snapshot;
+  int64_t reft = ref_time_ticks();
+  const bool saved = g_entity_mgr->saveSnapshot(snapshot);
+  const int saveUsec = get_time_usec(reft);
+
+  for (int i = 0; i < SNAPSHOT_ENTITIES; ++i)
+  {
+    const ecs::EntityId eid = eids[i];
+    if (i % 2)
+      g_entity_mgr->set(eid, ECS_HASH("snapshot_pos"), Point3(0, 1, 0));
+    else
+      g_entity_mgr->destroyEntity(eid);
+  }
+  g_entity_mgr->tick();
+
+  reft = ref_time_ticks();
+  const bool restored = g_entity_mgr->restoreSnapshot(make_span_const(snapshot));
+  const int restoreUsec = get_time_usec(reft);
+
+  int wrong = 0;
+  for (int i = 0; i < SNAPSHOT_ENTITIES; ++i)
+  {
+    const int *index = g_entity_mgr->getNullable<int>(eids[i], ECS_HASH("snapshot_index"));
+    const Point3 *pos = g_entity_mgr->getNullable<Point3>(eids[i], ECS_HASH("snapshot_pos"));
+    const ecs::string *name = g_entity_mgr->getNullable<ecs::string>(eids[i], ECS_HASH("snapshot_name"));
+    const bool named = i % SNAPSHOT_NAMED_EVERY == 0;
+    if (!index || *index != i || !pos || *pos != Point3(i, 0, 0) || named != (name != nullptr) ||
+        (name && strcmp(name->c_str(), String(0, "e%d", i).str()) != 0))
+      wrong++;
+  }
+  printf("snapshot of %d entities (%d bytes) saved in %d us, restored in %d us, %d entities differ\n", g_entity_mgr->getNumEntities(),
+    (int)snapshot.size(), saveUsec, restoreUsec, wrong);
+  G_ASSERT(saved && restored && wrong == 0);
+
+  for (int i = 0; i < SNAPSHOT_ENTITIES; ++i)
+  {
+    const ecs::EntityId eid = eids[i];
+    g_entity_mgr->destroyEntity(eid);
+  }
+  g_entity_mgr->tick();
+}
+
+ECS_UNICAST_EVENT_TYPE(EventUnicastBench, int)
+ECS_REGISTER_EVENT(EventUnicastBench)
+ECS_UNICAST_BATCHED_EVENT_TYPE(EventUnicastBatchedBench, int)
+ECS_REGISTER_EVENT(EventUnicastBatchedBench)
+
+// 16 ES subscribed to same unicast event, each requires own tag. Bench entities of 4 templates have quarter of tags each
+static constexpr int UNICAST_BENCH_ES = 16, UNICAST_BENCH_TEMPLATES = 4;
+static constexpr int UNICAST_BENCH_APPLIED_ES = UNICAST_BENCH_ES / UNICAST_BENCH_TEMPLATES;
+static constexpr ecs::ComponentDesc unicast_bench_es_comps[] = {
+  {ECS_HASH("unicast_bench_counter"), ecs::ComponentTypeInfo<int>()},
+  {ECS_HASH("unicast_bench_tag0"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag1"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag2"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag3"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag4"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag5"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag6"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag7"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag8"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag9"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag10"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag11"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag12"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag13"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag14"), ecs::ComponentTypeInfo<ecs::Tag>()},
+  {ECS_HASH("unicast_bench_tag15"), ecs::ComponentTypeInfo<ecs::Tag>()},
+};
+static void unicast_bench_es_event_handler(const ecs::Event &__restrict evt, const ecs::QueryView &__restrict components)
+{
+  const int add = evt.is<EventUnicastBench>() ? static_cast<const EventUnicastBench &>(evt).get<0>()
+                                               : static_cast<const EventUnicastBatchedBench &>(evt).get<0>();
+  auto comp = components.begin(), compE = components.end();
+  G_ASSERT(comp != compE);
+  do
+    components.getComponentRW<int>(0, comp) += add;
+  while (++comp != compE);
+}
+#define UNICAST_BENCH_ES_DESC(K)                                                                                                     \
+  static ecs::EntitySystemDesc unicast_bench_es##K##_desc("unicast_bench_es" #K, "prog/gameLibs/daECS/dasEcsUnitTest/unit_test.cpp", \
+    ecs::EntitySystemOps(nullptr, unicast_bench_es_event_handler), make_span(unicast_bench_es_comps + 0, 1) /*rw*/, empty_span(),    \
+    make_span(unicast_bench_es_comps + 1 + K, 1) /*rq*/, empty_span(),                                                               \
+    ecs::EventSetBuilder<EventUnicastBench, EventUnicastBatchedBench>::build(), 0);
+UNICAST_BENCH_ES_DESC(0)
+UNICAST_BENCH_ES_DESC(1)
+UNICAST_BENCH_ES_DESC(2)
+UNICAST_BENCH_ES_DESC(3)
+UNICAST_BENCH_ES_DESC(4)
+UNICAST_BENCH_ES_DESC(5)
+UNICAST_BENCH_ES_DESC(6)
+UNICAST_BENCH_ES_DESC(7)
+UNICAST_BENCH_ES_DESC(8)
+UNICAST_BENCH_ES_DESC(9)
+UNICAST_BENCH_ES_DESC(10)
+UNICAST_BENCH_ES_DESC(11)
+UNICAST_BENCH_ES_DESC(12)
+UNICAST_BENCH_ES_DESC(13)
+UNICAST_BENCH_ES_DESC(14)
+UNICAST_BENCH_ES_DESC(15)
+#undef UNICAST_BENCH_ES_DESC
+
+// sends unicast events to 10k entities of 4 archetypes, each handled by 4 of 16 subscribed ES, and checks that each of them was called
+// (immediate, deferred and deferred batched ones)
+static void unicast_event_benchmark()
+{
+  static constexpr int UNICAST_BENCH_ENTITIES = 10000, UNICAST_BENCH_ROUNDS = 100;
+  static const char *templates[UNICAST_BENCH_TEMPLATES] = {"unicastBench0", "unicastBench1", "unicastBench2", "unicastBench3"};
+  dag::Vector<ecs::EntityId> eids;
+  eids.reserve(UNICAST_BENCH_ENTITIES);
+  for (int i = 0; i < UNICAST_BENCH_ENTITIES; ++i)
+    eids.push_back(g_entity_mgr->createEntitySync(templates[i % UNICAST_BENCH_TEMPLATES]));
+
+  int64_t reft = ref_time_ticks();
+  for (int r = 0; r < UNICAST_BENCH_ROUNDS; ++r)
+    for (ecs::EntityId eid : eids)
+      g_entity_mgr->sendEventImmediate(eid, EventUnicastBench(1));
+  const int usec = max(get_time_usec(reft), 1);
+
+  int wrong = 0;
+  for (ecs::EntityId eid : eids)
+    if (g_entity_mgr->getOr(eid, ECS_HASH("unicast_bench_counter"), 0) != UNICAST_BENCH_ROUNDS * UNICAST_BENCH_APPLIED_ES)
+      wrong++;
+  const int events = UNICAST_BENCH_ENTITIES * UNICAST_BENCH_ROUNDS;
+  printf("%d unicast events sent in %d us (%.2f M events/s, %d of %d ES each), %d entities missed events\n", events, usec,
+    double(events) / usec, UNICAST_BENCH_APPLIED_ES, UNICAST_BENCH_ES, wrong);
+  G_ASSERT(wrong == 0);
+
+  // same events, deferred to entities in random order and drained once per round, as is and batched by archetype
+  uint32_t seed = 12345;
+  for (int i = UNICAST_BENCH_ENTITIES - 1; i > 0; --i)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    eastl::swap(eids[i], eids[(seed >> 8) % (i + 1)]);
+  }
+  int deferredUsec[2];
+  for (int batched = 0; batched < 2; ++batched)
+  {
+    reft = ref_time_ticks();
+    for (int r = 0; r < UNICAST_BENCH_ROUNDS; ++r)
+    {
+      for (ecs::EntityId eid : eids)
+        if (batched)
+          g_entity_mgr->sendEvent(eid, EventUnicastBatchedBench(1));
+        else
+          g_entity_mgr->sendEvent(eid, EventUnicastBench(1));
+      g_entity_mgr->flushDeferredEvents();
+    }
+    deferredUsec[batched] = max(get_time_usec(reft), 1);
+  }
+  wrong = 0;
+  for (ecs::EntityId eid : eids)
+    if (g_entity_mgr->getOr(eid, ECS_HASH("unicast_bench_counter"), 0) != 3 * UNICAST_BENCH_ROUNDS * UNICAST_BENCH_APPLIED_ES)
+      wrong++;
+  printf("%d deferred unicast events sent in %d us, batched in %d us (%.2fx), %d entities missed events\n", events,
+    deferredUsec[0], deferredUsec[1], double(deferredUsec[0]) / deferredUsec[1], wrong);
+  G_ASSERT(wrong == 0);
+
+  for (ecs::EntityId eid : eids)
+    g_entity_mgr->destroyEntity(eid);
+  g_entity_mgr->tick();
+}
+
+// batched and plain deferred events with same ES. Action is done by first ES, when it gets event to single entity
+ECS_UNICAST_BATCHED_EVENT_TYPE(EventBatchedTest, int /*payload*/, int /*action*/)
+ECS_REGISTER_EVENT(EventBatchedTest)
+ECS_UNICAST_EVENT_TYPE(EventBatchedTestRef, int /*payload*/, int /*action*/)
+ECS_REGISTER_EVENT(EventBatchedTestRef)
+
+enum BatchedTestAction
+{
+  BATCHED_TEST_NONE,
+  BATCHED_TEST_DESTROY,       // destroys entity right away, last entity of chunk is moved to its place
+  BATCHED_TEST_RECREATE,      // re-creates entity with template which has tag of third ES
+  BATCHED_TEST_NEW_COMPONENT, // creates entity with component not known before, which resets ES lists of archetypes
+};
+struct BatchedTestCall
+{
+  int es, index, order, payload;
+};
+static dag::Vector<BatchedTestCall> batched_test_calls;
+static const char *batched_test_new_component_templ = nullptr;
+static constexpr ecs::ComponentDesc batched_test_es_comps[] = {
+  {ECS_HASH("batched_test_index"), ecs::ComponentTypeInfo<int>()},
+  {ECS_HASH("eid"), ecs::ComponentTypeInfo<ecs::EntityId>()},
+  {ECS_HASH("batched_test_tag"), ecs::ComponentTypeInfo<ecs::Tag>()},
+};
+template <int ES>
+static void batched_test_es_event_handler(const ecs::Event &__restrict evt, const ecs::QueryView &__restrict components)
+{
+  const bool batched = evt.is<EventBatchedTest>();
+  const int payload =
+    batched ? static_cast<const EventBatchedTest &>(evt).get<0>() : static_cast<const EventBatchedTestRef &>(evt).get<0>();
+  const int action =
+    batched ? static_cast<const EventBatchedTest &>(evt).get<1>() : static_cast<const EventBatchedTestRef &>(evt).get<1>();
+  auto comp = components.begin(), compE = components.end();
+  G_ASSERT(comp != compE);
+  do
+    batched_test_calls.push_back(
+      BatchedTestCall{ES, components.getComponentRO<int>(0, comp), (int)batched_test_calls.size(), payload});
+  while (++comp != compE);
+  if (ES != 0 || action == BATCHED_TEST_NONE || compE - components.begin() != 1)
+    return;
+  const ecs::EntityId eid = components.getComponentRO<ecs::EntityId>(1, components.begin());
+  if (action == BATCHED_TEST_DESTROY)
+    g_entity_mgr->destroyEntity(eid);
+  else if (action == BATCHED_TEST_RECREATE)
+    g_entity_mgr->reCreateEntityFromAsync(eid, "batchedTestRecreated");
+  else if (action == BATCHED_TEST_NEW_COMPONENT)
+    g_entity_mgr->createEntitySync(batched_test_new_component_templ);
+  g_entity_mgr->performDelayedCreation(false);
+}
+#define BATCHED_TEST_ES_DESC(K, rq_cnt)                                                                                            \
+  static ecs::EntitySystemDesc batched_test_es##K##_desc("batched_test_es" #K, "prog/gameLibs/daECS/dasEcsUnitTest/unit_test.cpp", \
+    ecs::EntitySystemOps(nullptr, batched_test_es_event_handler<K>), empty_span(), make_span(batched_test_es_comps + 0, 2) /*ro*/, \
+    make_span(batched_test_es_comps + 2, rq_cnt) /*rq*/, empty_span(),                                                             \
+    ecs::EventSetBuilder<EventBatchedTest, EventBatchedTestRef>::build(), 0);
+BATCHED_TEST_ES_DESC(0, 0)
+BATCHED_TEST_ES_DESC(1, 0)
+BATCHED_TEST_ES_DESC(2, 1)
+#undef BATCHED_TEST_ES_DESC
+
+// sends same deferred events, batched or not, to entities of two archetypes: identical events to neighbour entities in chunk,
+// distinct ones in random order and ones which make first ES destroy or re-create entity, or reset ES lists while bucket is sent.
+// Each ES should receive events sent to each entity in same order as with plain events (actions are the last events to entity)
+static void batched_events_test()
+{
+  static constexpr int BATCHED_TEST_ENTITIES = 1000, BATCHED_TEST_ROUNDS = 3;
+  static const char *new_component_templates[2] = {"batchedTestNewComponent0", "batchedTestNewComponent1"};
+  dag::Vector<BatchedTestCall> calls[2];
+  for (int batched = 0; batched < 2; ++batched)
+  {
+    dag::Vector<ecs::EntityId> eids;
+    eids.reserve(BATCHED_TEST_ENTITIES);
+    for (int i = 0; i < BATCHED_TEST_ENTITIES; ++i)
+    {
+      ecs::ComponentsInitializer init;
+      init[ECS_HASH("batched_test_index")] = i;
+      eids.push_back(g_entity_mgr->createEntitySync(i % 5 ? "batchedTest" : "batchedTestRecreated", eastl::move(init)));
+    }
+    batched_test_new_component_templ = new_component_templates[batched]; // new one for each run, so both reset ES lists
+    batched_test_calls.clear();
+    auto send = [&](int i, int payload, int action) {
+      if (!g_entity_mgr->doesEntityExist(eids[i]))
+        return;
+      if (batched)
+        g_entity_mgr->sendEvent(eids[i], EventBatchedTest(payload, action));
+      else
+        g_entity_mgr->sendEvent(eids[i], EventBatchedTestRef(payload, action));
+    };
+    uint32_t seed = 12345;
+    for (int r = 0; r < BATCHED_TEST_ROUNDS; ++r)
+    {
+      for (int i = 0; i < BATCHED_TEST_ENTITIES; ++i)
+        send(i, r, BATCHED_TEST_NONE);
+      for (int j = 0; j < BATCHED_TEST_ENTITIES * 2; ++j)
+      {
+        seed = seed * 1664525u + 1013904223u;
+        send((seed >> 8) % BATCHED_TEST_ENTITIES, 1000 + j, BATCHED_TEST_NONE);
+      }
+      for (int i = r; i < BATCHED_TEST_ENTITIES; i += 97)
+        send(i, 100000 + i, BATCHED_TEST_DESTROY);
+      for (int i = r + 31; i < BATCHED_TEST_ENTITIES; i += 89)
+        if ((i - r) % 97 != 0) // not destroyed by previous event
+          send(i, 200000 + i, BATCHED_TEST_RECREATE);
+      if (r == 1)
+        send(500, 300000, BATCHED_TEST_NEW_COMPONENT);
+      g_entity_mgr->flushDeferredEvents();
+      g_entity_mgr->tick();
+    }
+    calls[batched].swap(batched_test_calls);
+    for (ecs::EntityId eid : eids)
+      g_entity_mgr->destroyEntity(eid);
+    g_entity_mgr->tick();
+  }
+
+  // compare sequences of events received by each ES for each entity
+  for (dag::Vector<BatchedTestCall> &c : calls)
+    stlsort::sort(c.begin(), c.end(), [](const BatchedTestCall &a, const BatchedTestCall &b) {
+      if (a.es != b.es)
+        return a.es < b.es;
+      return a.index != b.index ? a.index < b.index : a.order < b.order;
+    });
+  int wrong = calls[0].size() != calls[1].size();
+  for (int i = 0, e = min(calls[0].size(), calls[1].size()); i < e; ++i)
+    wrong += calls[0][i].es != calls[1][i].es || calls[0][i].index != calls[1][i].index || calls[0][i].payload != calls[1][i].payload;
+  printf("%d batched ES calls, %d calls of plain events, %d differ\n", (int)calls[1].size(), (int)calls[0].size(), wrong);
+  G_ASSERT(wrong == 0);
+}
+
+static constexpr ecs::ComponentDesc parallel_es_comps[] = {
+  {ECS_HASH("par_a"), ecs::ComponentTypeInfo<int>()},   // 0
+  {ECS_HASH("par_b"), ecs::ComponentTypeInfo<int>()},   // 1
+  {ECS_HASH("par_c"), ecs::ComponentTypeInfo<int>()},   // 2
+  {ECS_HASH("par_e"), ecs::ComponentTypeInfo<int>()},   // 3
+  {ECS_HASH("par_f"), ecs::ComponentTypeInfo<int>()},   // 4
+  {ECS_HASH("par_j"), ecs::ComponentTypeInfo<int>()},   // 5
+  {ECS_HASH("par_g"), ecs::ComponentTypeInfo<int>()},   // 6
+  {ECS_HASH("par_i"), ecs::ComponentTypeInfo<int>()},   // 7
+  {ECS_HASH("par_g"), ecs::ComponentTypeInfo<int>()},   // 8
+  {ECS_HASH("par_sum"), ecs::ComponentTypeInfo<int>()}, // 9
+  {ECS_HASH("par_a"), ecs::ComponentTypeInfo<int>()},   // 10
+  {ECS_HASH("par_b"), ecs::ComponentTypeInfo<int>()},   // 11
+};
+static bool parallel_bad_es_writes = false;
+
+static void parallel_add1_es(const ecs::UpdateStageInfo &, const ecs::QueryView &__restrict components)
+{
+  auto comp = components.begin(), compE = components.end();
+  do
+    components.getComponentRW<int>(0, comp) += 1;
+  while (++comp != compE);
+}
+static void parallel_add2_es(const ecs::UpdateStageInfo &, const ecs::QueryView &__restrict components)
+{
+  auto comp = components.begin(), compE = components.end();
+  do
+    components.getComponentRW<int>(0, comp) += 2;
+  while (++comp != compE);
+}
+static void parallel_double_es(const ecs::UpdateStageInfo &, const ecs::QueryView &__restrict components)
+{
+  auto comp = components.begin(), compE = components.end();
+  do
+  {
+    int &e = components.getComponentRW<int>(0, comp);
+    e = e * 2 + 1;
+  } while (++comp != compE);
+}
+static void parallel_copy_es(const ecs::UpdateStageInfo &, const ecs::QueryView &__restrict components)
+{
+  auto comp = components.begin(), compE = components.end();
+  do
+    components.getComponentRW<int>(0, comp) = components.getComponentRO<int>(1, comp);
+  while (++comp != compE);
+}
+// same as parallel_copy_es, but (when asked) also changes par_g it declared as RO, which is what validation should catch
+static void parallel_bad_es(const ecs::UpdateStageInfo &info, const ecs::QueryView &__restrict components)
+{
+  parallel_copy_es(info, components);
+  if (!parallel_bad_es_writes)
+    return;
+  auto comp = components.begin(), compE = components.end();
+  do
+    const_cast<int &>(components.getComponentRO<int>(1, comp)) += 1;
+  while (++comp != compE);
+}
+static void parallel_sum_es(const ecs::UpdateStageInfo &, const ecs::QueryView &__restrict components)
+{
+  auto comp = components.begin(), compE = components.end();
+  do
+    components.getComponentRW<int>(0, comp) = components.getComponentRO<int>(1, comp) + components.getComponentRO<int>(2, comp);
+  while (++comp != compE);
+}
+
+#define PARALLEL_ES_DESC(name, fn, rw, ro, ro_cnt, after)                                                                       \
+  static ecs::EntitySystemDesc name##_desc(#name, "prog/gameLibs/daECS/dasEcsUnitTest/unit_test.cpp", ecs::EntitySystemOps(fn), \
+    make_span(parallel_es_comps + rw, 1) /*rw*/, make_span(parallel_es_comps + ro, ro_cnt) /*ro*/, empty_span(), empty_span(),    \
+    ecs::EventSet{}, 1 << ecs::US_USER, nullptr, nullptr, nullptr, after);
+PARALLEL_ES_DESC(par_inc_a_es, parallel_add1_es, 0, 0, 0, nullptr)
+PARALLEL_ES_DESC(par_inc_b_es, parallel_add2_es, 1, 0, 0, nullptr)
+PARALLEL_ES_DESC(par_inc_c_es, parallel_add1_es, 2, 0, 0, nullptr)
+PARALLEL_ES_DESC(par_double_e_es, parallel_double_es, 3, 0, 0, nullptr)
+PARALLEL_ES_DESC(par_bad_es, parallel_bad_es, 5, 6, 1, nullptr)
+PARALLEL_ES_DESC(par_g_reader_es, parallel_copy_es, 7, 8, 1, nullptr)
+PARALLEL_ES_DESC(par_sum_es, parallel_sum_es, 9, 10, 2, nullptr)             // conflicts with par_inc_a_es and par_inc_b_es by data
+PARALLEL_ES_DESC(par_inc_f_es, parallel_add1_es, 4, 0, 0, "par_double_e_es") // conflicts with par_double_e_es by order
+#undef PARALLEL_ES_DESC
+
+// runs US_USER stage as parallel one: independent ES share the first wave, conflicting by data or order ones go to the second,
+// results should be the same as of sequential update. Then checks that validation mode reports ES writing its RO component.
+static void parallel_stages_test()
+{
+  static constexpr int PARALLEL_ENTITIES = 1000, PARALLEL_RUNS = 10;
+  dag::Vector<ecs::EntityId> eids;
+  eids.reserve(PARALLEL_ENTITIES);
+  for (int i = 0; i < PARALLEL_ENTITIES; ++i)
+  {
+    ecs::ComponentsInitializer init;
+    init[ECS_HASH("par_g")] = i;
+    eids.push_back(g_entity_mgr->createEntitySync("parallelStages", eastl::move(init)));
+  }
+
+  g_entity_mgr->setParallelUpdateStages(1u << ecs::US_USER);
+  for (int r = 0; r < PARALLEL_RUNS; ++r)
+    g_entity_mgr->update(ecs::UpdateStageInfo(ecs::US_USER));
+
+  int wrong = 0;
+  for (int i = 0; i < PARALLEL_ENTITIES; ++i)
+  {
+    auto get = [&](const ecs::HashedConstString &name) { return g_entity_mgr->getOr(eids[i], name, -1); };
+    if (get(ECS_HASH("par_a")) != PARALLEL_RUNS || get(ECS_HASH("par_b")) != 2 * PARALLEL_RUNS ||
+        get(ECS_HASH("par_sum")) != 3 * PARALLEL_RUNS || get(ECS_HASH("par_c")) != PARALLEL_RUNS ||
+        get(ECS_HASH("par_e")) != (1 << PARALLEL_RUNS) - 1 || get(ECS_HASH("par_f")) != PARALLEL_RUNS ||
+        get(ECS_HASH("par_g")) != i || get(ECS_HASH("par_i")) != i || get(ECS_HASH("par_j")) != i)
+      wrong++;
+  }
+  const ecs::EntityManager::ParallelStageStats stats = g_entity_mgr->getParallelStageStats(ecs::US_USER);
+  printf("parallel stage: %d ES in %d waves (max %d ES in wave), %d runs, %d entities with wrong results\n", stats.systems,
+    stats.waves, stats.maxWaveSize, stats.runs, wrong);
+  G_ASSERT(wrong == 0);
+  G_ASSERT(stats.systems == 8 && stats.waves == 2 && stats.maxWaveSize == 6 && stats.runs == PARALLEL_RUNS);
+
+  // par_bad_es changes par_g, that par_g_reader_es of the same wave reads
+  g_entity_mgr->setParallelUpdateStages(1u << ecs::US_USER, true);
+  parallel_conflicts_expected = parallel_bad_es_writes = true;
+  g_entity_mgr->update(ecs::UpdateStageInfo(ecs::US_USER));
+  parallel_conflicts_expected = parallel_bad_es_writes = false;
+  printf("parallel stage validation: %d conflicts reported\n", parallel_conflicts_reported);
+  G_ASSERT(parallel_conflicts_reported == 1);
+
+  g_entity_mgr->setParallelUpdateStages(0);
+  for (ecs::EntityId eid : eids)
+    g_entity_mgr->destroyEntity(eid);
+  g_entity_mgr->tick();
+}
+
 #include <osApiWrappers/dag_symHlp.h>
 #include <osApiWrappers/dag_dbgStr.h> //set_debug_console_handle
 #if _TARGET_PC_WIN
@@ -181,6 +623,10 @@ int myMain2(int startArgC)
 
   G_ASSERT(get_test_value("EventStartTriggered") == 1);
   G_ASSERT(get_test_value("EventEndTriggered") == 1);
+  snapshot_benchmark();
+  unicast_event_benchmark();
+  batched_events_test();
+  parallel_stages_test();
   int64_t reft = ref_time_ticks();
   g_entity_mgr->clear();
   debug("clear in %dus", get_time_usec(reft));
@@ -3,6 +3,7 @@
 #include <daNet/getTime.h>
 #include <debug/dag_assert.h>
 #include <debug/dag_debug.h>
+#include <osApiWrappers/dag_atomic.h>
 #include <osApiWrappers/dag_critSec.h>
 
 #include <enet/enet.h>
@@ -13,8 +14,10 @@ eastl::optional<ENetAddress> get_enet_address(const char *new_host);
 // Supposedly the enet doesn't send the first 2 bytes with all bits set
 using EchoPacketMarkerType = uint16_t;
 static constexpr EchoPacketMarkerType ECHO_PACKET_MARKER = 0xFFFF;
-// Read from the network thread, written from DaNetPeerInterface ctor before thread started and in dtor after thread stopped
-static danet::EchoManager *echo_manager; // We only create one peer interface, which uses only one echo manager
+// Read from the network thread, written from DaNetPeerInterface ctor before thread started and in dtor after thread stopped.
+// Only first created peer interface owns echo manager; additional ones (sockets sharded with SO_REUSEPORT, each with own
+// network thread) only answer echo requests, so their threads never touch echo manager state except for debug counters
+static danet::EchoManager *volatile echo_manager;
 
 #pragma pack(push, 1)
 struct EchoNetPacketBeforeChecksum
@@ -55,20 +58,30 @@ static void send_echo_impl(ENetSocket socket, ENetAddress *address, bool respons
   enet_socket_send(socket, address, &enetBuffer, /*bufferCount*/ 1);
 }
 
+static bool is_echo_packet(const void *data, int length)
+{
+  const EchoNetPacket *echoNetPacket = static_cast<const EchoNetPacket *>(data); // the host is expected to always be LE
+  return EASTL_UNLIKELY(length == sizeof(EchoNetPacket)) && echoNetPacket->marker == ECHO_PACKET_MARKER;
+}
+
 static void receive_echo_impl(ENetSocket socket, ENetAddress *receivedFrom, const EchoNetPacket &echoNetPacket)
 {
-  G_ASSERTF(echo_manager != nullptr, "A packet from enet, but there is no EchoManager");
+  danet::EchoManager *echoManager = interlocked_acquire_load_ptr(echo_manager);
+  G_ASSERTF_RETURN(echoManager != nullptr, , "A packet from enet, but there is no EchoManager");
 
   if (echoNetPacket.checksum != calc_checksum(echoNetPacket))
     return; // checksum doesn't match
 
 #if DAGOR_DBGLEVEL > 0
-  echo_manager->sendCount += size_t{!echoNetPacket.response};
-  echo_manager->receiveCount++;
+  echoManager->sendCount += size_t{!echoNetPacket.response};
+  echoManager->receiveCount++;
 #endif
 
   if (echoNetPacket.response)
-    echo_manager->processResponse(echoNetPacket.sequenceNumber);
+  {
+    if (echoManager->ownsSocket(socket)) // responses on sockets of other (sharded) peer interfaces are not ours
+      echoManager->processResponse(echoNetPacket.sequenceNumber);
+  }
   else
     // sending pong immediately to ensure smaller RTT, it's not very important, but it's a tad better for correct estimations
     send_echo_impl(socket, receivedFrom, /*response*/ true, echoNetPacket.sequenceNumber);
@@ -89,16 +102,25 @@ extern "C"
     for (; ret > 0; ret = receive())
     {
       const int receiveLength = ret; // positive result of receive is the length of received data
-
-      const EchoNetPacket *echoNetPacket = static_cast<const EchoNetPacket *>(buffers->data); // the host is expected to always be LE
-      if (EASTL_LIKELY(receiveLength != sizeof(EchoNetPacket)) || echoNetPacket->marker != ECHO_PACKET_MARKER)
+      if (!is_echo_packet(buffers->data, receiveLength))
         break; // not an echo, will be processed by enet
 
-      receive_echo_impl(socket, address, *echoNetPacket);
+      receive_echo_impl(socket, address, *static_cast<const EchoNetPacket *>(buffers->data));
     }
 
     return ret;
   }
+
+  int enet_socket_batch_receive_impl(ENetSocket socket, ENetSocketBatch *batch, ENetAddress *address, enet_uint8 **data);
+
+  // same as enet_socket_receive, but for batched receive (echo packets are filtered out from batch one by one)
+  int enet_socket_batch_receive(ENetSocket socket, ENetSocketBatch *batch, ENetAddress *address, enet_uint8 **data)
+  {
+    int ret;
+    while ((ret = enet_socket_batch_receive_impl(socket, batch, address, data)) > 0 && is_echo_packet(*data, ret))
+      receive_echo_impl(socket, address, *reinterpret_cast<const EchoNetPacket *>(*data));
+    return ret;
+  }
 };
 
 namespace danet
@@ -107,14 +129,14 @@ namespace danet
 // called from the main thread, before net thread is created
 EchoManager::EchoManager(DaNetTime echo_timeout_ms) : timeoutMs{echo_timeout_ms}
 {
-  G_ASSERTF(echo_manager == nullptr, "It's expected that there is only one Echo Manager for code simplicity");
-  echo_manager = this;
+  // only first one is used for echo requests for code simplicity, others (if any) belong to sharded peer interfaces
+  interlocked_compare_exchange_ptr(echo_manager, this, (EchoManager *)nullptr);
 }
 
 // called from the main thread, after the net thread is terminated
 EchoManager::~EchoManager()
 {
-  echo_manager = nullptr;
+  interlocked_compare_exchange_ptr(echo_manager, (EchoManager *)nullptr, this);
 #if DAGOR_DBGLEVEL > 0
   debug("Dumping echo stats: sent #%lld (%lld bytes), received #%lld (%lld bytes)", sendCount, sendCount * sizeof(EchoNetPacket),
     receiveCount, receiveCount * sizeof(EchoNetPacket));
@@ -134,6 +156,7 @@ void EchoManager::clear()
 // called from the main thread, simultaneous with the net thread
 void EchoManager::sendEcho(const char *route, uint32_t route_id)
 {
+  G_ASSERTF_RETURN(interlocked_acquire_load_ptr(echo_manager) == this, , "Echo requests are supported only by first peer interface");
   eastl::optional<ENetAddress> addr = get_enet_address(route);
   WinAutoLock l(crit); // access to "toSend" and "received"
 
@@ -151,6 +174,9 @@ void EchoManager::sendEcho(const char *route, uint32_t route_id)
 // called from the main thread, when the net thread isn't running
 void EchoManager::setHost(_ENetHost *new_host) { host = new_host; }
 
+// called from the net threads; peer interface that owns echo manager is expected to be shut down after sharded ones
+bool EchoManager::ownsSocket(intptr_t socket) const { return host && host->socket == (ENetSocket)socket; }
+
 // called from the net thread, simultaneous with the main thread
 void EchoManager::process()
 {
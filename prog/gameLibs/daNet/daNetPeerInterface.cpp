@@ -281,10 +281,17 @@ bool DaNetPeerInterface::Startup(uint16_t maxCon, int st, const SocketDescriptor
   }
   maximumIncomingConnections = maximumIncomingConnections ? min((uint16_t)maximumIncomingConnections, maxCon) : maxCon;
   G_ASSERT(maximumIncomingConnections);
-  _ENetHost *ehost = enet_host_create((sd && sd->type != SocketDescriptor::SOCKET) ? &addr : NULL, maximumIncomingConnections,
-    DANET_MAX_CHANNELS, 0, 0);
+  _ENetHost *ehost = enet_host_create_ex((sd && sd->type != SocketDescriptor::SOCKET) ? &addr : NULL, maximumIncomingConnections,
+    DANET_MAX_CHANNELS, 0, 0, (sd && sd->reusePort) ? ENET_HOST_FLAG_REUSEPORT : 0);
   if (!ehost)
+  {
+    if (sd && sd->reusePort)
+      logerr("failed to create host on port %d with SO_REUSEPORT (not supported on this platform or port is taken without it)",
+        sd->port);
     return false;
+  }
+  if (sd && sd->ioBatchSize > 1 && enet_host_set_batching(ehost, sd->ioBatchSize) < 0)
+    debug("batched datagram I/O is not supported, fallback to per-datagram send/receive");
   if ((char *)host == (char *)(this + 1))
   {
     // move host data
@@ -377,6 +384,7 @@ void DaNetPeerInterface::Shutdown(DaNetTime block_duration)
   {
     Stop(block_duration, DC_CONNECTION_CLOSED);
     enet_socket_destroy(host->socket);
+    enet_socket_batch_destroy(host->batch);
     for (_ENetPeer *cp = host->peers; cp < &host->peers[host->peerCount]; ++cp)
       enet_peer_reset(cp);
     enet_free(host->peers);
@@ -0,0 +1,135 @@
+// BitStream serialization microbenchmark: word-at-a-time WriteBits/ReadBits vs reference byte-at-a-time implementation
+// and per-value vs bulk quantized writes, on replication-like mix of unaligned fields.
+//
+// usage: danet-bitstream-bench [iterations=2000]
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <debug/dag_assert.h>
+#include <generic/dag_tab.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <daNet/bitStreamQuantized.h>
+
+static constexpr int NUM_FIELDS = 4096;
+static constexpr int NUM_VALUES = 1024;
+
+typedef gamemath::QuantizedPos<20, 14, 20, gamemath::NoScale, gamemath::NoScale, gamemath::NoScale> QPos;
+
+static bool assertion_handler(bool, const char *file, int line, const char *func, const char *cond, const char *, const DagorSafeArg *,
+  int)
+{
+  fprintf(stderr, "%s:%d: %s() !\"%s\"\n", file, line, func, cond);
+  abort();
+  return false;
+}
+
+struct Field
+{
+  uint64_t val;
+  uint32_t bits;
+};
+
+template <bool BYTEWISE>
+static void write_fields(danet::BitStream &bs, const Field *fields)
+{
+  for (int i = 0; i < NUM_FIELDS; ++i)
+    if (BYTEWISE)
+      bs.WriteBitsBytewise((const uint8_t *)&fields[i].val, fields[i].bits);
+    else
+      bs.WriteBits((const uint8_t *)&fields[i].val, fields[i].bits);
+}
+
+template <bool BYTEWISE>
+static uint64_t read_fields(const danet::BitStream &bs, const Field *fields)
+{
+  uint64_t sum = 0;
+  for (int i = 0; i < NUM_FIELDS; ++i)
+  {
+    uint64_t v = 0;
+    if (BYTEWISE)
+      bs.ReadBitsBytewise((uint8_t *)&v, fields[i].bits);
+    else
+      bs.ReadBits((uint8_t *)&v, fields[i].bits);
+    sum += v;
+  }
+  return sum;
+}
+
+template <typename F>
+static double measure_ns(int iterations, const F &f)
+{
+  int64_t best = INT64_MAX;
+  for (int i = 0; i < iterations; ++i)
+  {
+    int64_t t0 = ref_time_ticks();
+    f();
+    best = min(best, ref_time_ticks() - t0);
+  }
+  return double(best) * 1e9 / ref_ticks_frequency();
+}
+
+int main(int argc, const char *argv[])
+{
+  dgs_assertion_handler = assertion_handler;
+  measure_cpu_freq();
+  const int iterations = argc > 1 ? max(atoi(argv[1]), 1) : 2000;
+
+  // replication-like mix: flags, small enums, VLQ-sized ints, 16/32-bit values, occasional 64-bit ones
+  static const uint32_t fieldBits[] = {1, 1, 3, 5, 7, 8, 11, 13, 16, 17, 24, 32, 1, 2, 32, 64};
+  Tab<Field> fields;
+  fields.resize(NUM_FIELDS);
+  uint64_t seed = 1;
+  for (Field &f : fields)
+  {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    f.bits = fieldBits[(seed >> 33) % countof(fieldBits)];
+    f.val = seed & (f.bits < 64 ? (uint64_t(1) << f.bits) - 1 : ~uint64_t(0));
+  }
+  Tab<float> floats;
+  Tab<Point3> positions;
+  Tab<Quat> quats;
+  floats.resize(NUM_VALUES);
+  positions.resize(NUM_VALUES);
+  quats.resize(NUM_VALUES);
+  for (int i = 0; i < NUM_VALUES; ++i)
+  {
+    floats[i] = sinf(i * 0.1f);
+    positions[i] = Point3(sinf(i * 0.3f), cosf(i * 0.7f), sinf(i * 1.1f)) * 0.9f;
+    quats[i] = normalize(Quat(sinf(i * 0.2f), cosf(i * 0.5f), sinf(i * 0.9f), 1.f));
+  }
+
+  danet::BitStream bs(uint32_t(NUM_FIELDS * sizeof(uint64_t) + NUM_VALUES * 32));
+  const Field *f = fields.data();
+  double tWrB = measure_ns(iterations, [&] { bs.ResetWritePointer(), write_fields<true>(bs, f); });
+  double tWrW = measure_ns(iterations, [&] { bs.ResetWritePointer(), write_fields<false>(bs, f); });
+  uint64_t sumB = 0, sumW = 0;
+  double tRdB = measure_ns(iterations, [&] { bs.ResetReadPointer(), sumB = read_fields<true>(bs, f); });
+  double tRdW = measure_ns(iterations, [&] { bs.ResetReadPointer(), sumW = read_fields<false>(bs, f); });
+  G_ASSERT(sumB == sumW);
+  printf("%d fields (%u bits):\n", NUM_FIELDS, bs.GetNumberOfBitsUsed());
+  printf("  write: byte-wise %8.1f ns/field, word %8.1f ns/field (x%.2f)\n", tWrB / NUM_FIELDS, tWrW / NUM_FIELDS, tWrB / tWrW);
+  printf("  read:  byte-wise %8.1f ns/field, word %8.1f ns/field (x%.2f)\n", tRdB / NUM_FIELDS, tRdW / NUM_FIELDS, tRdB / tRdW);
+
+  double tPerValue = measure_ns(iterations, [&] {
+    bs.ResetWritePointer();
+    for (int i = 0; i < NUM_VALUES; ++i)
+    {
+      uint32_t q = gamemath::pack_scalar_signed<uint32_t>(floats[i], 11);
+      bs.WriteBitsBytewise((const uint8_t *)&q, 11);
+      auto qp = QPos(positions[i]).qpos;
+      bs.WriteBitsBytewise((const uint8_t *)&qp, QPos::TotalPosBits);
+      auto qq = gamemath::QuantizedQuat47(quats[i]).qquat;
+      bs.WriteBitsBytewise((const uint8_t *)&qq, gamemath::QuantizedQuat47::TotalQuatBits);
+    }
+  });
+  double tBulk = measure_ns(iterations, [&] {
+    bs.ResetWritePointer();
+    danet::write_quantized_floats(bs, floats, 11);
+    danet::write_quantized_positions<QPos>(bs, positions);
+    danet::write_quantized_quats<gamemath::QuantizedQuat47>(bs, quats);
+  });
+  printf("%d x (float, pos, quat) quantized (%u bits):\n", NUM_VALUES, bs.GetNumberOfBitsUsed());
+  printf("  write: per-value byte-wise %8.1f ns/item, bulk %8.1f ns/item (x%.2f)\n", tPerValue / NUM_VALUES, tBulk / NUM_VALUES,
+    tPerValue / tBulk);
+  return 0;
+}
@@ -0,0 +1,158 @@
+// Loopback load generator: N clients send unreliable packets to server which echoes them back.
+// Server may be sharded over several sockets (SO_REUSEPORT), each served by own network thread, and use batched datagram I/O.
+// Reports packets/sec of server and packets per CPU second (i.e. per fully loaded core).
+//
+// usage: danet-loadgen [clients=64] [shards=1] [io_batch=0] [seconds=10] [pps_per_client=60] [packet_size=64]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <debug/dag_assert.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <daNet/daNetPeerInterface.h>
+#include <daNet/messageIdentifiers.h>
+
+#define DEF_HOST     "127.0.0.1"
+#define DEF_PORT     36667
+#define ID_LOAD_DATA ID_USER_PACKET_ENUM
+
+static bool assertion_handler(bool, const char *file, int line, const char *func, const char *cond, const char *, const DagorSafeArg *,
+  int)
+{
+  fprintf(stderr, "%s:%d: %s() !\"%s\"\n", file, line, func, cond);
+  abort();
+  return false;
+}
+
+static int arg_int(int argc, const char *argv[], int i, int def) { return argc > i ? atoi(argv[i]) : def; }
+
+int main(int argc, const char *argv[])
+{
+  dgs_assertion_handler = assertion_handler;
+  measure_cpu_freq();
+
+  const int numClients = max(arg_int(argc, argv, 1, 64), 1);
+  const int numShards = max(arg_int(argc, argv, 2, 1), 1);
+  const int ioBatch = max(arg_int(argc, argv, 3, 0), 0);
+  const int seconds = max(arg_int(argc, argv, 4, 10), 1);
+  const int ppsPerClient = max(arg_int(argc, argv, 5, 60), 1);
+  const int packetSize = min(max(arg_int(argc, argv, 6, 64), 2), 1024);
+
+  Tab<DaNetPeerInterface *> shards, clients;
+  for (int i = 0; i < numShards; ++i)
+  {
+    SocketDescriptor sd(DEF_PORT, DEF_HOST);
+    sd.reusePort = numShards > 1;
+    sd.ioBatchSize = ioBatch;
+    DaNetPeerInterface *shard = new DaNetPeerInterface();
+    if (!shard->Startup(numClients, 1, &sd))
+    {
+      fprintf(stderr, "Can't start server shard #%d on %s:%d\n", i, DEF_HOST, DEF_PORT);
+      return 1;
+    }
+    shards.push_back(shard);
+  }
+  for (int i = 0; i < numClients; ++i)
+  {
+    DaNetPeerInterface *client = new DaNetPeerInterface();
+    if (!client->Startup(1, 1) || !client->Connect(DEF_HOST, DEF_PORT))
+    {
+      fprintf(stderr, "Can't connect client #%d to %s:%d\n", i, DEF_HOST, DEF_PORT);
+      return 1;
+    }
+    clients.push_back(client);
+  }
+  printf("%d clients, %d server shard(s), io batch %d, %d pps per client, %d bytes packets, %d sec\n", numClients, numShards, ioBatch,
+    ppsPerClient, packetSize, seconds);
+
+  Tab<uint8_t> payload;
+  payload.resize(packetSize);
+  mem_set_0(payload);
+  payload[0] = ID_LOAD_DATA;
+
+  Tab<int> shardPeers;
+  shardPeers.resize(numShards);
+  mem_set_0(shardPeers);
+  Tab<int64_t> shardPackets;
+  shardPackets.resize(numShards);
+  mem_set_0(shardPackets);
+  int64_t clientPackets = 0, sentPackets = 0;
+  int connected = 0;
+
+  const int64_t startTicks = ref_time_ticks();
+  clock_t startCpu = clock(); // process CPU time (of all threads) on Linux
+  int64_t statsStartTicks = startTicks;
+  for (int sentTick = 0;;)
+  {
+    for (int i = 0; i < numShards; ++i)
+      while (Packet *pkt = shards[i]->Receive())
+      {
+        if (pkt->data[0] == ID_LOAD_DATA)
+        {
+          shardPackets[i]++;
+          shards[i]->Send(dag::ConstSpan<uint8_t>(pkt->data, pkt->length), HIGH_PRIORITY, UNRELIABLE, 0, pkt->systemIndex, false);
+        }
+        else if (pkt->data[0] == ID_NEW_INCOMING_CONNECTION)
+          shardPeers[i]++;
+        shards[i]->DeallocatePacket(pkt);
+      }
+    for (DaNetPeerInterface *client : clients)
+      while (Packet *pkt = client->Receive())
+      {
+        if (pkt->data[0] == ID_LOAD_DATA)
+          clientPackets++;
+        else if (pkt->data[0] == ID_CONNECTION_REQUEST_ACCEPTED)
+          connected++;
+        client->DeallocatePacket(pkt);
+      }
+
+    if (connected < numClients) // don't start measurement until all clients are connected
+    {
+      G_ASSERTF(get_time_usec(startTicks) < 10000000, "only %d of %d clients connected", connected, numClients);
+      statsStartTicks = ref_time_ticks();
+      startCpu = clock();
+      sleep_msec(1);
+      continue;
+    }
+
+    const int elapsedUsec = get_time_usec(statsStartTicks);
+    if (elapsedUsec >= seconds * 1000000)
+      break;
+    for (const int needTick = int(int64_t(elapsedUsec) * ppsPerClient / 1000000); sentTick < needTick; ++sentTick)
+      for (DaNetPeerInterface *client : clients)
+      {
+        client->Send(payload, HIGH_PRIORITY, UNRELIABLE, 0, 0, false);
+        sentPackets++;
+      }
+    sleep_msec(1);
+  }
+
+  const double wallSec = get_time_usec(statsStartTicks) / 1e6;
+  const double cpuSec = double(clock() - startCpu) / CLOCKS_PER_SEC;
+  int64_t serverPackets = 0;
+  for (int i = 0; i < numShards; ++i)
+  {
+    printf("  shard #%d: %d peers, %lld packets received\n", i, shardPeers[i], (long long)shardPackets[i]);
+    serverPackets += shardPackets[i];
+  }
+  // every received packet is sent back, so each one costs server a receive and a send
+  printf("sent %lld, server received %lld (%.0f pps), echoed back %lld (%.1f%% lost)\n", (long long)sentPackets,
+    (long long)serverPackets, serverPackets / wallSec, (long long)clientPackets,
+    sentPackets ? 100.0 * (sentPackets - clientPackets) / sentPackets : 0.0);
+  printf("CPU %.2f sec in %.2f sec, %.0f server packets per CPU second (clients included)\n", cpuSec, wallSec,
+    cpuSec > 0 ? serverPackets / cpuSec : 0.0);
+
+  for (DaNetPeerInterface *client : clients)
+  {
+    client->Shutdown(0);
+    delete client;
+  }
+  for (int i = numShards - 1; i >= 0; --i) // first shard owns echo manager, so it's shut down last
+  {
+    shards[i]->Shutdown(100);
+    delete shards[i];
+  }
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include <UnitTest++/UnitTestPP.h>
 #include <daNet/bitStream.h>
+#include <daNet/bitStreamQuantized.h>
 #include <util/dag_string.h>
 #include <util/dag_simpleString.h>
 #include <EASTL/string.h>
@@ -228,3 +229,65 @@ TEST(RWBitAlignedByteBorder)
     CHECK_EQUAL(j, (int)c[1]);
   }
 }
+
+TEST(RWBitsWordEqualsBytewise)
+{
+  uint32_t seed = 1;
+  auto rnd = [&seed]() { return (seed = seed * 1664525u + 1013904223u) >> 8; };
+  for (int iter = 0; iter < 1000; ++iter)
+  {
+    danet::BitStream a, b;
+    uint8_t src[32];
+    for (int i = 0, n = rnd() % 16; i < n; ++i)
+    {
+      for (uint8_t &c : src)
+        c = (uint8_t)rnd();
+      uint32_t bits = rnd() % (sizeof(src) * 8);
+      a.WriteBits(src, bits);
+      b.WriteBitsBytewise(src, bits);
+      uint64_t v = (uint64_t(rnd()) << 32) | rnd();
+      bits = rnd() % 65;
+      a.WriteBitsValue(v, bits);
+      b.WriteBitsBytewise((const uint8_t *)&v, bits);
+    }
+    CHECK_EQUAL(b.GetNumberOfBitsUsed(), a.GetNumberOfBitsUsed());
+    CHECK(memcmp(a.GetData(), b.GetData(), a.GetNumberOfBytesUsed()) == 0);
+
+    for (bool ok = true; ok;)
+    {
+      uint8_t ra[32], rb[32];
+      uint32_t bits = rnd() % (sizeof(ra) * 8);
+      ok = a.ReadBits(ra, bits);
+      CHECK_EQUAL(b.ReadBitsBytewise(rb, bits), ok);
+      if (ok)
+        CHECK(memcmp(ra, rb, (bits + 7) / 8) == 0);
+    }
+  }
+}
+
+TEST(RWQuantizedBulk)
+{
+  typedef gamemath::QuantizedPos<20, 14, 20, gamemath::NoScale, gamemath::NoScale, gamemath::NoScale> QPos;
+  float vals[5] = {-1.f, -0.25f, 0.f, 0.5f, 1.f}, rvals[5];
+  Point3 pos[3] = {Point3(0.1f, -0.2f, 0.3f), Point3(-1.f, 1.f, 0.f), Point3(0.5f, 0.5f, -0.5f)}, rpos[3];
+  Quat quats[2] = {Quat(0.f, 0.f, 0.f, 1.f), normalize(Quat(0.1f, -0.7f, 0.2f, 0.6f))}, rquats[2];
+
+  danet::BitStream bs;
+  bs.Write1(); // unaligned start
+  danet::write_quantized_floats(bs, make_span_const(vals, countof(vals)), 11);
+  danet::write_quantized_positions<QPos>(bs, make_span_const(pos, countof(pos)));
+  danet::write_quantized_quats<gamemath::QuantizedQuat47>(bs, make_span_const(quats, countof(quats)));
+  CHECK_EQUAL(1 + 5 * 11 + 3 * QPos::TotalPosBits + 2 * gamemath::QuantizedQuat47::TotalQuatBits, (int)bs.GetNumberOfBitsUsed());
+
+  CHECK(bs.ReadBit());
+  CHECK(danet::read_quantized_floats(bs, make_span(rvals, countof(rvals)), 11));
+  CHECK(danet::read_quantized_positions<QPos>(bs, make_span(rpos, countof(rpos))));
+  CHECK(danet::read_quantized_quats<gamemath::QuantizedQuat47>(bs, make_span(rquats, countof(rquats))));
+  for (int i = 0; i < countof(vals); ++i)
+    CHECK_CLOSE(vals[i], rvals[i], 1e-3f);
+  for (int i = 0; i < countof(pos); ++i)
+    CHECK(lengthSq(pos[i] - rpos[i]) < 1e-6f);
+  for (int i = 0; i < countof(quats); ++i) // q and -q are the same rotation
+    CHECK(fabsf(quats[i].x * rquats[i].x + quats[i].y * rquats[i].y + quats[i].z * rquats[i].z + quats[i].w * rquats[i].w) > 0.9999f);
+  CHECK(!danet::read_quantized_floats(bs, make_span(rvals, 1), 11)); // nothing left
+}
@@ -288,6 +288,7 @@ int BhvDragAndDrop::pointingEvent(ElementTree *etree, Element *elem, InputDevice
       elem->setGroupStateFlags(Element::S_DRAG);
 
       elem->updFlags(Element::F_ZORDER_ON_TOP, true);
+      elem->invalidateStacks();
       callDragModeHandler(etree->guiScene, elem, true);
 
       etree->updateSceneStateFlags(ElementTree::F_DRAG_ACTIVE, true);
@@ -354,6 +355,7 @@ int BhvDragAndDrop::pointingEvent(ElementTree *etree, Element *elem, InputDevice
       if (elem->transform)
         elem->transform->translate.zero();
       elem->updFlags(Element::F_ZORDER_ON_TOP, false);
+      elem->invalidateStacks();
       result |= R_PROCESSED | R_REBUILD_RENDER_AND_INPUT_LISTS;
     }
   }
@@ -417,6 +419,7 @@ int BhvDragAndDrop::onDeactivateInput(Element *elem, InputDevice device, int poi
   if (elem->transform)
     elem->transform->translate.zero();
   elem->updFlags(Element::F_ZORDER_ON_TOP, false);
+  elem->invalidateStacks();
   elem->clearGroupStateFlags(Element::S_DRAG | active_state_flags_for_device(ddState->activeDeviceId));
 
   ddState->resetState();
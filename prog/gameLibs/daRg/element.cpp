@@ -1021,6 +1021,42 @@ int16_t Element::getZOrder(int parent_z_order) const
 }
 
 
+void Element::invalidateStacks()
+{
+  // walk up to root unconditionally: flags of hidden subtrees are not cleared on rebuild
+  for (Element *e = this; e; e = e->parent)
+    e->flags |= F_STACKS_DIRTY;
+}
+
+
+bool Element::reuseRenderEntries(ElemStacks &stacks, ElemStackCounters &counters, int order)
+{
+  // subtree without z-order overrides is a contiguous run of the sorted list starting with own RCMD_ELEM_RENDER
+  const RenderList::RListData &prev = stacks.rlistPrev->prevList;
+  RenderEntry key;
+  key.zOrder = rlistCacheZOrder;
+  key.hierOrder = rlistCacheHierFirst;
+  auto it = eastl::lower_bound(prev.begin(), prev.end(), key, RenderEntryCompare());
+  if (it == prev.end() || prev.end() - it < rlistCacheCount || it->elem != this || it->cmd != RCMD_ELEM_RENDER ||
+      it->hierOrder != rlistCacheHierFirst)
+    return false;
+  const RenderEntry &last = it[rlistCacheCount - 1];
+  if (last.elem != this || last.cmd != RCMD_ELEM_POSTRENDER || last.hierOrder != rlistCacheHierFirst + rlistCacheCount - 1)
+    return false;
+
+  rlistCacheZOrder = order;
+  rlistCacheHierFirst = counters.hierOrderRender + 1;
+  for (auto end = it + rlistCacheCount; it != end; ++it)
+  {
+    RenderEntry re = *it;
+    re.hierOrder = ++counters.hierOrderRender;
+    re.zOrder = order;
+    stacks.rlist->push(re);
+  }
+  return true;
+}
+
+
 void Element::putToSortedStacks(ElemStacks &stacks, ElemStackCounters &counters, int parent_z_order, bool parent_disable_input)
 {
   if (isHidden())
@@ -1028,6 +1064,13 @@ void Element::putToSortedStacks(ElemStacks &stacks, ElemStackCounters &counters,
 
   const int order = getZOrder(parent_z_order);
   bool disableInput = parent_disable_input || (flags & F_DISABLE_INPUT);
+
+  if (stacks.rlistPrev && !disableInput && (flags & (F_STACKS_DIRTY | F_STACKS_REUSABLE)) == F_STACKS_REUSABLE &&
+      reuseRenderEntries(stacks, counters, order))
+    return;
+
+  flags &= ~F_STACKS_DIRTY;
+  const ElemStackCounters startCounters = counters;
   bool putToRender = should_put_to_render(this);
 
   if (putToRender)
@@ -1090,8 +1133,13 @@ void Element::putToSortedStacks(ElemStacks &stacks, ElemStackCounters &counters,
     stacks.eventHandlers->push(ie);
   }
 
+  bool reusable = putToRender && !disableInput && stacks.input && stacks.cursors && stacks.eventHandlers && fadeOutChildren.empty();
   for (Element *child : children)
+  {
     child->putToSortedStacks(stacks, counters, order, disableInput);
+    if (!child->isHidden() && (!child->hasFlags(F_STACKS_REUSABLE) || child->getZOrder(order) != order))
+      reusable = false;
+  }
 
   for (Element *fadingChild : fadeOutChildren)
   {
@@ -1119,6 +1167,13 @@ void Element::putToSortedStacks(ElemStacks &stacks, ElemStackCounters &counters,
     re.zOrder = order;
     stacks.rlist->push(re);
   }
+
+  rlistCacheZOrder = order;
+  rlistCacheHierFirst = startCounters.hierOrderRender + 1;
+  rlistCacheCount = counters.hierOrderRender - startCounters.hierOrderRender;
+  reusable = reusable && counters.hierOrderInput == startCounters.hierOrderInput &&
+             counters.hierOrderCursor == startCounters.hierOrderCursor && counters.hierOrderEvtH == startCounters.hierOrderEvtH;
+  updFlags(F_STACKS_REUSABLE, reusable);
 }
 
 
@@ -1179,7 +1234,7 @@ Point2 Element::calcParentRelPos()
 }
 
 
-void Element::recalcScreenPositions()
+void Element::calcScreenPos()
 {
   // screen coordinates
   if (parent)
@@ -1189,21 +1244,57 @@ void Element::recalcScreenPositions()
 
   if (!(flags & F_SUBPIXEL))
     screenCoord.screenPos = floor(screenCoord.screenPos);
+}
 
+
+void Element::finishScreenPosRecalc()
+{
+  for (Behavior *bhv : behaviors)
+    bhv->onRecalcLayout(this);
+
+  afterRecalc();
+  flags &= ~F_LAYOUT_DIRTY;
+}
+
+
+void Element::recalcScreenPositions()
+{
+  calcScreenPos();
   limitScrollOffset();
 
   for (Element *child : children)
     child->recalcScreenPositions();
 
-  for (Behavior *bhv : behaviors)
-    bhv->onRecalcLayout(this);
+  finishScreenPosRecalc();
+}
 
-  afterRecalc();
+
+void Element::recalcDirtyScreenPositions()
+{
+  calcScreenPos();
+  limitScrollOffset();
+
+  // clean children keep their subtree layout, so only moved ones need their subtree to be updated
+  for (Element *child : children)
+  {
+    if (child->flags & F_LAYOUT_DIRTY)
+    {
+      child->recalcDirtyScreenPositions();
+      continue;
+    }
+    Point2 prevPos = child->screenCoord.screenPos;
+    child->calcScreenPos();
+    if (child->screenCoord.screenPos != prevPos)
+      child->recalcScreenPositions();
+  }
+
+  finishScreenPosRecalc();
 }
 
 
 void Element::calcFixedSizes()
 {
+  flags |= F_LAYOUT_DIRTY;
   screenCoord.size.zero();
   screenCoord.contentSize.zero();
 
@@ -1256,8 +1347,14 @@ void Element::calcConstrainedSizes(int axis)
 {
   if (children.size())
   {
+    // subtrees of clean children are skipped unless their size is changed here
+    Tab<float> prevChildSizes(framemem_ptr());
+    prevChildSizes.resize(children.size());
+    for (int i = 0, n = children.size(); i < n; ++i)
+      prevChildSizes[i] = children[i]->screenCoord.size[axis];
+
     for (Element *child : children)
-      if (child->layout.size[axis].mode == SizeSpec::CONTENT)
+      if (child->layout.size[axis].mode == SizeSpec::CONTENT && (child->flags & F_LAYOUT_DIRTY))
         child->calcConstrainedSizes(axis);
 
     if (layout.size[axis].mode == SizeSpec::CONTENT)
@@ -1394,9 +1491,14 @@ void Element::calcConstrainedSizes(int axis)
       }
     }
 
-    for (Element *child : children)
-      if (child->layout.size[axis].mode != SizeSpec::CONTENT)
+    for (int i = 0, n = children.size(); i < n; ++i)
+    {
+      Element *child = children[i];
+      if (child->screenCoord.size[axis] != prevChildSizes[i])
+        child->flags |= F_LAYOUT_DIRTY;
+      if (child->layout.size[axis].mode != SizeSpec::CONTENT && (child->flags & F_LAYOUT_DIRTY))
         child->calcConstrainedSizes(axis);
+    }
   }
 
   if (children.empty() || layout.size[axis].mode != SizeSpec::CONTENT)
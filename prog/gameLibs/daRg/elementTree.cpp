@@ -360,6 +360,12 @@ Element *ElementTree::rebuild(HSQUIRRELVM vm, Element *existing, const Component
 
   elem->setup(comp, guiScene, existing ? SM_REBUILD_UPDATE : SM_INITIAL);
 
+  // parents of nested rebuilds are marked by outer calls
+  if (call_depth == 0)
+    elem->invalidateStacks();
+  else
+    elem->updFlags(Element::F_STACKS_DIRTY, true);
+
   if (elem->isHidden() != wasHidden)
     out_flags |= RESULT_ELEMS_ADDED_OR_REMOVED;
   if (!existing && !elem->hotkeyCombos.empty())
@@ -514,6 +520,8 @@ bool ElementTree::removeExpiredFadeOutChildren(Element *elem)
     }
   }
 
+  if (removed)
+    elem->invalidateStacks();
 
   return removed;
 }
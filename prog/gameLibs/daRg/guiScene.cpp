@@ -115,6 +115,7 @@ namespace darg
 CONSOLE_BOOL_VAL("darg", debug_xmb, false);
 CONSOLE_BOOL_VAL("darg", debug_dirpad_nav, false);
 CONSOLE_BOOL_VAL("darg", debug_input_stack, false);
+CONSOLE_BOOL_VAL("darg", reuse_render_list, true);
 
 
 using namespace sqfrp;
@@ -558,7 +559,7 @@ void GuiScene::update(float dt)
   int updRes = etree.update(dt);
   if (updRes & ElementTree::RESULT_ELEMS_ADDED_OR_REMOVED)
   {
-    rebuildElemStacks(updRes & ElementTree::RESULT_HOTKEYS_STACK_MODIFIED);
+    rebuildElemStacks(updRes & ElementTree::RESULT_HOTKEYS_STACK_MODIFIED, true);
     updateHover();
   }
   if (updRes & ElementTree::RESULT_NEED_XMB_REBUILD)
@@ -2906,7 +2907,7 @@ void GuiScene::rebuildInvalidatedParts()
 
   if (etree.rebuildFlagsAccum & rebuildStacksFlags)
   {
-    rebuildElemStacks(etree.rebuildFlagsAccum & ElementTree::RESULT_HOTKEYS_STACK_MODIFIED);
+    rebuildElemStacks(etree.rebuildFlagsAccum & ElementTree::RESULT_HOTKEYS_STACK_MODIFIED, true);
     updateHover();
   }
   if (etree.rebuildFlagsAccum & ElementTree::RESULT_NEED_XMB_REBUILD)
@@ -2944,6 +2945,9 @@ void GuiScene::recalcLayoutFromRoots(dag::Span<Element *> fixed_size_roots, dag:
 
   for (Element *fixedSizeRoot : fixed_size_roots)
   {
+    // mark whole path from root, so that sizes and positions recalc reach changed subtree from any outer root
+    for (Element *e = fixedSizeRoot->getParent(); e; e = e->getParent())
+      e->updFlags(Element::F_LAYOUT_DIRTY, true);
     fixedSizeRoot->calcFixedSizes();
     fixedSizeRoot->updFlags(Element::F_LAYOUT_RECALC_PENDING_FIXED_SIZE, false);
   }
@@ -2957,9 +2961,14 @@ void GuiScene::recalcLayoutFromRoots(dag::Span<Element *> fixed_size_roots, dag:
 
   for (Element *flowRoot : flow_roots)
   {
-    flowRoot->recalcScreenPositions();
+    flowRoot->recalcDirtyScreenPositions();
     flowRoot->updFlags(Element::F_LAYOUT_RECALC_PENDING_FLOW, false);
   }
+
+  // flow recalc clears flags inside flow roots only, path above them was marked by this pass and is clean now
+  for (Element *fixedSizeRoot : fixed_size_roots)
+    for (Element *e = fixedSizeRoot->getParent(); e; e = e->getParent())
+      e->updFlags(Element::F_LAYOUT_DIRTY, false);
 }
 
 
@@ -3142,12 +3151,16 @@ int GuiScene::calcInteractiveFlags()
   return iflags;
 }
 
-void GuiScene::rebuildElemStacks(bool refresh_hotkeys_nav)
+void GuiScene::rebuildElemStacks(bool refresh_hotkeys_nav, bool reuse_clean_subtrees)
 {
   TIME_PROFILE(rebuildElemStacks);
 
   int prevInteractiveFlags = calcInteractiveFlags();
 
+  // changes made by behaviors are not tracked with dirty flags, so reuse is allowed only after tree rebuild/update
+  bool reuseEntries = reuse_clean_subtrees && reuse_render_list.get();
+  if (reuseEntries)
+    renderList.list.swap(renderList.prevList);
   renderList.clear();
   inputStack.clear();
   cursorStack.clear();
@@ -3160,12 +3173,14 @@ void GuiScene::rebuildElemStacks(bool refresh_hotkeys_nav)
     stacks.input = &inputStack;
     stacks.cursors = &cursorStack;
     stacks.eventHandlers = &eventHandlersStack;
+    stacks.rlistPrev = reuseEntries ? &renderList : nullptr;
     ElemStackCounters counters;
 
     etree.root->putToSortedStacks(stacks, counters, 0, false);
   }
 
   renderList.afterRebuild();
+  renderList.prevList.clear();
 
   // validateOverlaidXmbFocus();
 
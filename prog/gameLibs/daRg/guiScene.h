@@ -128,7 +128,7 @@ public:
   void onElementDetached(Element *elem);
   void validateAfterRebuild(Element *elem);
 
-  void rebuildElemStacks(bool refresh_hotkeys_nav);
+  void rebuildElemStacks(bool refresh_hotkeys_nav, bool reuse_clean_subtrees = false);
   void refreshHotkeysNav();
   virtual void notifyInputConsumersCallback() override;
 
@@ -70,6 +70,7 @@ private:
 public:
   typedef dag::Vector<RenderEntry> RListData;
   RListData list;
+  RListData prevList; //< previous list kept during rebuild as source of entries for clean subtrees
 
   dag::Vector<TransformStackItem> transformStack;
   dag::Vector<OpacityStackItem> opacityStack;
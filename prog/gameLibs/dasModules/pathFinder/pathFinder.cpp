@@ -240,6 +240,12 @@ public:
     das::addExtern<DAS_BIND_FUN(pathfinder::rebuildNavMesh_update)>(*this, lib, "rebuildNavMesh_update",
       das::SideEffects::modifyExternal, "pathfinder::rebuildNavMesh_update");
 
+    das::addExtern<DAS_BIND_FUN(pathfinder::rebuildNavMesh_clearPriorityPos)>(*this, lib, "rebuildNavMesh_clearPriorityPos",
+      das::SideEffects::modifyExternal, "pathfinder::rebuildNavMesh_clearPriorityPos");
+
+    das::addExtern<DAS_BIND_FUN(pathfinder::rebuildNavMesh_addPriorityPos)>(*this, lib, "rebuildNavMesh_addPriorityPos",
+      das::SideEffects::modifyExternal, "pathfinder::rebuildNavMesh_addPriorityPos");
+
     das::addExtern<DAS_BIND_FUN(pathfinder::rebuildNavMesh_getProgress)>(*this, lib, "rebuildNavMesh_getProgress",
       das::SideEffects::modifyExternal, "pathfinder::rebuildNavMesh_getProgress");
 
@@ -1556,6 +1556,7 @@ void shutdown_systems()
   G_VERIFY(esDescsAllocator.clear() == 0);
   G_VERIFY(esQueryDescsAllocator.clear() == 0);
   das::Module::Shutdown();
+  set_job_que_on_threadpool(false);
 
 
 #if DAS_SMART_PTR_TRACKER
@@ -3116,6 +3117,7 @@ void bind_dascript::init_das(AotMode enable_aot, HotReload allow_hot_reload, Log
   globally_aot_mode = enable_aot;
   globally_hot_reload = allow_hot_reload;
   globally_log_aot_errors = log_aot_errors;
+  set_job_que_on_threadpool(true);
   debug("daScript: init %s mode, %s hot reload", enable_aot == AotMode::AOT ? "AOT" : "INTERPRET",
     allow_hot_reload == HotReload::ENABLED ? "with" : "without");
 }
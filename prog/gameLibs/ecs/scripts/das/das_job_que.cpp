@@ -0,0 +1,84 @@
+#include <ecs/scripts/dasEs.h>
+#include <daScript/daScript.h>
+#include <daScript/misc/job_que.h>
+#include <util/dag_threadPool.h>
+#include <osApiWrappers/dag_critSec.h>
+#include <dag/dag_vector.h>
+#include <debug/dag_debug.h>
+
+// Runs daScript JobQue (new_job, parallel_for of with_job_que) on engine thread pool instead of JobQue own threads, one per core,
+// which compete with thread pool workers for the same cores
+
+namespace bind_dascript
+{
+static threadpool::JobPriority to_threadpool_prio(das::JobPriority priority)
+{
+  if (priority >= das::JobPriority::High)
+    return threadpool::PRIO_HIGH;
+  return priority <= das::JobPriority::Low ? threadpool::PRIO_LOW : threadpool::PRIO_NORMAL;
+}
+
+class ThreadPoolJobQueExecutor final : public das::JobQueExecutor
+{
+  struct DasJob final : public cpujobs::IJob
+  {
+    ThreadPoolJobQueExecutor *owner = nullptr;
+    das::Job job;
+    void doJob() override
+    {
+      job();
+      job = nullptr;
+      owner->release(this);
+    }
+  };
+
+public:
+  ~ThreadPoolJobQueExecutor()
+  {
+    for (DasJob *j : freeJobs)
+      threadpool::wait(j);
+    clear_all_ptr_items(freeJobs);
+  }
+
+  int getTotalHwJobs() override { return threadpool::get_num_workers(); }
+
+  void execute(das::Job &&job, das::JobPriority priority) override
+  {
+    DasJob *j = nullptr;
+    {
+      WinAutoLock lock(mutex);
+      if (!freeJobs.empty())
+      {
+        j = freeJobs.back();
+        freeJobs.pop_back();
+      }
+    }
+    if (!j)
+    {
+      j = new DasJob;
+      j->owner = this;
+    }
+    j->job = eastl::move(job);
+    threadpool::add(j, to_threadpool_prio(priority)); // executed in place when thread pool is already shut down
+  }
+
+private:
+  WinCritSec mutex;
+  dag::Vector<DasJob *> freeJobs;
+
+  // job is reused only after it is done (threadpool::add waits for that), so it can be released from its own doJob
+  void release(DasJob *j)
+  {
+    WinAutoLock lock(mutex);
+    freeJobs.push_back(j);
+  }
+};
+
+static ThreadPoolJobQueExecutor thread_pool_job_que_executor;
+
+void set_job_que_on_threadpool(bool enable)
+{
+  das::set_job_que_executor(enable ? &thread_pool_job_que_executor : nullptr);
+  debug("daScript: job que runs on %s", enable ? "thread pool" : "own threads");
+}
+} // namespace bind_dascript
@@ -0,0 +1,229 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <ecs/scripts/dasEs.h>
+#include <daScript/daScript.h>
+#include <daScript/misc/job_que.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <util/dag_threadPool.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <generic/dag_tab.h>
+#include <stdio.h>
+#include <string.h>
+
+// Usage: tests [JobQueOnThreadPool|Benchmark]
+// JobQueOnThreadPool checks that daScript JobQue executes every job exactly once when it runs on thread pool, and that job
+// contexts reused from pool have globals and heap reset. Benchmark runs
+// game-like frames of thread pool jobs while daScript parallel_for runs in background, with JobQue on own threads and on thread
+// pool, and reports peak number of computations running at once (more than cores means oversubscription) and frame times
+
+static constexpr int WORK_ITERATIONS = 20000;
+static const char *DAS_ROOT = "../../../../../1stPartyLibs/daScript"; // tests are run from their folder, for daslib
+
+// runs jobs one after another, so each next job can get context of previous one from pool; job changes globals and allocates
+// on heap, so each report should be the same as of the first job, which got fresh clone
+static const char *POOLED_JOBS_DAS = R"(
+options indenting = 4
+require daslib/jobque_boost
+require rtti
+require fio
+
+struct JobReport
+    context : uint64
+    counter : int
+    listLength : int
+    heapBytes : uint64
+
+var g_counter = 0
+var g_list : array<int>
+
+// returns number of jobs which reused context of previous one, or -1 if reused context wasn't reset
+[export]
+def run_jobs(runs : int) : int
+    var reused = 0
+    var ok = true
+    var firstHeapBytes = 0ul
+    var contexts : array<uint64>
+    with_job_que <|
+        for r in range(runs)
+            with_channel(1) <| $(channel)
+                new_job <| @
+                    g_counter ++
+                    g_list |> push(r)
+                    var report = [[JobReport counter=g_counter, listLength=length(g_list)]]
+                    report.context = intptr(unsafe(addr(this_context())))
+                    report.heapBytes = heap_bytes_allocated()
+                    channel |> push_clone(report)
+                    channel |> notify_and_release
+                for rep in each_clone(channel, type<JobReport>)
+                    ok = ok && rep.counter == 1 && rep.listLength == 1
+                    if r == 0
+                        firstHeapBytes = rep.heapBytes
+                    else
+                        ok = ok && rep.heapBytes <= firstHeapBytes
+                    if find_index(contexts, rep.context) != -1
+                        reused ++
+                    contexts |> push(rep.context)
+            sleep(10u) // let JobQue drop finished job, so its context is back in pool
+    return ok ? reused : -1
+)";
+static constexpr int FRAMES = 200;
+
+static int num_workers = 0;
+static volatile int running = 0, peak_running = 0, sink = 0;
+
+static void init_test_env()
+{
+  measure_cpu_freq();
+  cpujobs::init();
+  num_workers = max(cpujobs::get_core_count() - 1, 2); // main thread takes remaining core
+  threadpool::init(num_workers, 2048, 256 << 10);
+}
+
+static void compute()
+{
+  int now = interlocked_increment(running);
+  for (int peak = interlocked_acquire_load(peak_running); now > peak; peak = interlocked_acquire_load(peak_running))
+    if (interlocked_compare_exchange(peak_running, now, peak) == peak)
+      break;
+  float v = 1.f;
+  for (int i = 0; i < WORK_ITERATIONS; ++i)
+    v = v * 1.0001f + 0.5f / (v + 1.f);
+  interlocked_add(sink, int(v));
+  interlocked_decrement(running);
+}
+
+struct ComputeJob final : public cpujobs::IJob
+{
+  void doJob() override { compute(); }
+};
+
+class DasLoadThread final : public DaThread
+{
+public:
+  das::JobQue &que;
+  volatile int runs = 0;
+
+  DasLoadThread(das::JobQue &que_) : DaThread("DasLoadThread"), que(que_) {}
+  void execute() override
+  {
+    while (!interlocked_acquire_load(terminating))
+    {
+      que.parallel_for(0, 256, [](int from, int to) {
+        for (int i = from; i < to; ++i)
+          compute();
+      }, 0, das::JobPriority::Default);
+      interlocked_increment(runs);
+    }
+  }
+};
+
+SUITE(JobQueOnThreadPool)
+{
+  TEST(AllJobsAreExecuted)
+  {
+    static constexpr int PUSHED = 1000, RANGE = 10000;
+    bind_dascript::set_job_que_on_threadpool(true);
+    {
+      das::JobQue que;
+      CHECK_EQUAL(threadpool::get_num_workers(), que.getTotalHwJobs());
+      volatile int pushed = 0;
+      const das::JobPriority prios[] = {das::JobPriority::Low, das::JobPriority::Medium, das::JobPriority::High};
+      for (int i = 0; i < PUSHED; ++i)
+        que.push([&pushed]() { interlocked_increment(pushed); }, 0, prios[i % countof(prios)]);
+      Tab<int> hits;
+      hits.resize(RANGE);
+      mem_set_0(hits);
+      que.parallel_for(0, RANGE, [&hits](int from, int to) {
+        for (int i = from; i < to; ++i)
+          interlocked_increment(hits[i]);
+      }, 0, das::JobPriority::High);
+      que.wait();
+      CHECK_EQUAL(PUSHED, interlocked_acquire_load(pushed));
+      int wrong = 0;
+      for (int h : hits)
+        wrong += h != 1 ? 1 : 0;
+      CHECK_EQUAL(0, wrong);
+    }
+    bind_dascript::set_job_que_on_threadpool(false);
+  }
+
+  TEST(PooledJobContextsAreReset)
+  {
+    static constexpr int RUNS = 20;
+    bind_dascript::set_job_que_on_threadpool(true);
+    das::daScriptEnvironment::ensure();
+    das::setDasRoot(DAS_ROOT);
+    NEED_MODULE(Module_BuiltIn);
+    NEED_MODULE(Module_Math);
+    NEED_MODULE(Module_Strings);
+    NEED_MODULE(Module_Rtti);
+    NEED_MODULE(Module_Ast);
+    NEED_MODULE(Module_FIO);
+    NEED_MODULE(Module_JobQue);
+    das::Module::Initialize();
+    {
+      auto fAccess = das::make_smart<das::FsFileAccess>();
+      fAccess->setFileInfo("pooled_jobs.das",
+        das::make_unique<das::TextFileInfo>(POOLED_JOBS_DAS, uint32_t(strlen(POOLED_JOBS_DAS)), false));
+      das::TextPrinter tout;
+      das::ModuleGroup libGroup;
+      das::ProgramPtr program = das::compileDaScript("pooled_jobs.das", fAccess, tout, libGroup);
+      CHECK(!program->failed());
+      das::Context ctx(program->getContextStackSize());
+      das::SimFunction *fn = !program->failed() && program->simulate(ctx, tout) ? ctx.findFunction("run_jobs") : nullptr;
+      CHECK(fn != nullptr);
+      if (fn)
+      {
+        vec4f args[1] = {das::cast<int>::from(RUNS)};
+        const int reused = das::cast<int>::to(ctx.evalWithCatch(fn, args));
+        CHECK(ctx.getException() == nullptr);
+        CHECK(reused > 0); // -1 when reused context wasn't reset
+        printf("%d of %d jobs reused pooled context\n", max(reused, 0), RUNS);
+      }
+    }
+    das::Module::Shutdown();
+    bind_dascript::set_job_que_on_threadpool(false);
+  }
+}
+
+SUITE(Benchmark)
+{
+  TEST(Oversubscription)
+  {
+    Tab<ComputeJob> jobs;
+    jobs.resize(num_workers * 4);
+    for (bool onThreadPool : {false, true})
+    {
+      bind_dascript::set_job_que_on_threadpool(onThreadPool);
+      das::JobQue que;
+      DasLoadThread dasLoad(que);
+      dasLoad.start();
+      peak_running = 0;
+      int totalUsec = 0, maxUsec = 0;
+      for (int f = 0; f < FRAMES; ++f)
+      {
+        int64_t reft = ref_time_ticks();
+        for (ComputeJob &j : jobs)
+          threadpool::add(&j, threadpool::PRIO_HIGH, false);
+        threadpool::wake_up_all();
+        for (ComputeJob &j : jobs)
+          threadpool::wait(&j);
+        int usec = get_time_usec(reft);
+        totalUsec += usec;
+        maxUsec = max(maxUsec, usec);
+      }
+      dasLoad.terminate(true);
+      printf("das job que on %s: peak %d computations at once on %d cores (%d thread pool workers), frame avg %.2f ms, max %.2f ms, "
+             "%d parallel_for runs\n",
+        onThreadPool ? "thread pool" : "own threads", interlocked_acquire_load(peak_running), cpujobs::get_core_count(), num_workers,
+        totalUsec / (1000.f * FRAMES), maxUsec / 1000.f, interlocked_acquire_load(dasLoad.runs));
+      if (onThreadPool)
+        CHECK(interlocked_acquire_load(peak_running) <= num_workers + 1); // workers and das thread running its part of parallel_for
+    }
+    bind_dascript::set_job_que_on_threadpool(false);
+  }
+}
+
+#define CUSTOM_UNITTEST_CODE init_test_env();
+#include <unittest/main.inc.cpp>
@@ -0,0 +1,333 @@
+#include "batchDelivery.h"
+#include "httpRequest.h"
+
+#include <eventLog/eventLog.h>
+#include <util/dag_string.h>
+#include <util/dag_globDef.h>
+#include <dag/dag_vector.h>
+#include <ioSys/dag_zstdIo.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_events.h>
+#include <osApiWrappers/dag_critSec.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <osApiWrappers/dag_direct.h>
+#include <osApiWrappers/dag_files.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <math/random/dag_random.h>
+#include <debug/dag_debug.h>
+#include <EASTL/deque.h>
+#include <EASTL/sort.h>
+#include <stdlib.h>
+
+// Events (complete packets, as they would be sent with send_http) are appended to current batch under lock, everything else
+// is done by delivery thread: it closes batch when it is big or old enough, compresses it and puts to queue (spool files named
+// by sequence number when spool dir is set, memory otherwise), then posts queued batches oldest first. On failure posting is
+// retried with exponential backoff with jitter; batches rejected by collector (4xx besides 408/429) are dropped, as they will
+// never be accepted.
+
+namespace event_log
+{
+namespace batch
+{
+static constexpr int ZSTD_LEVEL = 5;
+static constexpr int MIN_BACKOFF_MS = 1000;
+static constexpr int MAX_BACKOFF_MS = 5 * 60 * 1000;
+static constexpr int IDLE_WAIT_MS = 1000;
+static const char *CONTENT_TYPE = "application/x-event-log-batch";
+static const char *SPOOL_EXT = ".evb";
+
+struct QueuedBatch
+{
+  uint64_t seq;
+  uint32_t size;
+  dag::Vector<char> data; // empty when batch is in spool file
+};
+
+class DeliveryThread final : public DaThread
+{
+public:
+  DeliveryThread(const EventLogInitParams &params, const char *url_, const char *user_agent, uint32_t timeout_sec) :
+    DaThread("EventLogDelivery", 256 << 10),
+    url(url_),
+    userAgent(user_agent),
+    spoolDir(params.spool_dir ? params.spool_dir : ""),
+    timeoutSec(timeout_sec),
+    maxBatchBytes(max(params.batch_max_bytes, 1024u)),
+    maxDelayMs(params.batch_max_delay_ms),
+    spoolMaxBytes(params.spool_max_bytes)
+  {
+    os_event_create(&wakeEvent);
+    if (!spoolDir.empty())
+    {
+      const char last = spoolDir[spoolDir.length() - 1];
+      if (last != '/' && last != '\\')
+        spoolDir += "/";
+      dd_mkpath(spoolDir);
+    }
+  }
+  ~DeliveryThread() { os_event_destroy(&wakeEvent); }
+
+  void push(const void *packet, uint32_t size)
+  {
+    bool full;
+    {
+      WinAutoLock lock(mutex);
+      if (pending.empty())
+        pendingStartMs = get_time_msec();
+      const size_t pos = pending.size();
+      pending.resize(pos + sizeof(size) + size);
+      memcpy(pending.data() + pos, &size, sizeof(size));
+      memcpy(pending.data() + pos + sizeof(size), packet, size);
+      full = pending.size() >= maxBatchBytes;
+    }
+    if (full)
+      os_event_set(&wakeEvent);
+  }
+
+  void flush()
+  {
+    interlocked_release_store(flushRequested, 1);
+    os_event_set(&wakeEvent);
+  }
+
+  void stop()
+  {
+    terminate(true, -1, &wakeEvent);
+    // delivery thread is stopped: close last batch here and, without spool, try to send memory queue once
+    closeBatch(true);
+    if (spoolDir.empty())
+      while (!queue.empty() && postFront(true) > 0) {}
+    if (!queue.empty())
+      debug("[event_log] %d batches left undelivered%s", (int)queue.size(), spoolDir.empty() ? " (lost)" : " in spool");
+  }
+
+  void execute() override
+  {
+    loadSpool();
+    while (!interlocked_acquire_load(terminating))
+    {
+      const int waitMs = waitTimeMs();
+      if (waitMs > 0) // zero timeout means infinite wait on some platforms
+        os_event_wait(&wakeEvent, waitMs);
+      closeBatch(false);
+      while (!queue.empty() && get_time_msec() - nextAttemptMs >= 0 && !interlocked_acquire_load(terminating))
+      {
+        int res = postFront(false);
+        if (res < 0)
+        {
+          backoffMs = backoffMs ? min(backoffMs * 2, MAX_BACKOFF_MS) : MIN_BACKOFF_MS;
+          nextAttemptMs = get_time_msec() + backoffMs * (3 + rnd_int(0, 2)) / 4; // +-25% jitter to not retry in sync with others
+          break;
+        }
+        backoffMs = 0;
+      }
+    }
+  }
+
+private:
+  String url, userAgent, spoolDir;
+  uint32_t timeoutSec, maxBatchBytes, maxDelayMs, spoolMaxBytes;
+  os_event_t wakeEvent;
+
+  WinCritSec mutex; // guards pending and pendingStartMs
+  dag::Vector<char> pending;
+  int pendingStartMs = 0;
+  volatile int flushRequested = 0;
+
+  // accessed by delivery thread only (or after it is stopped)
+  eastl::deque<QueuedBatch> queue;
+  uint64_t queueBytes = 0, nextSeq = 1;
+  int backoffMs = 0, nextAttemptMs = 0;
+  dag::Vector<char> zbuf;
+
+  int waitTimeMs()
+  {
+    int t = IDLE_WAIT_MS, now = get_time_msec();
+    if (!queue.empty())
+      t = min(t, nextAttemptMs - now);
+    WinAutoLock lock(mutex);
+    if (!pending.empty())
+      t = min(t, pendingStartMs + (int)maxDelayMs - now);
+    return max(t, 0);
+  }
+
+  void spoolFileName(String &fn, uint64_t seq) const { fn.printf(0, "%s%016llx%s", spoolDir, (unsigned long long)seq, SPOOL_EXT); }
+
+  void loadSpool()
+  {
+    if (spoolDir.empty())
+      return;
+    String mask(0, "%s*%s", spoolDir, SPOOL_EXT);
+    alefind_t ff;
+    if (::dd_find_first(mask, 0, &ff))
+    {
+      do
+        if (uint64_t seq = strtoull(ff.name, nullptr, 16))
+          queue.push_back(QueuedBatch{seq, (uint32_t)ff.size, {}});
+      while (::dd_find_next(&ff));
+      ::dd_find_close(&ff);
+    }
+    eastl::sort(queue.begin(), queue.end(), [](const QueuedBatch &a, const QueuedBatch &b) { return a.seq < b.seq; });
+    for (const QueuedBatch &b : queue)
+      queueBytes += b.size;
+    if (!queue.empty())
+    {
+      nextSeq = queue.back().seq + 1;
+      debug("[event_log] %d batches (%llu bytes) found in spool '%s'", (int)queue.size(), (unsigned long long)queueBytes, spoolDir);
+    }
+    trimQueue();
+  }
+
+  void closeBatch(bool force)
+  {
+    dag::Vector<char> batch;
+    {
+      WinAutoLock lock(mutex);
+      if (pending.empty())
+        return;
+      if (!force && !interlocked_exchange(flushRequested, 0) && pending.size() < maxBatchBytes &&
+          get_time_msec() - pendingStartMs < (int)maxDelayMs)
+        return;
+      batch.swap(pending);
+    }
+
+    zbuf.resize(zstd_compress_bound(batch.size()));
+    size_t zsize = zstd_compress(zbuf.data(), zbuf.size(), batch.data(), batch.size(), ZSTD_LEVEL);
+    if (!zsize || zsize > zbuf.size())
+    {
+      logwarn("[event_log] failed to compress batch of %d bytes", (int)batch.size());
+      return;
+    }
+
+    QueuedBatch qb{nextSeq++, (uint32_t)zsize, {}};
+    if (spoolDir.empty() || !writeSpoolFile(qb.seq, zbuf.data(), (int)zsize))
+      qb.data.assign(zbuf.begin(), zbuf.begin() + zsize);
+    queue.push_back(eastl::move(qb));
+    queueBytes += zsize;
+    trimQueue();
+  }
+
+  bool writeSpoolFile(uint64_t seq, const void *data, int size)
+  {
+    String fn, tmpFn;
+    spoolFileName(fn, seq);
+    tmpFn.printf(0, "%s.tmp", fn);
+    file_ptr_t fp = df_open(tmpFn, DF_WRITE | DF_CREATE);
+    if (!fp)
+      return false;
+    bool ok = df_write(fp, data, size) == size;
+    df_close(fp);
+    if (ok && dd_rename(tmpFn, fn)) // rename makes file appear complete
+      return true;
+    dd_erase(tmpFn);
+    return false;
+  }
+
+  void trimQueue()
+  {
+    int dropped = 0;
+    while (queueBytes > spoolMaxBytes && queue.size() > 1)
+    {
+      dropFront();
+      dropped++;
+    }
+    if (dropped)
+      logwarn("[event_log] event batch queue exceeds %u bytes, %d oldest batches dropped", spoolMaxBytes, dropped);
+  }
+
+  void dropFront()
+  {
+    QueuedBatch &b = queue.front();
+    if (b.data.empty())
+    {
+      String fn;
+      spoolFileName(fn, b.seq);
+      dd_erase(fn);
+    }
+    queueBytes -= b.size;
+    queue.pop_front();
+  }
+
+  // returns http code or -1 when batch should be retried later
+  // delivery thread doesn't poll http requests (with pollInThread=false that would run callbacks of other requests on it),
+  // thread which owns polling (caller of stop) does
+  int postFront(bool poll_requests)
+  {
+    QueuedBatch &b = queue.front();
+    dag::Vector<char> fileData;
+    const dag::Vector<char> *data = &b.data;
+    if (b.data.empty())
+    {
+      String fn;
+      spoolFileName(fn, b.seq);
+      file_ptr_t fp = df_open(fn, DF_READ);
+      if (fp)
+      {
+        fileData.resize(df_length(fp));
+        if (df_read(fp, fileData.data(), (int)fileData.size()) != (int)fileData.size())
+          fileData.clear();
+        df_close(fp);
+      }
+      if (fileData.empty())
+      {
+        logwarn("[event_log] can't read spooled batch '%s', skipped", fn);
+        dropFront();
+        return 0;
+      }
+      data = &fileData;
+    }
+
+    const uint32_t size = (uint32_t)data->size();
+    int code = poll_requests ? http::post_sync(url, data->data(), size, userAgent, timeoutSec, CONTENT_TYPE, "zstd")
+                             : http::post_wait(url, data->data(), size, userAgent, timeoutSec, CONTENT_TYPE, "zstd", terminating);
+    if (code >= 200 && code < 300)
+      dropFront();
+    else if (code >= 400 && code < 500 && code != 408 && code != 429)
+    {
+      logwarn("[event_log] batch of %d bytes rejected by collector with code %d, dropped", (int)data->size(), code);
+      dropFront();
+    }
+    else
+    {
+      debug("[event_log] failed to post batch (code %d), %d batches queued", code, (int)queue.size());
+      return -1;
+    }
+    return code;
+  }
+};
+
+static DeliveryThread *delivery = nullptr;
+
+bool init(const EventLogInitParams &params, const char *url, const char *user_agent, uint32_t timeout_sec)
+{
+  G_ASSERT_RETURN(!delivery, true);
+  delivery = new DeliveryThread(params, url, user_agent, timeout_sec);
+  if (delivery->start())
+    return true;
+  del_it(delivery);
+  return false;
+}
+
+void shutdown()
+{
+  if (!delivery)
+    return;
+  delivery->stop();
+  del_it(delivery);
+}
+
+bool is_enabled() { return delivery != nullptr; }
+
+void push(const void *packet, uint32_t size)
+{
+  if (delivery)
+    delivery->push(packet, size);
+}
+
+void flush()
+{
+  if (delivery)
+    delivery->flush();
+}
+} // namespace batch
+} // namespace event_log
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+
+namespace event_log
+{
+struct EventLogInitParams;
+
+namespace batch
+{
+bool init(const EventLogInitParams &params, const char *url, const char *user_agent, uint32_t timeout_sec);
+void shutdown(); // current batch is spooled (or sent once, when there is no spool)
+bool is_enabled();
+void push(const void *packet, uint32_t size);
+void flush();
+} // namespace batch
+} // namespace event_log
@@ -16,6 +16,7 @@
 
 #include "dataHelpers.h"
 #include "httpRequest.h"
+#include "batchDelivery.h"
 
 #define LOGLEVEL_DEBUG _MAKE4C('EVLG')
 
@@ -171,6 +172,9 @@ bool init(EventLogInitParams const &init_params)
     defaults::meta["system_id"] = id.c_str();
 
 
+  if (init_params.batch_delivery && !batch::init(init_params, config->url.str(), config->userAgent.str(), config->timeout))
+    logwarn("[network] Could not start event log batch delivery, events will be sent immediately");
+
   orig_debug_log = debug_set_log_callback(netlog_handler);
   return true;
 }
@@ -181,6 +185,7 @@ void shutdown()
   if (!is_enabled())
     return;
 
+  batch::shutdown();
   udp_socket.demandDestroy();
   del_it(config);
   os_sockets_shutdown();
@@ -208,9 +213,15 @@ void send_http_instant(const char *type, const void *data, uint32_t size, Json::
 
 void send_http(const char *type, const void *data, uint32_t size, Json::Value *meta)
 {
-  send_http_impl(http::post_async, type, data, size, meta);
+  if (batch::is_enabled())
+    send_http_impl([](const char *, const void *data, uint32_t size, const char *, uint32_t) { batch::push(data, size); }, type, data,
+      size, meta);
+  else
+    send_http_impl(http::post_async, type, data, size, meta);
 }
 
+void flush_batched() { batch::flush(); }
+
 void send_udp(const char *type, const void *data, uint32_t size, Json::Value *meta)
 {
   if (!is_enabled())
@@ -1,6 +1,8 @@
 #include "httpRequest.h"
 #include <asyncHTTPClient/asyncHTTPClient.h>
 #include <osApiWrappers/dag_events.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <perfMon/dag_cpuFreq.h>
 #include <debug/dag_debug.h>
 
 
@@ -11,9 +13,13 @@ namespace http
 
 template <typename F>
 static httprequests::RequestId make_request(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout,
-  const F &callback)
+  const F &callback, const char *content_type = nullptr, const char *content_encoding = nullptr)
 {
   httprequests::AsyncRequestParams reqParams;
+  if (content_type)
+    reqParams.headers.emplace_back("Content-Type", content_type);
+  if (content_encoding)
+    reqParams.headers.emplace_back("Content-Encoding", content_encoding);
   reqParams.url = url;
   reqParams.reqType = httprequests::HTTPReq::POST; //-V1048
   reqParams.userAgent = user_agent;
@@ -26,14 +32,20 @@ static httprequests::RequestId make_request(const char *url, const void *data, u
 }
 
 
-void post(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout)
+int post_sync(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout, const char *content_type,
+  const char *content_encoding)
 {
   os_event_t event;
   os_event_create(&event);
-  make_request(url, data, size, user_agent, timeout, [&event](httprequests::RequestStatus status, int http_code, auto, auto) {
-    debug("%s finished with %d/%d", __FUNCTION__, int(status), http_code);
-    os_event_set(&event);
-  });
+  int result = -1;
+  make_request(
+    url, data, size, user_agent, timeout,
+    [&event, &result](httprequests::RequestStatus status, int http_code, auto, auto) {
+      debug("%s finished with %d/%d", __FUNCTION__, int(status), http_code);
+      result = status == httprequests::RequestStatus::SUCCESS ? http_code : -1;
+      os_event_set(&event);
+    },
+    content_type, content_encoding);
 
   do
   {
@@ -44,6 +56,66 @@ void post(const char *url, const void *data, uint32_t size, const char *user_age
   } while (1);
 
   os_event_destroy(&event);
+  return result;
+}
+
+
+// shared by waiting thread and request callback, which is called later when wait was cancelled or timed out
+struct PostWaitState
+{
+  os_event_t event;
+  volatile int refCount = 2;
+  volatile int result = -1;
+  PostWaitState() { os_event_create(&event); }
+  ~PostWaitState() { os_event_destroy(&event); }
+  void release()
+  {
+    if (interlocked_decrement(refCount) == 0)
+      delete this;
+  }
+};
+
+int post_wait(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout, const char *content_type,
+  const char *content_encoding, volatile int &cancel)
+{
+  static constexpr int CANCEL_CHECK_MS = 100;
+  PostWaitState *state = new PostWaitState;
+  make_request(
+    url, data, size, user_agent, timeout,
+    [state](httprequests::RequestStatus status, int http_code, auto, auto) {
+      debug("%s finished with %d/%d", __FUNCTION__, int(status), http_code);
+      interlocked_release_store(state->result, status == httprequests::RequestStatus::SUCCESS ? http_code : -1);
+      os_event_set(&state->event);
+      state->release();
+    },
+    content_type, content_encoding);
+
+  // request times out only while it is polled, so don't wait forever if owner of http requests doesn't poll them
+  const int startMs = get_time_msec(), maxWaitMs = timeout * 2000 + 1000;
+  int result = -1;
+  for (;;)
+  {
+    if (os_event_wait(&state->event, CANCEL_CHECK_MS) != OS_WAIT_TIMEOUTED)
+    {
+      result = interlocked_acquire_load(state->result);
+      break;
+    }
+    if (interlocked_acquire_load(cancel))
+      break;
+    if (get_time_msec() - startMs > maxWaitMs)
+    {
+      debug("%s: no response from '%s' in %d ms (http requests aren't polled?)", __FUNCTION__, url, maxWaitMs);
+      break;
+    }
+  }
+  state->release();
+  return result;
+}
+
+
+void post(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout)
+{
+  post_sync(url, data, size, user_agent, timeout, nullptr, nullptr);
 }
 
 
@@ -7,6 +7,14 @@ namespace event_log
 {
 namespace http
 {
+// waits for request completion, returns http code or -1 if request failed
+// polls http requests itself (dispatching callbacks of all of them), so it is for thread which polls them anyway
+int post_sync(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout, const char *content_type,
+  const char *content_encoding);
+// same, for other threads: waits for callback dispatched by poller of http requests (main thread or poll thread),
+// returns -1 without waiting for completion when cancel is set
+int post_wait(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout, const char *content_type,
+  const char *content_encoding, volatile int &cancel);
 void post(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout);
 void post_async(const char *url, const void *data, uint32_t size, const char *user_agent, uint32_t timeout);
 } // namespace http
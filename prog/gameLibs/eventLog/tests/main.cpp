@@ -0,0 +1,287 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <eventLog/eventLog.h>
+#include <asyncHTTPClient/asyncHTTPClient.h>
+#include <ioSys/dag_zstdIo.h>
+#include <osApiWrappers/dag_sockets.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_critSec.h>
+#include <osApiWrappers/dag_direct.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <util/dag_string.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local HTTP stand-in for event log collector: answers requests with scripted status codes and keeps request bodies, so tests
+// check batch wire format (zstd-compressed sequence of uint32 size + packet), retries and spooling of undelivered batches
+
+static constexpr int BASE_PORT = 17800;
+static const char *PAYLOAD = "test_event_payload";
+
+struct Request
+{
+  eastl::string headers, body;
+  int answeredCode = 0;
+};
+
+class StandInServer final : public DaThread
+{
+public:
+  int port = 0;
+
+  StandInServer(eastl::vector<int> codes_) : DaThread("StandInServer"), codes(eastl::move(codes_))
+  {
+    for (int p = BASE_PORT; p < BASE_PORT + 16 && sock == OS_SOCKET_INVALID; p++)
+    {
+      sock = os_socket_create(OSAF_IPV4, OST_TCP);
+      os_socket_set_reuse_addr(sock, true);
+      sockets::SocketAddr<OSAF_IPV4> addr("127.0.0.1", (uint16_t)p);
+      int addrLen = 0;
+      const os_socket_addr *raw = addr.getRawAddr(addrLen);
+      if (os_socket_bind(sock, raw, addrLen) == 0 && os_socket_listen(sock, 4) == 0)
+        port = p;
+      else
+      {
+        os_socket_close(sock);
+        sock = OS_SOCKET_INVALID;
+      }
+    }
+    start();
+  }
+  ~StandInServer()
+  {
+    terminate(true);
+    os_socket_close(sock);
+  }
+
+  eastl::vector<Request> getRequests()
+  {
+    WinAutoLock lock(mutex);
+    return requests;
+  }
+
+  // waits until request with 2xx answer is received
+  // test thread polls http requests, as main thread does (delivery thread only waits for callbacks)
+  bool waitDelivered(int timeout_ms)
+  {
+    for (int t = 0; t < timeout_ms; t += 10, sleep_msec(10))
+    {
+      httprequests::poll();
+      for (const Request &r : getRequests())
+        if (r.answeredCode / 100 == 2)
+          return true;
+    }
+    return false;
+  }
+  void waitRequests(int count, int timeout_ms)
+  {
+    for (int t = 0; t < timeout_ms && (int)getRequests().size() < count; t += 10, sleep_msec(10))
+      httprequests::poll();
+  }
+
+  void execute() override
+  {
+    while (!terminating)
+    {
+      if (os_socket_read_select(sock, 0, 10000) <= 0)
+        continue;
+      os_socket_t conn = os_socket_accept(sock, nullptr, nullptr);
+      if (conn != OS_SOCKET_INVALID)
+        serve(conn);
+    }
+  }
+
+private:
+  os_socket_t sock = OS_SOCKET_INVALID;
+  eastl::vector<int> codes;
+  WinCritSec mutex;
+  eastl::vector<Request> requests;
+
+  void serve(os_socket_t conn)
+  {
+    Request req;
+    eastl::string data;
+    size_t headersEnd = eastl::string::npos, contentLen = 0;
+    bool continueSent = false;
+    char buf[4096];
+    for (;;)
+    {
+      if (headersEnd != eastl::string::npos && data.size() >= headersEnd + contentLen)
+        break;
+      if (os_socket_read_select(conn, 5) <= 0)
+        break;
+      int len = os_socket_recvfrom(conn, buf, sizeof(buf));
+      if (len <= 0)
+        break;
+      data.append(buf, buf + len);
+      if (headersEnd == eastl::string::npos && (headersEnd = data.find("\r\n\r\n")) != eastl::string::npos)
+      {
+        headersEnd += 4;
+        req.headers = data.substr(0, headersEnd);
+        const char *cl = strstr(req.headers.c_str(), "Content-Length:");
+        contentLen = cl ? strtoul(cl + 15, nullptr, 10) : 0;
+        if (!continueSent && strstr(req.headers.c_str(), "Expect: 100-continue"))
+        {
+          const char *cont = "HTTP/1.1 100 Continue\r\n\r\n";
+          os_socket_send(conn, cont, (int)strlen(cont));
+          continueSent = true;
+        }
+      }
+    }
+    if (headersEnd != eastl::string::npos)
+    {
+      req.body = data.substr(headersEnd);
+      WinAutoLock lock(mutex);
+      req.answeredCode = requests.size() < codes.size() ? codes[requests.size()] : 200;
+      requests.push_back(req);
+      String answer(0, "HTTP/1.1 %d Stand-In\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", req.answeredCode);
+      os_socket_send(conn, answer.c_str(), answer.length());
+    }
+    os_socket_close(conn);
+  }
+};
+
+struct HttpClientScope
+{
+  HttpClientScope()
+  {
+    os_sockets_init();
+    httprequests::init_async(httprequests::InitAsyncParams());
+  }
+  ~HttpClientScope()
+  {
+    httprequests::shutdown_async();
+    os_sockets_shutdown();
+  }
+};
+
+static event_log::EventLogInitParams make_params(int port, const char *spool_dir)
+{
+  event_log::EventLogInitParams params;
+  params.host = "127.0.0.1";
+  params.http_port = (uint16_t)port;
+  params.use_https = false;
+  params.user_agent = "eventLogTests";
+  params.batch_delivery = true;
+  params.spool_dir = spool_dir;
+  params.batch_max_delay_ms = 100;
+  return params;
+}
+
+// returns number of packets in batch carrying PAYLOAD, -1 if batch is malformed
+static int count_events(const eastl::string &body)
+{
+  eastl::vector<char> raw(16 << 20);
+  size_t rawSize = zstd_decompress(raw.data(), raw.size(), body.data(), body.size());
+  if (!rawSize || rawSize > raw.size())
+    return -1;
+  int count = 0;
+  for (size_t pos = 0; pos < rawSize;)
+  {
+    uint32_t size;
+    if (pos + sizeof(size) > rawSize)
+      return -1;
+    memcpy(&size, raw.data() + pos, sizeof(size));
+    pos += sizeof(size);
+    if (pos + size > rawSize)
+      return -1;
+    const eastl::string packet(raw.data() + pos, raw.data() + pos + size);
+    count += packet.find(PAYLOAD) != eastl::string::npos ? 1 : 0;
+    pos += size;
+  }
+  return count;
+}
+
+static int count_spooled(const char *dir)
+{
+  int count = 0;
+  alefind_t ff;
+  if (::dd_find_first(String(0, "%s/*.evb", dir), 0, &ff))
+  {
+    do
+      count++;
+    while (::dd_find_next(&ff));
+    ::dd_find_close(&ff);
+  }
+  return count;
+}
+
+TEST(BatchIsRetriedAfterServerError)
+{
+  HttpClientScope http;
+  StandInServer server({503});
+  CHECK(server.port != 0);
+
+  CHECK(event_log::init(make_params(server.port, nullptr)));
+  for (int i = 0; i < 50; i++)
+    event_log::send_http("test", PAYLOAD, (uint32_t)strlen(PAYLOAD));
+  event_log::flush_batched();
+  CHECK(server.waitDelivered(10000));
+  event_log::shutdown();
+
+  eastl::vector<Request> reqs = server.getRequests();
+  CHECK_EQUAL(2, (int)reqs.size());
+  if (reqs.size() != 2)
+    return;
+  CHECK_EQUAL(503, reqs[0].answeredCode);
+  CHECK_EQUAL(200, reqs[1].answeredCode);
+  CHECK(reqs[0].body == reqs[1].body);
+  CHECK(strstr(reqs[1].headers.c_str(), "Content-Encoding: zstd") != nullptr);
+  CHECK(strstr(reqs[1].headers.c_str(), "Content-Type: application/x-event-log-batch") != nullptr);
+  CHECK_EQUAL(50, count_events(reqs[1].body));
+}
+
+TEST(BatchIsDroppedWhenRejected)
+{
+  HttpClientScope http;
+  StandInServer server({400});
+
+  CHECK(event_log::init(make_params(server.port, nullptr)));
+  event_log::send_http("test", PAYLOAD, (uint32_t)strlen(PAYLOAD));
+  event_log::flush_batched();
+  server.waitRequests(1, 2000); // so second event goes to next batch
+  event_log::send_http("test", PAYLOAD, (uint32_t)strlen(PAYLOAD));
+  event_log::flush_batched();
+  CHECK(server.waitDelivered(5000));
+  event_log::shutdown();
+
+  eastl::vector<Request> reqs = server.getRequests();
+  CHECK_EQUAL(2, (int)reqs.size());
+  if (reqs.size() == 2)
+    CHECK_EQUAL(1, count_events(reqs[1].body));
+}
+
+TEST(SpooledBatchesSurviveRestart)
+{
+  HttpClientScope http;
+  const char *spoolDir = "eventLogTestsSpool";
+
+  int port = 0;
+  {
+    StandInServer server({});
+    port = server.port;
+  }
+  {
+    // collector is down: events stay in spool after shutdown
+    CHECK(event_log::init(make_params(port, spoolDir)));
+    for (int i = 0; i < 10; i++)
+      event_log::send_http("test", PAYLOAD, (uint32_t)strlen(PAYLOAD));
+    event_log::shutdown();
+  }
+  CHECK_EQUAL(1, count_spooled(spoolDir));
+
+  StandInServer server({});
+  CHECK(event_log::init(make_params(server.port, spoolDir)));
+  CHECK(server.waitDelivered(10000));
+  event_log::shutdown();
+
+  eastl::vector<Request> reqs = server.getRequests();
+  CHECK_EQUAL(1, (int)reqs.size());
+  if (!reqs.empty())
+    CHECK_EQUAL(10, count_events(reqs[0].body));
+  CHECK_EQUAL(0, count_spooled(spoolDir));
+  dd_rmdir(spoolDir);
+}
+
+#include <unittest/main.inc.cpp>
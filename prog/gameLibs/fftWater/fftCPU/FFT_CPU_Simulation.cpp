@@ -434,9 +434,9 @@ void FFTcSSE(unsigned int nn, unsigned int m, vec4f *x)
   }
 }
 
-//   Perform a 2D FFT inplace given a complex 2D array
-//   The size of the array (nx,nx)
-void FFT2DSSE(complex *c, int nx)
+//   First (row) pass of the 2D FFT, processes rows [row_begin, row_end), 4 rows at a time.
+//   Bands of rows are independent, so passes can be split between threads
+static void FFT2DSSERows(complex *c, int nx, int row_begin, int row_end)
 {
   vec4f iv_data[512 * 2];
   vec4f shuffledata0;
@@ -456,7 +456,7 @@ void FFT2DSSE(complex *c, int nx)
   int m = get_log2w(nx);
   int nn = 1 << m;
 
-  for (int jr = 0, j = 0; j < nx; j += 4, jr += nx * 4)
+  for (int jr = row_begin * nx, j = row_begin; j < row_end; j += 4, jr += nx * 4)
   {
     f0 = &(c[jr][0]);
     f1 = &(c[jr + nx][0]);
@@ -497,7 +497,22 @@ void FFT2DSSE(complex *c, int nx)
       f3 += 2;
     }
   }
-  for (int j = 0; j < nx; j += 4)
+}
+
+//   Second (column) pass of the 2D FFT, processes columns [col_begin, col_end), 4 columns at a time.
+//   Must be run after row pass is finished for all rows
+static void FFT2DSSEColumns(complex *c, int nx, int col_begin, int col_end)
+{
+  vec4f iv_data[512 * 2];
+  vec4f shuffledata0;
+  vec4f shuffledata1;
+  float *f0;
+  float *f1;
+
+  int m = get_log2w(nx);
+  int nn = 1 << m;
+
+  for (int j = col_begin; j < col_end; j += 4)
   {
 
     for (int ij = j, i = 0; i < nx; i++, ij += nx)
@@ -526,6 +541,14 @@ void FFT2DSSE(complex *c, int nx)
   }
 }
 
+//   Perform a 2D FFT inplace given a complex 2D array
+//   The size of the array (nx,nx)
+void FFT2DSSE(complex *c, int nx)
+{
+  FFT2DSSERows(c, nx, 0, nx);
+  FFT2DSSEColumns(c, nx, 0, nx);
+}
+
 // Updates Ht to desired time. Each call computes one scan line from source spectrum into 3 textures
 void NVWaveWorks_FFT_CPU_Simulation::UpdateHt(int row)
 {
@@ -744,6 +767,20 @@ void NVWaveWorks_FFT_CPU_Simulation::ComputeFFT(int index)
   FFT2DSSE(&m_fftCPU_io_buffer[index << (m_params.fft_resolution_bits << 1)], N);
 }
 
+void NVWaveWorks_FFT_CPU_Simulation::ComputeFFTRows(int index, int first_row, int count)
+{
+  G_ASSERT(((first_row | count) & 3) == 0);
+  FFT2DSSERows(&m_fftCPU_io_buffer[index << (m_params.fft_resolution_bits << 1)], 1 << m_params.fft_resolution_bits, first_row,
+    first_row + count);
+}
+
+void NVWaveWorks_FFT_CPU_Simulation::ComputeFFTColumns(int index, int first_col, int count)
+{
+  G_ASSERT(((first_col | count) & 3) == 0);
+  FFT2DSSEColumns(&m_fftCPU_io_buffer[index << (m_params.fft_resolution_bits << 1)], 1 << m_params.fft_resolution_bits, first_col,
+    first_col + count);
+}
+
 // Merge all 3 results of FFT into one texture with Dx,Dz and height
 void NVWaveWorks_FFT_CPU_Simulation::getHalfData(int row, cpu_types::half4 *compressed)
 {
@@ -845,6 +882,8 @@ void NVWaveWorks_FFT_CPU_Simulation::getUint16Data(int row, float minHt, float s
   vec4f ofs = v_splats(-minHt * 65535. / scaleHt);
 
   vec4f v_out_max_z = v_zero();
+  // last 4-component store would spill one element into next row, which makes rows unsafe to fill concurrently
+  alignas(8) uint16_t lastTexel[4];
   for (int x = 0; x < N; x += 2, pTex += 6, fftRes += 2, fftRes1 += 2, fftRes2 += 2)
   {
     vec4f a0, a1;
@@ -862,8 +901,9 @@ void NVWaveWorks_FFT_CPU_Simulation::getUint16Data(int row, float minHt, float s
     a1 = v_max(zero, a1);
     a1 = v_min(max65535, a1);
     vec4i a1i = v_cvt_roundi(a1);
-    v_stui_half(pTex + 3, v_packus(a1i));
+    v_stui_half(x + 2 < N ? pTex + 3 : lastTexel, v_packus(a1i));
   }
+  memcpy(pTex - 3, lastTexel, 3 * sizeof(uint16_t));
 
   out_max_z = v_extract_z(v_out_max_z);
   out_max_z *= choppy_scale;
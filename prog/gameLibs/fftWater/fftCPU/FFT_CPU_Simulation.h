@@ -98,10 +98,14 @@ public:
   void UpdateHt(int row);
   void UpdateHtC(int row);
   void ComputeFFT(int index);
+  // ComputeFFT split in two passes, each can be run on independent bands of 4-aligned rows/columns concurrently.
+  // All rows of an image have to be finished before its columns pass is started
+  void ComputeFFTRows(int index, int first_row, int count);
+  void ComputeFFTColumns(int index, int first_col, int count);
   void getHalfData(int row, cpu_types::half4 *compressed);
   void getFloatData(int row, cpu_types::float4 *uncompressed);
   // unaligned data, 3*short. store as (data-minHt)/maxScaleHt
-  // compressed data should be of a size N*N*3+1(!)
+  // compressed data should be of a size N*N*3+1(!), rows do not overlap, so can be filled concurrently
   void getUint16Data(int row, float minHt, float maxScaleHt, unsigned short *compressed, float &out_max_z);
 
   // Mandatory NVWaveWorks_FFT_Simulation interface
@@ -1005,6 +1005,16 @@ int getHeightAboveWaterAtTime(FFTWater *handle, double at_time, const Point3 &in
 {
   return handle->getPhysics()->getHeightAboveWater(at_time, in_point, result, displacement);
 }
+int get_heights_above_water_at_time(FFTWater *handle, double at_time, dag::ConstSpan<Point3> points, float *results,
+  Point3 *out_displacements)
+{
+  return handle->getPhysics()->getHeightAboveWaterBatch(at_time, points.data(), points.size(), results, out_displacements);
+}
+void set_parallel_physics(FFTWater *handle, bool enable)
+{
+  if (handle && handle->getPhysics())
+    handle->getPhysics()->setParallelSyncRun(enable);
+}
 void get_wind_speed(FFTWater *handle, float &out_speed, Point2 &out_wind_dir) { handle->getWind(out_speed, out_wind_dir); }
 void set_wind_speed(FFTWater *handle, float speed, const Point2 &wind_dir) { handle->setWind(speed, wind_dir); }
 void get_roughness(FFTWater *handle, float &out_roughness_base, float &out_cascades_roughness_base)
@@ -0,0 +1,153 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <fftWater/fftWater.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <util/dag_threadPool.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <generic/dag_tab.h>
+#include <math/dag_Point2.h>
+#include <math/dag_Point3.h>
+#include <string.h>
+#include <stdio.h>
+
+// Usage: tests [Determinism|Benchmark]
+// Determinism checks that threadpool-split physics simulation and batched height queries give bit-exact results
+// compared to serial simulation and per-point queries. Benchmark reports timings of both
+
+static const double TICK_RATE = 0.375;    // same as in WaterNVPhysics
+static const double JUMP_TIME = 10.0;     // more than MAX_FIFO ticks, so next simulate() fully resimulates fifo synchronously
+
+static void init_test_env()
+{
+  measure_cpu_freq();
+  cpujobs::init();
+  threadpool::init(4, 2048, 256 << 10); // always have workers, even on single core machine
+  fft_water::init();
+}
+
+static FFTWater *make_water(bool parallel)
+{
+  FFTWater *water = fft_water::create_water(fft_water::DONT_RENDER);
+  fft_water::set_parallel_physics(water, parallel);
+  fft_water::set_wind_speed(water, 12.f, Point2(1.f, 0.3f));
+  return water;
+}
+
+// time between two ticks, so interpolation between two fifo entries is tested
+static double between_ticks(double time) { return (floor(time / TICK_RATE) + 0.3) * TICK_RATE; }
+
+static void make_points(Tab<Point3> &points, int count)
+{
+  points.resize(count);
+  uint32_t seed = 12345;
+  for (Point3 &p : points)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    float x = (seed >> 8) * (2000.f / (1 << 24)) - 1000.f;
+    seed = seed * 1664525u + 1013904223u;
+    float z = (seed >> 8) * (2000.f / (1 << 24)) - 1000.f;
+    p = Point3(x, (seed & 0xFF) * (10.f / 255.f) - 5.f, z);
+  }
+}
+
+static void query_per_point(FFTWater *water, double time, dag::ConstSpan<Point3> points, Tab<float> &ht, Tab<Point3> &disp)
+{
+  ht.resize(points.size());
+  disp.resize(points.size());
+  for (int i = 0; i < points.size(); ++i)
+  {
+    ht[i] = 1e9f;
+    disp[i] = Point3(0, 0, 0);
+    fft_water::getHeightAboveWaterAtTime(water, time, points[i], ht[i], &disp[i]);
+  }
+}
+
+static void query_batched(FFTWater *water, double time, dag::ConstSpan<Point3> points, Tab<float> &ht, Tab<Point3> &disp)
+{
+  ht.resize(points.size());
+  disp.resize(points.size());
+  for (int i = 0; i < points.size(); ++i)
+  {
+    ht[i] = 1e9f;
+    disp[i] = Point3(0, 0, 0);
+  }
+  fft_water::get_heights_above_water_at_time(water, time, points, ht.data(), disp.data());
+}
+
+SUITE(Determinism)
+{
+  TEST(ParallelSimulationIsBitExact)
+  {
+    FFTWater *serial = make_water(false);
+    FFTWater *parallel = make_water(true);
+    Tab<Point3> points;
+    make_points(points, 4096);
+    Tab<float> htS, htP;
+    Tab<Point3> dispS, dispP;
+    for (int step = 1; step <= 4; ++step)
+    {
+      double time = between_ticks(step * JUMP_TIME);
+      fft_water::simulate(serial, time);
+      fft_water::simulate(parallel, time);
+      query_per_point(serial, time, points, htS, dispS);
+      query_per_point(parallel, time, points, htP, dispP);
+      CHECK(memcmp(htS.data(), htP.data(), data_size(htS)) == 0);
+      CHECK(memcmp(dispS.data(), dispP.data(), data_size(dispS)) == 0);
+    }
+    fft_water::delete_water(serial);
+    fft_water::delete_water(parallel);
+  }
+
+  TEST(BatchMatchesPerPointQueries)
+  {
+    FFTWater *water = make_water(true);
+    double time = between_ticks(JUMP_TIME);
+    fft_water::simulate(water, time);
+    for (int count : {1, 63, 64, 65, 5000})
+    {
+      Tab<Point3> points;
+      make_points(points, count);
+      Tab<float> ht, htBatch;
+      Tab<Point3> disp, dispBatch;
+      query_per_point(water, time, points, ht, disp);
+      query_batched(water, time, points, htBatch, dispBatch);
+      CHECK(memcmp(ht.data(), htBatch.data(), data_size(ht)) == 0);
+      CHECK(memcmp(disp.data(), dispBatch.data(), data_size(disp)) == 0);
+    }
+    fft_water::delete_water(water);
+  }
+}
+
+SUITE(Benchmark)
+{
+  TEST(SimulationAndQueries)
+  {
+    static constexpr int RUNS = 8;
+    Tab<Point3> points;
+    make_points(points, 16384);
+    Tab<float> ht;
+    Tab<Point3> disp;
+    for (bool parallel : {false, true})
+    {
+      FFTWater *water = make_water(parallel);
+      int64_t reft = ref_time_ticks();
+      double time = 0;
+      for (int i = 1; i <= RUNS; ++i)
+        fft_water::simulate(water, time = between_ticks(i * JUMP_TIME));
+      int simUsec = get_time_usec(reft);
+
+      reft = ref_time_ticks();
+      query_per_point(water, time, points, ht, disp);
+      int perPointUsec = get_time_usec(reft);
+      reft = ref_time_ticks();
+      query_batched(water, time, points, ht, disp);
+      int batchUsec = get_time_usec(reft);
+
+      printf("%s: fifo resimulation %.2f ms, %d queries: per-point %.2f ms, batched %.2f ms\n", parallel ? "parallel" : "serial",
+        simUsec / (1000.f * RUNS), (int)points.size(), perPointUsec / 1000.f, batchUsec / 1000.f);
+      fft_water::delete_water(water);
+    }
+  }
+}
+
+#define CUSTOM_UNITTEST_CODE init_test_env();
+#include <unittest/main.inc.cpp>
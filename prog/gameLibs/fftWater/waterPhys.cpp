@@ -2,6 +2,8 @@
 #include <osApiWrappers/dag_atomic.h>
 #include <osApiWrappers/dag_cpuJobs.h>
 #include <util/dag_threadPool.h>
+#include <util/dag_parallelForInline.h>
+#include <osApiWrappers/dag_miscApi.h>
 #include <perfMon/dag_statDrv.h>
 #include "waterPhys.h"
 #include <math/dag_adjpow2.h>
@@ -10,6 +12,10 @@
 
 #define THRESHOLD_TO_SWITCH_OFF_WAVES 0.2
 
+static constexpr int PARALLEL_ROWS_QUANT = 16;     // rows of Ht/displacement data per parallel job
+static constexpr int PARALLEL_FFT_BANDS_QUANT = 2; // bands of 4 FFT rows/columns per parallel job
+static constexpr int PARALLEL_BATCH_QUANT = 64;    // points per parallel job in getHeightAboveWaterBatch
+
 WaterNVPhysics::~WaterNVPhysics()
 {
   threadpool::wait(this);
@@ -77,6 +83,7 @@ void WaterNVPhysics::initializeCascades()
     }
     mem_set_0(cascades[cascadeNo].cascadeMaxZ);
   }
+  clear_and_resize(rowMaxZ, numCascades << cascades[0].fft.getParams().fft_resolution_bits);
 }
 
 WaterNVPhysics::WaterNVPhysics(const NVWaveWorks_FFT_CPU_Simulation::Params &p, const fft_water::SimulationParams &simulation,
@@ -187,6 +194,11 @@ void WaterNVPhysics::setCascadesSimulationTime(double time)
 void WaterNVPhysics::syncRun(int nextLastTick)
 {
   threadpool::wait(this);
+  if (parallelSyncRun && cascades && threadpool::get_num_workers() > 0)
+  {
+    syncRunParallel(nextLastTick);
+    return;
+  }
   currentJobIndex = -1;
   currentJobSize = 0;
 
@@ -215,6 +227,89 @@ void WaterNVPhysics::syncRun(int nextLastTick)
   debug("sync to %d(%d) in %dus", nextLastTick, destFifo, get_time_usec(reft));*/
 }
 
+void WaterNVPhysics::syncRunParallel(int nextLastTick)
+{
+  threadpool::wait(this);
+  if (!cascades)
+  {
+    syncRun(nextLastTick);
+    return;
+  }
+  currentJobIndex = -1;
+  currentJobSize = 0;
+
+  setCascadesSimulationTime(nextLastTick * tickRate);
+  asyncUpdatingTick = nextLastTick;
+  TIME_PROFILE(water_phys_sync_parallel);
+  updateH0(); // only when params were changed
+
+  const int N = 1 << cascades[0].fft.getParams().fft_resolution_bits;
+  for (int i = 1; i < numCascades; ++i)
+    G_ASSERT(N == (1 << cascades[i].fft.getParams().fft_resolution_bits));
+  const int totalRows = numCascades * N;
+  const threadpool::JobPriority prio = is_main_thread() ? threadpool::PRIO_HIGH : threadpool::PRIO_NORMAL;
+
+  // rows of Ht are independent in all cascades
+  threadpool::parallel_for_inline(
+    0, totalRows, PARALLEL_ROWS_QUANT, [this](uint32_t begin, uint32_t end, uint32_t) { updateHt(begin, end - begin); }, 0, prio);
+
+  // each cascade has 3 images, each image is split into bands of 4 rows (or columns).
+  // Columns pass can only be started after rows pass is finished, parallel_for_inline is the barrier
+  const int imageBands = N / 4, totalBands = numCascades * 3 * imageBands;
+  for (int columns = 0; columns < 2; ++columns)
+    threadpool::parallel_for_inline(
+      0, totalBands, PARALLEL_FFT_BANDS_QUANT,
+      [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (int band = begin; band < end;)
+        {
+          const int image = band / imageBands, first = band % imageBands, cnt = min<int>(imageBands - first, end - band);
+          NVWaveWorks_FFT_CPU_Simulation &fft = cascades[image / 3].fft;
+          if (columns)
+            fft.ComputeFFTColumns(image % 3, first * 4, cnt * 4);
+          else
+            fft.ComputeFFTRows(image % 3, first * 4, cnt * 4);
+          band += cnt;
+        }
+      },
+      0, prio);
+
+  // starting from this moment, old firstTick is invalid
+  const int destFifo = nextLastTick % MAX_FIFO;
+  interlocked_release_store(updatingFifo, destFifo);
+  threadpool::parallel_for_inline(
+    0, totalRows, PARALLEL_ROWS_QUANT,
+    [&](uint32_t begin, uint32_t end, uint32_t) {
+      for (int row = begin; row < end; ++row)
+      {
+        const int i = row / N, j = row % N;
+        uint16_t *data = cascades[i].fifo[destFifo].data() + j * N * 3;
+        cascades[i].fft.getUint16Data(j, -maxWaveSize[i], maxWaveSize[i] * 2.f, data, rowMaxZ[row]);
+      }
+    },
+    0, prio);
+  for (int i = 0; i < numCascades; ++i)
+  {
+    float &cascadeMaxZ = cascades[i].cascadeMaxZ[destFifo];
+    cascadeMaxZ = 0.f;
+    for (int j = 0; j < N; ++j)
+      cascadeMaxZ = max(cascadeMaxZ, rowMaxZ[i * N + j]);
+  }
+  updateFifoMaxZ(destFifo);
+
+  interlocked_release_store(lastTick, nextLastTick);
+  interlocked_release_store(updatingFifo, -1);
+}
+
+void WaterNVPhysics::updateFifoMaxZ(int fifo)
+{
+  fifoMaxZ[fifo] = 0.f;
+  for (int i = 0; i < numCascades; ++i)
+    fifoMaxZ[fifo] += cascades[i].cascadeMaxZ[fifo];
+  allFifoMaxZ = 0.f;
+  for (int f = 0; f < MAX_FIFO; f++)
+    allFifoMaxZ = max(allFifoMaxZ, fifoMaxZ[f]);
+}
+
 void WaterNVPhysics::updateH0()
 {
   if (!cascades)
@@ -317,14 +412,7 @@ int WaterNVPhysics::getDisplaceData(int destFifo, int start, int count)
     }
 
     if (i == numCascades - 1 && start + num == N)
-    {
-      fifoMaxZ[destFifo] = 0.f;
-      for (int i = 0; i < numCascades; ++i)
-        fifoMaxZ[destFifo] += cascades[i].cascadeMaxZ[destFifo];
-      allFifoMaxZ = 0.f;
-      for (int fifo = 0; fifo < MAX_FIFO; fifo++)
-        allFifoMaxZ = max(allFifoMaxZ, fifoMaxZ[fifo]);
-    }
+      updateFifoMaxZ(destFifo);
 
     totalComputed += num;
     if (totalComputed == count)
@@ -468,6 +556,15 @@ void WaterNVPhysics::calcWaveHeight()
 
 int WaterNVPhysics::intersectRayWithOcean(double time, Point3 &result, float &T, const Point3 &in_position, const Point3 &direction,
   Point3 *out_displacement, bool matchRenderGrid)
+{
+  int fifo1, fifo2;
+  float fifo2Part;
+  getFifoIndex(time, fifo1, fifo2, fifo2Part);
+  return intersectRayWithOcean(fifo1, fifo2, fifo2Part, result, T, in_position, direction, out_displacement, matchRenderGrid);
+}
+
+int WaterNVPhysics::intersectRayWithOcean(int fifo1, int fifo2, float fifo2Part, Point3 &result, float &T, const Point3 &in_position,
+  const Point3 &direction, Point3 *out_displacement, bool matchRenderGrid)
 {
   G_ASSERT(cascades != nullptr && !noActualWaves);
   vec3f test_point_xz, old_test_point_xz, displacements;
@@ -504,9 +601,6 @@ int WaterNVPhysics::intersectRayWithOcean(double time, Point3 &result, float &T,
     position = v_madd(v_splats(t), v_dir, position);
   }
 
-  int fifo1, fifo2;
-  float fifo2Part;
-  getFifoIndex(time, fifo1, fifo2, fifo2Part);
   vec3f v_fifo2Part = v_splats(fifo2Part);
   // tracing the ocean surface:
   // moving along the ray by distance defined by vertical distance form current test point, increased/decreased by safety multiplier
@@ -708,6 +802,16 @@ vec4f WaterNVPhysics::getRenderedHeight(float x, float z)
 
 int WaterNVPhysics::getHeightAboveWater(double time, const Point3 &point, float &result, Point3 *out_displacement,
   bool matchRenderGrid)
+{
+  int fifo1 = 0, fifo2 = 0;
+  float fifo2Part = 0.f;
+  if (cascades)
+    getFifoIndex(time, fifo1, fifo2, fifo2Part);
+  return getHeightAboveWater(fifo1, fifo2, fifo2Part, point, result, out_displacement, matchRenderGrid);
+}
+
+int WaterNVPhysics::getHeightAboveWater(int fifo1, int fifo2, float fifo2Part, const Point3 &point, float &result,
+  Point3 *out_displacement, bool matchRenderGrid)
 {
   if (!cascades)
   {
@@ -734,11 +838,38 @@ int WaterNVPhysics::getHeightAboveWater(double time, const Point3 &point, float
   float originY = maxSeaLevel;
   if (waterHeightmap)
     originY = waterHeightmap->heightMax + maxWaveHeight;
-  if (
-    intersectRayWithOcean(time, resPos, t, Point3(point.x, originY, point.z), Point3(0, -1.0f, 0), out_displacement, matchRenderGrid))
+  if (intersectRayWithOcean(fifo1, fifo2, fifo2Part, resPos, t, Point3(point.x, originY, point.z), Point3(0, -1.0f, 0),
+        out_displacement, matchRenderGrid))
   {
     result = point.y - resPos.y;
     return 1;
   }
   return 0;
 }
+
+int WaterNVPhysics::getHeightAboveWaterBatch(double time, const Point3 *points, int count, float *results, Point3 *displacements,
+  bool matchRenderGrid)
+{
+  if (count <= 0)
+    return 0;
+  int fifo1 = 0, fifo2 = 0;
+  float fifo2Part = 0.f;
+  if (cascades)
+    getFifoIndex(time, fifo1, fifo2, fifo2Part);
+
+  volatile int found = 0;
+  auto traceRange = [&](uint32_t begin, uint32_t end, uint32_t) {
+    int localFound = 0;
+    for (int i = begin; i < end; ++i)
+      localFound += getHeightAboveWater(fifo1, fifo2, fifo2Part, points[i], results[i], displacements ? displacements + i : nullptr,
+        matchRenderGrid);
+    interlocked_add(found, localFound);
+  };
+  // without waves it is just a heightmap lookup, not worth spreading over threads
+  if (cascades && count > PARALLEL_BATCH_QUANT && threadpool::get_num_workers() > 0)
+    threadpool::parallel_for_inline(0, count, PARALLEL_BATCH_QUANT, traceRange, 0,
+      is_main_thread() ? threadpool::PRIO_HIGH : threadpool::PRIO_NORMAL);
+  else
+    traceRange(0, count, 0);
+  return found;
+}
@@ -52,6 +52,8 @@ protected:
   Point2 renderGridOffset = ZERO<Point2>();
 
   int endUpdateHtJobIdx, endFFTJobIdx, totalJobSize; //
+  bool parallelSyncRun = false;
+  SmallTab<float, MidmemAlloc> rowMaxZ; // per row max z of all cascades, for syncRunParallel
 
   void setCascades(const NVWaveWorks_FFT_CPU_Simulation::Params &p);
 
@@ -85,6 +87,9 @@ public:
   ~WaterNVPhysics();
 
   void syncRun(int nextLastTick);
+  // same as syncRun (bit-exact), but each stage is split into row bands and spread over threadpool
+  void syncRunParallel(int nextLastTick);
+  void setParallelSyncRun(bool on) { parallelSyncRun = on; }
 
   void runAsyncTask(int nextLastTick, float tasks);
   void setCascadesSimulationTime(double time);
@@ -214,11 +219,20 @@ public:
   int intersectSegment(double time, const Point3 &vStart, const Point3 &vEnd, float &fResult);
   int getHeightAboveWater(double time, const Point3 &in_point, float &result, Point3 *displacement = NULL,
     bool matchRenderGrid = false);
+  // getHeightAboveWater for count points at once. Fifo is resolved once, so all points are sampled at the same simulation tick.
+  // results[i] (and displacements[i]) are written only for points where water was found; returns number of such points
+  int getHeightAboveWaterBatch(double time, const Point3 *points, int count, float *results, Point3 *displacements = NULL,
+    bool matchRenderGrid = false);
   void setForceActualWaves(bool enforce);
 
 protected:
   void calcWaveHeight();
+  void updateFifoMaxZ(int fifo);
   int intersectRayWithOcean(double time, Point3 &result, float &T, const Point3 &position, const Point3 &direction,
     Point3 *out_displacement = nullptr, bool matchRenderGrid = false);
+  int intersectRayWithOcean(int fifo1, int fifo2, float fifo2Part, Point3 &result, float &T, const Point3 &position,
+    const Point3 &direction, Point3 *out_displacement, bool matchRenderGrid);
+  int getHeightAboveWater(int fifo1, int fifo2, float fifo2Part, const Point3 &in_point, float &result, Point3 *displacement,
+    bool matchRenderGrid);
   void initializeCascades();
 };
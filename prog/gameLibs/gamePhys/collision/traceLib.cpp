@@ -590,6 +590,22 @@ float dacoll::traceht_water_at_time(const Point3 &pos, float time, Point3 *out_d
   return 0.f;
 }
 
+void dacoll::traceht_water_at_time(dag::ConstSpan<Point3> pos, float time, dag::Span<float> out_water_ht, Point3 *out_displacement)
+{
+  G_ASSERT(out_water_ht.size() >= pos.size());
+  FFTWater *water = get_water();
+  if (!water)
+  {
+    mem_set_0(out_water_ht);
+    return;
+  }
+  for (int i = 0; i < pos.size(); ++i)
+    out_water_ht[i] = 1e9f;
+  fft_water::get_heights_above_water_at_time(water, time, pos, out_water_ht.data(), out_displacement);
+  for (int i = 0; i < pos.size(); ++i)
+    out_water_ht[i] = out_water_ht[i] == 1e9f ? 0.f : pos[i].y - out_water_ht[i];
+}
+
 bool dacoll::traceray_water_at_time(const Point3 &start, const Point3 &end, float time, float &t)
 {
   FFTWater *water = get_water();
@@ -309,6 +309,53 @@ bool HeightmapPhysHandler::rayhitNormalized(const Point3 &p, const Point3 &normD
   return ray_hit_midpoint_heightmap(*this, p, normDir, t);
 }
 
+bool HeightmapPhysHandler::tracerayHier(const Point3 &p, const Point3 &dir, real &t, Point3 *normal, bool cull) const
+{
+  BBox3 rayBox(p, p);
+  Point3_vec4 end = p + dir * t;
+  rayBox += end;
+  if (!(worldBox & rayBox))
+    return false;
+  if (!v_test_segment_box_intersection(v_ldu(&p.x), v_ld(&end.x), vecbox))
+    return false;
+  return trace_ray_midpoint_heightmap_hier<false>(*this, p, dir, t, normal, cull);
+}
+
+bool HeightmapPhysHandler::rayhitNormalizedHier(const Point3 &p, const Point3 &normDir, real t) const
+{
+  vec3f pt = v_ldu(&p.x), end = v_madd(v_ldu(&normDir.x), v_splats(t), pt);
+  bbox3f rayBox;
+  rayBox.bmin = v_min(end, pt);
+  rayBox.bmax = v_max(end, pt);
+  if (!v_bbox3_test_box_intersect(rayBox, vecbox))
+    return false;
+  if (!v_test_segment_box_intersection(pt, end, vecbox))
+    return false;
+  return trace_ray_midpoint_heightmap_hier<true>(*this, p, normDir, t, nullptr);
+}
+
+int HeightmapPhysHandler::tracerayMulti(const Point3 *p, const Point3 *dir, real *t, Point3 *normals, int cnt, bool cull) const
+{
+  int hits = 0;
+  for (int i = 0; i < cnt; ++i)
+    hits += tracerayHier(p[i], dir[i], t[i], normals ? normals + i : nullptr, cull);
+  return hits;
+}
+
+int HeightmapPhysHandler::rayhitNormalizedMulti(const Point3 *p, const Point3 *normDir, const real *t, int cnt,
+  uint32_t *out_hit_mask) const
+{
+  memset(out_hit_mask, 0, ((cnt + 31) / 32) * sizeof(uint32_t));
+  int hits = 0;
+  for (int i = 0; i < cnt; ++i)
+    if (rayhitNormalizedHier(p[i], normDir[i], t[i]))
+    {
+      out_hit_mask[i / 32] |= 1u << (i & 31);
+      hits++;
+    }
+  return hits;
+}
+
 bool HeightmapPhysHandler::rayUnderHeightmapNormalized(const Point3 &p, const Point3 &normDir, real t) const
 {
   BBox3 rayBox(p, p);
@@ -0,0 +1,199 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <heightmap/heightmapPhysHandler.h>
+#include <heightMapLand/dag_hmlTraceRay.h>
+#include <ioSys/dag_fileIo.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <generic/dag_tab.h>
+#include <math/dag_mathUtils.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Usage: [HMAP_DUMP=heightmap.bin] tests [Hierarchy|Benchmark]
+// Hierarchy checks that hierarchical (max-mip) heightmap tracing returns exactly the same hits as cell by cell tracing.
+// Benchmark compares both on long grazing rays, over synthetic heightmap and, if HMAP_DUMP is set,
+// over real level heightmap (dump of HeightmapPhysHandler as it is stored in level binary)
+
+struct SyntheticHeightmap : public HeightmapPhysHandler
+{
+  Tab<uint8_t> data;
+
+  // rolling hills with flat plains, 'hrb_subsz' pixels per node of the finest level of height ranges
+  void init(int w, float cell_size, int hrb_subsz)
+  {
+    Tab<uint16_t> heights;
+    heights.resize(w * w);
+    for (int y = 0; y < w; y++)
+      for (int x = 0; x < w; x++)
+      {
+        float fx = x * 0.01f, fy = y * 0.01f;
+        float v = 0.5f + 0.25f * sinf(fx * 1.3f) * cosf(fy * 0.7f) + 0.12f * sinf(fx * 5.1f + fy * 3.3f) +
+                  0.05f * sinf(fx * 21.f) * sinf(fy * 17.f);
+        heights[y * w + x] = uint16_t(clamp(max(v, 0.45f), 0.f, 1.f) * 65535);
+      }
+    hmapCellSize = cell_size;
+    hMin = -50;
+    hScale = 400;
+    hScaleRaw = hScale / 65535.0;
+    hmapWidth = IPoint2(w, w);
+    worldPosOfs = Point2(-w * cell_size * 0.5f, -w * cell_size * 0.5f);
+    worldSize = Point2(w * cell_size, w * cell_size);
+    uint8_t blockShift = 3;
+    data.resize(CompressedHeightmap::calc_data_size_needed(w, w, blockShift, hrb_subsz));
+    compressed = CompressedHeightmap::compress(data.data(), data.size(), heights.data(), w, w, blockShift, hrb_subsz);
+
+    uint16_t minH16 = 65535, maxH16 = 0;
+    compressed.iterateBlocks(0, 0, compressed.bw, compressed.bh, [&](uint32_t, uint32_t, uint16_t mn, uint16_t mx) {
+      minH16 = min(mn, minH16);
+      maxH16 = max(mx, maxH16);
+    });
+    worldBox[0] = Point3(worldPosOfs.x, hMin + minH16 * hScaleRaw, worldPosOfs.y);
+    worldBox[1] = Point3(worldPosOfs.x + worldSize.x, hMin + maxH16 * hScaleRaw, worldPosOfs.y + worldSize.y);
+    worldBox2 = BBox2(Point2::xz(worldBox[0]), Point2::xz(worldBox[1]));
+    vecbox = v_ldu_bbox3(worldBox);
+    invElemSize = v_splats(1.0f / hmapCellSize);
+    v_worldOfsxzxz = v_make_vec4f(worldPosOfs.x, worldPosOfs.y, worldPosOfs.x, worldPosOfs.y);
+  }
+};
+
+struct Rays
+{
+  Tab<Point3> pos, dir;
+  Tab<float> len;
+};
+
+// mostly long grazing rays above terrain (ballistics, line of sight), some going slightly up and some starting low
+static void make_rays(const HeightmapPhysHandler &hmap, Rays &rays, int count)
+{
+  const BBox3 box = hmap.getWorldBox();
+  const Point3 size = box.width();
+  rays.pos.resize(count);
+  rays.dir.resize(count);
+  rays.len.resize(count);
+  uint32_t seed = 1;
+  auto rnd = [&]() {
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) * (1.f / (1 << 24));
+  };
+  for (int i = 0; i < count; i++)
+  {
+    rays.pos[i] = Point3(box[0].x + size.x * (0.05f + rnd() * 0.9f), box[1].y + rnd() * 20.f, box[0].z + size.z * (0.05f + rnd() * 0.9f));
+    if (i % 7 == 0)
+      rays.pos[i].y = box[0].y + size.y * rnd();
+    float angle = rnd() * TWOPI, dy = -(0.02f + rnd() * 0.15f);
+    if (i % 5 == 0)
+      dy = -dy * 0.3f;
+    rays.dir[i] = normalize(Point3(cosf(angle), dy, sinf(angle)));
+    rays.len[i] = max(size.x, size.z) * (0.3f + rnd() * 0.5f);
+  }
+}
+
+static void check_same_hits(const HeightmapPhysHandler &hmap, const Rays &rays)
+{
+  int mismatches = 0, hits = 0;
+  for (int i = 0; i < rays.pos.size(); i++)
+  {
+    float t = rays.len[i], tHier = rays.len[i];
+    Point3 n(0, 0, 0), nHier(0, 0, 0);
+    bool hit = hmap.traceray(rays.pos[i], rays.dir[i], t, &n);
+    bool hitHier = hmap.tracerayHier(rays.pos[i], rays.dir[i], tHier, &nHier);
+    if (hit != hitHier || (hit && (t != tHier || n != nHier)))
+      mismatches++;
+    if (hmap.rayhitNormalized(rays.pos[i], rays.dir[i], rays.len[i]) != hmap.rayhitNormalizedHier(rays.pos[i], rays.dir[i], rays.len[i]))
+      mismatches++;
+    hits += hit;
+  }
+  CHECK(hits > 0 && hits < rays.pos.size());
+  CHECK_EQUAL(0, mismatches);
+
+  Tab<float> t(rays.len);
+  Tab<Point3> normals;
+  normals.resize(rays.pos.size());
+  Tab<uint32_t> hitMask;
+  hitMask.resize((rays.pos.size() + 31) / 32);
+  CHECK_EQUAL(hits, hmap.tracerayMulti(rays.pos.data(), rays.dir.data(), t.data(), normals.data(), rays.pos.size()));
+  int anyHits = hmap.rayhitNormalizedMulti(rays.pos.data(), rays.dir.data(), rays.len.data(), rays.pos.size(), hitMask.data());
+  int maskHits = 0;
+  for (uint32_t m : hitMask)
+    maskHits += __popcount(m);
+  CHECK_EQUAL(anyHits, maskHits);
+}
+
+SUITE(Hierarchy)
+{
+  TEST(SameHitsAsCellTracing)
+  {
+    for (int hrbSubSz : {8, 16, 64})
+    {
+      SyntheticHeightmap hmap;
+      hmap.init(1024, 1.f, hrbSubSz);
+      CHECK(hmap.getCompressedData().htRangeBlocksLevels > 0);
+      Rays rays;
+      make_rays(hmap, rays, 2000);
+      check_same_hits(hmap, rays);
+    }
+  }
+
+  TEST(NoHierarchyFallback)
+  {
+    SyntheticHeightmap hmap;
+    hmap.init(512, 2.f, 0);
+    CHECK_EQUAL(0, hmap.getCompressedData().htRangeBlocksLevels);
+    Rays rays;
+    make_rays(hmap, rays, 500);
+    check_same_hits(hmap, rays);
+  }
+}
+
+static void bench(const char *name, const HeightmapPhysHandler &hmap)
+{
+  static constexpr int RAYS = 20000, RUNS = 3;
+  Rays rays;
+  make_rays(hmap, rays, RAYS);
+  Tab<float> t;
+  int hits = 0, hitsHier = 0;
+
+  int64_t reft = ref_time_ticks();
+  for (int run = 0; run < RUNS; run++)
+    for (int i = 0; i < RAYS; i++)
+    {
+      float len = rays.len[i];
+      hits += hmap.traceray(rays.pos[i], rays.dir[i], len, nullptr);
+    }
+  int cellUsec = get_time_usec(reft);
+
+  reft = ref_time_ticks();
+  for (int run = 0; run < RUNS; run++)
+  {
+    t = rays.len;
+    hitsHier += hmap.tracerayMulti(rays.pos.data(), rays.dir.data(), t.data(), nullptr, RAYS);
+  }
+  int hierUsec = get_time_usec(reft);
+
+  printf("%s (%dx%d, L%d): cell by cell %.3f us/ray, hierarchical %.3f us/ray, %d/%d hits\n", name, hmap.getHeightmapSizeX(),
+    hmap.getHeightmapSizeY(), hmap.getCompressedData().htRangeBlocksLevels, cellUsec / float(RAYS * RUNS),
+    hierUsec / float(RAYS * RUNS), hits / RUNS, hitsHier / RUNS);
+  CHECK_EQUAL(hits, hitsHier);
+}
+
+SUITE(Benchmark)
+{
+  TEST(GrazingRays)
+  {
+    measure_cpu_freq();
+    SyntheticHeightmap synthetic;
+    synthetic.init(2048, 1.f, 16); // 7 levels of height ranges
+    bench("synthetic", synthetic);
+
+    if (const char *dump = getenv("HMAP_DUMP"))
+    {
+      HeightmapPhysHandler level;
+      FullFileLoadCB crd(dump);
+      if (crd.fileHandle && level.loadDump(crd, nullptr, 0))
+        bench(dump, level);
+      else
+        printf("can't load heightmap from '%s'\n", dump);
+    }
+  }
+}
+
+#include <unittest/main.inc.cpp>
@@ -0,0 +1,84 @@
+#include <memoryProfiler/dag_heapProfileDump.h>
+#include <memory/dag_heapSampler.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_events.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <util/dag_string.h>
+#include <debug/dag_debug.h>
+#include <EASTL/unique_ptr.h>
+
+namespace heap_profile_dump
+{
+class HeapProfileDumpThread final : public DaThread
+{
+public:
+  HeapProfileDumpThread(const char *prefix, int period_sec) :
+    DaThread("HeapProfileDump"), pathPrefix(prefix), periodMsec(period_sec * 1000)
+  {
+    os_event_create(&wakeEvent);
+  }
+  ~HeapProfileDumpThread() { os_event_destroy(&wakeEvent); }
+
+  void execute() override
+  {
+    while (!interlocked_acquire_load(terminating))
+    {
+      os_event_wait(&wakeEvent, periodMsec);
+      if (interlocked_acquire_load(terminating))
+        break;
+      dump();
+    }
+  }
+
+  void stop() { terminate(true, -1, &wakeEvent); }
+
+  void dump()
+  {
+    String fn(0, "%s.%04d.heap", pathPrefix.str(), seq++);
+    heap_sampler::Stats st;
+    heap_sampler::get_stats(st);
+    if (heap_sampler::dump_profile(fn))
+      debug("heap profile %s: %lld live samples (%lldK), %d stacks, %d dropped", fn, (long long)st.liveSamples,
+        (long long)st.liveBytes >> 10, st.uniqueStacks, st.droppedSamples);
+    else
+      logwarn("failed to write heap profile %s", fn);
+  }
+
+private:
+  String pathPrefix;
+  int periodMsec;
+  int seq = 0;
+  os_event_t wakeEvent;
+};
+
+static eastl::unique_ptr<HeapProfileDumpThread> dump_thread;
+
+bool start(const char *path_prefix, int period_sec, size_t sample_interval)
+{
+  if (dump_thread || !sample_interval || period_sec <= 0)
+    return false;
+  heap_sampler::set_sample_interval(sample_interval);
+  dump_thread = eastl::make_unique<HeapProfileDumpThread>(path_prefix, period_sec);
+  if (!dump_thread->start())
+  {
+    dump_thread.reset();
+    heap_sampler::set_sample_interval(0);
+    return false;
+  }
+  debug("heap sampling started: interval=%dK, dumps to %s.*.heap every %ds", int(sample_interval >> 10), path_prefix, period_sec);
+  return true;
+}
+
+void stop(bool final_dump)
+{
+  if (!dump_thread)
+    return;
+  dump_thread->stop();
+  if (final_dump)
+    dump_thread->dump();
+  dump_thread.reset();
+  heap_sampler::set_sample_interval(0);
+}
+
+bool is_started() { return dump_thread != nullptr; }
+} // namespace heap_profile_dump
@@ -0,0 +1,148 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <pathFinder/pathFinder.h>
+#include <detourNavMesh.h>
+#include <detourTileCache.h>
+#include <ioSys/dag_memIo.h>
+#include <ioSys/dag_dataBlock.h>
+#include <startup/dag_globalSettings.h>
+#include <osApiWrappers/dag_cpuJobs.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <util/dag_threadPool.h>
+#include <generic/dag_tab.h>
+#include <string.h>
+
+// Usage: tests [RebuildNavMesh]
+// RebuildNavMesh checks that tiles rebuilt on threadpool by interactive update are the same as ones built synchronously.
+// No landmesh and rendinsts are loaded, so heightmap trace returns its 'no hit' height everywhere and tiles are built over flat
+// plane there, water level is set below it
+
+static const float TILE_SIZE = 16.f; // cs * width of tile cache params
+static const float NO_HMAP_HEIGHT = -1e5f;
+static const int REBUILT_TILES_FROM = 1, REBUILT_TILES_TO = 2;
+
+static DataBlock testSettings;
+static const DataBlock *get_test_settings() { return &testSettings; }
+
+static void init_test_env()
+{
+  cpujobs::init();
+  threadpool::init(4, 256, 256 << 10); // always have workers, even on single core machine
+
+  // empty navmesh configs, so rebuild doesn't complain about missing ones
+  const char *configs[][2] = {{"navmeshLayers", "navmesh_layers.test.blk"}, {"rendinstDmg", "rendinst_dmg.test.blk"},
+    {"navmeshObstacles", "navmesh_obstacles.test.blk"}};
+  for (auto &config : configs)
+  {
+    DataBlock blk;
+    if (strcmp(config[0], "rendinstDmg") == 0)
+      blk.addNewBlock("riExtra");
+    blk.saveToTextFile(config[1]);
+    testSettings.setStr(config[0], config[1]);
+  }
+  dgs_get_settings = &get_test_settings;
+}
+
+// tile cached navmesh in bucket format without tiles
+static bool load_empty_nav_mesh()
+{
+  dtNavMeshParams nmParams;
+  memset(&nmParams, 0, sizeof(nmParams));
+  nmParams.orig[0] = nmParams.orig[2] = -4 * TILE_SIZE;
+  nmParams.tileWidth = nmParams.tileHeight = TILE_SIZE;
+  nmParams.maxTiles = 256;
+  nmParams.maxPolys = 4096;
+
+  dtTileCacheParams tcParams;
+  memset(&tcParams, 0, sizeof(tcParams));
+  memcpy(tcParams.orig, nmParams.orig, sizeof(tcParams.orig));
+  tcParams.cs = 0.5f;
+  tcParams.ch = 0.25f;
+  tcParams.width = tcParams.height = int(TILE_SIZE / tcParams.cs);
+  tcParams.walkableHeight = 2.f;
+  tcParams.walkableRadius = 0.5f;
+  tcParams.walkableClimb = 0.5f;
+  tcParams.maxSimplificationError = 1.3f;
+  tcParams.maxTiles = 256;
+  tcParams.maxObstacles = 128;
+
+  DynamicMemGeneralSaveCB cwr(tmpmem);
+  cwr.writeInt(0x80000000); // bucket format
+  cwr.write(&nmParams, sizeof(nmParams));
+  cwr.write(&tcParams, sizeof(tcParams));
+  cwr.writeInt(0); // obstacle resource name hashes
+  cwr.writeInt(0); // zstd dictionary size
+  cwr.writeInt(0); // buckets
+
+  InPlaceMemLoadCB crd(cwr.data(), cwr.size());
+  return pathfinder::loadNavMesh(crd, pathfinder::NMT_TILECACHED);
+}
+
+struct TileSnapshot
+{
+  int polyCount = -1, vertCount = -1, detailTriCount = -1;
+  Tab<float> verts;
+};
+
+static void rebuild_tiles(bool async, Tab<TileSnapshot> &out_tiles)
+{
+  pathfinder::rebuildNavMesh_init();
+  pathfinder::rebuildNavMesh_setup("waterLevel", NO_HMAP_HEIGHT * 2);
+  pathfinder::rebuildNavMesh_setup("asyncMaxJobs", async ? 4 : 0);
+  const float from = -4 * TILE_SIZE + REBUILT_TILES_FROM * TILE_SIZE + 1, to = -4 * TILE_SIZE + (REBUILT_TILES_TO + 1) * TILE_SIZE - 1;
+  pathfinder::rebuildNavMesh_addBBox(BBox3(Point3(from, NO_HMAP_HEIGHT - 10, from), Point3(to, NO_HMAP_HEIGHT + 10, to)));
+
+  if (async)
+  {
+    for (int i = 0; i < 100000 && pathfinder::rebuildNavMesh_getProgress() < 100; i++)
+    {
+      pathfinder::rebuildNavMesh_update(true);
+      sleep_msec(1);
+    }
+  }
+  else
+    pathfinder::rebuildNavMesh_update(false);
+  CHECK_EQUAL(100, pathfinder::rebuildNavMesh_getProgress());
+
+  out_tiles.clear();
+  const dtNavMesh *navMesh = pathfinder::getNavMeshPtr();
+  for (int ty = REBUILT_TILES_FROM; ty <= REBUILT_TILES_TO; ty++)
+    for (int tx = REBUILT_TILES_FROM; tx <= REBUILT_TILES_TO; tx++)
+    {
+      TileSnapshot &snapshot = out_tiles.push_back();
+      const dtMeshTile *tile = navMesh->getTileAt(tx, ty, 0);
+      if (!tile || !tile->header)
+        continue;
+      snapshot.polyCount = tile->header->polyCount;
+      snapshot.vertCount = tile->header->vertCount;
+      snapshot.detailTriCount = tile->header->detailTriCount;
+      snapshot.verts.assign(tile->verts, tile->verts + tile->header->vertCount * 3);
+    }
+  pathfinder::rebuildNavMesh_close();
+}
+
+SUITE(RebuildNavMesh)
+{
+  TEST(AsyncTilesMatchSync)
+  {
+    CHECK(load_empty_nav_mesh());
+
+    Tab<TileSnapshot> asyncTiles, syncTiles;
+    rebuild_tiles(true, asyncTiles);
+    rebuild_tiles(false, syncTiles);
+
+    CHECK_EQUAL(syncTiles.size(), asyncTiles.size());
+    for (int i = 0, n = min<int>(syncTiles.size(), asyncTiles.size()); i < n; i++)
+    {
+      CHECK(syncTiles[i].polyCount > 0);
+      CHECK_EQUAL(syncTiles[i].polyCount, asyncTiles[i].polyCount);
+      CHECK_EQUAL(syncTiles[i].vertCount, asyncTiles[i].vertCount);
+      CHECK_EQUAL(syncTiles[i].detailTriCount, asyncTiles[i].detailTriCount);
+      CHECK(syncTiles[i].verts.size() == asyncTiles[i].verts.size() &&
+            memcmp(syncTiles[i].verts.data(), asyncTiles[i].verts.data(), data_size(syncTiles[i].verts)) == 0);
+    }
+    pathfinder::clear_nav_mesh(pathfinder::NM_MAIN);
+  }
+}
+
+#define CUSTOM_UNITTEST_CODE init_test_env();
+#include <unittest/main.inc.cpp>
@@ -23,6 +23,8 @@
 #include <ioSys/dag_dataBlock.h>
 
 #include <util/dag_string.h>
+#include <util/dag_threadPool.h>
+#include <EASTL/unique_ptr.h>
 
 namespace pathfinder
 {
@@ -58,6 +60,7 @@ struct RebuildNavMeshSetup
   float detailSampleMaxError = 2.0f;
   float edgeMaxLen = 128.0f;
   float waterLevel = 0.0f;
+  int asyncMaxJobs = 4; // tiles built on threadpool at once by interactive update, 0 to build them synchronously
 };
 RebuildNavMeshSetup rebuildParams;
 enum ERebuildStep
@@ -75,6 +78,7 @@ typedef ska::flat_hash_map<eastl::pair<int, int>, eastl::pair<float, float>, Reb
 static RebuildTiles rebuildedTiles;
 int rebuildedTilesTotalSz = 0;
 static RebuildTiles generateTiles;
+static Tab<Point3> rebuildPriorityPos;
 
 struct MarkData
 {
@@ -86,6 +90,31 @@ struct MarkData
   uint32_t r;
 };
 
+static bool build_tile_geometry(rcConfig &cfg, int tx, int ty, const Tab<Point3> &vertices, const Tab<int> &indices,
+  const Tab<MarkData> &obstacles, dtTileCacheCompressor *tc_comp, Tab<recastnavmesh::BuildTileData> &tile_data);
+static void free_tile_data(Tab<recastnavmesh::BuildTileData> &tile_data);
+
+// Tile building on threadpool. Geometry is gathered on main thread before job is queued, as heightmap and rendinsts are changed
+// by game meanwhile, and job has own compressor, as ZSTD context of tile cache one is used by main thread.
+// Results are added to tile cache and navmesh by rebuildNavMesh_update() only, so live navmesh is never modified while path
+// queries may use it
+struct RebuildTileJob final : public cpujobs::IJob
+{
+  int tx = 0, ty = 0;
+  bool built = false;
+  rcConfig cfg;
+  Tab<Point3> vertices;
+  Tab<int> indices;
+  Tab<MarkData> obstacles;
+  TileCacheCompressor compressor;
+  Tab<recastnavmesh::BuildTileData> tileData;
+
+  ~RebuildTileJob() { free_tile_data(tileData); }
+
+  virtual void doJob() override { built = build_tile_geometry(cfg, tx, ty, vertices, indices, obstacles, &compressor, tileData); }
+};
+static Tab<eastl::unique_ptr<RebuildTileJob>> rebuildJobs;
+
 // This version differs from the one used by the editor - a different format for iterating renderinsts in a loaded game
 // and a different format for marking obstacles:
 static class NavmeshLayers
@@ -369,7 +398,7 @@ struct RendinstVertexDataCbGame : public rendinst::RendinstVertexDataCbBase
 };
 
 static bool finalize_navmesh_tilecached_tile(rcContext &ctx, const rcConfig &cfg, recastnavmesh::RecastTileContext &tile_ctx, int tx,
-  int ty, const Tab<MarkData> &obstacles, Tab<recastnavmesh::BuildTileData> &tile_data)
+  int ty, const Tab<MarkData> &obstacles, dtTileCacheCompressor *tc_comp, Tab<recastnavmesh::BuildTileData> &tile_data)
 {
   auto fn = [](const Tab<MarkData> &obstacles, const rcConfig &cfg, dtTileCacheLayer &layer, const dtTileCacheLayerHeader &header) {
     for (const auto &obs : obstacles)
@@ -382,7 +411,7 @@ static bool finalize_navmesh_tilecached_tile(rcContext &ctx, const rcConfig &cfg
     }
   };
 
-  return finalize_navmesh_tilecached_tile(ctx, cfg, tileCache->getAlloc(), tileCache->getCompressor(), nullptr, tile_ctx, tx, ty,
+  return finalize_navmesh_tilecached_tile(ctx, cfg, tileCache->getAlloc(), tc_comp, nullptr, tile_ctx, tx, ty,
     tileCache->getParams()->walkableClimb, tileCache->getParams()->walkableHeight, tileCache->getParams()->walkableRadius, obstacles,
     tile_data, fn);
 }
@@ -501,8 +530,14 @@ void collect_height_map_geometry(const BBox3 &box, Tab<Point3> &vertices, Tab<in
   }
 }
 
+static void finish_rebuild_jobs(bool apply);
+static bool use_async_rebuild();
+static bool rebuildNavMesh_update_asyncTiles();
+
 void rebuildNavMesh_init()
 {
+  finish_rebuild_jobs(false); // jobs use tile cache params and share dictionary of its compressor
+
   rebuildParams = RebuildNavMeshSetup();
 
   navmeshLayers = NavmeshLayers();
@@ -546,6 +581,8 @@ void rebuildNavMesh_setup(const char *name, float value)
     rebuildParams.edgeMaxLen = value;
   else if (strcmp(name, "waterLevel") == 0)
     rebuildParams.waterLevel = value;
+  else if (strcmp(name, "asyncMaxJobs") == 0)
+    rebuildParams.asyncMaxJobs = max((int)floorf(value + 0.5f), 0);
   else
     logdbg("Unknown rebuildNavMesh_setup param: %s, value: %f", name, value);
 }
@@ -606,8 +643,14 @@ bool rebuildNavMesh_update(bool interactive)
       rebuildStep = RS_REBUILDING_TILES;
       [[fallthrough]];
     case RS_REBUILDING_TILES:
-      result = rebuildNavMesh_update_buildTiles(maxTiles);
-      if (rebuildedTiles.empty())
+      if (interactive && use_async_rebuild())
+        result = rebuildNavMesh_update_asyncTiles();
+      else
+      {
+        finish_rebuild_jobs(true);
+        result = rebuildNavMesh_update_buildTiles(maxTiles);
+      }
+      if (rebuildedTiles.empty() && rebuildJobs.empty())
         rebuildStep = RS_FINISHED;
       break;
 
@@ -669,102 +712,120 @@ void rebuildNavMesh_update_removeTiles()
   navMesh->reconstructFreeList();
 }
 
-bool rebuildNavMesh_update_buildTiles(int n)
+static void collect_tile_geometry(int tx, int ty, float min_y, float max_y, rcConfig &cfg, Tab<Point3> &vertices, Tab<int> &indices,
+  Tab<MarkData> &obstacles)
 {
+  const float tileSize = tileCache->getParams()->cs * tileCache->getParams()->width;
+
+  BBox3 bbox;
+  bbox.lim[0] = Point3(tileCache->getParams()->orig[0] + tx * tileSize, min_y, tileCache->getParams()->orig[2] + ty * tileSize);
+  bbox.lim[1] =
+    Point3(tileCache->getParams()->orig[0] + (tx + 1) * tileSize, max_y, tileCache->getParams()->orig[2] + (ty + 1) * tileSize);
+
   Tab<IPoint2> transparent;
-  Tab<MarkData> obstacles;
 
-  for (int i = 0; i < n && !rebuildedTiles.empty(); ++i)
-  {
-    const float tileSize = tileCache->getParams()->cs * tileCache->getParams()->width;
+  BBox3 extGeomBox(bbox);
+  extGeomBox.inflate(tileCache->getParams()->width * tileCache->getParams()->cs);
 
-    int tx = rebuildedTiles.begin()->first.first;
-    int ty = rebuildedTiles.begin()->first.second;
+  collect_height_map_geometry(extGeomBox, vertices, indices);
+  collect_rendinst(extGeomBox, vertices, indices, transparent, obstacles);
 
-    BBox3 bbox;
+  init_tile_config(cfg, vertices);
+}
 
-    bbox.lim[0] = Point3(tileCache->getParams()->orig[0] + tx * tileSize, rebuildedTiles.begin()->second.first,
-      tileCache->getParams()->orig[2] + ty * tileSize);
+static bool build_tile_geometry(rcConfig &cfg, int tx, int ty, const Tab<Point3> &vertices, const Tab<int> &indices,
+  const Tab<MarkData> &obstacles, dtTileCacheCompressor *tc_comp, Tab<recastnavmesh::BuildTileData> &tile_data)
+{
+  const Tab<IPoint2> noTransparent;
+  rcContext ctx;
+  recastnavmesh::RecastTileContext tile_ctx;
 
-    bbox.lim[1] = Point3(tileCache->getParams()->orig[0] + (tx + 1) * tileSize, rebuildedTiles.begin()->second.second,
-      tileCache->getParams()->orig[2] + (ty + 1) * tileSize);
+  if (!prepare_tile_context(ctx, cfg, tile_ctx, tx, ty, vertices, indices, noTransparent))
+  {
+    logerr("Rebuild NavMesh: failed to prepare tile context at (%d,%d)", tx, ty);
+    tile_ctx.clearIntermediate(nullptr);
+    return false;
+  }
 
-    Tab<Point3> vertices;
-    Tab<int> indices;
+  // TODO LATER Use transparent array to build heightmap for covers tracing without transparent geometry
+  // TODO LATER when covers generation added here.
 
-    BBox3 extGeomBox(bbox);
-    extGeomBox.inflate(tileCache->getParams()->width * tileCache->getParams()->cs);
+  if (!finalize_navmesh_tilecached_tile(ctx, cfg, tile_ctx, tx, ty, obstacles, tc_comp, tile_data))
+  {
+    logerr("Rebuild NavMesh: failed to generate navmesh tiles at (%d,%d)", tx, ty);
+    return false;
+  }
 
-    collect_height_map_geometry(extGeomBox, vertices, indices);
-    collect_rendinst(extGeomBox, vertices, indices, transparent, obstacles);
-    const Tab<IPoint2> noTransparent;
+  tile_ctx.clearIntermediate(nullptr);
+  return true;
+}
 
-    // build tiles
-    {
-      rcContext ctx;
-      rcConfig cfg;
+static bool build_tile(int tx, int ty, float min_y, float max_y, Tab<MarkData> &obstacles,
+  Tab<recastnavmesh::BuildTileData> &tile_data)
+{
+  rcConfig cfg;
+  Tab<Point3> vertices;
+  Tab<int> indices;
+  collect_tile_geometry(tx, ty, min_y, max_y, cfg, vertices, indices, obstacles);
+  return build_tile_geometry(cfg, tx, ty, vertices, indices, obstacles, tileCache->getCompressor(), tile_data);
+}
 
-      init_tile_config(cfg, vertices);
+static void free_tile_data(Tab<recastnavmesh::BuildTileData> &tile_data)
+{
+  for (recastnavmesh::BuildTileData &td : tile_data)
+  {
+    dtFree(td.navMeshData);
+    dtFree(td.tileCacheData);
+  }
+  clear_and_shrink(tile_data);
+}
 
-      recastnavmesh::RecastTileContext tile_ctx;
-      Tab<recastnavmesh::BuildTileData> tile_data;
+static void add_rebuilt_tile(int tx, int ty, Tab<recastnavmesh::BuildTileData> &tile_data)
+{
+  for (recastnavmesh::BuildTileData &td : tile_data)
+  {
+    if (td.tileCacheDataSz == 0 || td.navMeshDataSz == 0)
+      continue;
 
-      if (!prepare_tile_context(ctx, cfg, tile_ctx, tx, ty, vertices, indices, noTransparent))
-      {
-        logerr("Rebuild NavMesh: failed to prepare tile context at (%d,%d)", tx, ty);
-        continue;
-      }
+    rebuildedTilesTotalSz += td.tileCacheDataSz;
+    rebuildedTilesTotalSz += td.navMeshDataSz;
+
+    dtCompressedTileRef res = 0;
+    dtTileRef nav = 0;
 
-      // TODO LATER Use transparent array to build heightmap for covers tracing without transparent geometry
-      // TODO LATER when covers generation added here.
+    {
+      dtStatus status = tileCache->addTile(td.tileCacheData, td.tileCacheDataSz, DT_COMPRESSEDTILE_FREE_DATA, &res);
 
-      if (!finalize_navmesh_tilecached_tile(ctx, cfg, tile_ctx, tx, ty, obstacles, tile_data))
+      if (dtStatusSucceed(status) && res != 0)
       {
-        logerr("Rebuild NavMesh: failed to generate navmesh tiles at (%d,%d)", tx, ty);
-        continue;
+        tileCToSave.push_back(res);
+        td.tileCacheData = nullptr; // owned by tile cache now
       }
-
-      for (int i = 0; i < tile_data.size(); ++i)
+      else
       {
-        if (tile_data[i].tileCacheDataSz == 0 || tile_data[i].navMeshDataSz == 0)
-          continue;
-
-        rebuildedTilesTotalSz += tile_data[i].tileCacheDataSz;
-        rebuildedTilesTotalSz += tile_data[i].navMeshDataSz;
-
-        dtCompressedTileRef res = 0;
-        dtTileRef nav = 0;
-
-        {
-          dtStatus status =
-            tileCache->addTile(tile_data[i].tileCacheData, tile_data[i].tileCacheDataSz, DT_COMPRESSEDTILE_FREE_DATA, &res);
-
-          if (dtStatusSucceed(status) && res != 0)
-            tileCToSave.push_back(res);
-          else
-          {
-            logerr("Rebuild NavMesh: failed to add tilecache tile at (%d,%d)", tx, ty);
-          }
-        }
+        logerr("Rebuild NavMesh: failed to add tilecache tile at (%d,%d)", tx, ty);
+      }
+    }
 
-        {
-          dtStatus status = getNavMeshPtr()->addTile(tile_data[i].navMeshData, tile_data[i].navMeshDataSz, DT_TILE_FREE_DATA, 0, &nav);
-
-          if (dtStatusSucceed(status) && nav != 0)
-            tilesToSave.push_back(nav);
-          else
-          {
-            logerr("Rebuild NavMesh: failed to add navmesh tile at (%d,%d)", tx, ty);
-          }
-        }
+    {
+      dtStatus status = getNavMeshPtr()->addTile(td.navMeshData, td.navMeshDataSz, DT_TILE_FREE_DATA, 0, &nav);
 
-        tile_ctx.clearIntermediate(nullptr);
+      if (dtStatusSucceed(status) && nav != 0)
+      {
+        tilesToSave.push_back(nav);
+        td.navMeshData = nullptr; // owned by navmesh now
+      }
+      else
+      {
+        logerr("Rebuild NavMesh: failed to add navmesh tile at (%d,%d)", tx, ty);
       }
     }
-
-    rebuildedTiles.erase(rebuildedTiles.begin());
   }
+  free_tile_data(tile_data);
+}
 
+static void apply_rebuilt_obstacles(const Tab<MarkData> &obstacles)
+{
   Tab<obstacle_handle_t> removedHandles;
 
   for (const auto &obstacle : obstacles)
@@ -785,11 +846,112 @@ bool rebuildNavMesh_update_buildTiles(int n)
 
   for (const auto &obstacle : removedHandles)
     tilecache_obstacle_remove(obstacle, false);
+}
+
+bool rebuildNavMesh_update_buildTiles(int n)
+{
+  Tab<MarkData> obstacles;
+
+  for (int i = 0; i < n && !rebuildedTiles.empty(); ++i)
+  {
+    int tx = rebuildedTiles.begin()->first.first;
+    int ty = rebuildedTiles.begin()->first.second;
+
+    Tab<recastnavmesh::BuildTileData> tile_data;
+    if (build_tile(tx, ty, rebuildedTiles.begin()->second.first, rebuildedTiles.begin()->second.second, obstacles, tile_data))
+      add_rebuilt_tile(tx, ty, tile_data);
+
+    rebuildedTiles.erase(rebuildedTiles.begin());
+  }
+
+  apply_rebuilt_obstacles(obstacles);
 
   // logdbg("rebuild_tiles: total size %d bytes, %d tiles left", rebuildedTilesTotalSz, rebuildedTiles.size());
   return true;
 }
 
+static bool use_async_rebuild() { return rebuildParams.asyncMaxJobs > 0 && threadpool::get_num_workers() > 0; }
+
+static void finish_rebuild_jobs(bool apply)
+{
+  for (auto &job : rebuildJobs)
+  {
+    threadpool::wait(job.get());
+    if (apply && job->built)
+    {
+      add_rebuilt_tile(job->tx, job->ty, job->tileData);
+      apply_rebuilt_obstacles(job->obstacles);
+    }
+  }
+  clear_and_shrink(rebuildJobs);
+}
+
+// tiles closest to priority positions (agents) go first, otherwise order doesn't matter
+static RebuildTiles::iterator pick_rebuild_tile()
+{
+  if (rebuildPriorityPos.empty())
+    return rebuildedTiles.begin();
+
+  const float tileSize = tileCache->getParams()->cs * tileCache->getParams()->width;
+  const Point2 orig(tileCache->getParams()->orig[0], tileCache->getParams()->orig[2]);
+  RebuildTiles::iterator best = rebuildedTiles.begin();
+  float bestDistSq = FLT_MAX;
+  for (auto it = rebuildedTiles.begin(); it != rebuildedTiles.end(); ++it)
+  {
+    Point2 center = orig + Point2(it->first.first + 0.5f, it->first.second + 0.5f) * tileSize;
+    for (const Point3 &pos : rebuildPriorityPos)
+    {
+      float distSq = lengthSq(Point2::xz(pos) - center);
+      if (distSq < bestDistSq)
+      {
+        bestDistSq = distSq;
+        best = it;
+      }
+    }
+  }
+  return best;
+}
+
+static bool rebuildNavMesh_update_asyncTiles()
+{
+  // safe point to swap finished tiles into live navmesh
+  for (int i = 0; i < rebuildJobs.size();)
+  {
+    RebuildTileJob *job = rebuildJobs[i].get();
+    if (!interlocked_acquire_load(job->done))
+    {
+      ++i;
+      continue;
+    }
+    if (job->built)
+    {
+      add_rebuilt_tile(job->tx, job->ty, job->tileData);
+      apply_rebuilt_obstacles(job->obstacles);
+    }
+    erase_items(rebuildJobs, i, 1);
+  }
+
+  while (rebuildJobs.size() < rebuildParams.asyncMaxJobs && !rebuildedTiles.empty())
+  {
+    RebuildTiles::iterator it = pick_rebuild_tile();
+    eastl::unique_ptr<RebuildTileJob> job(new RebuildTileJob);
+    job->tx = it->first.first;
+    job->ty = it->first.second;
+    collect_tile_geometry(job->tx, job->ty, it->second.first, it->second.second, job->cfg, job->vertices, job->indices,
+      job->obstacles);
+    // tile cache of pathfinder is always created with TileCacheCompressor
+    job->compressor.resetShared(*static_cast<TileCacheCompressor *>(tileCache->getCompressor()));
+    rebuildedTiles.erase(it);
+    threadpool::add(job.get(), threadpool::PRIO_LOW);
+    rebuildJobs.push_back(eastl::move(job));
+  }
+  return true;
+}
+
+void rebuildNavMesh_clearPriorityPos() { rebuildPriorityPos.clear(); }
+
+void rebuildNavMesh_addPriorityPos(const Point3 &pos) { rebuildPriorityPos.push_back(pos); }
+
 int rebuildNavMesh_getProgress()
 {
   if (rebuildStep == RS_UNINIT)
@@ -798,7 +960,7 @@ int rebuildNavMesh_getProgress()
     return 100;
   int value = 100;
   if (!generateTiles.empty())
-    value = 100 - (100 * rebuildedTiles.size()) / generateTiles.size();
+    value = 100 - (100 * (rebuildedTiles.size() + rebuildJobs.size())) / generateTiles.size();
   return (value < 1) ? 1 : (value > 99) ? 99 : value;
 }
 
@@ -925,6 +1087,7 @@ bool rebuildNavMesh_saveToFile(const char *file_name)
 
 void rebuildNavMesh_close()
 {
+  finish_rebuild_jobs(false);
   rebuildStep = RS_UNINIT;
 
   rebuildedTiles.clear();
@@ -62,6 +62,10 @@ void rebuildNavMesh_addBBox(const BBox3 &) {}
 
 bool rebuildNavMesh_update(bool) { return false; }
 
+void rebuildNavMesh_clearPriorityPos() {}
+
+void rebuildNavMesh_addPriorityPos(const Point3 &) {}
+
 int rebuildNavMesh_getProgress() { return 0; }
 
 int rebuildNavMesh_getTotalTiles() { return 0; }
@@ -81,15 +81,18 @@ static inline bool is_pt_in_obstacle(const float *center, const float *half_exte
 TileCacheCompressor::~TileCacheCompressor()
 {
   ZSTD_freeDCtx(dctx);
-  ZSTD_freeDDict(dDict);
+  if (ownDDict)
+    ZSTD_freeDDict(dDict);
 }
 
 void TileCacheCompressor::reset(bool isZSTD, const Tab<char> &zstdDictBuff)
 {
   ZSTD_freeDCtx(dctx);
-  ZSTD_freeDDict(dDict);
+  if (ownDDict)
+    ZSTD_freeDDict(dDict);
   dctx = nullptr;
   dDict = nullptr;
+  ownDDict = true;
 
   if (!isZSTD)
     return;
@@ -103,6 +106,13 @@ void TileCacheCompressor::reset(bool isZSTD, const Tab<char> &zstdDictBuff)
   }
 }
 
+void TileCacheCompressor::resetShared(const TileCacheCompressor &src)
+{
+  reset(src.dctx != nullptr);
+  dDict = src.dDict; // ZSTD_DDict is read-only and can be used by several contexts at once
+  ownDDict = false;
+}
+
 int TileCacheCompressor::maxCompressedSize(const int bufferSize)
 {
   return (dctx != nullptr) ? (int)ZSTD_compressBound(bufferSize) : (int)(bufferSize * fastlzMaxCompressedSizeFactor);
@@ -16,6 +16,7 @@
 #include <EASTL/vector_map.h>
 #include <generic/dag_span.h>
 #include <generic/dag_smallTab.h>
+#include <dag/dag_vector.h>
 #include <generic/dag_initOnDemand.h>
 #include <daECS/core/event.h>
 #include "internal/templates.h"
@@ -100,6 +101,30 @@ public:
   void setConstrainedMTMode(bool on);
   bool isConstrainedMTMode() const;
 
+  // set update stages (mask of 1<<stage) which ES are run in parallel in threadpool.
+  //  ES of such stage are grouped into waves, ES can be in same wave if
+  //  * none of them writes (RW) component that other one reads or writes (RW/RO), according to their declaration
+  //  * they are not ordered with before/after/es_order (directly or via sync points)
+  //  * they are not dynamic (script) ES, and they do access some data components (otherwise they are likely to work with globals)
+  //  Waves are executed one after another, in order of first ES, and ES of wave are executed in Constrained MT mode (see above),
+  //  so all requirements of it are applied to ES of parallel stage. Order of deferred events sent from one wave is not determined.
+  //  If validate is true, ES of waves are run one-by-one (still in Constrained MT mode), and each ES is checked that it doesn't
+  //  change data of components that other ES of same wave access, unless declared as RW (logerr). It is slow, and only inline data of
+  //  components is checked (i.e. not content of containers)
+  void setParallelUpdateStages(uint32_t stages_mask, bool validate = false);
+  uint32_t getParallelUpdateStages() const { return parallelStagesMask; }
+  struct ParallelStageStats
+  {
+    uint32_t runs = 0;      // updates of stage since reset
+    uint32_t systems = 0;   // ES in stage schedule
+    uint32_t waves = 0;     // waves in stage schedule
+    uint64_t wallUsec = 0;  // total time of stage updates
+    uint64_t esUsec = 0;    // total time of stage ES, summed over threads. esUsec/wallUsec is achieved speedup
+    uint32_t maxWaveSize = 0;
+  };
+  ParallelStageStats getParallelStageStats(uint32_t stage) const;
+  void dumpParallelStageStats(bool reset = true); // debug() stats of all parallel stages
+
   // Enable mode where entities with reserved components assigned IDs within lowest 64K
   // Typically enabled on server in order to have identical eids for networking entities with client
   void setEidsReservationMode(bool on);
@@ -327,6 +352,13 @@ public:
   EntityManager(const EntityManager &from);
   ~EntityManager();
   void copyFrom(const EntityManager &from);
+
+  // Binary snapshot of all alive entities: descriptors with generations, used templates (by name) and archetype chunks, where pod
+  // components are copied as whole columns and only non-trivial ones are (de)serialized with their io, or recreated from template if
+  // they have none. Restore replaces all entities without sending any events and requires same templates and components layout.
+  // Entities that are not created yet (loading or queued) are not saved and are dead after restore.
+  bool saveSnapshot(dag::Vector<uint8_t> &out) const;
+  bool restoreSnapshot(dag::ConstSpan<uint8_t> data);
   // bool performQuery(EntityId eid, const NamedQueryDesc &desc, const query_cb_t &fun);//not yet implemented
 
   // for inspection
@@ -82,7 +82,19 @@ enum EventFlags : event_flags_t
                            // events, once we make inspection code
   EVFLG_CORE = 0x20,       // this is not really required, that's for validation purpose
   EVFLG_PROFILE = 0x40,    // ES for this event will be profiled by default
+  EVFLG_BATCHED = 0x80,    // deferred unicast event is sent batched with same events to entities of same archetype, see below
 };
+// Deferred (sendEvent) unicast events with EVFLG_BATCHED are not sent in order of arrival. Each drain of deferred events queue
+// collects them, and sends after all other events of that drain, bucketed by event type and archetype of entity.
+// Each ES is called for all events of bucket before next ES, in order of entities in chunks, and identical events sent to
+// neighbour entities of chunk are passed to ES with one call and query view of all these entities.
+// Guarantees kept are:
+//  * each ES receives events sent to same entity in order they were sent, and all ES of event are called as usual
+//  * ES of event are called in their usual order for each bucket, but not for each event
+// Not guaranteed is:
+//  * order relative to other events (of same or other types, sent to same or other entities)
+//  * order of ES calls for different events of same entity (ES A receives both events sent to entity before ES B receives first)
+// Which suits bursts of independent events, like damage, hits or net messages. sendEventImmediate is not affected.
 // we currently don't allow vec4f in Event
 //  If ever needed, just change EVENT_ALIGNMENT to 16, and/or
 //  change align_event_on_emplace to true
@@ -190,6 +202,8 @@ typedef void move_out_event(void *__restrict to, ecs::Event &&from); // will be
   ECS_BASE_DECL_EVENT_TYPE(Klass, ::ecs::EVCAST_UNICAST | ::ecs::EVFLG_PROFILE, __VA_ARGS__)
 #define ECS_BROADCAST_PROFILE_EVENT_TYPE(Klass, ...) \
   ECS_BASE_DECL_EVENT_TYPE(Klass, ::ecs::EVCAST_BROADCAST | ::ecs::EVFLG_PROFILE, __VA_ARGS__)
+#define ECS_UNICAST_BATCHED_EVENT_TYPE(Klass, ...) \
+  ECS_BASE_DECL_EVENT_TYPE(Klass, ::ecs::EVCAST_UNICAST | ::ecs::EVFLG_BATCHED, __VA_ARGS__)
 
 struct EventInfoLinkedList
 {
@@ -83,6 +83,8 @@ public:
   RESTRICT_FUN
   void *__restrict getData(uint32_t ofs, uint32_t sz, chunk_type_t chunkId, uint32_t id) const;
   uint32_t allocateChunk(const uint32_t entity_size, uint8_t capacity_bits);
+  // frees all chunks (components data has to be destroyed already) and allocates fitting ones with used_count entities in it
+  void resetToUsed(uint32_t entity_size, uint32_t used_count);
 
   Chunk &allocateEmptyInNewChunk(chunk_type_t &chunkId, uint32_t &id, uint32_t entity_size);
   Chunk &allocateEmpty(chunk_type_t &chunkId, uint32_t &id, uint32_t entity_size);
@@ -454,7 +454,7 @@ __forceinline void EntityManager::dispatchEvent(EntityId eid, EventType &&evt) /
 }
 
 template <class Storage>
-__forceinline void EntityManager::emplaceUntypedEvent(Storage &storage, EntityId eid, Event &evt)
+__forceinline Event &EntityManager::emplaceUntypedEvent(Storage &storage, EntityId eid, Event &evt)
 {
   const uint32_t len = evt.getLength();
   void *__restrict at = storage.allocateUntypedEvent(eid, len);
@@ -464,6 +464,7 @@ __forceinline void EntityManager::emplaceUntypedEvent(Storage &storage, EntityId
   }
   else
     eventDb.moveOut(at, eastl::move(evt)); // hash lookup
+  return *(Event *)at;
 }
 
 __forceinline void EntityManager::dispatchEvent(EntityId eid, Event &evt) // ecs::INVALID_ENTITY_ID means broadcast
@@ -41,6 +41,12 @@ bool archetypeTrackChangedCheck(uint32_t archetypeId, component_index_t cidx);
 struct EntityDesc;
 static constexpr int MAX_ONE_EID_QUERY_COMPONENTS = 96;
 bool fillEidQueryView(ecs::EntityId eid, EntityDesc ent, QueryId h, QueryView &__restrict qv);
+// fillEidQueryView split in two: index of archetype in query (INVALID_ARCHETYPE if query doesn't apply) and filling view with it
+archetype_t getEidQueryArchSubQuery(QueryId h, uint32_t archetype) const;
+void fillEidQueryViewArchSubQuery(ecs::EntityId eid, EntityDesc ent, QueryId h, archetype_t arch_sub_query, QueryView &__restrict qv);
+// same for count entities placed one after another in chunk, starting with ent
+void fillEidsQueryViewArchSubQuery(const ecs::EntityId *eids, uint32_t count, EntityDesc ent, QueryId h, archetype_t arch_sub_query,
+  QueryView &__restrict qv);
 template <typename Fn>
 bool performEidQuery(ecs::EntityId eid, QueryId h, Fn &&fun, void *user_data);
 
@@ -445,11 +451,72 @@ protected:
 typedef EsIndexFixedSet es_index_set;
 dag::Vector<es_index_set> esUpdates; // sorted by update priority ES functions (for each update stage)
 
+// parallel update stages, see setParallelUpdateStages
+struct ParallelStageSchedule
+{
+  bool valid = false;
+  dag::Vector<es_index_type> order;    // ES of stage sorted by wave
+  dag::Vector<uint16_t> waveEnds;      // end of each wave in order
+  dag::Vector<uint16_t> watchedOfs;    // validation only: for each ES in order, range of watchedComps (with next one)
+  dag::Vector<component_t> watchedComps;
+};
+uint32_t parallelStagesMask = 0;
+bool parallelStagesValidate = false;
+dag::Vector<ParallelStageSchedule> parallelSchedules; // per stage, lazily built
+dag::Vector<ParallelStageStats> parallelStageStats;   // per stage
+// ES order graph (ES and sync points), kept after resetEsOrder to find if two ES are ordered
+dag::Vector<int> esGraphNode;                    // parallel to esList
+dag::Vector<int> esGraphEdgesOfs, esGraphEdges; // edges from graph node n are esGraphEdges[esGraphEdgesOfs[n]..esGraphEdgesOfs[n+1])
+const ParallelStageSchedule &getParallelSchedule(uint32_t stage);
+void buildParallelSchedule(uint32_t stage, ParallelStageSchedule &sch) const;
+void updateParallel(const UpdateStageInfo &info);
+int runUpdateEs(es_index_type es_index, const UpdateStageInfo &info); // returns usec spent
+void runParallelWaveValidated(const UpdateStageInfo &info, const ParallelStageSchedule &sch, uint32_t from, uint32_t to,
+  uint64_t &es_usec);
+uint64_t hashComponentData(component_t name) const; // of all entities
+
 // probably use ska::flat_hash_map<event_type_t, event_index_t> esEventsMap; eastl::vector<eastl::vector_set<es_index_type>>
 // esEventsList; check performance
 ska::flat_hash_map<event_type_t, es_index_set, ska::power_of_two_std_hash<event_type_t>> esEvents;
 ska::flat_hash_map<component_t, es_index_set, ska::power_of_two_std_hash<event_type_t>> esOnChangeEvents;
 
+// Unicast events dispatch. Events with ES get dense indices on registration (esEventSlots is open addressing table on event type,
+// which is hash already), and for each archetype ES which apply to it, with their archetype subqueries (i.e. offsets of components),
+// are listed per event on first event sent to entity of that archetype. So dispatch is lookup in two arrays and direct ES calls.
+// Lists are reset with ES registration and queries re-resolve, new archetypes get own lists
+static constexpr uint16_t INVALID_ES_EVENT_INDEX = 0xFFFF;
+struct EsEventSlot
+{
+  event_type_t type;
+  uint16_t index;
+};
+dag::Vector<EsEventSlot> esEventSlots; // power of 2 size, at most half full
+dag::Vector<event_type_t> esEventTypes; // by event index
+uint16_t findEsEventIndex(event_type_t type) const;
+void addEsEventIndex(event_type_t type);
+void clearEsEventIndices();
+
+struct ArchetypeEventEs
+{
+  es_index_type esIndex;
+  archetype_t archSubQuery;
+};
+struct ArchetypeEventsEs
+{
+  static constexpr uint32_t NOT_BUILT = ~0u;
+  dag::Vector<uint32_t> lists; // by event index, first ES in es << 16 | count, or NOT_BUILT
+  dag::Vector<ArchetypeEventEs> es;
+};
+dag::Vector<ArchetypeEventsEs> archetypesEventsES; // by archetype
+uint32_t archetypesEventsESGeneration = 0;          // incremented on reset, so dispatch can detect it from within ES
+uint32_t getArchetypeEventES(uint32_t archetype, uint16_t event_index);
+uint32_t buildArchetypeEventES(uint32_t archetype, uint16_t event_index);
+void resetArchetypesEventsES()
+{
+  archetypesEventsES.clear();
+  ++archetypesEventsESGeneration;
+}
+
 enum ArchEsList
 {
   ENTITY_CREATION_ES,
@@ -507,6 +574,8 @@ void validateEventRegistration(const Event &, const char *) {}
 
 void callESEvent(es_index_type esIndex, const Event &evt, QueryView &qv);
 void notifyESEventHandlers(EntityId eid, const Event &evt);
+void notifyESEventHandlersAllES(EntityId eid, const Event &evt, const es_index_type *es_start, const es_index_type *es_end);
+void notifyESEventHandlersAfter(EntityId eid, const Event &evt, es_index_type last_es); // ES of event after last_es
 void notifyESEventHandlersInternal(EntityId eid, const Event &evt, const es_index_type *__restrict es_start,
   const es_index_type *__restrict es_end);
 void notifyESEventHandlers(EntityId eid, archetype_t archetype, ArchEsList list);
@@ -714,6 +783,32 @@ void destroyEntityImmediate(EntityId e);
 
 DeferredEventsStorage<> eventsStorage;
 uint32_t deferredEventsCount = 0;
+// deferred unicast events with EVFLG_BATCHED, collected while events queue is drained and sent after drain, see event.h
+enum BatchedEventsState : uint8_t
+{
+  BATCHED_EVENTS_IDLE,
+  BATCHED_EVENTS_COLLECTING,
+  BATCHED_EVENTS_SENDING
+};
+struct BatchedEvent
+{
+  Event *evt;
+  EntityId eid;
+  uint32_t bucket;     // index in batchedEventsBuckets
+  uint32_t position;   // chunkId << 16 | idInChunk of entity, when event was collected
+  uint32_t order;      // of arrival
+  uint32_t sentUpToEs; // when event was detached from bucket
+  uint32_t runLength;  // of identical events sent to entities following one after another in chunk, starting with this one
+};
+DeferredEventsStorage<> batchedEventsStorage;
+dag::Vector<BatchedEvent> batchedEvents, batchedEventsSorted;
+dag::Vector<uint64_t> batchedEventsBuckets; // event type << 32 | archetype
+ska::flat_hash_map<uint64_t, uint32_t, ska::power_of_two_std_hash<uint64_t>> batchedEventsBucketsMap;
+uint32_t batchedEventsPositionsMask = 0; // all positions or-ed, radix sort key fits only positions < 1 << 24
+uint8_t batchedEventsState = BATCHED_EVENTS_IDLE;
+void batchDeferredEvent(EntityId eid, Event &evt);
+void sendBatchedEvents();
+void sendBatchedEventsBucket(BatchedEvent *begin, BatchedEvent *end);
 WinCritSec deferredEventsMutex;
 template <class CircularBuffer, typename ProcessEvent>
 uint32_t processEventInternal(CircularBuffer &buffer, ProcessEvent &&cb);
@@ -722,7 +817,7 @@ uint32_t processEventsActive(uint32_t count, EventStorage &);
 template <class EventStorage>
 uint32_t processEventsAnyway(uint32_t count, EventStorage &);
 template <class EventStorage>
-void emplaceUntypedEvent(EventStorage &storage, EntityId eid, Event &evt);
+Event &emplaceUntypedEvent(EventStorage &storage, EntityId eid, Event &evt);
 template <class T>
 void destroyEvents(T &storage);
 // should be out-of-line
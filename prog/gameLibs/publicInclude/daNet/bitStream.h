@@ -6,6 +6,7 @@
 #pragma once
 
 #include <string.h>
+#include <stdlib.h>
 #include <stddef.h>
 #include <generic/dag_span.h>
 #include <EASTL/type_traits.h>
@@ -177,7 +178,93 @@ public:
   void ResetReadPointer() const { readOffset = 0; }
 
   // actual read/write implementation
+  // Bits are stored MSB first: whole bytes of input go first, then low (bits % 8) bits of last input byte.
+  // Data is moved with 64-bit loads/stores of up to 56 bits at once (bits around written range are preserved, as WriteAt relies on it);
+  // when there is no room for 8-byte access at the end of buffer byte-at-a-time implementation is used, the result is identical.
   void WriteBits(const uint8_t *input, uint32_t bits)
+  {
+    if (!input || !bits)
+      return;
+    reserveBits(bits);
+    if (!hasWordAccessRoom(bitsUsed + bits))
+      return WriteBitsBytewise(input, bits);
+
+    if (!(bitsUsed & 7) && !(bits & 7))
+    {
+      memcpy(GetData() + (bitsUsed >> 3), input, bits >> 3);
+      bitsUsed += bits;
+      return;
+    }
+    for (; bits > WORD_CHUNK_BITS; bits -= WORD_CHUNK_BITS, input += WORD_CHUNK_BITS / 8)
+      writeChunk(le_to_chunk(load_le(input, WORD_CHUNK_BITS / 8), WORD_CHUNK_BITS), WORD_CHUNK_BITS);
+    writeChunk(le_to_chunk(load_le(input, bits2bytes(bits)), bits), bits);
+  }
+
+  bool ReadBits(uint8_t *output, uint32_t bits) const
+  {
+    if (!bits)
+      return true;
+    else if ((readOffset + bits) > bitsUsed)
+    {
+#if DAGOR_DBGLEVEL > 0 && defined(_DEBUG_TAB_)
+      if (output)
+        memset(output, 0x7e, bits2bytes(bits));
+#endif
+      return false;
+    }
+    if (!hasWordAccessRoom(readOffset + bits))
+      return ReadBitsBytewise(output, bits);
+
+    if (!(readOffset & 7) && !(bits & 7)) // fast path - everything byte aligned
+    {
+      memcpy(output, GetData() + (readOffset >> 3), bits >> 3);
+      readOffset += bits;
+      return true;
+    }
+    for (; bits > WORD_CHUNK_BITS; bits -= WORD_CHUNK_BITS, output += WORD_CHUNK_BITS / 8)
+      store_le(output, chunk_to_le(readChunk(WORD_CHUNK_BITS), WORD_CHUNK_BITS), WORD_CHUNK_BITS / 8);
+    store_le(output, chunk_to_le(readChunk(bits), bits), bits2bytes(bits));
+    return true;
+  }
+
+  // Same as WriteBits((const uint8_t *)&v, bits)/ReadBits((uint8_t *)&v, bits) for integer value (bits <= 64), but without
+  // round trip through memory; useful for tightly packed quantized values
+  void WriteBitsValue(uint64_t v, uint32_t bits)
+  {
+    G_ASSERT(bits <= 64);
+    if (!bits)
+      return;
+    reserveBits(bits);
+    if (!hasWordAccessRoom(bitsUsed + bits))
+      return WriteBitsBytewise((const uint8_t *)&v, bits);
+    if (bits > WORD_CHUNK_BITS)
+    {
+      writeChunk(le_to_chunk(v, WORD_CHUNK_BITS), WORD_CHUNK_BITS);
+      v >>= WORD_CHUNK_BITS;
+      bits -= WORD_CHUNK_BITS;
+    }
+    writeChunk(le_to_chunk(v, bits), bits);
+  }
+  bool ReadBitsValue(uint64_t &v, uint32_t bits) const
+  {
+    G_ASSERT(bits <= 64);
+    v = 0;
+    if ((readOffset + bits) > bitsUsed)
+      return false;
+    if (!hasWordAccessRoom(readOffset + bits))
+      return ReadBitsBytewise((uint8_t *)&v, bits);
+    if (bits > WORD_CHUNK_BITS)
+    {
+      v = chunk_to_le(readChunk(WORD_CHUNK_BITS), WORD_CHUNK_BITS);
+      v |= chunk_to_le(readChunk(bits - WORD_CHUNK_BITS), bits - WORD_CHUNK_BITS) << WORD_CHUNK_BITS;
+    }
+    else if (bits)
+      v = chunk_to_le(readChunk(bits), bits);
+    return true;
+  }
+
+  // Reference byte-at-a-time implementation (used near the end of buffer)
+  void WriteBitsBytewise(const uint8_t *input, uint32_t bits)
   {
     if (!input || !bits)
       return;
@@ -224,7 +311,7 @@ public:
     *destPtr = (*destPtr & (0xff >> bits)) | ((srcByte & ((1 << bits) - 1)) << (8 - bits));
   }
 
-  bool ReadBits(uint8_t *output, uint32_t bits) const
+  bool ReadBitsBytewise(uint8_t *output, uint32_t bits) const
   {
     if (!bits)
       return true;
@@ -657,6 +744,77 @@ protected:
   static inline uint32_t bits2bytes(uint32_t bi) { return (bi + 7) >> 3; }
   static inline uint32_t bytes2bits(uint32_t by) { return by << 3; }
 
+  // Word access helpers. "Chunk" is up to WORD_CHUNK_BITS bits in stream order, aligned to MSB of uint64_t (i.e. as if stream
+  // bytes were read as big-endian word); chunk is shifted by (offset % 8) on access, so chunk must not exceed 56 bits
+  static constexpr uint32_t WORD_CHUNK_BITS = 56;
+
+  bool hasWordAccessRoom(uint32_t end_bit) const { return (end_bit >> 3) + sizeof(uint64_t) <= (bitsAllocated >> 3); }
+
+  static inline uint64_t bswap64(uint64_t v)
+  {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+  }
+  static inline uint64_t load_word(const uint8_t *p)
+  {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  static inline void store_word(uint8_t *p, uint64_t v) { memcpy(p, &v, sizeof(v)); }
+  // variable sized (<= 8 bytes) little-endian load/store; loops instead of memcpy to avoid library calls for small sizes
+  static inline uint64_t load_le(const uint8_t *p, uint32_t bytes)
+  {
+    uint64_t v = 0;
+    for (uint32_t i = 0; i < bytes; ++i)
+      v |= uint64_t(p[i]) << (i * 8);
+    return v;
+  }
+  static inline void store_le(uint8_t *p, uint64_t v, uint32_t bytes)
+  {
+    for (uint32_t i = 0; i < bytes; ++i, v >>= 8)
+      p[i] = uint8_t(v);
+  }
+
+  // little-endian value (whole bytes, then low bits % 8 bits of next byte) -> chunk
+  static inline uint64_t le_to_chunk(uint64_t v, uint32_t bits)
+  {
+    const uint32_t fullBits = bits & ~7u, restBits = bits & 7;
+    uint64_t chunk = fullBits ? bswap64(v & (~uint64_t(0) >> (64 - fullBits))) : 0;
+    if (restBits)
+      chunk |= ((v >> fullBits) & ((1u << restBits) - 1)) << (64 - fullBits - restBits);
+    return chunk;
+  }
+  // chunk -> little-endian value (inverse of le_to_chunk)
+  static inline uint64_t chunk_to_le(uint64_t chunk, uint32_t bits)
+  {
+    const uint32_t fullBits = bits & ~7u, restBits = bits & 7;
+    uint64_t v = fullBits ? bswap64(chunk & (~uint64_t(0) << (64 - fullBits))) : 0;
+    if (restBits)
+      v |= ((chunk >> (64 - fullBits - restBits)) & ((1u << restBits) - 1)) << fullBits;
+    return v;
+  }
+
+  void writeChunk(uint64_t chunk, uint32_t bits)
+  {
+    uint8_t *p = GetData() + (bitsUsed >> 3);
+    const uint32_t shift = bitsUsed & 7;
+    const uint64_t mask = (~uint64_t(0) << (64 - bits)) >> shift;
+    uint64_t w = bswap64(load_word(p));
+    w = (w & ~mask) | (chunk >> shift);
+    store_word(p, bswap64(w));
+    bitsUsed += bits;
+  }
+  uint64_t readChunk(uint32_t bits) const
+  {
+    uint64_t w = bswap64(load_word(GetData() + (readOffset >> 3))) << (readOffset & 7);
+    readOffset += bits;
+    return w & (~uint64_t(0) << (64 - bits));
+  }
+
   uint32_t bitsUsed : 31;
   uint32_t dataOwner : 1;
   uint32_t bitsAllocated;
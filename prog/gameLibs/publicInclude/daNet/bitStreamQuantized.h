@@ -0,0 +1,86 @@
+//
+// Dagor Engine 6.5 - Game Libraries
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <daNet/bitStream.h>
+#include <gameMath/quantization.h>
+
+// Bulk serialization of quantized values: whole array is written with single buffer reservation (and read with single bounds
+// check), each value takes exactly its quantized bits count (no byte alignment in between).
+// Every value is stored as WriteBits(&qval, bits) would store it, so reading one by one with ReadBits() is still possible.
+// Array sizes are not serialized, caller is expected to know them (or write them separately).
+
+namespace danet
+{
+
+// signed floats in [-scale, scale] range, 'bits' (<= 32) per value
+inline void write_quantized_floats(BitStream &bs, dag::ConstSpan<float> vals, uint32_t bits, float scale = 1.f,
+  bool *out_clamped = nullptr)
+{
+  G_ASSERT(bits > 1 && bits <= 32);
+  bs.reserveBits(bits * vals.size());
+  for (float v : vals)
+    bs.WriteBitsValue(gamemath::pack_scalar_signed<uint32_t>(v, bits, scale, out_clamped), bits);
+}
+inline bool read_quantized_floats(const BitStream &bs, dag::Span<float> vals, uint32_t bits, float scale = 1.f)
+{
+  G_ASSERT(bits > 1 && bits <= 32);
+  if (bs.GetNumberOfUnreadBits() < bits * vals.size())
+    return false;
+  for (float &v : vals)
+  {
+    uint64_t q = 0;
+    bs.ReadBitsValue(q, bits);
+    v = gamemath::unpack_scalar_signed<uint32_t>(uint32_t(q), bits, scale);
+  }
+  return true;
+}
+
+// positions quantized with QPos = gamemath::QuantizedPos<...>
+template <typename QPos>
+inline void write_quantized_positions(BitStream &bs, dag::ConstSpan<Point3> pos, bool *out_clamped = nullptr)
+{
+  bs.reserveBits(QPos::TotalPosBits * pos.size());
+  for (const Point3 &p : pos)
+    bs.WriteBitsValue(QPos(p, out_clamped).qpos, QPos::TotalPosBits);
+}
+template <typename QPos>
+inline bool read_quantized_positions(const BitStream &bs, dag::Span<Point3> pos)
+{
+  if (bs.GetNumberOfUnreadBits() < QPos::TotalPosBits * pos.size())
+    return false;
+  for (Point3 &p : pos)
+  {
+    uint64_t q = 0;
+    bs.ReadBitsValue(q, QPos::TotalPosBits);
+    p = QPos(typename QPos::PosType(q)).unpackPos();
+  }
+  return true;
+}
+
+// rotations quantized with QQuat = gamemath::QuantizedQuat<...> ("smallest three")
+template <typename QQuat>
+inline void write_quantized_quats(BitStream &bs, dag::ConstSpan<Quat> quats)
+{
+  bs.reserveBits(QQuat::TotalQuatBits * quats.size());
+  for (const Quat &q : quats)
+    bs.WriteBitsValue(QQuat(q).qquat, QQuat::TotalQuatBits);
+}
+template <typename QQuat>
+inline bool read_quantized_quats(const BitStream &bs, dag::Span<Quat> quats)
+{
+  if (bs.GetNumberOfUnreadBits() < QQuat::TotalQuatBits * quats.size())
+    return false;
+  for (Quat &q : quats)
+  {
+    uint64_t qq = 0;
+    bs.ReadBitsValue(qq, QQuat::TotalQuatBits);
+    q = QQuat(typename QQuat::IntType(qq)).unpackQuat();
+  }
+  return true;
+}
+
+} // namespace danet
@@ -62,6 +62,7 @@ public:
   void clear();
   void sendEcho(const char *route_addr, uint32_t route_id);
   void setHost(_ENetHost *new_host);
+  bool ownsSocket(intptr_t socket) const;
   void process();
   eastl::optional<EchoResponse> receive();
 
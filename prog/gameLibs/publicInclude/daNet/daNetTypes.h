@@ -81,6 +81,12 @@ struct SocketDescriptor
   };
   uint16_t port;
   uint8_t type;
+  // Bind socket with SO_REUSEPORT, so several peer interfaces (each with own socket and network thread) may share one port;
+  // kernel distributes incoming connections between them by address hash, i.e. each peer is served by one shard only.
+  // Startup() fails where SO_REUSEPORT is not supported (e.g. Windows)
+  bool reusePort = false;
+  // Receive/send up to this many datagrams per syscall (recvmmsg/sendmmsg, Linux only; silently ignored elsewhere); 0 - disabled
+  uint16_t ioBatchSize = 0;
 
   SocketDescriptor() : port(0), type(STR) { hostAddress[0] = 0; }
   SocketDescriptor(uint16_t _port, const char *_hostAddress);
@@ -68,6 +68,7 @@ class ElementRef;
 struct ElemStacks
 {
   RenderList *rlist = nullptr;
+  const RenderList *rlistPrev = nullptr; //< if set, entries of clean passive subtrees are copied from its prevList instead of traversal
   InputStack *input = nullptr;
   InputStack *cursors = nullptr;
   InputStack *eventHandlers = nullptr;
@@ -143,6 +144,9 @@ public:
     F_DOES_AFFECT_LAYOUT = 0x1000000,
     F_ZORDER_ON_TOP = 0x2000000,
     F_HAS_CURSOR = 0x4000000,
+    F_LAYOUT_DIRTY = 0x8000000,     //< sizes/positions in subtree need recalc (set on path from root too), cleared on positions recalc
+    F_STACKS_DIRTY = 0x10000000,    //< subtree was changed since last stacks rebuild (set on path from root too)
+    F_STACKS_REUSABLE = 0x20000000, //< subtree has no input entries and z-order overrides, its render entries may be reused
   };
 
 public:
@@ -165,12 +169,14 @@ public:
   void recalcLayout();
   void getSizeRoots(Element *&fixed_size_root, Element *&size_root, Element *&flow_root);
   void recalcScreenPositions();
+  void recalcDirtyScreenPositions();
   void recalcContentSize(int axis);
   void calcSizeConstraints(int axis, float *sz_min, float *sz_max) const;
   void calcFixedSizes();
   void calcConstrainedSizes(int axis);
 
   void putToSortedStacks(ElemStacks &stacks, ElemStackCounters &counters, int parent_z_order, bool parent_disable_input);
+  void invalidateStacks();
   void traceHit(const Point2 &p, InputStack *stack, int parent_z_order, int &hier_order);
 
   float calcParentW(float percent, bool use_min_max) const;
@@ -200,7 +206,13 @@ public:
   void updFlags(int f, bool on);
 
   bool isHidden() const { return hasFlags(F_HIDDEN); }
-  void setHidden(bool on) { updFlags(F_HIDDEN, on); }
+  void setHidden(bool on)
+  {
+    if (on == isHidden())
+      return;
+    updFlags(F_HIDDEN, on);
+    invalidateStacks();
+  }
   bool isDetached() const { return hasFlags(F_DETACHED); }
   bool bboxIsClippedOut() const { return hasFlags(F_SCREEN_BOX_CLIPPED_OUT); }
 
@@ -281,6 +293,9 @@ private:
   void playStateChangeSound(int prev_flags, int cur_flags);
 
   void afterRecalc();
+  void calcScreenPos();
+  void finishScreenPosRecalc();
+  bool reuseRenderEntries(ElemStacks &stacks, ElemStackCounters &counters, int order);
 
   void validateStaticText();
   void clampSizeToLimits(int axis, float &sz_px);
@@ -336,6 +351,11 @@ private:
   int16_t hierDepth = 0;
   int hierNumFadeOutAnims = 0;
 
+  // render entries of subtree emitted on last stacks rebuild
+  int rlistCacheZOrder = 0;
+  int rlistCacheHierFirst = 0;
+  int rlistCacheCount = 0;
+
 #if DARG_USE_DBGCOLOR
   mutable E3DCOLOR dbgColor = 0u;
 #endif
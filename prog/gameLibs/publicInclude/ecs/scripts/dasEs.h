@@ -72,6 +72,7 @@ int set_load_threads_num(int load_threads_num);
 int get_load_threads_num();
 ResolveECS get_resolve_ecs_on_load();
 void set_resolve_ecs_on_load(ResolveECS);
+void set_job_que_on_threadpool(bool enable); // with_job_que jobs run on threadpool workers (when it is inited) or on own threads
 void init_das(AotMode enable_aot, HotReload allow_hot_reload, LogAotErrors log_aot_errors);
 void pull_das();
 void init_scripts(HotReload hot_reload_mode, LoadDebugCode load_debug_code, const char *pak);
@@ -32,6 +32,17 @@ struct EventLogInitParams
   const char *project = nullptr;
   const char *version = nullptr;
   bool use_https = true;
+
+  // Batched delivery of send_http() events: events are collected to batches, each batch is compressed with zstd
+  // and posted (Content-Type: application/x-event-log-batch, Content-Encoding: zstd; body is sequence of
+  // uint32 size + packet) by background thread, that retries failed requests with exponential backoff.
+  // When spool_dir is set, batches are kept there until delivered (so they survive restarts), oldest batches are
+  // dropped when spool exceeds spool_max_bytes
+  bool batch_delivery = false;
+  const char *spool_dir = nullptr;
+  uint32_t batch_max_bytes = 256 << 10; // uncompressed
+  uint32_t batch_max_delay_ms = 5000;
+  uint32_t spool_max_bytes = 16 << 20; // compressed, both for disk and memory queue
 };
 
 // The following 2 functions are not threadsafe
@@ -40,7 +51,10 @@ void shutdown();
 
 bool is_enabled();
 
+// posts asynchronously (or queues to batch when batch_delivery is enabled)
 void send_http(const char *type, const void *data, uint32_t size, Json::Value *meta = NULL);
 void send_http_instant(const char *type, const void *data, uint32_t size, Json::Value *meta = NULL);
 void send_udp(const char *type, const void *data, uint32_t size, Json::Value *meta = NULL);
+// closes current batch so it is sent without waiting for batch_max_delay_ms (no-op without batch_delivery)
+void flush_batched();
 } // namespace event_log
@@ -7,6 +7,7 @@
 
 #include <generic/dag_carray.h>
 #include <generic/dag_tab.h>
+#include <generic/dag_span.h>
 #include <3d/dag_resId.h>
 #include <3d/dag_resPtr.h>
 #include <shaders/dag_postFxRenderer.h>
@@ -292,6 +293,12 @@ int intersect_segment_at_time(FFTWater *, double at_time, const Point3 &start, c
                                                                                                                   // found
 int getHeightAboveWater(FFTWater *, const Point3 &point, float &result, bool matchRenderGrid = false);
 int getHeightAboveWaterAtTime(FFTWater *, double at_time, const Point3 &point, float &result, Point3 *out_displacement = NULL);
+// batched getHeightAboveWaterAtTime: all points are sampled at the same simulation tick, big batches are spread over threadpool.
+// results[i] (and out_displacements[i]) are updated only for points where water was found. Returns number of such points
+int get_heights_above_water_at_time(FFTWater *, double at_time, dag::ConstSpan<Point3> points, float *results,
+  Point3 *out_displacements = NULL);
+// physics ticks which are simulated synchronously are split over threadpool workers (off by default). Results are identical either way
+void set_parallel_physics(FFTWater *handle, bool enable);
 void setRenderParamsToPhysics(FFTWater *handle);
 void setVertexSamplers(FFTWater *, int samplersCount); // samplersCount shows quality of sampling. Obviously, if higher cascades can
                                                        // not provide significant displacement, they should not be used
@@ -230,6 +230,7 @@ template <size_t XBits, size_t YBits, size_t ZBits, class XScale, class YScale,
 struct QuantizedPos
 {
   typedef typename eastl::type_select<((XBits + YBits + ZBits) > 32), uint64_t, uint32_t>::type PosType;
+  static constexpr int TotalPosBits = XBits + YBits + ZBits;
   PosType qpos = 0;
   G_STATIC_ASSERT((XBits + YBits + ZBits) <= sizeof(PosType) * CHAR_BIT);
 
@@ -150,6 +150,8 @@ float traceht_lmesh(const Point2 &pos);
 float traceht_hmap(const Point2 &pos);
 bool traceht_water(const Point3 &pos, float &t);
 float traceht_water_at_time(const Point3 &pos, float time, Point3 *out_displacement = nullptr);
+// batched version of above, out_water_ht[i] is water height at pos[i] (0 if not found)
+void traceht_water_at_time(dag::ConstSpan<Point3> pos, float time, dag::Span<float> out_water_ht, Point3 *out_displacement = nullptr);
 float traceht_water_at_time(const Point3 &pos, float t, float time, bool &underWater, float minWaterCoastDist = 1.5f);
 float traceht_water_at_time_no_ground(const Point3 &pos, float t, float time, bool &underwater);
 bool is_valid_heightmap_pos(const Point2 &pos);
@@ -71,6 +71,14 @@ public:
   bool traceray(const Point3 &p, const Point3 &dir, real &t, Point3 *normal, bool cull = true) const;
   bool rayhitNormalized(const Point3 &p, const Point3 &normDir, real t) const;
   bool rayUnderHeightmapNormalized(const Point3 &p, const Point3 &normDir, real t) const;
+  // same results as traceray/rayhitNormalized, but empty space is skipped using hierarchical height ranges of compressed data
+  bool tracerayHier(const Point3 &p, const Point3 &dir, real &t, Point3 *normal, bool cull = true) const;
+  bool rayhitNormalizedHier(const Point3 &p, const Point3 &normDir, real t) const;
+  // batched tracerayHier, t[i] (and normals[i], if provided) are updated for rays which hit. Returns number of such rays.
+  // NOTE: rays are traced one by one (no packet traversal), these are convenience wrappers for callers with arrays of rays
+  int tracerayMulti(const Point3 *p, const Point3 *dir, real *t, Point3 *normals, int cnt, bool cull = true) const;
+  // batched rayhitNormalizedHier, sets bit (i&31) of out_hit_mask[i/32] for rays which hit. Returns number of such rays
+  int rayhitNormalizedMulti(const Point3 *p, const Point3 *normDir, const real *t, int cnt, uint32_t *out_hit_mask) const;
 
   IBBox2 getExcludeBounding() const { return excludeBounding; }
   BBox3 getWorldBox() const { return worldBox; }
@@ -0,0 +1,18 @@
+//
+// Dagor Engine 6.5 - Game Libraries
+// Copyright (C) 2023  Gaijin Games KFT.  All rights reserved
+// (for conditions of use see prog/license.txt)
+//
+#pragma once
+
+#include <util/dag_stdint.h>
+
+// periodic dumping of sampled heap profile (see <memory/dag_heapSampler.h>), intended to be left on for live servers
+namespace heap_profile_dump
+{
+//! enables heap sampling with given mean interval and starts thread that writes "<path_prefix>.<seq>.heap" every period_sec
+bool start(const char *path_prefix, int period_sec, size_t sample_interval = 512 << 10);
+//! stops dump thread (optionally writing last dump) and disables sampling
+void stop(bool final_dump = true);
+bool is_started();
+} // namespace heap_profile_dump
@@ -274,7 +274,12 @@ obstacle_handle_t tilecache_obstacle_add(const Point3 &c, const Point3 &ext, flo
 void rebuildNavMesh_init();
 void rebuildNavMesh_setup(const char *name, float value);
 void rebuildNavMesh_addBBox(const BBox3 &);
+// interactive update builds tiles on threadpool (up to "asyncMaxJobs" at once) and adds finished ones to navmesh,
+// otherwise all remaining tiles are built synchronously
 bool rebuildNavMesh_update(bool interactive);
+// tiles closest to these positions (i.e. of agents) are rebuilt first
+void rebuildNavMesh_clearPriorityPos();
+void rebuildNavMesh_addPriorityPos(const Point3 &pos);
 int rebuildNavMesh_getProgress();
 int rebuildNavMesh_getTotalTiles();
 bool rebuildNavMesh_saveToFile(const char *);
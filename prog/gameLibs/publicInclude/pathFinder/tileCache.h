@@ -28,6 +28,9 @@ struct TileCacheCompressor : public dtTileCacheCompressor
   ~TileCacheCompressor();
 
   void reset(bool isZSTD, const Tab<char> &zstdDictBuff = Tab<char>());
+  // same compression as src, but with own decompression context, so it can be used on another thread concurrently with src;
+  // dictionary is shared, src must not be reset while this one is used
+  void resetShared(const TileCacheCompressor &src);
 
   int maxCompressedSize(const int bufferSize) override;
 
@@ -40,6 +43,7 @@ struct TileCacheCompressor : public dtTileCacheCompressor
 private:
   ZSTD_DCtx_s *dctx = nullptr;
   ZSTD_DDict_s *dDict = nullptr;
+  bool ownDDict = true;
 };
 
 struct TileCacheMeshProcess : public dtTileCacheMeshProcess
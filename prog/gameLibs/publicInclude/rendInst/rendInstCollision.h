@@ -159,6 +159,9 @@ bool traceDownMultiRay(dag::Span<Trace> traces, bbox3f_cref rayBox, dag::Span<Re
   const TraceMeshFaces *ri_cache = nullptr, int ray_mat_id = -1, TraceFlags trace_flags = TraceFlag::Destructible,
   Bitarray *filter_pools = nullptr); // all rays should be down
 
+// debug check of multi-ray traces with ray bundles against per-ray traversal around center, returns count of mismatched rays
+int verify_trace_ray_bundles(const Point3 &center, float radius, int rays_cnt);
+
 
 bool rayhitRendInstNormalized(const Point3 &from, const Point3 &dir, float t, int ray_mat_id, const RendInstDesc &ri_desc);
 bool rayhitRendInstsNormalized(const Point3 &from, const Point3 &dir, float t, float min_size, int ray_mat_id,
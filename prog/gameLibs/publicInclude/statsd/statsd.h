@@ -86,6 +86,22 @@ bool connect(const char *addr, int port);
 
 void enable(bool is_enabled);
 
+// Aggregating mode: instead of sending one packet per call, metrics are accumulated per thread (counters are summed, gauges keep
+// last value and sum of increments, timings and histograms are collected to samples or sketches) and sent on flush as
+// multi-metric packets (one metric per line).
+struct AggregationParams
+{
+  int flushPeriodMs = 1000; // flush is made by first metric call after period is elapsed (and by flush())
+  int maxPacketSize = 1432; // UDP payload, should fit in MTU
+  // if true timings and histograms are sent as log-scale buckets: bucket center value repeated count times (several values
+  // per line), so statsd server gets the same counts and percentiles with given relative accuracy, otherwise all samples are sent
+  bool timingSketch = true;
+  float sketchRelativeAccuracy = 0.01f;
+};
+void enable_aggregation(const AggregationParams &params = {});
+void disable_aggregation(); // sends accumulated metrics
+void flush();               // sends accumulated metrics (if aggregation is enabled)
+
 void shutdown();
 
 // inline int64_t get_timestamp_us() { return ref_time_delta_to_usec(ref_time_ticks()-0); }
@@ -14,6 +14,10 @@
 #include <memory/dag_framemem.h>
 #include <gameMath/traceUtils.h>
 #include <util/dag_bitArray.h>
+#include <math/dag_intrin.h>
+#include <EASTL/sort.h>
+#include <util/dag_console.h>
+#include <perfMon/dag_cpuFreq.h>
 
 #define LOGLEVEL_DEBUG _MAKE4C('RGEN')
 
@@ -76,28 +80,31 @@ struct TraceRayStrat : public MaterialRayStrat
 
   bool isCheckBBoxAll() { return false; }
 
+  void onMeshHit(rendinst::RendInstDesc *ri_desc, int layer_idx, int idx, int pool, int offs, int &out_mat_id, int cell_idx) const
+  {
+    if (ri_desc)
+    {
+      ri_desc->layer = layer_idx;
+      ri_desc->idx = idx;
+      ri_desc->pool = pool;
+      ri_desc->offs = offs;
+    }
+    if (out_mat_id == PHYSMAT_INVALID || out_mat_id == PHYSMAT_DEFAULT)
+    {
+      int poolRef = cell_idx == -1 ? rendinst::riExtra[pool].riPoolRef : pool;
+      RendInstGenData *rgl = rendinst::getRgLayer(cell_idx == -1 ? rendinst::riExtra[pool].riPoolRefLayer : layer_idx);
+      if (poolRef >= 0 && rgl)
+        out_mat_id = rgl->rtData->riProperties[poolRef].matId;
+    }
+  }
+
   bool executeForMesh(CollisionResource *coll_res, mat44f_cref tm, const Point3 &pos, const Point3 &dir, float &out_t,
     Point3 &out_norm, rendinst::RendInstDesc *ri_desc, bool &have_collision, int layer_idx, int idx, int pool, int offs,
     int &out_mat_id, int cell_idx)
   {
     bool meshCollision = coll_res->traceRay(tm, pos, dir, out_t, &out_norm, out_mat_id, rayMatId, behaviorFlag);
     if (meshCollision)
-    {
-      if (ri_desc)
-      {
-        ri_desc->layer = layer_idx;
-        ri_desc->idx = idx;
-        ri_desc->pool = pool;
-        ri_desc->offs = offs;
-      }
-      if (out_mat_id == PHYSMAT_INVALID || out_mat_id == PHYSMAT_DEFAULT)
-      {
-        int poolRef = cell_idx == -1 ? rendinst::riExtra[pool].riPoolRef : pool;
-        RendInstGenData *rgl = rendinst::getRgLayer(cell_idx == -1 ? rendinst::riExtra[pool].riPoolRefLayer : layer_idx);
-        if (poolRef >= 0 && rgl)
-          out_mat_id = rgl->rtData->riProperties[poolRef].matId;
-      }
-    }
+      onMeshHit(ri_desc, layer_idx, idx, pool, offs, out_mat_id, cell_idx);
     have_collision |= meshCollision;
     return false;
   }
@@ -110,22 +117,7 @@ struct TraceRayStrat : public MaterialRayStrat
       return false;
     bool meshCollision = coll_res->traceRay(tm, pos, dir, out_t, &out_norm, out_mat_id, rayMatId, behaviorFlag);
     if (meshCollision)
-    {
-      if (ri_desc)
-      {
-        ri_desc->layer = layer_idx;
-        ri_desc->idx = idx;
-        ri_desc->pool = pool;
-        ri_desc->offs = offs;
-      }
-      if (out_mat_id == PHYSMAT_INVALID || out_mat_id == PHYSMAT_DEFAULT)
-      {
-        int poolRef = cell_idx == -1 ? rendinst::riExtra[pool].riPoolRef : pool;
-        RendInstGenData *rgl = rendinst::getRgLayer(cell_idx == -1 ? rendinst::riExtra[pool].riPoolRefLayer : layer_idx);
-        if (poolRef >= 0 && rgl)
-          out_mat_id = rgl->rtData->riProperties[poolRef].matId;
-      }
-    }
+      onMeshHit(ri_desc, layer_idx, idx, pool, offs, out_mat_id, cell_idx);
     have_collision |= meshCollision;
     return false;
   }
@@ -1069,89 +1061,153 @@ static bool rayTestIndividualNoLock(dag::Span<Trace> traces, const rendinst::Ren
   return haveCollision;
 }
 
-bool traceRayRIGenNormalized(dag::Span<Trace> traces, TraceFlags trace_flags, int ray_mat_id, rendinst::RendInstDesc *out_ri_descs,
-  const TraceMeshFaces *ri_cache, rendinst::riex_handle_t skip_riex_handle)
+DECL_ALIGN16(static float, v_SUBCELL_DIV_MAX[4]) = {
+  SUBCELL_DIV - 0.01f, SUBCELL_DIV - 0.01f, SUBCELL_DIV - 0.01f, SUBCELL_DIV - 0.01f};
+
+// Coherent ray batching for multi-ray traces: rays are sorted by riGen cell of their start and split to bundles of up to 64 rays.
+// Candidate instances are gathered once per bundle, each candidate box is tested against 4 rays at once, and only rays that
+// reach the box are traced against collision with CollisionResource::traceMultiRay()
+struct RayBundle
 {
-  TraceRayStrat traceRayStrategy(ray_mat_id, trace_flags);
-  bool ret = false;
-  if (ri_cache)
-  {
-    AutoLockReadPrimaryAndExtra lockRead;
+  static constexpr int MAX_RAYS = 64;
 
-    if (check_cached_ri_data(ri_cache))
-    {
-      bbox3f rayBox;
-      trace_utils::prepare_traces_box(traces, rayBox);
-      ri_cache->rendinstCache.foreachValid(rendinst::GatherRiTypeFlag::RiGenTmAndExtra,
-        [&](const rendinst::RendInstDesc &ri_desc, bool) {
-          if (rendinst::isRgLayerPrimary(ri_desc.layer))
-            ret |= rayTestIndividualNoLock(traces, ri_desc, {}, traceRayStrategy, rayBox, skip_riex_handle);
-        });
+  alignas(16) float ox[MAX_RAYS], oy[MAX_RAYS], oz[MAX_RAYS];
+  alignas(16) float invDx[MAX_RAYS], invDy[MAX_RAYS], invDz[MAX_RAYS];
+  alignas(16) float maxT[MAX_RAYS]; //< current outT of rays, so boxes behind closest hit are culled
+  int traceIdx[MAX_RAYS];
+  int cnt = 0;
+  bbox3f box;
+  eastl::fixed_vector<CollisionTrace, 16, true, framemem_allocator> collTraces;
 
-      return ret;
+  static float safeInv(float d) { return fabsf(d) > 1e-12f ? 1.f / d : (d < 0.f ? -1e12f : 1e12f); }
+
+  void init(dag::Span<Trace> traces, const int *trace_ids, int count)
+  {
+    G_ASSERT(count > 0 && count <= MAX_RAYS);
+    cnt = count;
+    for (int i = 0; i < cnt; i++)
+    {
+      const Trace &trace = traces[trace_ids[i]];
+      verify_trace(trace);
+      traceIdx[i] = trace_ids[i];
+      ox[i] = trace.pos.x, oy[i] = trace.pos.y, oz[i] = trace.pos.z;
+      invDx[i] = safeInv(trace.dir.x), invDy[i] = safeInv(trace.dir.y), invDz[i] = safeInv(trace.dir.z);
+      maxT[i] = trace.pos.outT;
+
+      vec4f vFrom = v_ld(&trace.pos.x);
+      vec4f vTo = v_madd(v_ld(&trace.dir.x), v_max(v_splat_w(vFrom), v_zero()), vFrom);
+      if (i == 0)
+        v_bbox3_init(box, vFrom);
+      else
+        v_bbox3_add_pt(box, vFrom);
+      v_bbox3_add_pt(box, vTo);
     }
-    trace_utils::draw_trace_handle_debug_cast_result(ri_cache, traces, false, true);
+    for (int i = cnt, e = (cnt + 3) & ~3; i < e; i++) // unused lanes never hit
+    {
+      ox[i] = oy[i] = oz[i] = 0.f;
+      invDx[i] = invDy[i] = invDz[i] = 1.f;
+      maxT[i] = -1.f;
+    }
+    collTraces.resize(cnt);
   }
-  return rayTraverse(traces, bool(trace_flags & TraceFlag::Meshes), out_ri_descs, traceRayStrategy, skip_riex_handle);
-}
 
+  uint64_t allRays() const { return cnt == MAX_RAYS ? ~0ull : (1ull << cnt) - 1; }
 
-DECL_ALIGN16(static float, v_SUBCELL_DIV_MAX[4]) = {
-  SUBCELL_DIV - 0.01f, SUBCELL_DIV - 0.01f, SUBCELL_DIV - 0.01f, SUBCELL_DIV - 0.01f};
+  // returns subset of ray_mask with rays that intersect box within their current length
+  VECTORCALL uint64_t testBox(bbox3f_cref b, uint64_t ray_mask) const
+  {
+    vec4f bminX = v_splat_x(b.bmin), bminY = v_splat_y(b.bmin), bminZ = v_splat_z(b.bmin);
+    vec4f bmaxX = v_splat_x(b.bmax), bmaxY = v_splat_y(b.bmax), bmaxZ = v_splat_z(b.bmax);
+    uint64_t res = 0;
+    for (int g = 0; g < cnt; g += 4)
+    {
+      if (!((ray_mask >> g) & 0xF))
+        continue;
+      vec4f rox = v_ld(ox + g), roy = v_ld(oy + g), roz = v_ld(oz + g);
+      vec4f rix = v_ld(invDx + g), riy = v_ld(invDy + g), riz = v_ld(invDz + g);
+      vec4f t0x = v_mul(v_sub(bminX, rox), rix), t1x = v_mul(v_sub(bmaxX, rox), rix);
+      vec4f t0y = v_mul(v_sub(bminY, roy), riy), t1y = v_mul(v_sub(bmaxY, roy), riy);
+      vec4f t0z = v_mul(v_sub(bminZ, roz), riz), t1z = v_mul(v_sub(bmaxZ, roz), riz);
+      vec4f tNear = v_max(v_max(v_min(t0x, t1x), v_min(t0y, t1y)), v_max(v_min(t0z, t1z), v_zero()));
+      vec4f tFar = v_min(v_min(v_max(t0x, t1x), v_max(t0y, t1y)), v_min(v_max(t0z, t1z), v_ld(maxT + g)));
+      res |= uint64_t(v_signmask(v_cmp_ge(tFar, tNear))) << g;
+    }
+    return res & ray_mask;
+  }
+};
 
-static bool traceDownMultiRayCell(int layer_idx, int cell_idx, dag::Span<Trace> traces, dag::Span<rendinst::RendInstDesc> ri_desc,
-  bbox3f_cref ray_box, int ray_mat_id, uint8_t behaviorFlags, Bitarray *filter_pools)
+// Traces rays of ray_mask against coll_res; for each ray with closer hit updates pos.outT/outNorm/outMatId of its trace and calls
+// on_hit(trace, trace_idx)
+template <typename OnHit>
+static bool trace_ray_bundle(const CollisionResource *coll_res, mat44f_cref tm, uint64_t ray_mask, RayBundle &bundle,
+  dag::Span<Trace> traces, int ray_mat_id, uint8_t behavior_flags, OnHit on_hit)
 {
-  const RendInstGenData *rgl = rendinst::rgLayer[layer_idx];
-  const RendInstGenData::Cell &cell = rgl->cells[cell_idx];
-  const RendInstGenData::CellRtData *crt_ptr = cell.isReady();
-  if (!crt_ptr)
+  int lanes[RayBundle::MAX_RAYS];
+  int n = 0;
+  for (uint64_t m = ray_mask; m; m &= m - 1)
+  {
+    int lane = __ctz_unsafe(m);
+    const Trace &trace = traces[bundle.traceIdx[lane]];
+    CollisionTrace &ct = bundle.collTraces[n];
+    ct.vFrom = v_ld(&trace.pos.x);
+    ct.vDir = v_ld(&trace.dir.x);
+    ct.t = trace.pos.outT;
+    ct.outMatId = PHYSMAT_INVALID;
+    lanes[n++] = lane;
+  }
+  dag::Span<CollisionTrace> collTraces(bundle.collTraces.data(), n);
+  if (!coll_res->traceMultiRay(tm, collTraces, ray_mat_id, behavior_flags))
     return false;
-  const RendInstGenData::CellRtData &crt = *crt_ptr;
 
-  if (!v_bbox3_test_box_intersect(crt.bbox[0], ray_box))
-    return false;
+  bool haveCollision = false;
+  for (int i = 0; i < n; i++)
+  {
+    const CollisionTrace &ct = collTraces[i];
+    if (!ct.isHit)
+      continue;
+    int lane = lanes[i];
+    Trace &trace = traces[bundle.traceIdx[lane]];
+    trace.pos.outT = ct.t;
+    trace.outNorm = ct.norm;
+    trace.outMatId = ct.outMatId;
+    bundle.maxT[lane] = ct.t;
+    on_hit(trace, bundle.traceIdx[lane]);
+    haveCollision = true;
+  }
+  return haveCollision;
+}
 
-  float cellSz = rgl->grid2world * rgl->cellSz;
-  vec4f v_invSubcellSz = v_splats(SUBCELL_DIV / cellSz);
+// Calls inst_cb(coll_res, tm, ray_mask, subcell_idx, pool, offs) for every not destroyed instance of riGen cell, which collision box
+// is reached by some rays of bundle (ray_mask); pools are skipped when skip_pool(pool, is_pos_inst) returns true
+template <typename SkipPool, typename InstCB>
+static void traverse_ray_bundle_cell(int layer_idx, const RendInstGenData::CellRtData &crt, const RayBundle &bundle,
+  SkipPool skip_pool, InstCB inst_cb)
+{
+  uint64_t cellRays = bundle.testBox(crt.bbox[0], bundle.allRays());
+  if (!cellRays)
+    return;
 
+  const RendInstGenData *rgl = rendinst::rgLayer[layer_idx];
+  float cellSz = rgl->grid2world * rgl->cellSz;
   int pcnt = crt.pools.size();
   vec3f v_cell_add = crt.cellOrigin;
   vec3f v_cell_mul = v_mul(rendinst::gen::VC_1div32767, v_make_vec4f(cellSz, crt.cellHeight, cellSz, 0));
 
-  bool haveCollision = false;
-  // crt.bbox[0] and rayBox intersects, so we can merge them (isectBox2d = rayBox2d & cellBox2d)
-  vec4f rayBox2d = v_perm_xzac(ray_box.bmin, ray_box.bmax);
+  vec4f rayBox2d = v_perm_xzac(bundle.box.bmin, bundle.box.bmax);
   vec4f cellBox2d = v_perm_xzac(crt.bbox[0].bmin, crt.bbox[0].bmax);
   vec4f isectBox2d = v_perm_xycd(v_max(rayBox2d, cellBox2d), v_min(rayBox2d, cellBox2d));
-
-  isectBox2d = v_sub(isectBox2d, v_perm_xzxz(v_cell_add));
-  isectBox2d = v_mul(isectBox2d, v_invSubcellSz);
-  isectBox2d = v_max(isectBox2d, v_zero());
-  isectBox2d = v_min(isectBox2d, v_ld(v_SUBCELL_DIV_MAX));
-  vec4i vSubCell = v_cvt_vec4i(isectBox2d); // it is the same as floor, since it is always positive!
-  DECL_ALIGN16(int, subCell[4]);            // xzXZ
-  v_sti(subCell, vSubCell);
-
-  // Possible small optimization: check that each ray intersect isectBox2d
-  eastl::fixed_vector<CollisionTrace, 20, true, framemem_allocator> collisionTraces(traces.size());
-  for (int rayId = 0; rayId < traces.size(); rayId++)
-  {
-    collisionTraces[rayId].vFrom = v_ldu(&traces[rayId].pos.x);
-    collisionTraces[rayId].vDir = v_ldu(&traces[rayId].dir.x);
-    collisionTraces[rayId].norm = Point3(0, 1, 0);
-    collisionTraces[rayId].t = traces[rayId].pos.outT;
-    collisionTraces[rayId].outMatId = PHYSMAT_INVALID;
-  }
-  dag::Span<CollisionTrace> tracesSlice(collisionTraces.data(), collisionTraces.size());
+  isectBox2d = v_mul(v_sub(isectBox2d, v_perm_xzxz(v_cell_add)), v_splats(SUBCELL_DIV / cellSz));
+  isectBox2d = v_min(v_max(isectBox2d, v_zero()), v_ld(v_SUBCELL_DIV_MAX));
+  DECL_ALIGN16(int, subCell[4]); // xzXZ
+  v_sti(subCell, v_cvt_vec4i(isectBox2d));
 
   const eastl::BitvectorWordType *riPosInstData = rgl->rtData->riPosInst.data();
-  for (int stride_subCell = SUBCELL_DIV - (subCell[2] - subCell[0] + 1), idx = subCell[1] * SUBCELL_DIV + subCell[0];
-       subCell[1] <= subCell[3]; subCell[1]++, idx += stride_subCell)
-  {
-    for (int x2 = subCell[0]; x2 <= subCell[2]; x2++, idx++)
+  const eastl::BitvectorWordType *riPaletteRotationData = rgl->rtData->riPaletteRotation.data();
+  for (int z = subCell[1]; z <= subCell[3]; z++)
+    for (int x = subCell[0], idx = z * SUBCELL_DIV + x; x <= subCell[2]; x++, idx++)
     {
-      if (!v_bbox3_test_box_intersect(crt.bbox[idx + 1], ray_box))
+      uint64_t subcellRays = bundle.testBox(crt.bbox[idx + 1], cellRays);
+      if (!subcellRays)
         continue;
       eastl::BitvectorWordType riPosInstBit = 1;
       for (int p = 0; EASTL_LIKELY(p < pcnt); p++, riPosInstBit = roll_bit(riPosInstBit))
@@ -1159,56 +1215,242 @@ static bool traceDownMultiRayCell(int layer_idx, int cell_idx, dag::Span<Trace>
         const RendInstGenData::CellRtData::SubCellSlice &scs = crt.getCellSlice(p, idx);
         if (EASTL_LIKELY(!scs.sz))
           continue;
-        bool isPosInst = (riPosInstData[p / (sizeof(riPosInstBit) * CHAR_BIT)] & riPosInstBit) != 0;
-        if (EASTL_LIKELY(isPosInst))
-          continue;
-
         CollisionResource *collRes = rgl->rtData->riCollRes[p].collRes;
-        if (!collRes)
+        if (EASTL_UNLIKELY(!collRes))
           continue;
-
-        if (filter_pools && filter_pools->get(p))
+        bool isPosInst = (riPosInstData[p / (sizeof(riPosInstBit) * CHAR_BIT)] & riPosInstBit) != 0;
+        if (skip_pool(p, isPosInst))
           continue;
 
-        int16_t *data_s = (int16_t *)(crt.sysMemData + scs.ofs);
-        int stride_w = RIGEN_TM_STRIDE_B(rgl->perInstDataDwords) / 2;
-        for (int16_t *data = data_s, *data_e = data + scs.sz / 2; data < data_e; data += stride_w)
+        const int16_t *data_s = (int16_t *)(crt.sysMemData + scs.ofs);
+        if (!isPosInst)
         {
-          if (is_tm_rendinst_data_destroyed(data))
-            continue;
+          int stride_w = RIGEN_TM_STRIDE_B(rgl->perInstDataDwords) / 2;
+          for (const int16_t *__restrict data = data_s, *data_e = data + scs.sz / 2; data < data_e; data += stride_w)
+          {
+            if (is_tm_rendinst_data_destroyed(data))
+              continue;
 #if RIGEN_PERINST_ADD_DATA_FOR_TOOLS
-          if (is_rendinst_marked_collision_ignored(data, rgl->perInstDataDwords, RIGEN_TM_STRIDE_B(false) / 2))
-            continue;
+            if (is_rendinst_marked_collision_ignored(data, rgl->perInstDataDwords, RIGEN_TM_STRIDE_B(false) / 2))
+              continue;
 #endif
-          mat44f tm;
-          rendinst::gen::unpack_tm_full(tm, data, v_cell_add, v_cell_mul);
+            mat44f tm;
+            rendinst::gen::unpack_tm_full(tm, data, v_cell_add, v_cell_mul);
+            bbox3f transformedBox;
+            v_bbox3_init(transformedBox, tm, collRes->vFullBBox);
+            if (uint64_t rays = bundle.testBox(transformedBox, subcellRays))
+              inst_cb(collRes, tm, rays, idx, p, int(intptr_t(data) - intptr_t(data_s)));
+          }
+          continue;
+        }
+
+        bool paletteRotation = (riPaletteRotationData[p / (sizeof(riPosInstBit) * CHAR_BIT)] & riPosInstBit) != 0;
+        rendinst::gen::RotationPaletteManager::Palette palette;
+        if (paletteRotation)
+          palette = rendinst::gen::get_rotation_palette_manager()->getPalette({layer_idx, p});
+        vec4f posBoundingRad = v_add_x(v_length3_x(collRes->vBoundingSphere), v_set_x(collRes->getBoundingSphereRad()));
+        int stride_w = RIGEN_POS_STRIDE_B(rgl->perInstDataDwords) / 2;
+        for (const int16_t *__restrict data = data_s, *data_e = data + scs.sz / 2; data < data_e; data += stride_w)
+        {
+          if (is_pos_rendinst_data_destroyed(data))
+            continue;
+          vec3f v_pos, v_scale;
+          vec4i paletteId;
+          rendinst::gen::unpack_tm_pos(v_pos, v_scale, data, v_cell_add, v_cell_mul, paletteRotation, &paletteId);
 
-          haveCollision |= collRes->traceMultiRay(tm, tracesSlice, ray_mat_id, behaviorFlags);
-          for (int rayId = 0; rayId < traces.size(); rayId++)
+          mat44f tm;
+          bbox3f transformedBox;
+          if (paletteRotation)
           {
-            if (collisionTraces[rayId].isHit)
-            {
-              ri_desc[rayId].cellIdx = cell_idx;
-              ri_desc[rayId].idx = idx;
-              ri_desc[rayId].pool = p;
-              ri_desc[rayId].offs = int(intptr_t(data) - intptr_t(data_s));
-              ri_desc[rayId].layer = layer_idx;
-
-              traces[rayId].pos.outT = collisionTraces[rayId].t;
-              traces[rayId].outNorm = collisionTraces[rayId].norm;
-              if (collisionTraces[rayId].outMatId == PHYSMAT_INVALID || collisionTraces[rayId].outMatId == PHYSMAT_DEFAULT)
-                traces[rayId].outMatId = getRIGenMaterialId(ri_desc[rayId]);
-              else
-                traces[rayId].outMatId = collisionTraces[rayId].outMatId;
-            }
+            // box of bounding sphere is cheap and filters most of instances before rotation is composed
+            vec4f rad = v_splat_x(v_mul_x(posBoundingRad, v_hmax3(v_scale)));
+            bbox3f sphBox;
+            sphBox.bmin = v_sub(v_pos, rad);
+            sphBox.bmax = v_add(v_pos, rad);
+            if (!bundle.testBox(sphBox, subcellRays))
+              continue;
+            quat4f v_rot = rendinst::gen::RotationPaletteManager::get_quat(palette, v_extract_xi(paletteId));
+            v_mat44_compose(tm, v_pos, v_rot, v_scale);
+            v_bbox3_init(transformedBox, tm, collRes->vFullBBox);
           }
+          else
+          {
+            transformedBox.bmin = v_add(v_pos, v_mul(v_scale, collRes->vFullBBox.bmin));
+            transformedBox.bmax = v_add(v_pos, v_mul(v_scale, collRes->vFullBBox.bmax));
+            v_mat44_compose(tm, v_pos, V_C_UNIT_0001, v_scale);
+          }
+          if (uint64_t rays = bundle.testBox(transformedBox, subcellRays))
+            inst_cb(collRes, tm, rays, idx, p, int(intptr_t(data) - intptr_t(data_s)));
         }
       }
     }
+}
+
+// Calls traverse_ray_bundle_cell() for loaded cells of riGen layer intersected by bundle box, inst_cb gets cell index as first arg
+template <typename SkipPool, typename InstCB>
+static void traverse_ray_bundle_layer(int layer_idx, const RayBundle &bundle, SkipPool skip_pool, InstCB inst_cb)
+{
+  const RendInstGenData *rgl = rendinst::rgLayer[layer_idx];
+  vec4f worldBboxXZ = v_perm_xzac(bundle.box.bmin, bundle.box.bmax);
+  vec4f regionV = v_sub(worldBboxXZ, rgl->world0Vxz);
+  regionV = v_max(v_mul(regionV, rgl->invGridCellSzV), v_zero());
+  regionV = v_min(regionV, rgl->lastCellXZXZ);
+  DECL_ALIGN16(int, regions[4]);
+  v_sti(regions, v_cvt_floori(regionV));
+
+  ScopedLockRead lock(rgl->rtData->riRwCs);
+  rgl->rtData->loadedCellsBBox.clip(regions[0], regions[1], regions[2], regions[3]);
+
+  auto traverseCell = [&](int cell_idx) {
+    const RendInstGenData::CellRtData *crt = rgl->cells[cell_idx].isReady();
+    if (!crt || !v_bbox3_test_box_intersect(crt->bbox[0], bundle.box))
+      return;
+    traverse_ray_bundle_cell(layer_idx, *crt, bundle, skip_pool,
+      [&](CollisionResource *coll_res, mat44f_cref tm, uint64_t ray_mask, int subcell_idx, int pool, int offs) {
+        inst_cb(cell_idx, coll_res, tm, ray_mask, subcell_idx, pool, offs);
+      });
+  };
+
+  dag::ConstSpan<int> ld = rgl->rtData->loaded.getList();
+  if ((regions[2] - regions[0] + 1) * (regions[3] - regions[1] + 1) < ld.size())
+  {
+    int cellXStride = rgl->cellNumW - (regions[2] - regions[0] + 1);
+    for (int z = regions[1], cellI = regions[1] * rgl->cellNumW + regions[0]; z <= regions[3]; z++, cellI += cellXStride)
+      for (int x = regions[0]; x <= regions[2]; x++, cellI++)
+        traverseCell(cellI);
   }
+  else
+    for (auto ldi : ld)
+      traverseCell(ldi);
+}
+
+// Sorts traces by cell of first primary riGen layer (where their start is) and calls cb(bundle) for each bundle of sorted traces
+template <typename CB>
+static void foreach_ray_bundle(dag::Span<Trace> traces, CB cb)
+{
+  RayBundle bundle;
+  const RendInstGenData *rgl = nullptr;
+  for (int l = 0; l < rendinst::rgPrimaryLayers && !rgl; l++)
+    rgl = rendinst::rgLayer[l];
+
+  eastl::fixed_vector<uint64_t, RayBundle::MAX_RAYS, true, framemem_allocator> keys(traces.size());
+  for (int i = 0; i < traces.size(); i++)
+  {
+    uint32_t cellI = 0;
+    if (rgl)
+    {
+      vec4f regionV = v_sub(v_perm_xzxz(v_ldu(&traces[i].pos.x)), rgl->world0Vxz);
+      regionV = v_min(v_max(v_mul(regionV, rgl->invGridCellSzV), v_zero()), rgl->lastCellXZXZ);
+      DECL_ALIGN16(int, cellXZ[4]);
+      v_sti(cellXZ, v_cvt_floori(regionV));
+      cellI = cellXZ[1] * rgl->cellNumW + cellXZ[0];
+    }
+    keys[i] = (uint64_t(cellI) << 32) | uint32_t(i);
+  }
+  if (rgl)
+    eastl::sort(keys.begin(), keys.end());
+
+  int ids[RayBundle::MAX_RAYS];
+  for (int i = 0; i < traces.size(); i += RayBundle::MAX_RAYS)
+  {
+    int cnt = min<int>(traces.size() - i, RayBundle::MAX_RAYS);
+    for (int j = 0; j < cnt; j++)
+      ids[j] = int(uint32_t(keys[i + j]));
+    bundle.init(traces, ids, cnt);
+    cb(bundle);
+  }
+}
+
+static bool trace_ray_bundles(dag::Span<Trace> traces, rendinst::RendInstDesc *ri_desc, TraceRayStrat &strategy,
+  riex_handle_t skip_riex_handle)
+{
+  bool haveCollision = false;
+  foreach_ray_bundle(traces, [&](RayBundle &bundle) {
+    BBox3 rayBox;
+    v_stu_bbox3(rayBox, bundle.box);
+    riex_collidable_t ri_h;
+    rendinst::gatherRIGenExtraCollidable(ri_h, rayBox, true /*read_lock*/);
+    for (riex_handle_t h : ri_h)
+    {
+      if (EASTL_UNLIKELY(h == skip_riex_handle))
+        continue;
+      uint32_t pool = rendinst::handle_to_ri_type(h);
+      CollisionResource *collRes = rendinst::riExtra[pool].collRes;
+      if (!collRes)
+        continue;
+      int poolRef = rendinst::riExtra[pool].riPoolRef;
+      int layer = rendinst::riExtra[pool].riPoolRefLayer;
+      if (RendInstGenData *rgl = (poolRef >= 0) ? rendinst::getRgLayer(layer) : nullptr)
+      {
+        const RendInstGenData::RendinstProperties &riProp = rgl->rtData->riProperties[poolRef];
+        if (strategy.shouldIgnoreRendinst(/*isPos*/ false, riProp.immortal, riProp.matId))
+          continue;
+      }
+
+      mat44f tm;
+      rendinst::getRIGenExtra44(h, tm);
+      bbox3f transformedBox;
+      v_bbox3_init(transformedBox, tm, collRes->vFullBBox);
+      if (uint64_t rays = bundle.testBox(transformedBox, bundle.allRays()))
+        haveCollision |= trace_ray_bundle(collRes, tm, rays, bundle, traces, strategy.rayMatId, strategy.behaviorFlag,
+          [&](Trace &trace, int) {
+            strategy.onMeshHit(ri_desc, layer, rendinst::handle_to_ri_inst(h), pool, 0, trace.outMatId, -1);
+            if (ri_desc)
+              ri_desc->setRiExtra();
+          });
+    }
+
+    FOR_EACH_PRIMARY_RG_LAYER_DO (rgl)
+    {
+      const int layerIdx = _layer;
+      traverse_ray_bundle_layer(
+        layerIdx, bundle,
+        [&](int pool, bool is_pos) {
+          const RendInstGenData::RendinstProperties &riProp = rgl->rtData->riProperties[pool];
+          return strategy.shouldIgnoreRendinst(is_pos, riProp.immortal, riProp.matId);
+        },
+        [&](int cell_idx, CollisionResource *coll_res, mat44f_cref tm, uint64_t rays, int subcell_idx, int pool, int offs) {
+          haveCollision |=
+            trace_ray_bundle(coll_res, tm, rays, bundle, traces, strategy.rayMatId, strategy.behaviorFlag, [&](Trace &trace, int) {
+              strategy.onMeshHit(ri_desc, layerIdx, subcell_idx, pool, offs, trace.outMatId, cell_idx);
+              if (ri_desc)
+                ri_desc->cellIdx = cell_idx;
+            });
+        });
+    }
+  });
   return haveCollision;
 }
 
+bool traceRayRIGenNormalized(dag::Span<Trace> traces, TraceFlags trace_flags, int ray_mat_id, rendinst::RendInstDesc *out_ri_descs,
+  const TraceMeshFaces *ri_cache, rendinst::riex_handle_t skip_riex_handle)
+{
+  TraceRayStrat traceRayStrategy(ray_mat_id, trace_flags);
+  bool ret = false;
+  if (ri_cache)
+  {
+    AutoLockReadPrimaryAndExtra lockRead;
+
+    if (check_cached_ri_data(ri_cache))
+    {
+      bbox3f rayBox;
+      trace_utils::prepare_traces_box(traces, rayBox);
+      ri_cache->rendinstCache.foreachValid(rendinst::GatherRiTypeFlag::RiGenTmAndExtra,
+        [&](const rendinst::RendInstDesc &ri_desc, bool) {
+          if (rendinst::isRgLayerPrimary(ri_desc.layer))
+            ret |= rayTestIndividualNoLock(traces, ri_desc, {}, traceRayStrategy, rayBox, skip_riex_handle);
+        });
+
+      return ret;
+    }
+    trace_utils::draw_trace_handle_debug_cast_result(ri_cache, traces, false, true);
+  }
+  if (traces.size() > 1)
+    return trace_ray_bundles(traces, out_ri_descs, traceRayStrategy, skip_riex_handle);
+  return rayTraverse(traces, bool(trace_flags & TraceFlag::Meshes), out_ri_descs, traceRayStrategy, skip_riex_handle);
+}
+
+
 bool traceDownMultiRay(dag::Span<Trace> traces, bbox3f_cref ray_box, dag::Span<rendinst::RendInstDesc> ri_descs,
   const TraceMeshFaces *ri_cache, int ray_mat_id, TraceFlags trace_flags, Bitarray *filter_pools)
 {
@@ -1238,82 +1480,162 @@ bool traceDownMultiRay(dag::Span<Trace> traces, bbox3f_cref ray_box, dag::Span<r
   }
 
   uint8_t behaviorFlags = trace_flags & TraceFlag::Phys ? CollisionNode::PHYS_COLLIDABLE : CollisionNode::TRACEABLE;
+  auto resolveMatId = [&](Trace &trace, const rendinst::RendInstDesc &desc) {
+    if (trace.outMatId == PHYSMAT_INVALID || trace.outMatId == PHYSMAT_DEFAULT)
+      trace.outMatId = getRIGenMaterialId(desc);
+  };
 
+  // riExtra candidates are gathered once within caller's ray_box, bundles only test their boxes
   BBox3 rayBox;
   v_stu_bbox3(rayBox, ray_box);
   riex_collidable_t ri_h;
   rendinst::gatherRIGenExtraCollidable(ri_h, rayBox, true /*read_lock*/);
 
-  eastl::fixed_vector<CollisionTrace, 20, true, framemem_allocator> collisionTraces(traces.size());
-  for (int rayId = 0; rayId < traces.size(); rayId++)
-  {
-    collisionTraces[rayId].vFrom = v_ldu(&traces[rayId].pos.x);
-    collisionTraces[rayId].vDir = v_ldu(&traces[rayId].dir.x);
-    collisionTraces[rayId].norm = Point3(0, 1, 0);
-    collisionTraces[rayId].t = traces[rayId].pos.outT;
-    collisionTraces[rayId].outMatId = PHYSMAT_INVALID;
-  }
-
-  for (int i = 0; i < ri_h.size(); i++)
-  {
-    uint32_t resIdx = rendinst::handle_to_ri_type(ri_h[i]);
-    const CollisionResource *collRes = rendinst::riExtra[resIdx].collRes;
-    if (!collRes)
-      continue;
+  foreach_ray_bundle(traces, [&](RayBundle &bundle) {
+    if (!v_bbox3_test_box_intersect(bundle.box, ray_box))
+      return;
+    for (riex_handle_t h : ri_h)
+    {
+      uint32_t resIdx = rendinst::handle_to_ri_type(h);
+      const CollisionResource *collRes = rendinst::riExtra[resIdx].collRes;
+      if (!collRes)
+        continue;
 
-    if (filter_pools && filter_pools->get(rendinst::riExtra[resIdx].riPoolRef))
-      continue;
+      if (filter_pools && filter_pools->get(rendinst::riExtra[resIdx].riPoolRef))
+        continue;
 
-    mat44f tm;
-    rendinst::getRIGenExtra44(ri_h[i], tm);
+      mat44f tm;
+      rendinst::getRIGenExtra44(h, tm);
+      bbox3f transformedBox;
+      v_bbox3_init(transformedBox, tm, collRes->vFullBBox);
+      if (!v_bbox3_test_box_intersect(bundle.box, transformedBox))
+        continue;
+      if (uint64_t rays = bundle.testBox(transformedBox, bundle.allRays()))
+        haveCollision |=
+          trace_ray_bundle(collRes, tm, rays, bundle, traces, ray_mat_id, behaviorFlags, [&](Trace &trace, int trace_idx) {
+            rendinst::RendInstDesc &desc = ri_descs[trace_idx];
+            desc.setRiExtra();
+            desc.idx = rendinst::handle_to_ri_inst(h);
+            desc.pool = resIdx;
+            desc.offs = 0;
+            desc.layer = rendinst::riExtra[resIdx].riPoolRefLayer;
+            resolveMatId(trace, desc);
+          });
+    }
 
-    dag::Span<CollisionTrace> tracesSlice(collisionTraces.data(), collisionTraces.size());
-    haveCollision |= collRes->traceMultiRay(tm, tracesSlice, ray_mat_id, behaviorFlags);
-    for (int rayId = 0; rayId < traces.size(); rayId++)
+    FOR_EACH_PRIMARY_RG_LAYER_DO (rgl)
     {
-      if (collisionTraces[rayId].isHit)
-      {
-        ri_descs[rayId].setRiExtra();
-        ri_descs[rayId].idx = rendinst::handle_to_ri_inst(ri_h[i]);
-        ri_descs[rayId].pool = resIdx;
-        ri_descs[rayId].offs = 0;
-        ri_descs[rayId].layer = rendinst::riExtra[resIdx].riPoolRefLayer;
-
-        traces[rayId].pos.outT = collisionTraces[rayId].t;
-        traces[rayId].outNorm = collisionTraces[rayId].norm;
-        if (collisionTraces[rayId].outMatId == PHYSMAT_INVALID || collisionTraces[rayId].outMatId == PHYSMAT_DEFAULT)
-          traces[rayId].outMatId = getRIGenMaterialId(ri_descs[rayId]);
-        else
-          traces[rayId].outMatId = collisionTraces[rayId].outMatId;
-      }
+      const int layerIdx = _layer;
+      traverse_ray_bundle_layer(
+        layerIdx, bundle, [&](int pool, bool is_pos) { return is_pos || (filter_pools && filter_pools->get(pool)); },
+        [&](int cell_idx, CollisionResource *coll_res, mat44f_cref tm, uint64_t rays, int subcell_idx, int pool, int offs) {
+          haveCollision |=
+            trace_ray_bundle(coll_res, tm, rays, bundle, traces, ray_mat_id, behaviorFlags, [&](Trace &trace, int trace_idx) {
+              rendinst::RendInstDesc &desc = ri_descs[trace_idx];
+              desc.cellIdx = cell_idx;
+              desc.idx = subcell_idx;
+              desc.pool = pool;
+              desc.offs = offs;
+              desc.layer = layerIdx;
+              resolveMatId(trace, desc);
+            });
+        });
     }
-  }
+  });
 
-  FOR_EACH_PRIMARY_RG_LAYER_DO (rgl)
-  {
-    vec4f worldBboxXZ = v_perm_xzac(ray_box.bmin, ray_box.bmax);
-    vec4f regionV = v_sub(worldBboxXZ, rgl->world0Vxz);
-    regionV = v_max(v_mul(regionV, rgl->invGridCellSzV), v_zero());
-    regionV = v_min(regionV, rgl->lastCellXZXZ);
-    vec4i regionI = v_cvt_floori(regionV);
-    DECL_ALIGN16(int, regions[4]);
-    v_sti(regions, regionI);
+  return haveCollision;
+}
 
-    ScopedLockRead lock(rgl->rtData->riRwCs);
-    rgl->rtData->loadedCellsBBox.clip(regions[0], regions[1], regions[2], regions[3]);
+static int compare_trace_results(const char *name, dag::ConstSpan<Trace> bundle_traces, dag::ConstSpan<Trace> per_ray_traces,
+  int rays_cnt, float max_t, int bundle_usec, int per_ray_usec)
+{
+  int hits = 0, mismatches = 0;
+  for (int i = 0; i < rays_cnt; i++)
+  {
+    const Trace &bundle = bundle_traces[i], &perRay = per_ray_traces[i];
+    const bool bundleHit = bundle.pos.outT < max_t, perRayHit = perRay.pos.outT < max_t;
+    hits += perRayHit;
+    if (bundleHit == perRayHit && fabsf(bundle.pos.outT - perRay.pos.outT) <= 1e-4f * max(perRay.pos.outT, 1.f) &&
+        (!perRayHit || bundle.outMatId == perRay.outMatId))
+      continue;
+    if (mismatches++ < 8)
+      logerr("%s ray %d " FMT_P3 "->" FMT_P3 ": bundle t=%f mat=%d, per ray t=%f mat=%d", name, i, P3D(perRay.pos), P3D(perRay.dir),
+        bundle.pos.outT, bundle.outMatId, perRay.pos.outT, perRay.outMatId);
+  }
+  console::print_d("%s: %d rays, %d hits: bundles %d us, per ray %d us (%.2fx), %d mismatches", name, rays_cnt, hits, bundle_usec,
+    per_ray_usec, float(per_ray_usec) / max(bundle_usec, 1), mismatches);
+  return mismatches;
+}
 
-    int cellXStride = rgl->cellNumW - (regions[2] - regions[0] + 1);
-    for (int z = regions[1], cellI = regions[1] * rgl->cellNumW + regions[0]; z <= regions[3]; z++, cellI += cellXStride)
+// traces the same rays around center with ray bundles and with per-ray traversal (used before bundles and still used for single
+// ray) and compares hits, t and material: coherent (parallel rays from grid) and incoherent (random rays) bundles of
+// traceRayRIGenNormalized, and down rays of traceDownMultiRay with ray_box covering only part of them, so other bundles are rejected.
+// Logs and returns count of rays with different results, prints timings
+int verify_trace_ray_bundles(const Point3 &center, float radius, int rays_cnt)
+{
+  const float maxT = radius * 3;
+  const int side = max((int)ceilf(sqrtf(float(rays_cnt))), 2);
+  rays_cnt = side * side;
+  Tab<Trace> bundleTraces(framemem_ptr()), perRayTraces(framemem_ptr());
+  bundleTraces.resize(rays_cnt);
+  uint32_t seed = 1;
+  auto rnd = [&seed]() { return float((seed = seed * 1664525u + 1013904223u) >> 8) / float(1 << 24); };
+  auto initGrid = [&](const Point3 &dir) {
+    for (int i = 0; i < rays_cnt; i++)
     {
-      for (int x = regions[0]; x <= regions[2]; x++, cellI++)
-      {
-        if (traceDownMultiRayCell(_layer, cellI, traces, ri_descs, ray_box, ray_mat_id, behaviorFlags, filter_pools))
-          haveCollision = true;
-      }
+      Point2 xz = Point2(i % side, i / side) * (2.f / (side - 1)) - Point2(1, 1);
+      bundleTraces[i] = Trace(center + Point3(xz.x, 1, xz.y) * radius, dir, maxT, nullptr);
     }
-  }
+  };
+  auto traceRayPerRay = [&]() {
+    perRayTraces = bundleTraces;
+    TraceRayStrat perRayStrat(PHYSMAT_INVALID);
+    int64_t reft = ref_time_ticks();
+    for (Trace &trace : perRayTraces)
+      rayTraverse(dag::Span<Trace>(&trace, 1), false, nullptr, perRayStrat);
+    return get_time_usec(reft);
+  };
+  auto verifyTraceRay = [&](const char *name) {
+    const int perRayUsec = traceRayPerRay();
+    TraceRayStrat bundleStrat(PHYSMAT_INVALID);
+    int64_t reft = ref_time_ticks();
+    trace_ray_bundles(make_span(bundleTraces), nullptr, bundleStrat, RIEX_HANDLE_NULL);
+    const int bundleUsec = get_time_usec(reft);
+    return compare_trace_results(name, bundleTraces, perRayTraces, rays_cnt, maxT, bundleUsec, perRayUsec);
+  };
 
-  return haveCollision;
+  int mismatches = 0;
+  initGrid(Point3(0, -1, 0));
+  mismatches += verifyTraceRay("coherent down");
+  initGrid(normalize(Point3(0.3f, -1.f, 0.2f)));
+  mismatches += verifyTraceRay("coherent slanted");
+  for (Trace &trace : bundleTraces)
+  {
+    Point3 from = center + Point3((rnd() * 2 - 1) * radius, rnd() * radius, (rnd() * 2 - 1) * radius);
+    trace = Trace(from, normalize(Point3(rnd() * 2 - 1, rnd() * 2 - 1, rnd() * 2 - 1) + Point3(0, 1e-3f, 0)), maxT, nullptr);
+  }
+  mismatches += verifyTraceRay("incoherent");
+
+  // per-ray TraceRayStrat with default flags ignores pos instances, as traceDownMultiRay does
+  Tab<Trace> downTraces(framemem_ptr());
+  Tab<RendInstDesc> riDescs(framemem_ptr());
+  riDescs.resize(rays_cnt);
+  initGrid(Point3(0, -1, 0));
+  downTraces = bundleTraces;
+  const int perRayUsec = traceRayPerRay();
+  for (int checkedCnt : {rays_cnt, rays_cnt / 2})
+  {
+    // rows are stored in order, so box of the first rays covers part of grid and rest of bundles are out of it
+    bbox3f rayBox;
+    trace_utils::prepare_traces_box(make_span(downTraces).first(checkedCnt), rayBox);
+    bundleTraces = downTraces;
+    int64_t reft = ref_time_ticks();
+    traceDownMultiRay(make_span(bundleTraces), rayBox, make_span(riDescs));
+    const int bundleUsec = get_time_usec(reft);
+    mismatches += compare_trace_results(checkedCnt == rays_cnt ? "down multi ray" : "down multi ray, half ray box", bundleTraces,
+      perRayTraces, checkedCnt, maxT, bundleUsec, perRayUsec);
+  }
+  return mismatches;
 }
 
 bool rayhitRendInstNormalized(const Point3 &from, const Point3 &dir, float t, int ray_mat_id, const rendinst::RendInstDesc &ri_desc)
@@ -2622,3 +2944,16 @@ bool initializeCachedRiData(TraceMeshFaces *ri_cache)
 }
 
 } // namespace rendinst
+
+static bool ri_trace_console_handler(const char *argv[], int argc)
+{
+  int found = 0;
+  CONSOLE_CHECK_NAME("ri", "verify_trace_bundles", 4, 6)
+  {
+    Point3 pos(atof(argv[1]), atof(argv[2]), atof(argv[3]));
+    rendinst::verify_trace_ray_bundles(pos, argc > 4 ? atof(argv[4]) : 100.f, argc > 5 ? max(atoi(argv[5]), 1) : 10000);
+  }
+  return found;
+}
+
+REGISTER_CONSOLE_HANDLER(ri_trace_console_handler);
@@ -0,0 +1,321 @@
+#include "aggregation.h"
+#include <util/dag_globDef.h>
+#include <math/dag_mathBase.h>
+#include <util/dag_hash.h>
+#include <osApiWrappers/dag_critSec.h>
+#include <osApiWrappers/dag_spinlock.h>
+#include <osApiWrappers/dag_atomic.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <dag/dag_vector.h>
+#include <EASTL/string.h>
+#include <ska_hash_map/flat_hash_map2.hpp>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+// Metrics are accumulated in per-thread maps keyed by (type, name with tags), so hot paths pay only for key formatting, hashing
+// and uncontended spinlock. On flush (first metric call after flush period or explicit flush()) maps of all threads are merged and
+// sent as multi-metric packets ("\n"-separated lines, as understood by statsd, telegraf and influx statsd servers):
+//   counters are summed, gauges send last set value and then sum of increments (increments made by other threads are applied
+//   after latest set), timings and histograms send either all samples or log-scale sketch buckets (bucket center value repeated
+//   count times and packed as "key:v|ms:v|ms..." lines, so server gets exact count and percentiles within sketch relative accuracy;
+//   sample rate isn't used as statsd servers truncate 1/rate and ignore it for percentiles).
+
+namespace statsd
+{
+namespace aggregation
+{
+struct Sketch
+{
+  ska::flat_hash_map<uint32_t, uint32_t> bins; // bin index -> count
+
+  static constexpr int IDX_BIAS = 1 << 24;
+  static uint32_t binOf(double v, double inv_log_gamma)
+  {
+    if (v == 0)
+      return 0;
+    int idx = clamp((int)ceil(log(fabs(v)) * inv_log_gamma), 1 - IDX_BIAS, IDX_BIAS - 1);
+    return uint32_t(idx + IDX_BIAS) * 2 + (v < 0 ? 1 : 0);
+  }
+  static double binValue(uint32_t bin, double gamma)
+  {
+    if (!bin)
+      return 0;
+    double v = 2 * pow(gamma, int(bin >> 1) - IDX_BIAS) / (gamma + 1); // center of (gamma^(i-1), gamma^i]
+    return (bin & 1) ? -v : v;
+  }
+};
+
+struct Metric
+{
+  eastl::string key;
+  MetricType type = COUNTER; // COUNTER, GAUGE (also for increments), PROFILE or HISTOGRAM
+  int64_t sum = 0;           // counter value or gauge increment made after gauge set
+  int64_t looseDelta = 0;    // gauge increments of threads that didn't set gauge
+  long gauge = 0;
+  int64_t gaugeSetTicks = -1; // -1 when gauge wasn't set
+  dag::Vector<double> samples;
+  Sketch sketch;
+
+  void mergeFrom(Metric &m);
+};
+
+using MetricsMap = ska::flat_hash_map<uint64_t, Metric>;
+
+struct ThreadMetrics
+{
+  OSSpinlock lock;
+  MetricsMap metrics;
+  volatile int alive = 1;
+};
+
+static AggregationParams params;
+static double sketch_gamma = 1, inv_log_gamma = 0;
+static volatile int enabled = 0;
+static volatile int next_flush_msec = 0;
+static WinCritSec registry_cs; // guards thread_metrics and merged
+static dag::Vector<ThreadMetrics *> thread_metrics;
+static MetricsMap merged;
+
+static thread_local struct ThreadMetricsRef
+{
+  ThreadMetrics *tm = nullptr;
+  ~ThreadMetricsRef()
+  {
+    if (tm) // metrics are sent and freed by next flush
+      interlocked_release_store(tm->alive, 0);
+    tm = nullptr;
+  }
+} tls_metrics;
+
+static MetricType type_class(MetricType type) { return (type == GAUGE_INC || type == GAUGE_DEC) ? GAUGE : type; }
+
+static void add_value(Metric &m, MetricType type, double value)
+{
+  switch (type)
+  {
+    case COUNTER: m.sum += (int64_t)value; break;
+    case GAUGE:
+      m.gauge = (long)value;
+      m.gaugeSetTicks = ref_time_ticks();
+      m.sum = 0;
+      break;
+    case GAUGE_INC: m.sum += (int64_t)value; break;
+    case GAUGE_DEC: m.sum -= (int64_t)fabs(value); break;
+    case PROFILE:
+    case HISTOGRAM:
+      if (params.timingSketch)
+        m.sketch.bins[Sketch::binOf(value, inv_log_gamma)]++;
+      else
+        m.samples.push_back(value);
+      break;
+  }
+}
+
+void Metric::mergeFrom(Metric &m)
+{
+  switch (type)
+  {
+    case COUNTER: sum += m.sum; break;
+    case GAUGE:
+      if (m.gaugeSetTicks < 0)
+        looseDelta += m.sum;
+      else if (m.gaugeSetTicks > gaugeSetTicks)
+      {
+        if (gaugeSetTicks < 0)
+          looseDelta += sum;
+        gauge = m.gauge;
+        gaugeSetTicks = m.gaugeSetTicks;
+        sum = m.sum;
+      }
+      looseDelta += m.looseDelta;
+      break;
+    default:
+      samples.insert(samples.end(), m.samples.begin(), m.samples.end());
+      for (auto &b : m.sketch.bins)
+        sketch.bins[b.first] += b.second;
+  }
+}
+
+class PacketWriter
+{
+  char buf[MAX_PACKET_SIZE];
+  int used = 0, maxSize;
+
+public:
+  PacketWriter() : maxSize(clamp(params.maxPacketSize, 256, (int)MAX_PACKET_SIZE)) {}
+  ~PacketWriter() { flush(); }
+
+  void flush()
+  {
+    if (used)
+      send_packet(buf, used);
+    used = 0;
+  }
+
+  void printf(const char *fmt, ...)
+  {
+    char line[MAX_PACKET_SIZE];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = _vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (len <= 0 || len >= maxSize) // can't be sent in one packet
+      return;
+    if (used && used + 1 + len > maxSize)
+      flush();
+    if (used)
+      buf[used++] = '\n';
+    memcpy(buf + used, line, len);
+    used += len;
+  }
+
+  // sends value count times, packing as many ":value|type" items to one line as fit in packet
+  void repeat(const char *key, double value, const char *type, uint32_t count)
+  {
+    char item[64];
+    int keyLen = (int)strlen(key), itemLen = _snprintf(item, sizeof(item), ":%g|%s", value, type);
+    if (itemLen <= 0 || itemLen >= (int)sizeof(item) || keyLen + itemLen > maxSize) // can't be sent in one packet
+      return;
+    while (count)
+    {
+      int room = ((used ? maxSize - used - 1 : maxSize) - keyLen) / itemLen;
+      if (room <= 0)
+      {
+        flush();
+        continue;
+      }
+      int n = min<int>(room, count);
+      if (used)
+        buf[used++] = '\n';
+      memcpy(buf + used, key, keyLen);
+      used += keyLen;
+      for (int i = 0; i < n; i++, used += itemLen)
+        memcpy(buf + used, item, itemLen);
+      count -= n;
+    }
+  }
+};
+
+static void send_metric(PacketWriter &pw, const Metric &m)
+{
+  const char *key = m.key.c_str();
+  switch (m.type)
+  {
+    case COUNTER: pw.printf("%s:%lld|c", key, (long long)m.sum); break;
+    case GAUGE:
+    {
+      if (m.gaugeSetTicks >= 0)
+        pw.printf("%s:%ld|g", key, m.gauge);
+      int64_t delta = m.sum + m.looseDelta;
+      if (delta)
+        pw.printf("%s:%c%lld|g", key, delta > 0 ? '+' : '-', (long long)(delta > 0 ? delta : -delta));
+      break;
+    }
+    default:
+    {
+      const char *type = m.type == PROFILE ? "ms" : "h";
+      for (double v : m.samples)
+        pw.printf("%s:%g|%s", key, v, type);
+      for (auto &b : m.sketch.bins)
+        pw.repeat(key, Sketch::binValue(b.first, sketch_gamma), type, b.second);
+    }
+  }
+}
+
+static ThreadMetrics *get_thread_metrics()
+{
+  if (!tls_metrics.tm)
+  {
+    tls_metrics.tm = new ThreadMetrics;
+    WinAutoLock lock(registry_cs);
+    thread_metrics.push_back(tls_metrics.tm);
+  }
+  return tls_metrics.tm;
+}
+
+bool is_enabled() { return interlocked_relaxed_load(enabled) != 0; }
+
+bool add(const char *key, int key_len, MetricType type, double value)
+{
+  const MetricType cls = type_class(type);
+  const uint64_t hash = mem_hash_fnv1<64>(key, key_len, FNV1Params<64>::offset_basis + cls);
+  ThreadMetrics *tm = get_thread_metrics();
+  {
+    OSSpinlockScopedLock lock(tm->lock);
+    auto it = tm->metrics.find(hash);
+    if (it == tm->metrics.end())
+    {
+      it = tm->metrics.emplace(hash, Metric()).first;
+      it->second.key.assign(key, key + key_len);
+      it->second.type = cls;
+    }
+    else if (it->second.type != cls || it->second.key.size() != (size_t)key_len || memcmp(it->second.key.data(), key, key_len) != 0)
+      return false; // hash collision
+    add_value(it->second, type, value);
+  }
+
+  const int nextFlush = interlocked_relaxed_load(next_flush_msec);
+  const int t = get_time_msec();
+  if (t - nextFlush >= 0 && interlocked_compare_exchange(next_flush_msec, t + params.flushPeriodMs, nextFlush) == nextFlush)
+    flush();
+  return true;
+}
+} // namespace aggregation
+
+using namespace aggregation;
+
+void enable_aggregation(const AggregationParams &params_)
+{
+  disable_aggregation();
+  params = params_;
+  float acc = clamp(params.sketchRelativeAccuracy, 0.0001f, 0.5f);
+  sketch_gamma = (1.0 + acc) / (1.0 - acc);
+  inv_log_gamma = 1.0 / log(sketch_gamma);
+  interlocked_release_store(next_flush_msec, get_time_msec() + params.flushPeriodMs);
+  interlocked_release_store(enabled, 1);
+}
+
+void disable_aggregation()
+{
+  if (!interlocked_exchange(enabled, 0))
+    return;
+  flush(); // metrics added concurrently with disabling are sent by next flush
+}
+
+void flush()
+{
+  WinAutoLock lock(registry_cs);
+  for (int i = 0; i < (int)thread_metrics.size(); i++)
+  {
+    ThreadMetrics *tm = thread_metrics[i];
+    {
+      OSSpinlockScopedLock tmLock(tm->lock);
+      for (auto &it : tm->metrics)
+      {
+        auto ins = merged.emplace(it.first, Metric());
+        if (ins.second)
+          ins.first->second = eastl::move(it.second);
+        else
+          ins.first->second.mergeFrom(it.second);
+      }
+      tm->metrics.clear();
+    }
+    if (!interlocked_acquire_load(tm->alive))
+    {
+      delete tm;
+      thread_metrics[i--] = thread_metrics.back();
+      thread_metrics.pop_back();
+    }
+  }
+  if (merged.empty())
+    return;
+
+  PacketWriter pw;
+  for (auto &it : merged)
+    send_metric(pw, it.second);
+  merged.clear();
+}
+} // namespace statsd
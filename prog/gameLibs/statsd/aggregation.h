@@ -0,0 +1,17 @@
+#pragma once
+
+#include <statsd/statsd.h>
+
+namespace statsd
+{
+static constexpr int MAX_PACKET_SIZE = 1500 - 28; // MTU minus IPv4 and UDP headers
+
+void send_packet(const char *buf, int len); // statsd.cpp
+
+namespace aggregation
+{
+bool is_enabled();
+// key is metric name with tags (without value); returns false if metric can't be aggregated and must be sent as is
+bool add(const char *key, int key_len, MetricType type, double value);
+} // namespace aggregation
+} // namespace statsd
@@ -8,6 +8,7 @@
 #include <EASTL/fixed_vector.h>
 #include <memory/dag_framemem.h>
 #include <initializer_list>
+#include "aggregation.h"
 
 namespace statsd
 {
@@ -100,6 +101,14 @@ static void try_recover_on_error(int sent, const char *buf, int size, const char
   }
 }
 
+void send_packet(const char *buf, int len)
+{
+  if (!sending_enabled || !stats_sock)
+    return;
+  int nsent = stats_sock.send(buf, len);
+  try_recover_on_error(nsent, buf, len, __FUNCTION__);
+}
+
 bool init_socket(ILogger *logger_)
 {
   char errStr[512];
@@ -190,6 +199,26 @@ constexpr const char *value_spec_string_new = ":%s%ld|%s";
 template <>
 constexpr const char *value_spec_string_new<float> = ":%s%f|%s";
 
+static void get_type_spec(MetricType mtype, const char *&type, const char *&val_prefix)
+{
+  switch (mtype)
+  {
+    case COUNTER: type = "c"; break;
+    case PROFILE: type = "ms"; break;
+    case GAUGE: type = "g"; break;
+    case HISTOGRAM: type = "h"; break;
+    case GAUGE_INC:
+      type = "g";
+      val_prefix = "+";
+      break;
+    case GAUGE_DEC:
+      type = "g";
+      val_prefix = "-";
+      break;
+    default: G_ASSERT(0);
+  }
+}
+
 template <typename ValueType>
 static void send_internal(const char *metric, dag::ConstSpan<MetricTag> tags, MetricType mtype, ValueType value)
 {
@@ -212,22 +241,7 @@ static void send_internal(const char *metric, dag::ConstSpan<MetricTag> tags, Me
 
   const char *type = "";
   const char *val_prefix = "";
-  switch (mtype)
-  {
-    case COUNTER: type = "c"; break;
-    case PROFILE: type = "ms"; break;
-    case GAUGE: type = "g"; break;
-    case HISTOGRAM: type = "h"; break;
-    case GAUGE_INC:
-      type = "g";
-      val_prefix = "+";
-      break;
-    case GAUGE_DEC:
-      type = "g";
-      val_prefix = "-";
-      break;
-    default: G_ASSERT(0);
-  }
+  get_type_spec(mtype, type, val_prefix);
 
   char *pos = buf;
   size_t bytes_left = sizeof(buf);
@@ -274,6 +288,9 @@ static void send_internal(const char *metric, dag::ConstSpan<MetricTag> tags, Me
     bytes_left -= bytesAdded;
   }
 
+  if (aggregation::is_enabled() && aggregation::add(buf, (int)(pos - buf), mtype, (double)value))
+    return;
+
   // value specification
   {
     bytesAdded = _snprintf(pos, bytes_left, value_spec_string_new<ValueType>, val_prefix, value, type);
@@ -317,17 +334,15 @@ void send_internal(const char *metric, dag::ConstSpan<MetricTag> tags, ValueType
 }
 
 template <typename ValueType>
-constexpr const char *value_spec_string_old = "%s%s:%s%ld|%s";
+constexpr const char *value_spec_string_old = ":%s%ld|%s";
 
 template <>
-constexpr const char *value_spec_string_old<float> = "%s%s:%s%g|%s";
+constexpr const char *value_spec_string_old<float> = ":%s%g|%s";
 
-template <typename ValueType>
-static void statsd_send(const char *metric, const char *type, const char *val_pref, ValueType value)
+template <MetricType mtype, typename ValueType>
+static void statsd_send(const char *metric, ValueType value)
 {
   G_ASSERT(metric && *metric);
-  G_ASSERT(type && *type);
-  G_ASSERT(val_pref); // can be empty string
 
   if (prefix.empty() || !sending_enabled)
     return;
@@ -338,8 +353,18 @@ static void statsd_send(const char *metric, const char *type, const char *val_pr
     return;
   }
 
+  const char *type = "";
+  const char *val_pref = "";
+  get_type_spec(mtype, type, val_pref);
+
   char buf[STATSD_PACKET_MAX_SIZE];
-  int n = _snprintf(buf, sizeof(buf), value_spec_string_old<ValueType>, prefix.str(), metric, val_pref, value, type);
+  int n = _snprintf(buf, sizeof(buf), "%s%s", prefix.str(), metric);
+  if ((size_t)n < sizeof(buf))
+  {
+    if (aggregation::is_enabled() && aggregation::add(buf, n, mtype, (double)value))
+      return;
+    n += _snprintf(buf + n, sizeof(buf) - n, value_spec_string_old<ValueType>, val_pref, value, type);
+  }
   if ((size_t)n >= sizeof(buf))
   {
     logerr("%s: failed to format string data for statsd (tag: '%s', metric: '%s', "
@@ -358,7 +383,7 @@ void gauge(const char *metric, long value, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<GAUGE>(metric, value, tag);
   else
-    statsd_send(metric, "g", "", value);
+    statsd_send<GAUGE>(metric, value);
 }
 
 void gauge(const char *metric, long value, std::initializer_list<MetricTag> tags)
@@ -366,7 +391,7 @@ void gauge(const char *metric, long value, std::initializer_list<MetricTag> tags
   if (useNewMetricFormat)
     send_internal_tags<GAUGE>(metric, value, tags);
   else
-    statsd_send(metric, "g", "", value);
+    statsd_send<GAUGE>(metric, value);
 }
 
 void gauge_inc(const char *metric, long value, const MetricTag &tag)
@@ -374,7 +399,7 @@ void gauge_inc(const char *metric, long value, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<GAUGE_INC>(metric, value, tag);
   else
-    statsd_send(metric, "g", "+", value);
+    statsd_send<GAUGE_INC>(metric, value);
 }
 
 void gauge_inc(const char *metric, long value, std::initializer_list<MetricTag> tags)
@@ -382,7 +407,7 @@ void gauge_inc(const char *metric, long value, std::initializer_list<MetricTag>
   if (useNewMetricFormat)
     send_internal_tags<GAUGE_INC>(metric, value, tags);
   else
-    statsd_send(metric, "g", "+", value);
+    statsd_send<GAUGE_INC>(metric, value);
 }
 
 void gauge_dec(const char *metric, long value, const MetricTag &tag)
@@ -390,7 +415,7 @@ void gauge_dec(const char *metric, long value, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<GAUGE_DEC>(metric, value, tag);
   else
-    statsd_send(metric, "g", "-", abs(value));
+    statsd_send<GAUGE_DEC>(metric, abs(value));
 }
 
 void gauge_dec(const char *metric, long value, std::initializer_list<MetricTag> tags)
@@ -398,7 +423,7 @@ void gauge_dec(const char *metric, long value, std::initializer_list<MetricTag>
   if (useNewMetricFormat)
     send_internal_tags<GAUGE_DEC>(metric, value, tags);
   else
-    statsd_send(metric, "g", "-", abs(value));
+    statsd_send<GAUGE_DEC>(metric, abs(value));
 }
 
 void counter(const char *metric, long value, const MetricTag &tag)
@@ -406,7 +431,7 @@ void counter(const char *metric, long value, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<COUNTER>(metric, value, tag);
   else
-    statsd_send(metric, "c", "", value);
+    statsd_send<COUNTER>(metric, value);
 }
 
 void counter(const char *metric, long value, std::initializer_list<MetricTag> tags)
@@ -414,7 +439,7 @@ void counter(const char *metric, long value, std::initializer_list<MetricTag> ta
   if (useNewMetricFormat)
     send_internal_tags<COUNTER>(metric, value, tags);
   else
-    statsd_send(metric, "c", "", value);
+    statsd_send<COUNTER>(metric, value);
 }
 
 void profile(const char *metric, float time_ms, const MetricTag &tag)
@@ -422,7 +447,7 @@ void profile(const char *metric, float time_ms, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<PROFILE>(metric, time_ms, tag);
   else
-    statsd_send(metric, "ms", "", time_ms);
+    statsd_send<PROFILE>(metric, time_ms);
 }
 
 void profile(const char *metric, long time_ms, const MetricTag &tag)
@@ -430,7 +455,7 @@ void profile(const char *metric, long time_ms, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<PROFILE>(metric, time_ms, tag);
   else
-    statsd_send(metric, "ms", "", time_ms);
+    statsd_send<PROFILE>(metric, time_ms);
 }
 
 void profile(const char *metric, float time_ms, std::initializer_list<MetricTag> tags)
@@ -438,7 +463,7 @@ void profile(const char *metric, float time_ms, std::initializer_list<MetricTag>
   if (useNewMetricFormat)
     send_internal_tags<PROFILE>(metric, time_ms, tags);
   else
-    statsd_send(metric, "ms", "", time_ms);
+    statsd_send<PROFILE>(metric, time_ms);
 }
 
 void profile(const char *metric, long time_ms, std::initializer_list<MetricTag> tags)
@@ -446,7 +471,7 @@ void profile(const char *metric, long time_ms, std::initializer_list<MetricTag>
   if (useNewMetricFormat)
     send_internal_tags<PROFILE>(metric, time_ms, tags);
   else
-    statsd_send(metric, "ms", "", time_ms);
+    statsd_send<PROFILE>(metric, time_ms);
 }
 
 void histogram(const char *metric, float value, const MetricTag &tag)
@@ -454,7 +479,7 @@ void histogram(const char *metric, float value, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<HISTOGRAM>(metric, value, tag);
   else
-    statsd_send(metric, "h", "", value);
+    statsd_send<HISTOGRAM>(metric, value);
 }
 
 void histogram(const char *metric, long value, const MetricTag &tag)
@@ -462,7 +487,7 @@ void histogram(const char *metric, long value, const MetricTag &tag)
   if (useNewMetricFormat)
     send_internal_args<HISTOGRAM>(metric, value, tag);
   else
-    statsd_send(metric, "h", "", value);
+    statsd_send<HISTOGRAM>(metric, value);
 }
 
 void histogram(const char *metric, float value, std::initializer_list<MetricTag> tags)
@@ -470,7 +495,7 @@ void histogram(const char *metric, float value, std::initializer_list<MetricTag>
   if (useNewMetricFormat)
     send_internal_tags<HISTOGRAM>(metric, value, tags);
   else
-    statsd_send(metric, "h", "", value);
+    statsd_send<HISTOGRAM>(metric, value);
 }
 
 void histogram(const char *metric, long value, std::initializer_list<MetricTag> tags)
@@ -478,7 +503,7 @@ void histogram(const char *metric, long value, std::initializer_list<MetricTag>
   if (useNewMetricFormat)
     send_internal_tags<HISTOGRAM>(metric, value, tags);
   else
-    statsd_send(metric, "h", "", value);
+    statsd_send<HISTOGRAM>(metric, value);
 }
 
 // Tag arrays functions
@@ -556,6 +581,7 @@ void report(void (*action)(const char *, long, const MetricTag &), long value, c
 
 void shutdown()
 {
+  disable_aggregation();
   stats_sock.close();
   prefix.clear();
   if (sockets_initialized)
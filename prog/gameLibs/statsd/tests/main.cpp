@@ -0,0 +1,195 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <statsd/statsd.h>
+#include <osApiWrappers/dag_sockets.h>
+#include <osApiWrappers/dag_threads.h>
+#include <osApiWrappers/dag_miscApi.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <EASTL/algorithm.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local UDP listener receives what statsd sends: checks wire format of aggregated metrics and number of packets (send calls)
+
+static constexpr int BASE_PORT = 18125;
+
+struct Listener
+{
+  os_socket_t sock = OS_SOCKET_INVALID;
+  int port = 0;
+
+  Listener()
+  {
+    os_sockets_init();
+    for (int p = BASE_PORT; p < BASE_PORT + 16 && sock == OS_SOCKET_INVALID; p++)
+    {
+      sock = os_socket_create(OSAF_IPV4, OST_UDP);
+      sockets::SocketAddr<OSAF_IPV4> addr("127.0.0.1", (uint16_t)p);
+      int addrLen = 0;
+      const os_socket_addr *raw = addr.getRawAddr(addrLen);
+      if (os_socket_bind(sock, raw, addrLen) == 0)
+        port = p;
+      else
+      {
+        os_socket_close(sock);
+        sock = OS_SOCKET_INVALID;
+      }
+    }
+    os_socket_set_option(sock, OSO_NONBLOCK, 1);
+  }
+  ~Listener()
+  {
+    os_socket_close(sock);
+    os_sockets_shutdown();
+  }
+
+  // returns received packets, waits until no packets arrive for a while
+  eastl::vector<eastl::string> receive()
+  {
+    eastl::vector<eastl::string> packets;
+    char buf[2048];
+    for (int idleMs = 0; idleMs < 200;)
+    {
+      int len = os_socket_recvfrom(sock, buf, sizeof(buf));
+      if (len > 0)
+      {
+        packets.emplace_back(buf, buf + len);
+        idleMs = 0;
+      }
+      else
+      {
+        sleep_msec(10);
+        idleMs += 10;
+      }
+    }
+    return packets;
+  }
+};
+
+static eastl::vector<eastl::string> split_lines(const eastl::vector<eastl::string> &packets)
+{
+  eastl::vector<eastl::string> lines;
+  for (const eastl::string &p : packets)
+    for (size_t start = 0; start < p.size();)
+    {
+      size_t end = p.find('\n', start);
+      if (end == eastl::string::npos)
+        end = p.size();
+      lines.emplace_back(p.substr(start, end - start));
+      start = end + 1;
+    }
+  return lines;
+}
+
+static bool has_line(const eastl::vector<eastl::string> &lines, const char *line)
+{
+  for (const eastl::string &l : lines)
+    if (l == line)
+      return true;
+  return false;
+}
+
+static Listener *listener = nullptr;
+
+static void init_statsd()
+{
+  if (listener)
+    return;
+  listener = new Listener;
+  const char *keys[] = {"test", nullptr};
+  statsd::init(statsd::get_dagor_logger(), keys, "127.0.0.1", listener->port, statsd::Env{"test"}, statsd::Circuit{"circ"},
+    statsd::Application{"app"}, statsd::Platform{""}, statsd::Project{"proj"}, statsd::Host{""});
+}
+
+#define HDR ",env=test,circuit=circ,application=app,project=proj"
+
+TEST(immediate_send)
+{
+  init_statsd();
+  for (int i = 0; i < 50; i++)
+    statsd::counter("hits", 1, {"kind", "a"});
+  auto packets = listener->receive();
+  CHECK_EQUAL(50, (int)packets.size());
+  CHECK(packets[0] == "hits" HDR ",kind=a:1|c");
+}
+
+TEST(aggregated_send)
+{
+  init_statsd();
+  statsd::AggregationParams params;
+  params.flushPeriodMs = 1000000;
+  statsd::enable_aggregation(params);
+  for (int i = 0; i < 1000; i++)
+  {
+    statsd::counter("hits", 1, {"kind", "a"});
+    statsd::counter("hits", 2, {"kind", "b"});
+    statsd::profile("frame", (float)(1 + i % 10), {"kind", "a"});
+  }
+  statsd::gauge("players", 10L);
+  statsd::gauge_inc("players", 3L);
+  statsd::gauge_dec("players", 1L);
+  statsd::flush();
+  auto packets = listener->receive();
+  auto lines = split_lines(packets);
+
+  CHECK(packets.size() <= 12); // 3000 calls, ~15 lines (1000 timing values packed in ~9 packets)
+  for (const eastl::string &p : packets)
+    CHECK(p.size() <= (size_t)params.maxPacketSize);
+  CHECK(has_line(lines, "hits" HDR ",kind=a:1000|c"));
+  CHECK(has_line(lines, "hits" HDR ",kind=b:2000|c"));
+  CHECK(has_line(lines, "players" HDR ":10|g"));
+  CHECK(has_line(lines, "players" HDR ":+2|g"));
+
+  // timings are sent as sketch buckets: 10 distinct values repeated 100 times each (several values per line, no sample rate),
+  // value within relative accuracy
+  int samples = 0;
+  double sum = 0;
+  eastl::vector<double> distinct;
+  for (const eastl::string &l : lines)
+    if (l.find("frame" HDR ",kind=a:") == 0)
+      for (const char *v = strchr(l.c_str(), ':'); v; v = strchr(v, ':'))
+      {
+        double value = atof(++v);
+        CHECK(strncmp(strchr(v, '|'), "|ms", 3) == 0);
+        CHECK(strstr(v, "|@") == nullptr);
+        samples++;
+        sum += value;
+        if (eastl::find(distinct.begin(), distinct.end(), value) == distinct.end())
+          distinct.push_back(value);
+      }
+  CHECK_EQUAL(10, (int)distinct.size());
+  CHECK_EQUAL(1000, samples);
+  CHECK_CLOSE(5500.0, sum, 5500.0 * params.sketchRelativeAccuracy);
+  statsd::disable_aggregation();
+}
+
+class CounterThread final : public DaThread
+{
+public:
+  CounterThread() : DaThread("statsdCounter") {}
+  void execute() override
+  {
+    for (int i = 0; i < 10000; i++)
+      statsd::counter("mt_hits", 1);
+  }
+};
+
+TEST(aggregated_multithreaded)
+{
+  init_statsd();
+  statsd::AggregationParams params;
+  params.flushPeriodMs = 1000000;
+  statsd::enable_aggregation(params);
+  CounterThread threads[4];
+  for (CounterThread &t : threads)
+    t.start();
+  for (CounterThread &t : threads)
+    t.terminate(true);
+  statsd::flush();
+  auto lines = split_lines(listener->receive());
+  CHECK_EQUAL(1, (int)lines.size());
+  CHECK(has_line(lines, "mt_hits" HDR ":40000|c"));
+  statsd::disable_aggregation();
+}
+
+#include <unittest/main.inc.cpp>
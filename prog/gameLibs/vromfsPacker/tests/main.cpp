@@ -0,0 +1,182 @@
+#include <UnitTest++/UnitTestPP.h>
+#include <ioSys/dag_dataBlock.h>
+#include <vromfsPacker/vromfsPacker.h>
+#include <osApiWrappers/dag_vromfs.h>
+#include <osApiWrappers/dag_files.h>
+#include <osApiWrappers/dag_direct.h>
+#include <util/dag_string.h>
+#include <util/dag_globDef.h>
+#include <generic/dag_span.h>
+#include <hash/md5.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <string.h>
+
+// Round trip of vromfs delta patches: builds base and new dumps from generated folders (files changed, added, removed and
+// duplicated), makes patch with -mkpatch and checks that patched dump (applied to file, in place and loaded directly) has the same
+// files with the same MD5 of contents as new dump
+
+static const char *WORK_DIR = "vromfsPatchTest";
+static constexpr int BASE_FILES = 12;
+
+static uint32_t rnd_seed = 1;
+static uint32_t rnd() { return (rnd_seed = rnd_seed * 1664525u + 1013904223u) >> 8; }
+
+// text-like contents, so that dumps are packed and patch has both copied and added chunks
+static eastl::string make_contents(int lines)
+{
+  static const char *words[] = {"name", "value", "damage", "speed", "model", "texture", "radius", "count", "enabled", "weight"};
+  eastl::string s;
+  for (int i = 0; i < lines; i++)
+    s.append_sprintf("%s_%u:i=%u\n", words[rnd() % countof(words)], rnd() % 100, rnd() % 100000);
+  return s;
+}
+
+static String path(const char *name) { return String(0, "%s/%s", WORK_DIR, name); }
+
+static bool write_file(const char *fname, const eastl::string &contents)
+{
+  dd_mkpath(fname);
+  file_ptr_t fp = df_open(fname, DF_WRITE | DF_CREATE);
+  if (!fp)
+    return false;
+  bool ok = df_write(fp, contents.data(), (int)contents.size()) == (int)contents.size();
+  df_close(fp);
+  return ok;
+}
+
+static int build(const char *src_dir, const char *out_fname)
+{
+  String src(0, "-B:%s", path(src_dir)), out(0, "-out:%s", path(out_fname));
+  const char *argv[] = {"vromfsPacker", src, out, "-quiet"};
+  return buildVromfs(nullptr, make_span_const(argv, countof(argv)));
+}
+
+static int make_patch(const char *base_fname, const char *new_fname, const char *patch_fname)
+{
+  String base(path(base_fname)), upd(path(new_fname)), patch(path(patch_fname));
+  const char *argv[] = {"vromfsPacker", "-mkpatch", base, upd, patch, "-chunk:512"};
+  return buildVromfs(nullptr, make_span_const(argv, countof(argv)));
+}
+
+static void make_dumps()
+{
+  eastl::vector<eastl::string> files;
+  for (int i = 0; i < BASE_FILES; i++)
+  {
+    files.push_back(make_contents(100 + rnd() % 2000));
+    write_file(path(String(0, "base/data/file%02d.txt", i)), files.back());
+  }
+
+  files[0].insert(files[0].size() / 2, make_contents(10));   // inserted in the middle
+  files[1].append(make_contents(50));                        // appended
+  files[5].erase(files[5].size() / 3, files[5].size() / 3); // cut out
+  files[7] = make_contents(500);                             // replaced
+  for (int i = 0; i < BASE_FILES; i++)
+    if (i != 2) // removed
+      write_file(path(String(0, "new/data/file%02d.txt", i)), files[i]);
+  write_file(path("new/data/added.txt"), make_contents(300));
+  write_file(path("new/data/copy_of_file04.txt"), files[4]);
+
+  CHECK_EQUAL(0, build("base", "base.vromfs.bin"));
+  CHECK_EQUAL(0, build("new", "new.vromfs.bin"));
+  CHECK_EQUAL(0, make_patch("base.vromfs.bin", "new.vromfs.bin", "new.vromfs.patch"));
+}
+
+static void file_md5(VirtualRomFsData *fs, int idx, unsigned char out_md5[16])
+{
+  md5_state_t s;
+  md5_init(&s);
+  md5_append(&s, (const md5_byte_t *)fs->data[idx].data(), fs->data[idx].size());
+  md5_finish(&s, out_md5);
+}
+
+// checks that fs has the same files with the same contents as reference dump
+static void check_same_contents(VirtualRomFsData *fs, VirtualRomFsData *ref)
+{
+  CHECK(fs != nullptr);
+  if (!fs || !ref)
+    return;
+  CHECK_EQUAL(ref->files.map.size(), fs->files.map.size());
+  for (int i = 0, ie = ref->files.map.size(); i < ie; i++)
+  {
+    int id = fs->files.getNameId(ref->files.map[i]);
+    CHECK(id >= 0);
+    if (id < 0)
+      continue;
+    unsigned char refMD5[16], md5[16];
+    file_md5(ref, i, refMD5);
+    file_md5(fs, id, md5);
+    CHECK(memcmp(refMD5, md5, sizeof(md5)) == 0);
+  }
+}
+
+static void check_file_same_contents(const char *fname, VirtualRomFsData *ref)
+{
+  VirtualRomFsData *fs = load_vromfs_dump(path(fname), tmpmem);
+  check_same_contents(fs, ref);
+  if (fs)
+    tmpmem->free(fs);
+}
+
+static bool copy_file(const char *src, const char *dst)
+{
+  eastl::string contents;
+  file_ptr_t fp = df_open(src, DF_READ);
+  if (!fp)
+    return false;
+  contents.resize(df_length(fp));
+  bool ok = df_read(fp, contents.data(), (int)contents.size()) == (int)contents.size();
+  df_close(fp);
+  return ok && write_file(dst, contents);
+}
+
+static void remove_work_dir()
+{
+  static const char *dumps[] = {
+    "base.vromfs.bin", "new.vromfs.bin", "new.vromfs.patch", "patched.vromfs.bin", "inplace.vromfs.bin"};
+  for (const char *fn : dumps)
+    dd_erase(path(fn));
+  for (const char *dir : {"base", "new"})
+  {
+    for (int i = 0; i < BASE_FILES; i++)
+      dd_erase(path(String(0, "%s/data/file%02d.txt", dir, i)));
+    dd_erase(path(String(0, "%s/data/added.txt", dir)));
+    dd_erase(path(String(0, "%s/data/copy_of_file04.txt", dir)));
+    dd_rmdir(path(String(0, "%s/data", dir)));
+    dd_rmdir(path(dir));
+  }
+  dd_rmdir(WORK_DIR);
+}
+
+TEST(PatchRoundTrip)
+{
+  remove_work_dir();
+  make_dumps();
+  VirtualRomFsData *ref = load_vromfs_dump(path("new.vromfs.bin"), tmpmem);
+  CHECK(ref != nullptr);
+
+  // applied to separate file
+  CHECK(apply_vromfs_patch(path("base.vromfs.bin"), path("new.vromfs.patch"), path("patched.vromfs.bin")));
+  check_file_same_contents("patched.vromfs.bin", ref);
+
+  // loaded directly from patch, base is found near it
+  check_file_same_contents("new.vromfs.patch", ref);
+
+  // applied in place: written to temp file and renamed over base
+  CHECK(copy_file(path("base.vromfs.bin"), path("inplace.vromfs.bin")));
+  CHECK(apply_vromfs_patch(path("inplace.vromfs.bin"), path("new.vromfs.patch"), path("inplace.vromfs.bin")));
+  CHECK(!dd_file_exists(path("inplace.vromfs.bin.tmp")));
+  check_file_same_contents("inplace.vromfs.bin", ref);
+
+  // wrong base: fails, existing dest is kept intact
+  CHECK(!apply_vromfs_patch(path("new.vromfs.bin"), path("new.vromfs.patch"), path("inplace.vromfs.bin")));
+  CHECK(!dd_file_exists(path("inplace.vromfs.bin.tmp")));
+  check_file_same_contents("inplace.vromfs.bin", ref);
+
+  if (ref)
+    tmpmem->free(ref);
+  remove_work_dir();
+}
+
+#include <unittest/main.inc.cpp>
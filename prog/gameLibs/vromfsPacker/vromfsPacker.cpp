@@ -1167,98 +1167,106 @@ print_version:
   return true;
 }
 
-bool repackVromfs(const char *fname, const char *dest_fname, bool store_packed, bool index_only = false)
+bool readVromfsDump(const char *fname, VirtualRomFsDataHdr &hdr, Tab<uint8_t> &hdr_ex_data, Tab<char> &fs,
+  unsigned char md5_digest[16], Tab<char> &digitalSignature)
 {
-  VirtualRomFsDataHdr hdr;
-  Tab<char> fs(tmpmem);
   bool read_be = false;
-  unsigned char md5_digest[16];
-  Tab<char> digitalSignature(tmpmem);
-  Tab<uint8_t> hdr_ex_data;
-
+  FullFileLoadCB crd(fname);
+  if (!crd.fileHandle)
   {
-    FullFileLoadCB crd(fname);
-    if (!crd.fileHandle)
-    {
-      printf("ERR: can't open %s", fname);
-      return false;
-    }
-    crd.read(&hdr, sizeof(hdr));
-    if (hdr.label != _MAKE4C('VRFs') && hdr.label != _MAKE4C('VRFx'))
-    {
-      printf("ERR: VRFS label not found in %s", fname);
-      return false;
-    }
-    if (!dagor_target_code_valid(hdr.target))
-    {
-      printf("ERR: unknowm format %c%c%c%c, %s", _DUMP4C(hdr.target), fname);
-      return false;
-    }
+    printf("ERR: can't open %s", fname);
+    return false;
+  }
+  crd.read(&hdr, sizeof(hdr));
+  if (hdr.label != _MAKE4C('VRFs') && hdr.label != _MAKE4C('VRFx'))
+  {
+    printf("ERR: VRFS label not found in %s", fname);
+    return false;
+  }
+  if (!dagor_target_code_valid(hdr.target))
+  {
+    printf("ERR: unknowm format %c%c%c%c, %s", _DUMP4C(hdr.target), fname);
+    return false;
+  }
 
-    if (hdr.label == _MAKE4C('VRFx'))
-    {
-      uint16_t hdr_ex;
-      crd.read(&hdr_ex, 2);
-      crd.seekrel(-2);
-      if (read_be) // -V547
-        hdr_ex = mkbindump::le2be16(hdr_ex);
-      hdr_ex_data.resize(hdr_ex);
-      crd.read(hdr_ex_data.data(), data_size(hdr_ex_data));
-    }
+  if (hdr.label == _MAKE4C('VRFx'))
+  {
+    uint16_t hdr_ex;
+    crd.read(&hdr_ex, 2);
+    crd.seekrel(-2);
+    if (read_be) // -V547
+      hdr_ex = mkbindump::le2be16(hdr_ex);
+    hdr_ex_data.resize(hdr_ex);
+    crd.read(hdr_ex_data.data(), data_size(hdr_ex_data));
+  }
 
-    read_be = dagor_target_code_be(hdr.target);
-    G_ASSERT(!read_be);
-    if (read_be)
-    {
-      hdr.fullSz = mkbindump::le2be32(hdr.fullSz);
-      hdr.hw32 = mkbindump::le2be32(hdr.hw32);
-    }
+  read_be = dagor_target_code_be(hdr.target);
+  G_ASSERT(!read_be);
+  if (read_be)
+  {
+    hdr.fullSz = mkbindump::le2be32(hdr.fullSz);
+    hdr.hw32 = mkbindump::le2be32(hdr.hw32);
+  }
 
-    fs.resize(hdr.fullSz);
-    if (hdr.packedSz() && hdr.zstdPacked())
-    {
-      Tab<char> src;
-      src.resize(hdr.packedSz());
-      crd.read(src.data(), data_size(src));
-      DEOBFUSCATE_ZSTD_DATA(src.data(), data_size(src));
-      size_t dsz = zstd_decompress(fs.data(), hdr.fullSz, src.data(), data_size(src));
-      if (dsz != hdr.fullSz)
-      {
-        printf("ERR: failed to decode data, ret=%d (decSz=%d), %s", (int)dsz, hdr.fullSz, fname);
-        return false;
-      }
-    }
-    else if (hdr.packedSz())
+  fs.resize(hdr.fullSz);
+  if (hdr.packedSz() && hdr.zstdPacked())
+  {
+    Tab<char> src;
+    src.resize(hdr.packedSz());
+    crd.read(src.data(), data_size(src));
+    DEOBFUSCATE_ZSTD_DATA(src.data(), data_size(src));
+    size_t dsz = zstd_decompress(fs.data(), hdr.fullSz, src.data(), data_size(src));
+    if (dsz != hdr.fullSz)
     {
-      ZlibLoadCB zcrd(crd, hdr.packedSz());
-      zcrd.read(fs.data(), hdr.fullSz);
-      zcrd.ceaseReading();
+      printf("ERR: failed to decode data, ret=%d (decSz=%d), %s", (int)dsz, hdr.fullSz, fname);
+      return false;
     }
-    else
-      crd.read(fs.data(), hdr.fullSz);
+  }
+  else if (hdr.packedSz())
+  {
+    ZlibLoadCB zcrd(crd, hdr.packedSz());
+    zcrd.read(fs.data(), hdr.fullSz);
+    zcrd.ceaseReading();
+  }
+  else
+    crd.read(fs.data(), hdr.fullSz);
 
-    if (crd.tryRead(md5_digest, 16) != 16)
-      memset(md5_digest, 0, sizeof(md5_digest));
-    else
+  if (crd.tryRead(md5_digest, 16) != 16)
+    memset(md5_digest, 0, sizeof(md5_digest));
+  else
+  {
+    char buffer[4096];
+    const int maxSignatureSize = 65536;
+    int bytesRead = 0;
+    while ((bytesRead = crd.tryRead(buffer, sizeof(buffer))) > 0)
     {
-      char buffer[4096];
-      const int maxSignatureSize = 65536;
-      int bytesRead = 0;
-      while ((bytesRead = crd.tryRead(buffer, sizeof(buffer))) > 0)
+      int currentSize = digitalSignature.size();
+      int newSize = currentSize + bytesRead;
+      if (newSize > maxSignatureSize)
       {
-        int currentSize = digitalSignature.size();
-        int newSize = currentSize + bytesRead;
-        if (newSize > maxSignatureSize)
-        {
-          printf("The digital signature is oversized and will be deleted!\n");
-          clear_and_shrink(digitalSignature);
-          break;
-        }
-        digitalSignature.resize(newSize);
-        memcpy(&digitalSignature[currentSize], buffer, bytesRead);
+        printf("The digital signature is oversized and will be deleted!\n");
+        clear_and_shrink(digitalSignature);
+        break;
       }
+      digitalSignature.resize(newSize);
+      memcpy(&digitalSignature[currentSize], buffer, bytesRead);
     }
   }
+  return true;
+}
+
+bool makeVromfsPatch(const char *base_fname, const char *new_fname, const char *patch_fname, unsigned chunk_avg_sz);
+
+bool repackVromfs(const char *fname, const char *dest_fname, bool store_packed, bool index_only = false)
+{
+  VirtualRomFsDataHdr hdr;
+  Tab<char> fs(tmpmem);
+  bool read_be = false;
+  unsigned char md5_digest[16];
+  Tab<char> digitalSignature(tmpmem);
+  Tab<uint8_t> hdr_ex_data;
+  if (!readVromfsDump(fname, hdr, hdr_ex_data, fs, md5_digest, digitalSignature))
+    return false;
 
   VirtualRomFsPack &fs_view = *(VirtualRomFsPack *)(fs.data() - FS_OFFS);
   // file layout of PatchableTab may differ from memory layout, do patch!
@@ -1352,6 +1360,8 @@ static void print_usage()
     "usage(index):  vromfsPacker-dev.exe -dumpver <data.vromfs.bin>\n"
     "usage(index):  vromfsPacker-dev.exe -dump <data.vromfs.bin>\n"
     "usage(index):  vromfsPacker-dev.exe -mkdict <dest_dict.bin> <dict_sz_KB> <data_for_dict.bin>...\n"
+    "usage(patch):  vromfsPacker-dev.exe -mkpatch <base.vromfs.bin> <new.vromfs.bin> <dest.vromfs.patch> [-chunk:<avg_bytes>]\n"
+    "usage(patch):  vromfsPacker-dev.exe -applypatch <base.vromfs.bin> <src.vromfs.patch> <dest.vromfs.bin>\n"
     "\noptions are:\n"
     "  -D:<def>          define macro for preprocessing\n"
     "  -out:<fname>      set output file\n"
@@ -1546,6 +1556,32 @@ int buildVromfs(DataBlock *explicit_build_rules, dag::ConstSpan<const char *> ar
     if (!repackVromfs(argv[2], argv[3], true, true))
       return 13;
   }
+  else if (dd_stricmp(argv[1], "-mkpatch") == 0)
+  {
+    // build delta patch from base VROMFS to new one
+    if (argc < 5)
+    {
+      print_usage();
+      return -1;
+    }
+    unsigned chunk_avg_sz = 2 << 10;
+    for (int i = 5; i < argc; i++)
+      if (strnicmp(argv[i], "-chunk:", 7) == 0)
+        chunk_avg_sz = atoi(argv[i] + 7);
+    if (!makeVromfsPatch(argv[2], argv[3], argv[4], chunk_avg_sz))
+      return 13;
+  }
+  else if (dd_stricmp(argv[1], "-applypatch") == 0)
+  {
+    // apply delta patch to base VROMFS and store result as non-packed binary
+    if (argc < 5)
+    {
+      print_usage();
+      return -1;
+    }
+    if (!apply_vromfs_patch(argv[2], argv[3], argv[4]))
+      return 13;
+  }
   else if (dd_stricmp(argv[1], "-dumpver") == 0)
   {
     if (argc < 3 || !unpackVromfs(argv[2], nullptr, false, 0, 0, false, true))
@@ -0,0 +1,332 @@
+// Copyright 2023 by Gaijin Games KFT, All rights reserved.
+#include <osApiWrappers/dag_vromfs.h>
+#include <osApiWrappers/dag_files.h>
+#include <osApiWrappers/dag_direct.h>
+#include <ioSys/dag_fileIo.h>
+#include <ioSys/dag_memIo.h>
+#include <ioSys/dag_zstdIo.h>
+#include <memory/dag_mem.h>
+#include <perfMon/dag_cpuFreq.h>
+#include <generic/dag_tab.h>
+#include <util/dag_globDef.h>
+#include <ska_hash_map/flat_hash_map2.hpp>
+#include <EASTL/sort.h>
+#include <hash/BLAKE3/blake3.h>
+#include <openssl/md5.h>
+#include <stdio.h>
+#include <stddef.h> // offsetof
+
+// Delta patch between two vromfs dumps: contents of both dumps are split with content-defined chunking (FastCDC-like gear hash
+// with normalized chunking; cut points are also forced on file data boundaries), so an edit in one file shifts chunk bounds only
+// locally. Each chunk of new contents is then stored as a reference to the same chunk in base contents, a reference to an earlier
+// chunk of new contents (duplicates across files) or as new data; adjacent ops are merged and whole ops stream is zstd-packed.
+
+extern bool readVromfsDump(const char *fname, VirtualRomFsDataHdr &hdr, Tab<uint8_t> &hdr_ex_data, Tab<char> &fs,
+  unsigned char md5_digest[16], Tab<char> &digitalSignature);
+
+#define FS_OFFS int(offsetof(VirtualRomFsData, files))
+static const int DATA_TAB_OFS = int(offsetof(VirtualRomFsData, data)) - FS_OFFS;
+static const int DATA_REC_SZ = 16; // file layout of PatchableTab (offset, count, padding)
+static const int PATCH_ZSTD_CLEVEL = 19;
+static const int BENCH_ITERATIONS = 10;
+
+namespace
+{
+struct ChunkParams
+{
+  unsigned minSz, avgSz, maxSz;
+  uint64_t maskS, maskL; // stricter mask before avgSz and looser after, to keep chunk sizes close to avgSz
+
+  explicit ChunkParams(unsigned avg_sz)
+  {
+    int bits = 6;
+    while (bits < 24 && (1u << (bits + 1)) <= avg_sz)
+      bits++;
+    avgSz = 1u << bits;
+    minSz = avgSz / 4;
+    maxSz = avgSz * 8;
+    maskS = ((1ull << (bits + 1)) - 1) << (63 - bits);
+    maskL = ((1ull << (bits - 1)) - 1) << (65 - bits);
+  }
+};
+
+struct Chunk
+{
+  unsigned ofs, len;
+};
+
+struct ChunkIndex
+{
+  const char *data = nullptr;
+  ska::flat_hash_map<uint64_t, Chunk> map;
+
+  // returns offset of chunk with the same contents or -1
+  int find(uint64_t h, const char *p, unsigned len) const
+  {
+    auto it = map.find(h);
+    if (it == map.end() || it->second.len != len || memcmp(data + it->second.ofs, p, len) != 0)
+      return -1;
+    return (int)it->second.ofs;
+  }
+  void add(uint64_t h, unsigned ofs, unsigned len) { map.emplace(h, Chunk{ofs, len}); }
+};
+
+class OpsWriter
+{
+public:
+  unsigned opsCount = 0;
+
+  OpsWriter(IGenSave &cwr, const char *src) : zcwr(cwr, PATCH_ZSTD_CLEVEL), srcData(src) {}
+  ~OpsWriter() { G_ASSERT(!curLen); }
+
+  void add(uint8_t type, unsigned pos, unsigned ofs, unsigned len)
+  {
+    // merged self copy must not overlap its destination, as ops are applied with memcpy
+    bool contiguous = (type == VirtualRomFsPatchHdr::VRFD_OP_ADD) ||
+                      (curOfs + curLen == ofs && (type != VirtualRomFsPatchHdr::VRFD_OP_COPY_SELF || ofs + len <= curPos));
+    if (curLen && (type != curType || !contiguous))
+      flushOp();
+    if (!curLen)
+      curType = type, curPos = pos, curOfs = ofs;
+    curLen += len;
+  }
+  void finish()
+  {
+    if (curLen)
+      flushOp();
+    zcwr.finish();
+  }
+
+private:
+  ZstdSaveCB zcwr;
+  const char *srcData;
+  uint8_t curType = 0;
+  unsigned curPos = 0, curOfs = 0, curLen = 0;
+
+  void flushOp()
+  {
+    uint32_t len = curLen, ofs = curOfs;
+    zcwr.write(&curType, sizeof(curType));
+    zcwr.write(&len, sizeof(len));
+    if (curType == VirtualRomFsPatchHdr::VRFD_OP_ADD)
+      zcwr.write(srcData + curPos, curLen);
+    else
+      zcwr.write(&ofs, sizeof(ofs));
+    opsCount++;
+    curLen = 0;
+  }
+};
+} // namespace
+
+static uint64_t gear[256];
+
+static void init_gear_table()
+{
+  uint64_t s = 0x5647524644435F31ull; // fixed seed, so chunking is the same for all packer builds
+  for (uint64_t &g : gear)
+  {
+    // splitmix64
+    uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    g = z ^ (z >> 31);
+  }
+}
+
+static unsigned next_cut(const uint8_t *p, unsigned n, const ChunkParams &cp)
+{
+  if (n <= cp.minSz)
+    return n;
+  unsigned end = min(n, cp.maxSz), norm_end = min(end, cp.avgSz), i = cp.minSz;
+  uint64_t h = 0;
+  for (; i < norm_end; i++)
+    if (!((h = (h << 1) + gear[p[i]]) & cp.maskS))
+      return i + 1;
+  for (; i < end; i++)
+    if (!((h = (h << 1) + gear[p[i]]) & cp.maskL))
+      return i + 1;
+  return end;
+}
+
+static uint64_t chunk_hash(const char *p, unsigned len)
+{
+  uint64_t h;
+  blake3_hasher hasher;
+  blake3_hasher_init(&hasher);
+  blake3_hasher_update(&hasher, p, len);
+  blake3_hasher_finalize(&hasher, (uint8_t *)&h, sizeof(h));
+  return h;
+}
+
+static unsigned read_u32(const Tab<char> &fs, unsigned ofs)
+{
+  unsigned v = 0;
+  if (ofs + sizeof(v) <= data_size(fs))
+    memcpy(&v, fs.data() + ofs, sizeof(v));
+  return v;
+}
+
+// calls cb(ofs, len) for each chunk of contents; file data entries are chunked separately from each other and from gaps between
+// them (headers, names, hashes), data entries shared by several files (dedup by content SHA1) are chunked once
+template <typename F>
+static void for_each_chunk(const Tab<char> &fs, const ChunkParams &cp, const F &cb)
+{
+  auto chunk_range = [&](unsigned start, unsigned end) {
+    while (start < end)
+    {
+      unsigned len = next_cut((const uint8_t *)fs.data() + start, end - start, cp);
+      cb(start, len);
+      start += len;
+    }
+  };
+
+  const unsigned full_sz = data_size(fs);
+  const unsigned data_ofs = read_u32(fs, DATA_TAB_OFS), data_cnt = read_u32(fs, DATA_TAB_OFS + 4);
+  Tab<Chunk> entries;
+  if (data_ofs <= full_sz && data_cnt <= (full_sz - data_ofs) / DATA_REC_SZ)
+  {
+    entries.reserve(data_cnt);
+    for (unsigned i = 0; i < data_cnt; i++)
+    {
+      Chunk e{read_u32(fs, data_ofs + i * DATA_REC_SZ), read_u32(fs, data_ofs + i * DATA_REC_SZ + 4)};
+      if (e.len && e.ofs <= full_sz && e.len <= full_sz - e.ofs)
+        entries.push_back(e);
+    }
+  }
+  eastl::sort(entries.begin(), entries.end(), [](const Chunk &a, const Chunk &b) { return a.ofs < b.ofs; });
+
+  unsigned pos = 0;
+  for (const Chunk &e : entries)
+    if (e.ofs >= pos)
+    {
+      chunk_range(pos, e.ofs);
+      chunk_range(e.ofs, e.ofs + e.len);
+      pos = e.ofs + e.len;
+    }
+  chunk_range(pos, full_sz);
+}
+
+static int64_t file_size(const char *fname)
+{
+  DagorStat st;
+  return df_stat(fname, &st) == 0 ? st.size : -1;
+}
+
+static void bench_apply(const char *base_fname, const char *new_fname, const char *patch_fname)
+{
+  int64_t patched_usec = 0, full_usec = 0;
+  for (int i = 0; i < BENCH_ITERATIONS; i++)
+  {
+    int64_t reft = ref_time_ticks();
+    VirtualRomFsData *fs = load_vromfs_dump_patched(base_fname, patch_fname, tmpmem);
+    patched_usec += ref_time_delta_to_usec(reft);
+    if (!fs)
+    {
+      printf("ERR: failed to load %s patched with %s\n", base_fname, patch_fname);
+      return;
+    }
+    tmpmem->free(fs);
+
+    reft = ref_time_ticks();
+    fs = load_vromfs_dump(new_fname, tmpmem);
+    full_usec += ref_time_delta_to_usec(reft);
+    if (fs)
+      tmpmem->free(fs);
+  }
+  printf("  apply time: %.2f ms (base+patch), %.2f ms (full dump), avg of %d loads\n", patched_usec / 1e3 / BENCH_ITERATIONS,
+    full_usec / 1e3 / BENCH_ITERATIONS, BENCH_ITERATIONS);
+}
+
+bool makeVromfsPatch(const char *base_fname, const char *new_fname, const char *patch_fname, unsigned chunk_avg_sz)
+{
+  VirtualRomFsDataHdr base_hdr, new_hdr;
+  Tab<uint8_t> base_hdr_ex, new_hdr_ex;
+  Tab<char> base_fs(tmpmem), new_fs(tmpmem), base_sig(tmpmem), new_sig(tmpmem);
+  unsigned char base_md5[16], new_md5[16];
+  if (!readVromfsDump(base_fname, base_hdr, base_hdr_ex, base_fs, base_md5, base_sig) ||
+      !readVromfsDump(new_fname, new_hdr, new_hdr_ex, new_fs, new_md5, new_sig))
+    return false;
+  if (base_hdr.target != new_hdr.target)
+  {
+    printf("ERR: target mismatch %c%c%c%c != %c%c%c%c\n", _DUMP4C(base_hdr.target), _DUMP4C(new_hdr.target));
+    return false;
+  }
+
+  int reft = get_time_msec();
+  init_gear_table();
+  ChunkParams cp(chunk_avg_sz);
+
+  ChunkIndex base_idx, self_idx;
+  base_idx.data = base_fs.data();
+  self_idx.data = new_fs.data();
+  int base_chunks = 0;
+  for_each_chunk(base_fs, cp, [&](unsigned ofs, unsigned len) {
+    base_idx.add(chunk_hash(base_fs.data() + ofs, len), ofs, len);
+    base_chunks++;
+  });
+
+  DynamicMemGeneralSaveCB ops_cwr(tmpmem, 0, 256 << 10);
+  OpsWriter ops(ops_cwr, new_fs.data());
+  int chunks[3] = {0, 0, 0};
+  unsigned bytes[3] = {0, 0, 0};
+  for_each_chunk(new_fs, cp, [&](unsigned ofs, unsigned len) {
+    const char *p = new_fs.data() + ofs;
+    uint64_t h = chunk_hash(p, len);
+    uint8_t type = VirtualRomFsPatchHdr::VRFD_OP_ADD;
+    int src_ofs = base_idx.find(h, p, len);
+    if (src_ofs >= 0)
+      type = VirtualRomFsPatchHdr::VRFD_OP_COPY_BASE;
+    else if ((src_ofs = self_idx.find(h, p, len)) >= 0)
+      type = VirtualRomFsPatchHdr::VRFD_OP_COPY_SELF;
+    else
+      self_idx.add(h, ofs, len);
+    ops.add(type, ofs, src_ofs, len);
+    chunks[type]++;
+    bytes[type] += len;
+  });
+  ops.finish();
+
+  VirtualRomFsPatchHdr hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.label = _MAKE4C('VRFd');
+  hdr.target = new_hdr.target;
+  hdr.fullSz = data_size(new_fs);
+  hdr.opsPackedSz = ops_cwr.size();
+  hdr.baseFullSz = data_size(base_fs);
+  hdr.sigSz = data_size(new_sig);
+  hdr.dumpHdrSz = sizeof(new_hdr) + data_size(new_hdr_ex);
+  const char *base_name = dd_get_fname(base_fname);
+  hdr.baseNameLen = strlen(base_name);
+  MD5((const unsigned char *)base_fs.data(), data_size(base_fs), hdr.baseMD5);
+  MD5((const unsigned char *)new_fs.data(), data_size(new_fs), hdr.fullMD5);
+  new_hdr.hw32 &= 0x80000000U; // ops produce non-packed contents, keep signedContents flag
+
+  dd_mkpath(patch_fname);
+  {
+    FullFileSaveCB cwr(patch_fname);
+    if (!cwr.fileHandle)
+    {
+      printf("ERR: can't write %s\n", patch_fname);
+      return false;
+    }
+    cwr.write(&hdr, sizeof(hdr));
+    cwr.write(&new_hdr, sizeof(new_hdr));
+    cwr.write(new_hdr_ex.data(), data_size(new_hdr_ex));
+    cwr.write(base_name, hdr.baseNameLen);
+    cwr.write(new_sig.data(), data_size(new_sig));
+    cwr.write(ops_cwr.data(), ops_cwr.size());
+  }
+
+  const int64_t new_file_sz = file_size(new_fname), patch_sz = file_size(patch_fname);
+  printf("built vromfs patch %s for %.3f sec (chunk avg=%u min=%u max=%u)\n", patch_fname, (get_time_msec() - reft) / 1e3f, cp.avgSz,
+    cp.minSz, cp.maxSz);
+  printf("  base:  %s, %u bytes in %d chunks\n", base_fname, hdr.baseFullSz, base_chunks);
+  printf("  new:   %s, %u bytes (file %lld bytes)\n", new_fname, hdr.fullSz, (long long)new_file_sz);
+  printf("  ops:   %u; %d chunks (%u bytes) from base, %d chunks (%u bytes) duplicated, %d chunks (%u bytes) new\n", ops.opsCount,
+    chunks[VirtualRomFsPatchHdr::VRFD_OP_COPY_BASE], bytes[VirtualRomFsPatchHdr::VRFD_OP_COPY_BASE],
+    chunks[VirtualRomFsPatchHdr::VRFD_OP_COPY_SELF], bytes[VirtualRomFsPatchHdr::VRFD_OP_COPY_SELF],
+    chunks[VirtualRomFsPatchHdr::VRFD_OP_ADD], bytes[VirtualRomFsPatchHdr::VRFD_OP_ADD]);
+  printf("  patch: %lld bytes (%.1f%% of new file)\n", (long long)patch_sz, new_file_sz > 0 ? patch_sz * 100.0 / new_file_sz : 0.0);
+  bench_apply(base_fname, new_fname, patch_fname);
+  return true;
+}
@@ -0,0 +1,76 @@
+from "%darg/ui_imports.nut" import *
+
+// Large mostly static tree with a few cells changed every frame: measures incremental layout and render list rebuild.
+// Can be run headless: dargbox -config:video/driver:t="stub" with this script, average frame time is printed to log.
+// Compare with "darg.reuse_render_list false" console var to see cost of full stacks rebuild.
+
+let math = require("math")
+let {get_time_msec} = require("dagor.time")
+
+const rows = 100
+const cols = 50
+const changesPerFrame = 8 //cells changed each frame (text, size or children)
+const reportEveryFrames = 300
+
+let cells = persist("cells", @() array(rows * cols).map(@(_) Watched(0)))
+
+local framesCount = 0
+local lastReportTime = get_time_msec()
+
+gui_scene.setUpdateHandler(function(_dt) {
+  for (local i = 0; i < changesPerFrame; ++i) {
+    let cell = cells[math.rand() % cells.len()]
+    cell(cell.value + 1)
+  }
+  ++framesCount
+  if (framesCount % reportEveryFrames == 0) {
+    let t = get_time_msec()
+    log($"incremental_layout: {rows*cols} cells, avg frame {(t - lastReportTime).tofloat() / reportEveryFrames} ms")
+    lastReportTime = t
+  }
+})
+
+let function cell(idx) {
+  let state = cells[idx]
+  return @() {
+    watch = state
+    rendObj = ROBJ_SOLID
+    color = Color(20 + idx % 200, 40, 60)
+    size = [flex(), hdpx(16 + state.value % 3 * 2)]
+    padding = hdpx(1)
+    flow = FLOW_HORIZONTAL
+    children = [
+      {
+        rendObj = ROBJ_TEXT
+        text = state.value
+      }
+      // occasionally add/remove child to exercise stacks rebuild
+      state.value % 4 == 3 ? { rendObj = ROBJ_FRAME size = flex() borderWidth = 1 } : null
+    ]
+  }
+}
+
+let function row(r) {
+  let children = []
+  for (local c = 0; c < cols; ++c)
+    children.append(cell(r * cols + c))
+  return {
+    size = [flex(), SIZE_TO_CONTENT]
+    flow = FLOW_HORIZONTAL
+    gap = hdpx(1)
+    children
+  }
+}
+
+let function incrementalLayout() {
+  let children = []
+  for (local r = 0; r < rows; ++r)
+    children.append(row(r))
+  return {
+    size = flex()
+    flow = FLOW_VERTICAL
+    children
+  }
+}
+
+return incrementalLayout
@@ -46,8 +46,8 @@ int pull_dll_sum =
 
   dll_pull_iosys_asyncIo + dll_pull_iosys_asyncIoCached + dll_pull_iosys_asyncWrite + dll_pull_iosys_baseIo + dll_pull_iosys_fileIo +
   dll_pull_iosys_ioUtils + dll_pull_iosys_memIo + dll_pull_iosys_obsolete_cfg + dll_pull_iosys_zlibIo + dll_pull_iosys_lzmaDecIo +
-  dll_pull_iosys_lzmaEnc + dll_pull_iosys_zstdIo + dll_pull_iosys_oodleIo + dll_pull_iosys_chainedMemIo + dll_pull_iosys_msgIo +
-  dll_pull_iosys_fastSeqRead + dll_pull_iosys_vromfsLoad + dll_pull_iosys_findFiles +
+  dll_pull_iosys_lzmaEnc + dll_pull_iosys_zstdIo + dll_pull_iosys_zstdSeekableIo + dll_pull_iosys_oodleIo +
+  dll_pull_iosys_chainedMemIo + dll_pull_iosys_msgIo + dll_pull_iosys_fastSeqRead + dll_pull_iosys_vromfsLoad + dll_pull_iosys_findFiles +
 
   dll_pull_iosys_datablock_core + dll_pull_iosys_datablock_errors + dll_pull_iosys_datablock_parser +
   dll_pull_iosys_datablock_readbbf3 + dll_pull_iosys_datablock_serialize + dll_pull_iosys_datablock_zstd +
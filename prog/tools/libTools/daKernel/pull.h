@@ -61,6 +61,7 @@ extern int dll_pull_iosys_zlibIo;
 extern int dll_pull_iosys_lzmaDecIo;
 extern int dll_pull_iosys_lzmaEnc;
 extern int dll_pull_iosys_zstdIo;
+extern int dll_pull_iosys_zstdSeekableIo;
 extern int dll_pull_iosys_oodleIo;
 extern int dll_pull_iosys_chainedMemIo;
 extern int dll_pull_iosys_msgIo;
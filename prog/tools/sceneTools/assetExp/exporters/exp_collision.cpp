@@ -355,7 +355,7 @@ public:
   virtual unsigned __stdcall getGameResClassId() const { return 0xACE50000; }
   virtual unsigned __stdcall getGameResVersion() const
   {
-    static constexpr const int base_ver = 2;
+    static constexpr const int base_ver = 3;
     return base_ver * 12 + 5 + (def_collidable ? 1 : 0) + 2 * (!preferZstdPacking ? 0 : (allowOodlePacking ? 2 : 1 + 6)) +
            (writePrecookedFmt ? 6 : 0);
   }
@@ -1046,6 +1046,7 @@ public:
         coll.collapseAndOptimize(build_frt, /* fast= */ false);
       }
     }
+    coll.buildNodesBVH(); // after all mesh changes; keeps BVH built by collapseAndOptimize for nodes sharing triangles with FRT
 
     // write back uncompressed data in modern format
     mcwr.reset(128 << 10);
@@ -1155,6 +1156,17 @@ public:
       }
       else
         cwr.write16ex(n.indices.data(), data_size(n.indices));
+
+      if (c.collisionFlags & COLLISION_RES_FLAG_HAS_NODE_BVH)
+      {
+        cwr.writeInt32e(n.bvh.size());
+        for (const CollisionBVHNode &b : n.bvh)
+        {
+          cwr.write16ex(b.bmin, sizeof(b.bmin));
+          cwr.write16ex(b.bmax, sizeof(b.bmax));
+          cwr.writeInt32e(b.data);
+        }
+      }
     }
 
     if (c.collisionFlags & COLLISION_RES_FLAG_HAS_REL_GEOM_NODE_ID)
@@ -10,6 +10,7 @@
 #include <libTools/util/iLogWriter.h>
 #include <image/dag_loadImage.h>
 #include <image/dag_texPixel.h>
+#include <image/dag_dxtCompress.h>
 #include <nvtt/nvtt.h>
 #include <nvimage/image.h>
 #include <nvimage/floatImage.h>
@@ -2194,25 +2195,12 @@ public:
 #if _TARGET_PC_WIN
   void chooseBC6HEncodeSettings(bc6h_enc_settings *settings, const char *quality)
   {
-    if (strcmp(quality, "") == 0)
-    {
-      GetProfile_bc6h_slow(settings);
-    }
-    else if (strcmp(quality, "fastest") == 0)
-    {
-      GetProfile_bc6h_fast(settings);
-    }
-    else if (strcmp(quality, "normal") == 0)
-    {
-      GetProfile_bc6h_basic(settings);
-    }
-    else if (strcmp(quality, "production") == 0)
+    switch (dxt_preset_from_name(quality))
     {
-      GetProfile_bc6h_slow(settings);
-    }
-    else if (strcmp(quality, "highest") == 0)
-    {
-      GetProfile_bc6h_veryslow(settings);
+      case DXT_PRESET_FASTEST: GetProfile_bc6h_fast(settings); break;
+      case DXT_PRESET_NORMAL: GetProfile_bc6h_basic(settings); break;
+      case DXT_PRESET_HIGHEST: GetProfile_bc6h_veryslow(settings); break;
+      default: GetProfile_bc6h_slow(settings); break;
     }
   }
 
@@ -2235,15 +2223,42 @@ public:
     }
   }
 
-  void EncodeBC6(uint8_t *src, uint8_t *dst, nv::Image *image, bc6h_enc_settings *settings)
+  // ispc encoders are SIMD but single-threaded, so image is split into bands of block rows compressed in parallel using threadpool
+  struct IspcEncodeBands
   {
     rgba_surface input;
-    input.ptr = src;
-    input.stride = image->width() * 8;
-    input.width = image->width();
-    input.height = image->height();
+    uint8_t *dst;
+    void *settings;
+    void (*compress)(IspcEncodeBands &ctx, const rgba_surface &band, uint8_t *dst);
+
+    void run()
+    {
+      const int blockCols = (input.width + 3) / 4, blockRows = (input.height + 3) / 4;
+      dxt_parallel_block_rows(blockRows, blockCols, &compressBand, this);
+    }
+    static void compressBand(void *p, int row0, int row1)
+    {
+      IspcEncodeBands &ctx = *(IspcEncodeBands *)p;
+      rgba_surface band = ctx.input;
+      band.ptr += row0 * 4 * band.stride;
+      band.height = min(row1 * 4, ctx.input.height) - row0 * 4;
+      ctx.compress(ctx, band, ctx.dst + row0 * ((ctx.input.width + 3) / 4) * 16); // 16 bytes per BC6H/BC7 block
+    }
+  };
 
-    CompressBlocksBC6H(&input, dst, settings);
+  void EncodeBC6(uint8_t *src, uint8_t *dst, nv::Image *image, bc6h_enc_settings *settings)
+  {
+    IspcEncodeBands enc;
+    enc.input.ptr = src;
+    enc.input.stride = image->width() * 8;
+    enc.input.width = image->width();
+    enc.input.height = image->height();
+    enc.dst = dst;
+    enc.settings = settings;
+    enc.compress = [](IspcEncodeBands &ctx, const rgba_surface &band, uint8_t *band_dst) {
+      CompressBlocksBC6H(&band, band_dst, (bc6h_enc_settings *)ctx.settings);
+    };
+    enc.run();
   }
 
   void save2DDS(IGenSave &cwr, nvtt::TextureType ttype, int w, int h, int d, int mips, DWORD fourcc, Tab<char> &packed, int hq_part)
@@ -2325,25 +2340,12 @@ public:
 
   void chooseBC7EncodeSettings(bc7_enc_settings *settings, const char *quality)
   {
-    if (strcmp(quality, "") == 0)
-    {
-      GetProfile_alpha_basic(settings);
-    }
-    else if (strcmp(quality, "fastest") == 0)
-    {
-      GetProfile_alpha_veryfast(settings);
-    }
-    else if (strcmp(quality, "normal") == 0)
+    switch (dxt_preset_from_name(quality))
     {
-      GetProfile_alpha_fast(settings);
-    }
-    else if (strcmp(quality, "production") == 0)
-    {
-      GetProfile_alpha_basic(settings);
-    }
-    else if (strcmp(quality, "highest") == 0)
-    {
-      GetProfile_alpha_slow(settings);
+      case DXT_PRESET_FASTEST: GetProfile_alpha_veryfast(settings); break;
+      case DXT_PRESET_NORMAL: GetProfile_alpha_fast(settings); break;
+      case DXT_PRESET_HIGHEST: GetProfile_alpha_slow(settings); break;
+      default: GetProfile_alpha_basic(settings); break;
     }
   }
 
@@ -2360,13 +2362,17 @@ public:
 
   void EncodeBC7(uint8_t *src, uint8_t *dst, nv::Image *image, bc7_enc_settings *settings)
   {
-    rgba_surface input;
-    input.ptr = src;
-    input.stride = image->width() * 4;
-    input.width = image->width();
-    input.height = image->height();
-
-    CompressBlocksBC7(&input, dst, settings);
+    IspcEncodeBands enc;
+    enc.input.ptr = src;
+    enc.input.stride = image->width() * 4;
+    enc.input.width = image->width();
+    enc.input.height = image->height();
+    enc.dst = dst;
+    enc.settings = settings;
+    enc.compress = [](IspcEncodeBands &ctx, const rgba_surface &band, uint8_t *band_dst) {
+      CompressBlocksBC7(&band, band_dst, (bc7_enc_settings *)ctx.settings);
+    };
+    enc.run();
   }
 
   bool convert_to_bc7(IGenSave &cwr, dag::ConstSpan<ImageSurface> imgSurf, nvtt::TextureType ttype, int voltex_d, const char *quality,